@@ -0,0 +1,207 @@
+#include <bit>
+#include <span>
+#include <print>
+#include <chrono>
+#include <vector>
+#include <typeinfo>
+#include <exception>
+#include <filesystem>
+#include <string_view>
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#include "../support/error.hpp"
+#include "../support/mesh.hpp"
+#include "../support/mesh_file.hpp"
+#include "../support/mesh_layouts.hpp"
+#include "../support/mesh_optimize.hpp"
+#include "../support/terrain_lod.hpp"
+
+/* asset-cook: converts Wavefront OBJ meshes into cooked mesh files
+ *
+ * Usage (from the project root, like main):
+ *
+ *   asset-cook [--force]
+ *       Cooks the meshes used by main.
+ *
+ *   asset-cook [--force] [--materials] [--terrain] input.obj output.cw2mesh
+ *       Cooks a single mesh. --materials keeps the MTL materials and the
+ *       per-vertex material IDs. --terrain bakes the terrain LOD (see
+ *       kTerrainLod in mesh_layouts.hpp).
+ *
+ * Meshes are passed through optimize_mesh() before they are written; the
+ * vertex cache statistics before and after are printed. The vertices are
+ * also stored interleaved, in the layout that main uploads them with (see
+ * mesh_layouts.hpp). For the terrain, build_terrain_lod() runs last, and its
+ * tiles, levels and skirts are stored with the mesh.
+ *
+ * Meshes whose cooked file is current are skipped, unless --force is given.
+ * For each cooked mesh, the time to load it from the OBJ and from the cooked
+ * file are printed side by side. See support/mesh_file.hpp for the format.
+ */
+
+namespace
+{
+	using Clock_ = std::chrono::steady_clock;
+	using Millisf_ = std::chrono::duration<float, std::milli>;
+
+	struct CookJob_
+	{
+		std::filesystem::path source;
+		std::filesystem::path output;
+		bool materials;
+		TerrainLodOptions const* lod; // null: no LOD
+	};
+
+	// Keep in sync with the load_mesh() calls in main/main.cpp
+	CookJob_ const kDefaultJobs_[] = {
+		{ "assets/cw2/parlahti.obj", "assets/cw2/parlahti.cw2mesh", false, &kTerrainLod },
+		{ "assets/cw2/landingpad.obj", "assets/cw2/landingpad.cw2mesh", true, nullptr }
+	};
+
+	struct Interleaved_
+	{
+		MeshFileVertexLayout layout;
+		std::vector<std::byte> vertices;
+	};
+
+	template< typename tLayout >
+	Interleaved_ interleave_( SimpleMeshData const& aMesh )
+	{
+		using Vertex = typename tLayout::Vertex;
+
+		Interleaved_ ret{ mesh_file_layout<tLayout>(), std::vector<std::byte>( aMesh.positions.size() * sizeof(Vertex) ) };
+		interleave_mesh<tLayout>( std::span( reinterpret_cast<Vertex*>(ret.vertices.data()), aMesh.positions.size() ), mesh_streams( aMesh ) );
+		return ret;
+	}
+
+	// Picks the layout that main uses for a mesh with these streams
+	Interleaved_ interleave_for_main_( SimpleMeshData const& aMesh )
+	{
+		if( !aMesh.materialIds.empty() )
+			return interleave_<MaterialVertexLayout>( aMesh );
+		if( !aMesh.texcoords.empty() )
+			return interleave_<TexturedVertexLayout>( aMesh );
+		return interleave_<UntexturedVertexLayout>( aMesh );
+	}
+
+	void cook_( CookJob_ const& aJob, bool aForce )
+	{
+		if( !aForce && is_mesh_file_current( aJob.output, aJob.source ) )
+		{
+			std::print( "{}: up to date\n", aJob.output.string() );
+			return;
+		}
+
+		// Parse OBJ. Fingerprinting the source hashes the whole file, so it
+		// is kept out of the timed load.
+		std::vector<Material> materials;
+		auto const source = fingerprint_source( aJob.source );
+
+		auto const t0 = Clock_::now();
+		auto mesh = load_wavefront_obj( aJob.source.string().c_str(), aJob.materials ? &materials : nullptr );
+
+		auto const t1 = Clock_::now();
+
+		auto const report = optimize_mesh( mesh );
+
+		auto const t1b = Clock_::now();
+
+		std::size_t const vertexCount = mesh.positions.size();
+		TerrainLod lod;
+		if( aJob.lod )
+			lod = build_terrain_lod( mesh, *aJob.lod );
+
+		auto const t1c = Clock_::now();
+
+		auto const interleaved = interleave_for_main_( mesh );
+		write_mesh_file( aJob.output, mesh, materials, interleaved.layout, interleaved.vertices, lod, aJob.lod ? *aJob.lod : TerrainLodOptions{}, source );
+
+		// Load the cooked file again. Touch all of its data, so that the page
+		// faults of the mapping are included in the time.
+		auto const t2 = Clock_::now();
+
+		MeshFile const cooked( aJob.output );
+		auto const streams = cooked.streams();
+		auto const vertices = cooked.vertices();
+
+		std::uint32_t sum = 0;
+		for( std::size_t i = 0; i < vertices.size(); i += 4 ) sum += std::to_integer<std::uint32_t>( vertices[i] );
+		for( auto const& p : streams.positions ) sum += std::bit_cast<std::uint32_t>( p.x );
+		for( auto const& n : streams.normals ) sum += std::bit_cast<std::uint32_t>( n.x );
+		for( auto const& t : streams.texcoords ) sum += std::bit_cast<std::uint32_t>( t.x );
+		for( auto const i : streams.indices16 ) sum += i;
+		for( auto const i : streams.indices32 ) sum += i;
+
+		auto const t3 = Clock_::now();
+
+		auto const& hdr = cooked.header();
+		std::print( "{}: {} vertices ({} bytes each), {} indices ({}-bit), {} materials\n", aJob.output.string(), hdr.vertexCount, hdr.layout.stride, hdr.indexCount, 8*hdr.indexSize, hdr.materialCount );
+		std::print( "  load time: OBJ {:.2f} ms | cooked {:.2f} ms{} | x{:.0f}  (checksum {:08x})\n",
+			Millisf_( t1 - t0 ).count(),
+			Millisf_( t3 - t2 ).count(),
+			cooked.is_mapped() ? " (mapped)" : "",
+			Millisf_( t1 - t0 ).count() / Millisf_( t3 - t2 ).count(),
+			sum
+		);
+		std::print( "  optimized in {:.2f} ms: ACMR {:.3f} -> {:.3f} | ATVR {:.3f} -> {:.3f}\n",
+			Millisf_( t1b - t1 ).count(),
+			report.before.acmr, report.after.acmr,
+			report.before.atvr, report.after.atvr
+		);
+		if( !lod.empty() )
+		{
+			std::print( "  terrain LOD in {:.2f} ms: {} tiles x {} levels, {} skirt vertices\n",
+				Millisf_( t1c - t1b ).count(),
+				lod.tileCount, lod.levelCount,
+				mesh.positions.size() - vertexCount
+			);
+		}
+	}
+}
+
+int main( int aArgc, char* aArgv[] ) try
+{
+	bool force = false, materials = false, terrain = false;
+	std::vector<std::filesystem::path> paths;
+
+	for( int i = 1; i < aArgc; ++i )
+	{
+		std::string_view const arg = aArgv[i];
+		if( "--force" == arg )
+			force = true;
+		else if( "--materials" == arg )
+			materials = true;
+		else if( "--terrain" == arg )
+			terrain = true;
+		else if( arg.starts_with( "--" ) )
+			throw Error( "Unknown option '{}'", arg );
+		else
+			paths.emplace_back( arg );
+	}
+
+	if( paths.empty() )
+	{
+		for( auto const& job : kDefaultJobs_ )
+			cook_( job, force );
+	}
+	else if( 2 == paths.size() )
+	{
+		cook_( CookJob_{ paths[0], paths[1], materials, terrain ? &kTerrainLod : nullptr }, force );
+	}
+	else
+	{
+		throw Error( "Usage: {} [--force] [--materials] [--terrain] [input.obj output.cw2mesh]", aArgv[0] );
+	}
+
+	return 0;
+}
+catch( std::exception const& eErr )
+{
+	std::print( stderr, "Top-level Exception ({}):\n", typeid(eErr).name() );
+	std::print( stderr, "{}\n", eErr.what() );
+	std::print( stderr, "Bye.\n" );
+	return 1;
+}
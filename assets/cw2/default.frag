@@ -4,29 +4,69 @@ in vec2 v2fTexcoord;
 in vec3 v2fNormal;
 in vec3 v2fworldPos;
 
+// Per-frame data, shared by all programs (see support/frame_data.hpp).
+// kMaxPointLights must match the C++ side.
+const uint kMaxPointLights = 16u;
+
 struct DirLight {
 	vec3 direction;
-	vec3 color;
 	bool enabled;
+	vec3 color;
 };
 
 struct PointLight {
 	vec3 position;
-	vec3 color;
 	bool enabled;
+	vec3 color;
+};
+
+layout(std140, binding = 0) uniform FrameData {
+	vec3 uCameraPos;
+	uint uPointLightCount;
+	vec3 uSceneAmbient;
+	DirLight uGlobalLight;
+	PointLight uPointLights[kMaxPointLights];
 };
 
-layout(location = 4) uniform vec3 uSceneAmbient;
-uniform DirLight uGlobalLight;
-uniform PointLight uPointLights[3];
+// Unlit draws (particles) output the base color scaled by uEmissive
+layout(location = 4) uniform vec3 uEmissive;
+layout(location = 13) uniform bool uUnlit;
 
 uniform sampler2D uTexture;
 layout(location = 5) uniform bool uHasTexture;
 
-layout(location = 6) uniform vec3 uCameraPos;
+// Virtual texturing (see support/virtual_texture.hpp): replaces uTexture
+// if set. uVtParams holds the page grid of level 0 (x, y), the number of
+// levels and a level bias; uVtCache the page size and border in texels,
+// and the reciprocal size of the page cache. The samplers have their own
+// units, so that they never share one with uTexture.
+layout(location = 10) uniform bool uVirtualTexture;
+layout(location = 11) uniform vec4 uVtParams;
+layout(location = 12) uniform vec4 uVtCache;
+
+layout(binding = 1) uniform usampler2D uVtPageTable;
+layout(binding = 2) uniform sampler2D uVtPageCache;
 
 out vec4 outColor;
 
+vec3 virtual_texture(vec2 uv)
+{
+	// Level from the footprint of the pixel, in level 0 texels
+	vec2 texels = uv * uVtParams.xy * uVtCache.x;
+	vec2 dx = dFdx(texels), dy = dFdy(texels);
+	float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + uVtParams.w;
+	int level = clamp(int(floor(lod)), 0, int(uVtParams.z) - 1);
+
+	// The page table points at the finest resident page covering uv
+	vec2 wrapped = fract(uv);
+	ivec2 page = ivec2(wrapped * uVtParams.xy) >> level;
+	uvec4 entry = texelFetch(uVtPageTable, page, level);
+
+	vec2 inPage = fract(wrapped * uVtParams.xy / float(1 << entry.z));
+	vec2 cacheTexel = vec2(entry.xy) * (uVtCache.x + 2.0 * uVtCache.y) + uVtCache.y + inPage * uVtCache.x;
+	return textureLod(uVtPageCache, cacheTexel * uVtCache.zw, 0.0).rgb;
+}
+
 void main()
 {
 	vec3 normal = normalize(v2fNormal);
@@ -34,11 +74,19 @@ void main()
 
 	// Texture or gray for base color
 	vec3 baseColor;
-	if (uHasTexture)
+	if (uHasTexture && uVirtualTexture)
+		baseColor = virtual_texture(v2fTexcoord);
+	else if (uHasTexture)
 		baseColor = texture(uTexture, v2fTexcoord).rgb;
 	else
 		baseColor = vec3(0.3, 0.3, 0.3);
 
+	if (uUnlit)
+	{
+		outColor = vec4(uEmissive * baseColor, 1.0);
+		return;
+	}
+
 	// Ambient term
 	vec3 lighting = uSceneAmbient * baseColor;
 
@@ -52,10 +100,10 @@ void main()
 		lighting += diffuse * baseColor; 
 	}
 
-	// 3 Local Point Lights
+	// Local Point Lights
 	float shininess = 20.0;
 
-	for (int i = 0; i < 3; ++i)
+	for (uint i = 0; i < uPointLightCount; ++i)
 	{
 		if (uPointLights[i].enabled)
 		{
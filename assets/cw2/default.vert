@@ -8,14 +8,31 @@ layout(location = 0) uniform mat4 uMVP;
 layout(location = 1) uniform mat3 uNormalMatrix;
 layout(location = 2) uniform mat4 world;
 
+// Quantized vertices (see support/mesh_quantize.hpp): positions are unorm16
+// relative to the mesh bounds, normals octahedral snorm16 in .xy.
+layout(location = 7) uniform bool uQuantized;
+layout(location = 8) uniform vec3 uPositionScale;
+layout(location = 9) uniform vec3 uPositionOffset;
+
 out vec3 v2fNormal;
 out vec2 v2fTexcoord;
 out vec3 v2fworldPos;
 
+vec3 oct_decode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy -= vec2(e.x >= 0.0 ? t : -t, e.y >= 0.0 ? t : -t);
+	return normalize(n);
+}
+
 void main()
 {
-	v2fNormal = normalize(uNormalMatrix * aNormal);
-	v2fworldPos = (world * vec4(aPosition, 1.0)).xyz;
+	vec3 position = uQuantized ? uPositionOffset + uPositionScale * aPosition : aPosition;
+	vec3 normal = uQuantized ? oct_decode(aNormal.xy) : aNormal;
+
+	v2fNormal = normalize(uNormalMatrix * normal);
+	v2fworldPos = (world * vec4(position, 1.0)).xyz;
 	v2fTexcoord = aTexcoord;
-	gl_Position = uMVP * vec4(aPosition, 1.0);
+	gl_Position = uMVP * vec4(position, 1.0);
 }
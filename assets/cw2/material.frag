@@ -4,27 +4,33 @@ flat in int v2fMaterialID;
 in vec3 v2fNormal;
 in vec3 v2fworldPos;
 
+// Per-frame data, shared by all programs (see support/frame_data.hpp).
+// kMaxPointLights must match the C++ side.
+const uint kMaxPointLights = 16u;
+
 struct DirLight {
 	vec3 direction;
-	vec3 color;
 	bool enabled;
+	vec3 color;
 };
 
 struct PointLight {
 	vec3 position;
-	vec3 color;
 	bool enabled;
+	vec3 color;
 };
 
-layout(location = 4) uniform vec3 uSceneAmbient;
-uniform DirLight uGlobalLight;
-uniform PointLight uPointLights[3];
+layout(std140, binding = 0) uniform FrameData {
+	vec3 uCameraPos;
+	uint uPointLightCount;
+	vec3 uSceneAmbient;
+	DirLight uGlobalLight;
+	PointLight uPointLights[kMaxPointLights];
+};
 
 uniform vec3 uMaterialDiffuse[16];
 uniform float uMaterialShine[16];
 
-layout(location = 6) uniform vec3 uCameraPos;
-
 out vec4 outColor;
 
 void main()
@@ -46,10 +52,10 @@ void main()
 		lighting += diffuse; 
 	}
 
-	// 3 Local Point Lights
+	// Local Point Lights
 	float shininess = uMaterialShine[v2fMaterialID]; // Shine per material
 
-	for (int i = 0; i < 3; ++i)
+	for (uint i = 0; i < uPointLightCount; ++i)
 	{
 		if (uPointLights[i].enabled)
 		{
@@ -0,0 +1,26 @@
+#version 430
+
+// Virtual texture feedback (see support/virtual_texture.hpp): writes the
+// page that each fragment would sample, as (x, y, level, 1). Uses the same
+// level selection as virtual_texture() in default.frag; uVtParams.w also
+// compensates for the reduced size of the feedback buffer.
+
+in vec2 v2fTexcoord;
+in vec3 v2fNormal;
+in vec3 v2fworldPos;
+
+layout(location = 11) uniform vec4 uVtParams;
+layout(location = 12) uniform vec4 uVtCache;
+
+out uvec4 outPage;
+
+void main()
+{
+	vec2 texels = v2fTexcoord * uVtParams.xy * uVtCache.x;
+	vec2 dx = dFdx(texels), dy = dFdy(texels);
+	float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + uVtParams.w;
+	int level = clamp(int(floor(lod)), 0, int(uVtParams.z) - 1);
+
+	ivec2 page = ivec2(fract(v2fTexcoord) * uVtParams.xy) >> level;
+	outPage = uvec4(page, level, 1);
+}
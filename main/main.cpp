@@ -2,7 +2,9 @@
 #include <GLFW/glfw3.h>
 
 #include <print>
+#include <memory>
 #include <numbers>
+#include <optional>
 #include <typeinfo>
 #include <stdexcept>
 
@@ -13,6 +15,7 @@
 #include <ctime> 
 #include <vector> 
 #include <cstdio>
+#include <cstdint>
 #include <rapidobj/rapidobj.hpp> 
 #include "../vmlib/vec2.hpp"
 #include "../vmlib/vec3.hpp"
@@ -20,21 +23,49 @@
 
 #include "../support/error.hpp"
 #include "../support/program.hpp"
+#include "../support/frame_data.hpp"
 #include "../support/checkpoint.hpp"
 #include "../support/debug_output.hpp"
+#include "../support/mesh.hpp"
+#include "../support/mesh_file.hpp"
+#include "../support/mesh_layouts.hpp"
+#include "../support/mesh_optimize.hpp"
+#include "../support/mesh_quantize.hpp"
+#include "../support/task_graph.hpp"
+#include "../support/mip_chain.hpp"
+#include "../support/compressed_texture.hpp"
+#include "../support/texture_stream.hpp"
+#include "../support/virtual_texture.hpp"
+#include "../support/terrain_lod.hpp"
+#include "../support/vertex_layout.hpp"
 
 #include "../vmlib/vec4.hpp"
 #include "../vmlib/mat44.hpp"
+#include "../vmlib/column_major.hpp"
 #include "../vmlib/mat33.hpp"
+#include "../vmlib/quat.hpp"
+#include "../vmlib/transform.hpp"
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+#include "../vmlib/vec3_soa.hpp"
 
 #include "defaults.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../third_party/stb/include/stb_image.h"
 
+// Upload the terrain and landing pad with quantized vertices
+//#define ENABLE_QUANTIZED_MESHES
+
+// Texture the terrain with a virtual texture (support/virtual_texture.hpp)
+// instead of streaming the whole mip chain
+//#define ENABLE_VIRTUAL_TEXTURE
+
 //#define ENABLE_GPU_TIMERS
 #ifdef ENABLE_GPU_TIMERS
+#include <map>
 #include <chrono>
+#include <fstream>
 
 static constexpr int TIMESTAMP_POINTS = 5;
 
@@ -47,9 +78,15 @@ struct GPUTimers {
 		uint64_t timestamps[TIMESTAMP_POINTS];
 		double diff_ms[TIMESTAMP_POINTS - 1];
 		int frameIndex;
+		float lodError; // terrain LOD threshold, pixels
+		std::size_t terrainTriangles;
 	};
 	std::vector<Result> results;
 
+	// Terrain LOD state of the frames in flight, per slot
+	std::vector<float> slotLodError;
+	std::vector<std::size_t> slotTerrainTriangles;
+
 } gpuTimers;
 
 static int frameCounter = 0;
@@ -62,6 +99,18 @@ namespace
 {
 	constexpr char const* kWindowTitle = "COMP3811 - CW2";
 
+	// Terrain levels of detail (see kTerrainLod in mesh_layouts.hpp). The
+	// error threshold (in pixels) can be changed with - and =.
+	constexpr float kTerrainLodDefaultError = 2.f;
+	constexpr float kTerrainLodMinError = 0.25f;
+	constexpr float kTerrainLodMaxError = 64.f;
+
+#ifdef ENABLE_QUANTIZED_MESHES
+	constexpr bool kQuantizeMeshes = true;
+#else
+	constexpr bool kQuantizeMeshes = false;
+#endif
+
 	constexpr float kMovementSpeed = 5.f;
 	constexpr float kMouseSens = 0.01f;
 
@@ -72,23 +121,57 @@ namespace
 		Ground = 2
 	};
 
-	struct Particle
-	{
-		Vec3f position;
-		Vec3f velocity;
-		float life;
-		float maxLife;
-	};
-
+	// Particles are stored as a structure of arrays, so that the physics
+	// update in update_particles() runs on full SIMD registers.
 	struct ParticleSystem
 	{
-		std::vector<Particle> particles;
+		Vec3fSoA positions;
+		Vec3fSoA velocities;
+		std::vector<float> life;
+		std::vector<float> maxLife;
+		std::vector<Mat44fCM> models; // per-frame scratch for draw_particles
+		std::vector<Mat44fCM> mvps;
 		GLuint vao = 0;
 		GLuint texture = 0;
 		float emissionTimer = 0.0f;
 
 		ParticleSystem() { 
-			particles.reserve(1024); 
+			positions.reserve(1024);
+			velocities.reserve(1024);
+			life.reserve(1024);
+			maxLife.reserve(1024);
+			models.reserve(1024);
+			mvps.reserve(1024);
+		}
+
+		std::size_t size() const { return life.size(); }
+		bool empty() const { return life.empty(); }
+
+		void emit(Vec3f const& position, Vec3f const& velocity, float ttl)
+		{
+			positions.push_back(position);
+			velocities.push_back(velocity);
+			life.push_back(ttl);
+			maxLife.push_back(ttl);
+		}
+
+		// Removes particle i by moving the last one into its place
+		void kill(std::size_t i)
+		{
+			positions.swap_remove(i);
+			velocities.swap_remove(i);
+			life[i] = life.back();
+			life.pop_back();
+			maxLife[i] = maxLife.back();
+			maxLife.pop_back();
+		}
+
+		void clear()
+		{
+			positions.clear();
+			velocities.clear();
+			life.clear();
+			maxLife.clear();
 		}
 	};
 
@@ -155,6 +238,8 @@ namespace
 		ParticleSystem particles;
 		CameraMode cameraModeR;
 		bool splitScreen = false;
+
+		float terrainLodError = kTerrainLodDefaultError; // pixels
 	};
 
 	void glfw_callback_error_(int, char const*);
@@ -180,17 +265,17 @@ namespace
 		GLFWwindow* window;
 	};
 
-	struct SimpleMeshData
+	// Mesh uploaded by create_vao()
+	struct GpuMesh
 	{
-		std::vector<Vec3f> positions;
-		std::vector<Vec3f> normals;
-		std::vector<Vec2f> texcoords;
-		std::vector<float> materialIds;
-	};
+		GLuint vao = 0;
+		std::size_t count = 0;      // indices, or vertices if not indexed
+		GLenum indexType = GL_NONE; // GL_UNSIGNED_SHORT/INT; GL_NONE if not indexed
 
-	struct Material {
-		Vec3f diffuse;
-		float shine;
+		// Decoding of quantized vertices, see set_vertex_decode()
+		bool quantized = false;
+		Vec3f positionScale{ 1.f, 1.f, 1.f };
+		Vec3f positionOffset{ 0.f, 0.f, 0.f };
 	};
 
 	struct DirectionalLight {
@@ -203,356 +288,807 @@ namespace
 		Vec3f position;
 		Vec3f color;
 		bool enabled;
-	} pointLights[3];
+	};
+	std::vector<PointLight> pointLights; // at most kMaxPointLights are used
+
+	// Per-frame uniform buffer (see frame_data.hpp), with one FrameData per
+	// view, each at an offset that can be bound with glBindBufferRange()
+	struct FrameUniforms {
+		GLuint buffer = 0;
+		GLintptr stride = 0;
+	};
 
 	// Common info required to draw an object
 	struct RenderContext {
 		Mat44f projection;
 		Mat44f cameraView;
+		Mat44fCM projView; // projection * cameraView, for uploads
 		Vec3f camPos;
+
+		// Terrain LOD selection, see select_terrain_lod()
+		Vec3f eyePos;
+		float lodPixelScale;
+		float lodMaxError;
 	};
 
 	// Data for terrain and vehicle
 	struct DefaultData {
-		GLuint vao;
-		std::size_t vertexCount;
+		GpuMesh mesh;
 		GLuint texture;
 		Mat44f model;
+		Mat44fCM modelCM; // same as model, for uploads
+		Aabb3f bounds; // model space
+		TerrainLod const* lod = nullptr; // null: no LOD
+		VirtualTexture const* virtualTexture = nullptr; // replaces texture if set
 	};
 	// Data for pad
 	struct PadData {
-		GLuint vao;
-		std::size_t vertexCount;
+		GpuMesh mesh;
 		std::vector<Material> materials;
+		Aabb3f bounds; // model space
 	};
 
-	SimpleMeshData load_wavefront_obj(char const* path, std::vector<Material>* materials = nullptr)
+	// CPU side of a mesh upload: interleaved vertices and indices, ready for
+	// create_vao(). Built by prepare_vao(), which does not call GL and can
+	// therefore run on any thread. The data is either owned, or that of a
+	// cooked mesh file, which then stays open until the VaoData is released.
+	// Move-only, as the spans point into the storage.
+	struct VaoData
+	{
+		std::span<std::byte const> vertices; // interleaved, see setupAttribs
+		std::size_t vertexCount = 0;
+		void (*setupAttribs)(std::size_t) noexcept = nullptr;
+
+		std::span<std::uint16_t const> indices16; // at most one of these is set
+		std::span<std::uint32_t const> indices32;
+
+		// See GpuMesh
+		bool quantized = false;
+		Vec3f positionScale{ 1.f, 1.f, 1.f };
+		Vec3f positionOffset{ 0.f, 0.f, 0.f };
+
+		// Storage
+		std::vector<std::byte> ownedVertices;
+		std::vector<std::uint16_t> ownedIndices16;
+		std::vector<std::uint32_t> ownedIndices32;
+		std::unique_ptr<MeshFile const> file;
+	};
+
+	// Interleaves a mesh with the given layout. The vertices come from
+	// vertexData (a MeshStreams or a QuantizedMesh), the indices from
+	// meshData. Throws if the mesh lacks a stream that the layout requires.
+	template< typename tLayout, typename tVertexData >
+	VaoData prepare_vao(MeshStreams const& meshData, tVertexData const& vertexData)
+	{
+		using Vertex = typename tLayout::Vertex;
+
+		VaoData ret;
+		ret.vertexCount = vertexData.positions.size();
+		ret.setupAttribs = &tLayout::setup_attribs;
+
+		ret.ownedVertices.resize(ret.vertexCount * sizeof(Vertex));
+		interleave_mesh<tLayout>(std::span(reinterpret_cast<Vertex*>(ret.ownedVertices.data()), ret.vertexCount), vertexData);
+		ret.vertices = ret.ownedVertices;
+
+		// Use 16-bit indices whenever all vertices can be addressed.
+		if (!meshData.indices32.empty() && meshData.positions.size() <= 0x10000)
+			ret.ownedIndices16.assign(meshData.indices32.begin(), meshData.indices32.end());
+		else if (!meshData.indices32.empty())
+			ret.ownedIndices32.assign(meshData.indices32.begin(), meshData.indices32.end());
+		else
+			ret.ownedIndices16.assign(meshData.indices16.begin(), meshData.indices16.end());
+
+		ret.indices16 = ret.ownedIndices16;
+		ret.indices32 = ret.ownedIndices32;
+		return ret;
+	}
+	template< typename tLayout >
+	VaoData prepare_vao(MeshStreams const& meshData)
+	{
+		return prepare_vao<tLayout>(meshData, meshData);
+	}
+
+	// Quantized version. Sets up the decoding of the positions.
+	template< typename tLayout >
+	VaoData prepare_vao(MeshStreams const& meshData, QuantizedMesh const& quantized)
 	{
-		auto result = rapidobj::ParseFile(path);
-		if (result.error)
-			throw Error("Unable to load OBJ file '{}': {}", path, result.error.code.message());
+		VaoData ret = prepare_vao<tLayout, QuantizedMesh>(meshData, quantized);
+		ret.quantized = true;
+		ret.positionScale = quantized.positionScale;
+		ret.positionOffset = quantized.positionOffset;
+		return ret;
+	}
 
-		rapidobj::Triangulate(result);
+	// Uses the interleaved vertices and the indices of a cooked mesh file as
+	// they are, without copies. The file must store its vertices in tLayout.
+	template< typename tLayout >
+	VaoData prepare_vao(std::unique_ptr<MeshFile const> file)
+	{
+		auto const streams = file->streams();
+
+		VaoData ret;
+		ret.vertices = file->vertices();
+		ret.vertexCount = file->header().vertexCount;
+		ret.setupAttribs = &tLayout::setup_attribs;
+		ret.indices16 = streams.indices16;
+		ret.indices32 = streams.indices32;
+		ret.file = std::move(file);
+		return ret;
+	}
 
-		SimpleMeshData ret;
+	// Uploads a mesh prepared by prepare_vao() as a single interleaved
+	// vertex buffer
+	GpuMesh create_vao(VaoData const& data)
+	{
+		GLuint vao = 0;
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
 
-		// only if required
-		if (materials)
+		GpuMesh ret;
+		ret.vao = vao;
+		ret.count = data.vertexCount;
+		ret.quantized = data.quantized;
+		ret.positionScale = data.positionScale;
+		ret.positionOffset = data.positionOffset;
+
+		GLuint vbo = 0;
+		glGenBuffers(1, &vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			data.vertices.size(),
+			data.vertices.data(),
+			GL_STATIC_DRAW
+		);
+		data.setupAttribs(0);
+
+		// Indices. The element buffer binding is part of the VAO state.
+		if (!data.indices16.empty() || !data.indices32.empty())
 		{
-			materials->resize(result.materials.size());
-			for (size_t i = 0; i < result.materials.size(); ++i)
+			GLuint ibo = 0;
+			glGenBuffers(1, &ibo);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+			if (!data.indices16.empty())
+			{
+				glBufferData(
+					GL_ELEMENT_ARRAY_BUFFER,
+					data.indices16.size() * sizeof(std::uint16_t),
+					data.indices16.data(),
+					GL_STATIC_DRAW
+				);
+				ret.indexType = GL_UNSIGNED_SHORT;
+				ret.count = data.indices16.size();
+			}
+			else
 			{
-				auto const& mat = result.materials[i];
-				(*materials)[i].diffuse = Vec3f{mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]};
-				(*materials)[i].shine = float(mat.shininess);
+				glBufferData(
+					GL_ELEMENT_ARRAY_BUFFER,
+					data.indices32.size() * sizeof(std::uint32_t),
+					data.indices32.data(),
+					GL_STATIC_DRAW
+				);
+				ret.indexType = GL_UNSIGNED_INT;
+				ret.count = data.indices32.size();
 			}
 		}
 
-		for (auto const& shape : result.shapes)
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		return ret;
+	}
+
+	// Sets the decoding uniforms of default.vert and material.vert for the
+	// current program
+	void set_vertex_decode(GpuMesh const& mesh)
+	{
+		glUniform1i(7, mesh.quantized);
+		glUniform3f(8, mesh.positionScale.x, mesh.positionScale.y, mesh.positionScale.z);
+		glUniform3f(9, mesh.positionOffset.x, mesh.positionOffset.y, mesh.positionOffset.z);
+	}
+
+	// Draws each tile of a terrain at the level given in levels (skipping
+	// those at kTerrainLodCulled). Ranges that are adjacent in the index
+	// buffer, i.e., neighbouring tiles at the same level, are merged into a
+	// single draw call.
+	void draw_terrain_lod(GpuMesh const& mesh, TerrainLod const& lod, std::span<std::uint8_t const> levels)
+	{
+		std::size_t const indexSize = GL_UNSIGNED_SHORT == mesh.indexType ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+		set_vertex_decode(mesh);
+
+		glBindVertexArray(mesh.vao);
+		auto const range = [&](std::size_t tile) { return levels[tile] * lod.tileCount + tile; };
+
+		for (std::size_t i = 0; i < lod.tileCount; )
 		{
-			for (std::size_t i = 0; i < shape.mesh.indices.size(); ++i)
+			if (kTerrainLodCulled == levels[i])
 			{
-				auto const& idx = shape.mesh.indices[i];
+				++i;
+				continue;
+			}
 
-				// Positions
-				ret.positions.emplace_back(Vec3f{
-					result.attributes.positions[idx.position_index * 3 + 0],
-					result.attributes.positions[idx.position_index * 3 + 1],
-					result.attributes.positions[idx.position_index * 3 + 2]
-					});
+			std::uint32_t const first = lod.firstIndex[range(i)];
+			std::uint32_t end = first + lod.indexCount[range(i)];
+			for (++i; i < lod.tileCount && kTerrainLodCulled != levels[i] && lod.firstIndex[range(i)] == end; ++i)
+				end += lod.indexCount[range(i)];
 
-				// Normals
-				if (idx.normal_index >= 0)
-				{
-					ret.normals.emplace_back(normalize(Vec3f{
-						result.attributes.normals[idx.normal_index * 3 + 0],
-						result.attributes.normals[idx.normal_index * 3 + 1],
-						result.attributes.normals[idx.normal_index * 3 + 2]
-						}));
-				}
+			glDrawElements(GL_TRIANGLES, GLsizei(end - first), mesh.indexType, reinterpret_cast<void const*>(first * indexSize));
+		}
+		glBindVertexArray(0);
+	}
+
+	void draw_mesh(GpuMesh const& mesh)
+	{
+		set_vertex_decode(mesh);
+
+		glBindVertexArray(mesh.vao);
+		if (GL_NONE == mesh.indexType)
+			glDrawArrays(GL_TRIANGLES, 0, GLsizei(mesh.count));
+		else
+			glDrawElements(GL_TRIANGLES, GLsizei(mesh.count), mesh.indexType, nullptr);
+		glBindVertexArray(0);
+	}
+
+	struct LoadedMesh
+	{
+		VaoData vao; // released by upload_mesh()
+		GpuMesh gpu;
+		Aabb3f bounds;
+		std::vector<Material> materials;
+		TerrainLod lod;
+	};
 
-				// Texture coordinates
-				if (idx.texcoord_index >= 0)
+	// Loads a mesh from its cooked version (see asset-cook) if that is
+	// current, and from the OBJ otherwise. The cooked file is mapped, and its
+	// interleaved vertices are uploaded as they are if they have tLayout.
+	// Otherwise, e.g. if the mesh is quantized to tQuantizedLayout first
+	// (ENABLE_QUANTIZED_MESHES), its vertex streams are interleaved.
+	//
+	// With lodOptions, the mesh is split into tiles with levels of detail
+	// (see build_terrain_lod()). The cooked file has them baked in, with the
+	// skirts, unless it was cooked with other options; it is then skipped.
+	//
+	// Does not call GL, so that meshes can be loaded on worker threads. The
+	// result is uploaded with upload_mesh().
+	template< typename tLayout, typename tQuantizedLayout >
+	LoadedMesh load_mesh(char const* name, char const* objPath, char const* cookedPath, TerrainLodOptions const* lodOptions = nullptr)
+	{
+		constexpr bool withMaterials = tLayout::template has_location<3>();
+		static_assert(withMaterials == tQuantizedLayout::template has_location<3>());
+
+		auto const start = Clock::now();
+
+		LoadedMesh ret;
+		char const* from = "OBJ";
+
+		float maxPositionError = 0.f;
+		auto const prepare = [&](MeshStreams const& streams) {
+			if constexpr (kQuantizeMeshes)
+			{
+				QuantizedMesh const quantized = quantize_mesh(streams);
+				maxPositionError = quantized.maxPositionError;
+				return prepare_vao<tQuantizedLayout>(streams, quantized);
+			}
+			else
+			{
+				return prepare_vao<tLayout>(streams);
+			}
+		};
+
+		bool cooked = false;
+		if (is_mesh_file_current(cookedPath, objPath))
+		{
+			try
+			{
+				// The file is moved into the VaoData if that uses its data.
+				auto file = std::make_unique<MeshFile const>(cookedPath);
+				MeshFile const& data = *file;
+
+				if (lodOptions)
 				{
-					ret.texcoords.emplace_back(Vec2f{
-						result.attributes.texcoords[idx.texcoord_index * 2 + 0],
-						result.attributes.texcoords[idx.texcoord_index * 2 + 1]
-						});
+					auto const& lod = data.header().lod;
+					if (lod.tileGrid != lodOptions->tileGrid || lod.levelCount != lodOptions->levelCount)
+						throw Error("'{}' has no LOD with {}x{} tiles and {} levels", cookedPath, lodOptions->tileGrid, lodOptions->tileGrid, lodOptions->levelCount);
+					ret.lod = data.lod();
 				}
 
-				// Materials
-				if (materials)
+				ret.bounds = data.header().bounds;
+				if (!kQuantizeMeshes && mesh_file_layout<tLayout>() == data.header().layout)
+					ret.vao = prepare_vao<tLayout>(std::move(file));
+				else
+					ret.vao = prepare(data.streams());
+				if (withMaterials)
+					ret.materials.assign(data.materials().begin(), data.materials().end());
+
+				from = data.is_mapped() ? "cooked, mapped" : "cooked";
+				cooked = true;
+			}
+			catch (Error const& err)
+			{
+				std::print(stderr, "Warning: {}; falling back to '{}'\n", err.what(), objPath);
+			}
+		}
+
+		if (!cooked)
+		{
+			SimpleMeshData mesh = load_wavefront_obj(objPath, withMaterials ? &ret.materials : nullptr);
+			auto const report = optimize_mesh(mesh);
+			std::print("Optimized {} mesh: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}\n",
+				name, report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+
+			// The skirts of the LOD tiles extend below the mesh, so the
+			// bounds are computed from the final vertices.
+			if (lodOptions)
+				ret.lod = build_terrain_lod(mesh, *lodOptions);
+
+			ret.bounds = make_aabb(mesh.positions);
+			ret.vao = prepare(mesh_streams(mesh));
+		}
+
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		bool const indices16 = !ret.vao.indices16.empty();
+		std::print("Loaded {} mesh ({}): {} vertices, {} indices ({}-bit) in {:.1f} ms\n",
+			name, from, ret.vao.vertexCount, indices16 ? ret.vao.indices16.size() : ret.vao.indices32.size(), indices16 ? 16 : 32, ms);
+		if (!ret.lod.empty())
+		{
+			std::print("  {} tiles x {} levels (vertices include skirts):\n", ret.lod.tileCount, ret.lod.levelCount);
+			for (std::size_t level = 0; level < ret.lod.levelCount; ++level)
+			{
+				std::size_t triangles = 0;
+				float error = 0.f;
+				for (std::size_t tile = 0; tile < ret.lod.tileCount; ++tile)
 				{
-					int faceIndex = int(i / 3);
-					int matId = shape.mesh.material_ids[faceIndex];
-					ret.materialIds.push_back(float(matId));
+					triangles += ret.lod.indexCount[level * ret.lod.tileCount + tile] / 3;
+					error = std::max(error, ret.lod.error[level * ret.lod.tileCount + tile]);
 				}
+				std::print("    level {}: {} triangles, max. error {:.3g}\n", level, triangles, error);
 			}
 		}
+		if (ret.vao.quantized)
+		{
+			std::print("  quantized: {} -> {} bytes per vertex, max. position error {:.3g}\n",
+				tLayout::kStride, tQuantizedLayout::kStride, maxPositionError);
+		}
+		if (!cooked)
+			std::print("  run asset-cook to create '{}' for faster loading\n", cookedPath);
+
 		return ret;
 	}
 
-	GLuint create_vao(SimpleMeshData const& meshData)
+	void upload_mesh(LoadedMesh& mesh)
 	{
-		GLuint vao = 0;
-		glGenVertexArrays(1, &vao);
-		glBindVertexArray(vao);
+		mesh.gpu = create_vao(mesh.vao);
+		mesh.vao = {};
+	}
 
-		// Positions at location 0
-		if (!meshData.positions.empty())
-		{
-			GLuint vbo = 0;
-			glGenBuffers(1, &vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(
-				GL_ARRAY_BUFFER,
-				meshData.positions.size() * sizeof(Vec3f),
-				meshData.positions.data(),
-				GL_STATIC_DRAW
-			);
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-			glEnableVertexAttribArray(0);
+	// RGBA8 image, decoded by decode_image(), and its mip levels, built by
+	// build_mips(). Neither calls GL; see load_texture().
+	struct StbiDeleter
+	{
+		void operator()(stbi_uc* data) const noexcept { stbi_image_free(data); }
+	};
+	struct DecodedImage
+	{
+		int width = 0;
+		int height = 0;
+		std::unique_ptr<stbi_uc, StbiDeleter> rgba;
+		std::vector<MipLevel> mips; // levels 1 and up, see make_srgb_mip_chain()
+	};
+
+	DecodedImage decode_image(const char* filename)
+	{
+		auto const start = Clock::now();
+
+		int width, height, channels;
+		std::unique_ptr<stbi_uc, StbiDeleter> data(stbi_load(filename, &width, &height, &channels, 4));
+
+		if (!data) {
+			throw Error("Failed to load texture file '{}'", filename);
 		}
 
-		// Normals at location 1
-		if (!meshData.normals.empty())
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		std::print("Decoded texture '{}' ({}x{}) in {:.1f} ms\n", filename, width, height, ms);
+
+		return { width, height, std::move(data), {} };
+	}
+
+	void build_mips(DecodedImage& image)
+	{
+		auto const start = Clock::now();
+
+		std::size_t const bytes = std::size_t(image.width) * std::size_t(image.height) * 4;
+		image.mips = make_srgb_mip_chain(std::span(image.rgba.get(), bytes), std::size_t(image.width), std::size_t(image.height));
+
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		std::print("Built {} mip levels in {:.1f} ms\n", image.mips.size(), ms);
+	}
+
+	// Loads the BC7 mip chain of an image from its cache file (see
+	// compressed_texture.hpp), if that is current. Otherwise, the image is
+	// decoded, mipmapped and encoded, and the cache file is (re-)written for the
+	// next run. Like load_mesh(), this does not call GL.
+	CompressedTexture load_texture(const char* imagePath, const char* cachePath)
+	{
+		if (is_texture_file_current(cachePath, imagePath))
 		{
-			GLuint vbo = 0;
-			glGenBuffers(1, &vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(
-				GL_ARRAY_BUFFER,
-				meshData.normals.size() * sizeof(Vec3f),
-				meshData.normals.data(),
-				GL_STATIC_DRAW
-			);
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-			glEnableVertexAttribArray(1);
+			try
+			{
+				auto const start = Clock::now();
+				CompressedTexture ret = read_texture_file(cachePath);
+
+				auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+				std::print("Loaded cached texture '{}' ({}x{}, {} levels) in {:.1f} ms\n", cachePath, ret.width, ret.height, ret.levels.size(), ms);
+				return ret;
+			}
+			catch (Error const& err)
+			{
+				std::print(stderr, "Warning: {}; falling back to '{}'\n", err.what(), imagePath);
+			}
 		}
 
-		// Texcoords at location 2
-		if (!meshData.texcoords.empty())
+		DecodedImage image = decode_image(imagePath);
+		build_mips(image);
+
+		auto const start = Clock::now();
+
+		std::size_t const bytes = std::size_t(image.width) * std::size_t(image.height) * 4;
+		CompressedTexture ret = compress_bc7_srgb(std::span(image.rgba.get(), bytes), std::size_t(image.width), std::size_t(image.height), image.mips);
+
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		std::print("Encoded {} levels as BC7 in {:.1f} ms\n", ret.levels.size(), ms);
+
+		try
 		{
-			GLuint vbo = 0;
-			glGenBuffers(1, &vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(
-				GL_ARRAY_BUFFER,
-				meshData.texcoords.size() * sizeof(Vec2f),
-				meshData.texcoords.data(),
-				GL_STATIC_DRAW
-			);
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-			glEnableVertexAttribArray(2);
+			write_texture_file(cachePath, ret, fingerprint_source(imagePath));
 		}
-
-		// Material IDs at location 3
-		if (!meshData.materialIds.empty())
+		catch (Error const& err)
 		{
-			GLuint vbo = 0;
-			glGenBuffers(1, &vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, vbo);
-			glBufferData(
-				GL_ARRAY_BUFFER,
-				meshData.materialIds.size() * sizeof(float),
-				meshData.materialIds.data(),
-				GL_STATIC_DRAW
-			);
-			glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
-			glEnableVertexAttribArray(3);
+			std::print(stderr, "Warning: {}; the texture will be encoded again on the next run\n", err.what());
 		}
 
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		return vao;
+		return ret;
 	}
 
-	GLuint loadTexture(const char* filename)
+	// Writes the pages of an image to a virtual texture file (see
+	// virtual_texture_file.hpp), unless that is current. Does not call GL.
+	void build_virtual_texture(const char* imagePath, const char* pagesPath)
 	{
-		int width, height, channels;
-		stbi_uc* data = stbi_load(filename, &width, &height, &channels, 4);
+		if (is_virtual_texture_file_current(pagesPath, imagePath))
+			return;
 
-		if (!data) {
-			throw Error("Failed to load texture file '{}'", filename);
-		}
+		DecodedImage image = decode_image(imagePath);
+		build_mips(image);
 
-		GLuint textureID;
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
+		auto const start = Clock::now();
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		std::size_t const bytes = std::size_t(image.width) * std::size_t(image.height) * 4;
+		write_virtual_texture_file(pagesPath, std::span(image.rgba.get(), bytes), std::size_t(image.width), std::size_t(image.height), image.mips, fingerprint_source(imagePath));
+
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		std::print("Encoded virtual texture pages to '{}' in {:.1f} ms\n", pagesPath, ms);
+	}
+
+	void create_virtual_texture(std::optional<VirtualTexture>& texture, const char* pagesPath)
+	{
+		auto const start = Clock::now();
+
+		texture.emplace(pagesPath);
+
+		VtLayout const& layout = texture->layout();
+		std::size_t const cacheBytes = std::size_t(texture->cache_size()) * texture->cache_size(); // BC7: one byte per texel
+		std::size_t const allBytes = std::size_t(layout.page_count()) * kVtPageBytes;
+
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		auto const mib = [] (std::size_t bytes) { return float(bytes) / (1024.f * 1024.f); };
+		std::print("Created virtual texture in {:.1f} ms: {}x{} texels, {} pages in {} levels; page cache {:.1f} MiB instead of {:.1f} MiB\n",
+			ms, layout.width(), layout.height(), layout.page_count(), layout.level_count(), mib(cacheBytes), mib(allBytes));
+	}
+
+	void set_virtual_texture_uniforms(VirtualTexture const& texture, float lodBias)
+	{
+		VtLayout const& layout = texture.layout();
+		float const cacheTexel = 1.f / float(texture.cache_size());
+
+		glUniform4f(11, float(layout.pages_x(0)), float(layout.pages_y(0)), float(layout.level_count()), lodBias);
+		glUniform4f(12, float(kVtPageSize), float(kVtPageBorder), cacheTexel, cacheTexel);
+	}
+
+	// Bytes of the terrain texture uploaded per frame once loading is done, see
+	// StreamingTexture. Zero uploads the whole texture while loading.
+	constexpr std::size_t kTextureStreamBudget = 2*1024*1024;
+
+	void create_texture(std::optional<StreamingTexture>& texture, CompressedTexture&& image)
+	{
+		auto const start = Clock::now();
+
+		std::size_t uncompressed = 0;
+		for (std::size_t i = 0; i < image.levels.size(); ++i)
+			uncompressed += std::size_t(std::max(image.width >> i, 1u)) * std::size_t(std::max(image.height >> i, 1u)) * 4;
+		std::size_t const compressed = image.size_bytes();
 
+		texture.emplace(std::move(image), kTextureStreamBudget);
+
+		glBindTexture(GL_TEXTURE_2D, texture->texture());
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-		stbi_image_free(data);
+		auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+		auto const mib = [] (std::size_t bytes) { return float(bytes) / (1024.f * 1024.f); };
+		std::print("Created compressed texture in {:.1f} ms, levels {}-{} resident: {:.1f} MiB instead of {:.1f} MiB as RGBA8 ({:.1f} MiB saved)\n",
+			ms, texture->resident_level(), texture->level_count() - 1, mib(compressed), mib(uncompressed), mib(uncompressed - compressed));
+	}
+
+	// Frame shown while the startup tasks run: a progress bar, drawn with
+	// scissored clears so that it needs neither shaders nor buffers
+	void draw_loading_frame(int fbWidth, int fbHeight, float progress)
+	{
+		glViewport(0, 0, fbWidth, fbHeight);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		int const barWidth = fbWidth / 2;
+		int const barHeight = std::max(4, fbHeight / 60);
+		int const x = (fbWidth - barWidth) / 2;
+		int const y = (fbHeight - barHeight) / 2;
+
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(x, y, barWidth, barHeight);
+		glClearColor(0.1f, 0.1f, 0.1f, 1.f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		glScissor(x, y, int(float(barWidth) * progress), barHeight);
+		glClearColor(0.9f, 0.9f, 0.6f, 1.f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
 
-		return textureID;
+		glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
 	}
 
-	void setLighting(GLuint programId, DirectionalLight const& globalLight, PointLight const* pointLights)
+	FrameUniforms create_frame_uniforms(std::size_t views)
 	{
-		// Global Directional Light
-		GLint locDir = glGetUniformLocation(programId, "uGlobalLight.direction");
-		GLint locColor = glGetUniformLocation(programId, "uGlobalLight.color");
-		GLint locEnabled = glGetUniformLocation(programId, "uGlobalLight.enabled");
+		GLint alignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
 
-		glUniform3fv(locDir, 1, &globalLight.direction.x);
-		glUniform3fv(locColor, 1, &globalLight.color.x);
-		glUniform1i(locEnabled, globalLight.enabled);
+		FrameUniforms ret;
+		ret.stride = (GLintptr(sizeof(FrameData)) + alignment - 1) / alignment * alignment;
 
-		// 3 Local Point Lights
-		std::string base;
-		GLint locPos;
-		for (std::size_t i = 0; i < 3; ++i)
-		{
-			base = "uPointLights[" + std::to_string(i) + "].";
-			locPos = glGetUniformLocation(programId, (base + "position").c_str());
-			locColor = glGetUniformLocation(programId, (base + "color").c_str());
-			locEnabled = glGetUniformLocation(programId, (base + "enabled").c_str());
+		glGenBuffers(1, &ret.buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, ret.buffer);
+		glBufferData(GL_UNIFORM_BUFFER, ret.stride * GLsizeiptr(views), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-			glUniform3fv(locPos, 1, &pointLights[i].position.x);
-			glUniform3fv(locColor, 1, &pointLights[i].color.x);
-			glUniform1i(locEnabled, pointLights[i].enabled);
-		}
+		return ret;
+	}
+
+	// The programs must declare FrameData exactly as frame_data.hpp does
+	void check_frame_data_block(ShaderProgram const& program, char const* name)
+	{
+		auto const block = program.uniform_block("FrameData");
+		if (!block)
+			throw Error("Program '{}' has no active FrameData block", name);
+		if (GLint(sizeof(FrameData)) != block.dataSize || GLint(kFrameDataBinding) != block.binding)
+			throw Error("FrameData block of program '{}' does not match frame_data.hpp ({} bytes at binding {}, expected {} at {})", name, block.dataSize, block.binding, sizeof(FrameData), kFrameDataBinding);
+	}
+
+	// Writes the camera and lights for a view, and binds them for the
+	// following draws
+	void set_frame_uniforms(FrameUniforms const& uniforms, std::size_t view, RenderContext const& ctx)
+	{
+		FrameData data{};
+		data.cameraPos = ctx.camPos;
+		data.sceneAmbient = Vec3f{ 0.05f, 0.05f, 0.05f };
+		data.globalLight = { globalLight.direction, globalLight.enabled, globalLight.color, 0.f };
+
+		std::size_t const count = std::min(pointLights.size(), kMaxPointLights);
+		data.pointLightCount = std::uint32_t(count);
+		for (std::size_t i = 0; i < count; ++i)
+			data.pointLights[i] = { pointLights[i].position, pointLights[i].enabled, pointLights[i].color, 0.f };
+
+		GLintptr const offset = uniforms.stride * GLintptr(view);
+		glBindBuffer(GL_UNIFORM_BUFFER, uniforms.buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(data), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, kFrameDataBinding, uniforms.buffer, offset, sizeof(data));
 	}
 
 	void drawTerrain(
 		RenderContext const& ctx,
-		GLuint programId,
+		ShaderProgram const& program,
 		GLuint texture,
-		GLuint vao,
-		std::size_t vertexCount
+		VirtualTexture const* virtualTexture,
+		GpuMesh const& mesh,
+		TerrainLod const* lod,
+		std::span<std::uint8_t const> lodLevels
 	)
 	{
-		Mat44f model = kIdentity44f;
-		Mat44f mvp = ctx.projection * ctx.cameraView * model;
-		Mat33f normalMatrix = mat44_to_mat33(transpose(invert(model)));
-
-		glUseProgram(programId);
-		setLighting(programId, globalLight, pointLights);
-		glUniformMatrix4fv(0, 1, GL_TRUE, mvp.v);
-		glUniformMatrix3fv(1, 1, GL_TRUE, normalMatrix.v);
-		glUniformMatrix4fv(2, 1, GL_TRUE, model.v);
-		glUniform3f(4, 0.05f, 0.05f, 0.05f);
+		Mat44fCM model = kIdentity44fCM;
+		Mat44fCM mvp = ctx.projView * model;
+		Mat33fCM normalMatrix = normal_matrix(model);
+
+		glUseProgram(program.programId());
+		glUniformMatrix4fv(0, 1, GL_FALSE, mvp.v);
+		glUniformMatrix3fv(1, 1, GL_FALSE, normalMatrix.v);
+		glUniformMatrix4fv(2, 1, GL_FALSE, model.v);
 		glUniform1i(5, true);
-		glUniform3f(6, ctx.camPos.x, ctx.camPos.y, ctx.camPos.z);
 
 		// Bind texture to texture unit0 and set sampler uniform
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, texture);
-		glUniform1i(glGetUniformLocation(programId, "uTexture"), 0);
+		glUniform1i(program.uniform("uTexture"), 0);
 
-		glBindVertexArray(vao);
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertexCount));
-		glBindVertexArray(0);
+		// Virtual texture: page table and cache on units 1 and 2 (see
+		// default.frag)
+		glUniform1i(10, nullptr != virtualTexture);
+		if (virtualTexture)
+		{
+			set_virtual_texture_uniforms(*virtualTexture, 0.f);
+
+			glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, virtualTexture->page_table());
+			glActiveTexture(GL_TEXTURE2);
+			glBindTexture(GL_TEXTURE_2D, virtualTexture->page_cache());
+			glActiveTexture(GL_TEXTURE0);
+		}
+
+		if (lod)
+			draw_terrain_lod(mesh, *lod, lodLevels);
+		else
+			draw_mesh(mesh);
+	}
+
+	// Tile culling and LOD selection, in the terrain's model space. Fills
+	// lodLevels (one per tile) and triangles. Returns false if no tile is
+	// visible.
+	bool select_terrain_tiles(RenderContext const& ctx, DefaultData const& terrain, std::span<std::uint8_t> lodLevels, std::size_t& triangles)
+	{
+		Mat44f const terrainProjView = ctx.projection * ctx.cameraView * terrain.model;
+		std::vector<std::uint8_t> visibleTiles(terrain.lod->tileCount);
+		bool const visible = 0 != cull_aabbs(make_frustum(terrainProjView), terrain.lod->bounds, visibleTiles);
+
+		Vec4f const eye = invert_affine(terrain.model) * Vec4f{ ctx.eyePos.x, ctx.eyePos.y, ctx.eyePos.z, 1.f };
+		triangles = select_terrain_lod(*terrain.lod, Vec3f{ eye.x, eye.y, eye.z }, ctx.lodPixelScale, ctx.lodMaxError, visibleTiles, lodLevels);
+		return visible;
+	}
+
+	// Draws the terrain into the feedback buffer of its virtual texture,
+	// which must be bound (see VirtualTexture::begin_feedback())
+	void drawTerrainFeedback(RenderContext const& ctx, ShaderProgram const& program, DefaultData const& terrain)
+	{
+		std::vector<std::uint8_t> lodLevels(terrain.lod ? terrain.lod->tileCount : 0);
+		std::size_t triangles = 0;
+		if (terrain.lod && !select_terrain_tiles(ctx, terrain, lodLevels, triangles))
+			return;
+
+		Mat44fCM mvp = ctx.projView * terrain.modelCM;
+
+		glUseProgram(program.programId());
+		glUniformMatrix4fv(0, 1, GL_FALSE, mvp.v);
+		glUniformMatrix3fv(1, 1, GL_FALSE, normal_matrix(terrain.modelCM).v);
+		glUniformMatrix4fv(2, 1, GL_FALSE, terrain.modelCM.v);
+		set_virtual_texture_uniforms(*terrain.virtualTexture, terrain.virtualTexture->feedback_lod_bias());
+
+		if (terrain.lod)
+			draw_terrain_lod(terrain.mesh, *terrain.lod, lodLevels);
+		else
+			draw_mesh(terrain.mesh);
 	}
 
 	void drawLandingPad(
 		RenderContext const& ctx,
-		GLuint programId,
-		Mat44f const& model,
+		ShaderProgram const& program,
+		Mat44fCM const& model,
 		std::vector<Material> const& materials,
-		GLuint vao,
-		std::size_t vertexCount
+		GpuMesh const& mesh
 	)
 	{
-		Mat44f mvp = ctx.projection * ctx.cameraView * model;
-		Mat33f normalMatrix = mat44_to_mat33(transpose(invert(model)));
+		Mat44fCM mvp = ctx.projView * model;
+		Mat33fCM normalMatrix = normal_matrix(model);
 
-		glUseProgram(programId);
-		setLighting(programId, globalLight, pointLights);
-		glUniformMatrix4fv(0, 1, GL_TRUE, mvp.v);
-		glUniformMatrix3fv(1, 1, GL_TRUE, normalMatrix.v);
-		glUniform3f(4, 0.05f, 0.05f, 0.05f);
-		glUniform3f(6, ctx.camPos.x, ctx.camPos.y, ctx.camPos.z);
+		glUseProgram(program.programId());
+		glUniformMatrix4fv(0, 1, GL_FALSE, mvp.v);
+		glUniformMatrix3fv(1, 1, GL_FALSE, normalMatrix.v);
 
 		// Pass material colors
-		GLint loc;
-		std::string name;
 		for (size_t i = 0; i < materials.size(); ++i)
 		{
-			name = "uMaterialDiffuse[" + std::to_string(i) + "]";
-			loc = glGetUniformLocation(programId, name.c_str());
-			glUniform3fv(loc, 1, &materials[i].diffuse.x);
-
-			name = "uMaterialShine[" + std::to_string(i) + "]";
-			loc = glGetUniformLocation(programId, name.c_str());
-			glUniform1f(loc, materials[i].shine);
+			glUniform3fv(program.uniform("uMaterialDiffuse[]", i), 1, &materials[i].diffuse.x);
+			glUniform1f(program.uniform("uMaterialShine[]", i), materials[i].shine);
 		}
 
-		glBindVertexArray(vao);
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertexCount));
-		glBindVertexArray(0);
+		draw_mesh(mesh);
 	}
 
 	void drawSpaceVehicle(
 		RenderContext const& ctx,
-		GLuint programId,
-		Mat44f const& model,
-		GLuint vao,
-		std::size_t vertexCount
+		ShaderProgram const& program,
+		Mat44fCM const& model,
+		GpuMesh const& mesh
 	)
 	{
-		Mat44f mvp = ctx.projection * ctx.cameraView * model;
-		Mat33f normalMatrix = mat44_to_mat33(transpose(invert(model)));
+		Mat44fCM mvp = ctx.projView * model;
+		Mat33fCM normalMatrix = normal_matrix(model);
 
-		glUseProgram(programId);
-		glUniformMatrix4fv(0, 1, GL_TRUE, mvp.v);
-		glUniformMatrix3fv(1, 1, GL_TRUE, normalMatrix.v);
-		setLighting(programId, globalLight, pointLights);
-		glUniform3f(4, 0.05f, 0.05f, 0.05f);
+		glUseProgram(program.programId());
+		glUniformMatrix4fv(0, 1, GL_FALSE, mvp.v);
+		glUniformMatrix3fv(1, 1, GL_FALSE, normalMatrix.v);
 		glUniform1i(5, false);
 
 		glDisable(GL_CULL_FACE);
 
-		glBindVertexArray(vao);
-		glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertexCount));
-		glBindVertexArray(0);
+		draw_mesh(mesh);
 	}
 
-	void drawScene(
+	// Returns the number of terrain triangles drawn
+	std::size_t drawScene(
 		RenderContext const& ctx,
 		DefaultData const& terrain,
 		PadData const& pad,
 		DefaultData const& vehicle,
-		GLuint const& defaultProgId,
-		GLuint const& padProgId
+		ShaderProgram const& defaultProg,
+		ShaderProgram const& padProg
 	)
 	{
-		Mat44f padModel;
+		Vec3f const padPositions[2] = {
+			Vec3f{ 10.f, -0.97f, 45.f },
+			Vec3f{ 20.f, -0.97f, -50.f }
+		};
+		Mat44f const padModels[2] = { make_translation(padPositions[0]), make_translation(padPositions[1]) };
+		Mat44fCM const padModelsCM[2] = { make_translation_cm(padPositions[0]), make_translation_cm(padPositions[1]) };
+
+		// Frustum culling: test the world space bounds of all objects at once
+		Frustumf const frustum = make_frustum(ctx.projection * ctx.cameraView);
+		Aabb3f const worldBounds[4] = {
+			transform(terrain.model, terrain.bounds),
+			transform(padModels[0], pad.bounds),
+			transform(padModels[1], pad.bounds),
+			transform(vehicle.model, vehicle.bounds)
+		};
+		std::uint8_t visible[4];
+		cull_aabbs(frustum, worldBounds, visible);
+
+		// Terrain tiles: culling and LOD selection, in the terrain's model
+		// space
+		std::size_t terrainTriangles = 0;
+		std::vector<std::uint8_t> lodLevels(terrain.lod ? terrain.lod->tileCount : 0);
+		if (visible[0] && terrain.lod && !select_terrain_tiles(ctx, terrain, lodLevels, terrainTriangles))
+			visible[0] = 0;
 
 		#ifdef ENABLE_GPU_TIMERS
 			slot = frameCounter % gpuTimers.ringSize;
 			glQueryCounter(gpuTimers.queries[slot * gpuTimers.points + 0], GL_TIMESTAMP);
 		#endif
 
-		drawTerrain(ctx, defaultProgId, terrain.texture, terrain.vao, terrain.vertexCount);
+		if (visible[0])
+			drawTerrain(ctx, defaultProg, terrain.texture, terrain.virtualTexture, terrain.mesh, terrain.lod, lodLevels);
 
 		#ifdef ENABLE_GPU_TIMERS
 		// task 1.2
 			glQueryCounter(gpuTimers.queries[slot * gpuTimers.points + 1], GL_TIMESTAMP);
 		#endif
 
-		padModel = make_translation(Vec3f{ 10.f, -0.97f, 45.f });
-		drawLandingPad(ctx, padProgId, padModel, pad.materials, pad.vao, pad.vertexCount);
-
-		padModel = make_translation(Vec3f{ 20.f, -0.97f, -50.f });
-		drawLandingPad(ctx, padProgId, padModel, pad.materials, pad.vao, pad.vertexCount);
+		for (std::size_t i = 0; i < 2; ++i)
+		{
+			if (visible[1 + i])
+				drawLandingPad(ctx, padProg, padModelsCM[i], pad.materials, pad.mesh);
+		}
 
 		#ifdef ENABLE_GPU_TIMERS
 		// task 1.4
 			glQueryCounter(gpuTimers.queries[slot * gpuTimers.points + 2], GL_TIMESTAMP);
 		#endif
 
-		drawSpaceVehicle(ctx, defaultProgId, vehicle.model, vehicle.vao, vehicle.vertexCount);
+		if (visible[3])
+			drawSpaceVehicle(ctx, defaultProg, vehicle.modelCM, vehicle.mesh);
 		#ifdef ENABLE_GPU_TIMERS
 		// task 1.5
 			glQueryCounter(gpuTimers.queries[slot * gpuTimers.points + 3], GL_TIMESTAMP);
 		#endif
+
+		return terrainTriangles;
 	}
 
 	SimpleMeshData create_cylinder(float radius = 0.5f, float height = 1.0f, int segments = 32)
@@ -840,19 +1376,17 @@ namespace
 
 	void append_transformed_mesh(SimpleMeshData& dest, const SimpleMeshData& src, const Mat44f& transform)
 	{
-		Mat33f normalTransform = mat44_to_mat33(transpose(invert(transform)));
+		Mat33f normalTransform = normal_matrix(transform);
 
-		for (std::size_t i = 0; i < src.positions.size(); ++i)
-		{
-			Vec4f pos = transform * Vec4f{ src.positions[i].x, src.positions[i].y, src.positions[i].z, 1.0f };
-			dest.positions.push_back(Vec3f{ pos.x, pos.y, pos.z });
+		// Grow once, then transform straight into the new tail
+		std::size_t const posBase = dest.positions.size();
+		dest.positions.resize(posBase + src.positions.size());
+		transform_points(transform, src.positions, std::span(dest.positions).subspan(posBase));
 
-			if (i < src.normals.size())
-			{
-				Vec3f normal = normalTransform * src.normals[i];
-				dest.normals.push_back(normalize(normal));
-			}
-		}
+		std::size_t const normalCount = std::min(src.normals.size(), src.positions.size());
+		std::size_t const normalBase = dest.normals.size();
+		dest.normals.resize(normalBase + normalCount);
+		transform_normals(normalTransform, std::span(src.normals).first(normalCount), std::span(dest.normals).subspan(normalBase));
 	}
 
 	SimpleMeshData create_space_vehicle()
@@ -916,6 +1450,7 @@ namespace
 	{
 		Vec3f position;
 		Vec3f direction;
+		Quatf orientation;
 		float speed;
 	};
 
@@ -973,6 +1508,9 @@ namespace
 			result.direction = Vec3f{ 0.0f, 1.0f, 0.0f };
 		}
 
+		// Orientation: the vehicle's +Y axis points along the flight direction
+		result.orientation = make_quat_align_y(result.direction);
+
 		result.speed = 30.0f * (s * (1.0f - s)) * 4.0f;
 
 		return result;
@@ -1018,12 +1556,20 @@ namespace
 
 	GLuint create_particle_quad_vao()
 	{
-		float vertices[] = {
-			-0.5f, -0.5f, 0.0f,   0.f, 1.f, 0.f,   0.0f, 0.0f,
-			 0.5f, -0.5f, 0.0f,   0.f, 1.f, 0.f,   1.0f, 0.0f,
-			 0.5f,  0.5f, 0.0f,   0.f, 1.f, 0.f,   1.0f, 1.0f,
-			-0.5f,  0.5f, 0.0f,   0.f, 1.f, 0.f,   0.0f, 1.0f
+		Vec3f const positions[] = {
+			{ -0.5f, -0.5f, 0.0f },
+			{  0.5f, -0.5f, 0.0f },
+			{  0.5f,  0.5f, 0.0f },
+			{ -0.5f,  0.5f, 0.0f }
+		};
+		Vec3f const normals[] = {
+			{ 0.f, 1.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 1.f, 0.f }
+		};
+		Vec2f const texcoords[] = {
+			{ 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f }
 		};
+		auto const vertices = interleave<TexturedVertexLayout>(positions, normals, texcoords);
+
 		unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
 
 		GLuint vao = 0, vbo = 0, ebo = 0;
@@ -1034,20 +1580,12 @@ namespace
 		glBindVertexArray(vao);
 
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STATIC_DRAW);
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-		// Loc 0: position
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
-		// Loc 1: normal
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
-		// Loc 2: uv
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glEnableVertexAttribArray(2);
+		TexturedVertexLayout::setup_attribs();
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1071,60 +1609,54 @@ namespace
 			for (int i = 0; i < particlesToEmit; ++i)
 			{
 				// Cap particle count
-				if (ps.particles.size() >= 1024) break;
-
-				Particle p;
-				p.position = exhaustPos;
+				if (ps.size() >= 1024) break;
 
 				// Random spread and speed variation of particles
 				float spreadX = ((rand() % 200) - 100) / 100.0f;
 				float spreadZ = ((rand() % 200) - 100) / 100.0f;
 				float speedVariation = ((rand() % 100) / 100.0f); 
 
-				p.velocity = Vec3f{
+				Vec3f velocity{
 					spreadX * 1.5f,
 					-3.0f - speedVariation * 2.0f,
 					spreadZ * 1.5f
 				};
 
 				// Randomise TTL
-				p.life = p.maxLife = 1.0f + ((rand() % 100) / 100.0f) * 0.5f; 
-				ps.particles.push_back(p);
+				float ttl = 1.0f + ((rand() % 100) / 100.0f) * 0.5f; 
+				ps.emit(exhaustPos, velocity, ttl);
 			}
 		}
 		else if (!state.animation.isActive)
 		{
-			ps.particles.clear();
+			ps.clear();
 			ps.emissionTimer = 0.0f;
 		}
 
 		// Particle physics 
 		Vec3f gravity{ 0.0f, -1.0f, 0.0f }; 
 
-		for (size_t i = 0; i < ps.particles.size(); )
-		{
-			auto& p = ps.particles[i];
+		add(ps.velocities, gravity * dt, ps.velocities);
+		madd(dt, ps.velocities, ps.positions, ps.positions); // p += dt * v
 
-			p.velocity += gravity * dt;
-			p.position += p.velocity * dt;
-			p.life -= dt;
+		for (size_t i = 0; i < ps.size(); )
+		{
+			ps.life[i] -= dt;
 
-			if (p.life <= 0.0f)
-			{
-				ps.particles[i] = ps.particles.back();
-				ps.particles.pop_back();
-			}
+			if (ps.life[i] <= 0.0f)
+				ps.kill(i);
 			else ++i;
 		}
 	}
 
-	void draw_particles(State_& state, Mat44f const& view, Mat44f const& proj,
+	void draw_particles(State_& state, Mat44fCM const& projView,
 		Vec3f const& camRight, Vec3f const& camUp)
 	{
 		auto& ps = state.particles;
-		if (ps.particles.empty()) return;
+		if (ps.empty()) return;
 
-		glUseProgram(state.progTex->programId());
+		ShaderProgram const& program = *state.progTex;
+		glUseProgram(program.programId());
 
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_ONE, GL_ONE); 
@@ -1133,63 +1665,53 @@ namespace
 
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, ps.texture);
-		glUniform1i(glGetUniformLocation(state.progTex->programId(), "uTexture"), 0);
+		glUniform1i(program.uniform("uTexture"), 0);
 		glUniform1i(5, true); 
+		glUniform1i(10, false);
+		set_vertex_decode(GpuMesh{});
 
-		GLint origGlobalEnabled;
-		glGetUniformiv(state.progTex->programId(),
-			glGetUniformLocation(state.progTex->programId(), "uGlobalLight.enabled"),
-			&origGlobalEnabled);
-
-		// Disable lighting for particles
-		glUniform3f(glGetUniformLocation(state.progTex->programId(), "uGlobalLight.color"), 0.f, 0.f, 0.f);
-		glUniform1i(glGetUniformLocation(state.progTex->programId(), "uGlobalLight.enabled"), 0);
-
-		for (int i = 0; i < 3; ++i)
-		{
-			std::string base = "uPointLights[" + std::to_string(i) + "].";
-			glUniform1i(glGetUniformLocation(state.progTex->programId(), (base + "enabled").c_str()), 0);
-		}
+		// Particles are unlit; the lights in FrameData are left alone
+		glUniform1i(13, true);
 
 		glBindVertexArray(ps.vao);
 
 		Vec3f camForward = normalize(cross(camUp, camRight));
 
-		// Draw all particles
-		for (const auto& p : ps.particles)
+		// Build all particle transforms first, so that the MVPs can be
+		// computed in one batch (proj*view is shared by all particles).
+		ps.models.resize(ps.size());
+		ps.mvps.resize(ps.size());
+
+		for (std::size_t i = 0; i < ps.size(); ++i)
 		{
+			Vec3f const position = ps.positions[i];
+
 			// Particle size variation
-			float lifeRatio = p.life / p.maxLife;
+			float lifeRatio = ps.life[i] / ps.maxLife[i];
 			float scale = 0.5f * (0.3f + 0.7f * lifeRatio); // Scale from 0.3 to 1.0
 
-			Mat44f model = kIdentity44f;
-
-			model.v[0] = camRight.x * scale;
-			model.v[4] = camRight.y * scale;
-			model.v[8] = camRight.z * scale;
-			model.v[12] = 0.0f;
-
-			model.v[1] = camUp.x * scale;
-			model.v[5] = camUp.y * scale;
-			model.v[9] = camUp.z * scale;
-			model.v[13] = 0.0f;
+			// Column-major: one column per line
+			ps.models[i] = Mat44fCM{ {
+				camRight.x * scale, camRight.y * scale, camRight.z * scale, 0.0f,
+				camUp.x * scale, camUp.y * scale, camUp.z * scale, 0.0f,
+				camForward.x * scale, camForward.y * scale, camForward.z * scale, 0.0f,
+				position.x, position.y, position.z, 1.0f
+			} };
+		}
 
-			model.v[2] = camForward.x * scale;
-			model.v[6] = camForward.y * scale;
-			model.v[10] = camForward.z * scale;
-			model.v[14] = 0.0f;
+		mul_batch(projView, ps.models, ps.mvps);
 
-			model.v[3] = p.position.x;
-			model.v[7] = p.position.y;
-			model.v[11] = p.position.z;
-			model.v[15] = 1.0f;
+		// The identity is the same in either layout
+		Mat33f normalMatrix = kIdentity33f;
+		glUniformMatrix3fv(1, 1, GL_FALSE, normalMatrix.v);
 
-			Mat44f mvp = proj * view * model;
-			glUniformMatrix4fv(0, 1, GL_TRUE, mvp.v);
-			glUniformMatrix4fv(2, 1, GL_TRUE, model.v);
+		// Draw all particles
+		for (std::size_t i = 0; i < ps.size(); ++i)
+		{
+			float lifeRatio = ps.life[i] / ps.maxLife[i];
 
-			Mat33f normalMatrix = kIdentity33f;
-			glUniformMatrix3fv(1, 1, GL_TRUE, normalMatrix.v);
+			glUniformMatrix4fv(0, 1, GL_FALSE, ps.mvps[i].v);
+			glUniformMatrix4fv(2, 1, GL_FALSE, ps.models[i].v);
 
 			// Color Shift
 			float intensity = lifeRatio * lifeRatio; 
@@ -1199,6 +1721,7 @@ namespace
 		}
 
 		glBindVertexArray(0);
+		glUniform1i(13, false);
 
 		glDepthMask(GL_TRUE);
 		glDisable(GL_BLEND);
@@ -1219,7 +1742,8 @@ namespace
 		Vec3f const& up,
 		Vec3f const& right,
 		State_::Animation_ const& animation,
-		Vec3f const& currentVehiclePos
+		Vec3f const& currentVehiclePos,
+		Vec3f const& currentVehicleDir
 	)
 	{
 		CamFinal result;
@@ -1253,10 +1777,8 @@ namespace
 				Vec3f target = currentVehiclePos;
 				Vec3f vehicleDir = Vec3f{ 0.f, 1.f, 0.f };
 
-				AnimationState as = compute_vehicle_animation(animation.time,
-					animation.startPosition);
-				if (length(as.direction) > 0.001f)
-					vehicleDir = normalize(as.direction);
+				if (length(currentVehicleDir) > 0.001f)
+					vehicleDir = normalize(currentVehicleDir);
 
 				result.camPosFinal = target - (vehicleDir * 20.0f) + Vec3f{ 0.0f, 5.0f, 0.0f };
 
@@ -1316,6 +1838,15 @@ namespace
 		unsigned char r, g, b, a;
 	};
 
+	using UIVertexLayout = VertexLayout<
+		VertexAttrib<0, Vec2f>,
+		VertexAttrib<1, Vec2f>,
+		VertexAttrib<2, std::array<std::uint8_t, 4>, true>
+	>;
+	static_assert(UIVertexLayout::kStride == sizeof(UIVertex));
+	static_assert(UIVertexLayout::kOffsets[1] == offsetof(UIVertex, u));
+	static_assert(UIVertexLayout::kOffsets[2] == offsetof(UIVertex, r));
+
 	std::vector<UIVertex> g_uiVerts;
 
 	// Shader compilation and program linking helpers
@@ -1522,14 +2053,7 @@ namespace
 		glBindVertexArray(state.ui.vao);
 		glBindBuffer(GL_ARRAY_BUFFER, state.ui.vbo);
 
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)0);
-
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(UIVertex), (void*)(2 * sizeof(float)));
-
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(UIVertex), (void*)(4 * sizeof(float)));
+		UIVertexLayout::setup_attribs();
 
 		glBindVertexArray(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -1737,10 +2261,6 @@ int main() try
 	// Initial Camera mode
 	state.cameraMode = CameraMode::Free;
 
-	glfwSetMouseButtonCallback(window, &glfw_callback_mouse_button_);
-	glfwSetKeyCallback( window, &glfw_callback_key_ );
-	glfwSetCursorPosCallback(window, &glfw_callback_motion_);
-
 	// Set up drawing stuff
 	glfwMakeContextCurrent( window );
 	glfwSwapInterval( 1 ); // V-Sync is on.
@@ -1753,6 +2273,8 @@ int main() try
 	#ifdef ENABLE_GPU_TIMERS
 	// initialise GPU timers
 	gpuTimers.queries.resize(gpuTimers.ringSize * gpuTimers.points);
+	gpuTimers.slotLodError.resize(gpuTimers.ringSize);
+	gpuTimers.slotTerrainTriangles.resize(gpuTimers.ringSize);
 	glGenQueries((GLsizei)gpuTimers.queries.size(), gpuTimers.queries.data());
 	#endif
 
@@ -1788,28 +2310,7 @@ int main() try
 	glViewport( 0, 0, iwidth, iheight );
 
 	// Other initialization & loading
-	
-	// Load shader programs
-	ShaderProgram progDefault({
-		{ GL_VERTEX_SHADER, "assets/cw2/default.vert" },
-		{ GL_FRAGMENT_SHADER, "assets/cw2/default.frag" }
-	});
-	state.progTex = &progDefault;
-
-	ShaderProgram progPads({
-		{GL_VERTEX_SHADER, "assets/cw2/material.vert"},
-		{GL_FRAGMENT_SHADER, "assets/cw2/material.frag"}
-	});
-	state.progMat = &progPads;
-
-	// UI Initialization
-	glfwGetFramebufferSize(window, &iwidth, &iheight);
-	ui_init(state, iwidth, iheight);
-	
-	// Particles Initialization
 	std::srand(static_cast<unsigned>(std::time(nullptr)));
-	state.particles.vao = create_particle_quad_vao();
-	state.particles.texture = create_procedural_texture();
 
 	// Initialize camera
 	state.camControl.phi = 0.0f;
@@ -1817,9 +2318,11 @@ int main() try
 
 	// Initialize light sources
 	globalLight  = { Vec3f{0.1f, 1.f, -1.f}, Vec3f{ 0.9f, 0.9f, 0.6f }, true };
-	pointLights[0] = { Vec3f{10.f, 5.f, 50.f}, Vec3f{0.f, 1.f, 1.f}, true };
-	pointLights[1] = { Vec3f{15.f, 5.f, 42.f}, Vec3f{1.f, 1.f, 0.2f}, true };
-	pointLights[2] = { Vec3f{5.f, 5.f, 42.f}, Vec3f{1.f, 0.f, 1.f}, true };
+	pointLights = {
+		{ Vec3f{10.f, 5.f, 50.f}, Vec3f{0.f, 1.f, 1.f}, true },
+		{ Vec3f{15.f, 5.f, 42.f}, Vec3f{1.f, 1.f, 0.2f}, true },
+		{ Vec3f{5.f, 5.f, 42.f}, Vec3f{1.f, 0.f, 1.f}, true }
+	};
 
 	// Animation state
 	Vec3f vehiclePosition{ 10.f, -0.5f, 45.f };
@@ -1829,34 +2332,132 @@ int main() try
 	state.animation.time = 0.0f;
 	state.animation.startPosition = vehiclePosition;
 
-	auto last = Clock::now();
-
 	float angle = 0.f;
 
 	OGL_CHECKPOINT_ALWAYS();
 	
-	// Load terrain mesh and create VAO
-	SimpleMeshData terrainMesh = load_wavefront_obj("assets/cw2/parlahti.obj");
-	std::print("Loaded terrain mesh: {} vertices, {} texcoords\n", terrainMesh.positions.size(), terrainMesh.texcoords.size());
-	GLuint terrainVAO = create_vao(terrainMesh);
-	std::size_t terrainVertexCount = terrainMesh.positions.size();
+	// Load shaders, meshes and textures with a task graph: parsing, mesh
+	// processing and image decoding run on worker threads, and the GL work on
+	// this thread, in between frames of a loading screen. The input callbacks
+	// are installed once everything is loaded, as they use the programs.
+	std::optional<ShaderProgram> progDefault, progPads, progFeedback;
+	FrameUniforms frameUniforms;
+	LoadedMesh terrainMesh, padMesh;
+	SimpleMeshData vehicleMesh;
+	VaoData vehicleVao;
+	CompressedTexture textureImage;
+
+	GpuMesh vehicleGpu;
+	std::optional<StreamingTexture> terrainTexture;
+	std::optional<VirtualTexture> virtualTexture; // ENABLE_VIRTUAL_TEXTURE
+
+	TaskGraph startup;
+	using enum TaskGraph::Thread;
+
+	startup.add("shaders", Main, [&] {
+		progDefault.emplace(std::vector<ShaderProgram::ShaderSource>{
+			{ GL_VERTEX_SHADER, "assets/cw2/default.vert" },
+			{ GL_FRAGMENT_SHADER, "assets/cw2/default.frag" }
+		});
+		state.progTex = &*progDefault;
+
+		progPads.emplace(std::vector<ShaderProgram::ShaderSource>{
+			{GL_VERTEX_SHADER, "assets/cw2/material.vert"},
+			{GL_FRAGMENT_SHADER, "assets/cw2/material.frag"}
+		});
+		state.progMat = &*progPads;
+
+		check_frame_data_block(*progDefault, "default");
+		check_frame_data_block(*progPads, "material");
+		frameUniforms = create_frame_uniforms(2); // left and right views
+
+		#ifdef ENABLE_VIRTUAL_TEXTURE
+		progFeedback.emplace(std::vector<ShaderProgram::ShaderSource>{
+			{ GL_VERTEX_SHADER, "assets/cw2/default.vert" },
+			{ GL_FRAGMENT_SHADER, "assets/cw2/vt_feedback.frag" }
+		});
+		#endif
+	});
+	startup.add("ui", Main, [&] {
+		glfwGetFramebufferSize(window, &iwidth, &iheight);
+		ui_init(state, iwidth, iheight);
+	});
+	startup.add("particles", Main, [&] {
+		state.particles.vao = create_particle_quad_vao();
+		state.particles.texture = create_procedural_texture();
+	});
 
-	// Load landing_pad mesh and create VAO
-	std::vector<Material> padMaterials;
-	SimpleMeshData padMesh = load_wavefront_obj("assets/cw2/landingpad.obj", &padMaterials);
-	std::print("Loaded landing_pad mesh: {} vertices, {} texcoords\n", padMesh.positions.size(), padMesh.texcoords.size());
-	GLuint padVAO = create_vao(padMesh);
-	std::size_t padVertexCount = padMesh.positions.size();
+	auto const terrainLoad = startup.add("terrain: load", Worker, [&] {
+		terrainMesh = load_mesh<TexturedVertexLayout, QuantizedTexturedVertexLayout>("terrain", "assets/cw2/parlahti.obj", "assets/cw2/parlahti.cw2mesh", &kTerrainLod);
+	});
+	auto const padLoad = startup.add("landing pad: load", Worker, [&] {
+		padMesh = load_mesh<MaterialVertexLayout, QuantizedMaterialVertexLayout>("landing_pad", "assets/cw2/landingpad.obj", "assets/cw2/landingpad.cw2mesh");
+	});
+	auto const vehicleBuild = startup.add("vehicle: build", Worker, [&] {
+		vehicleMesh = create_space_vehicle();
+		MeshOptimizeReport const vehicleReport = optimize_mesh(vehicleMesh);
+		std::print("Created space vehicle: {} vertices, {} indices (ACMR {:.3f} -> {:.3f})\n",
+			vehicleMesh.positions.size(), vehicleMesh.indices.size(), vehicleReport.before.acmr, vehicleReport.after.acmr);
+		vehicleVao = prepare_vao<UntexturedVertexLayout>(mesh_streams(vehicleMesh));
+	});
+	#ifdef ENABLE_VIRTUAL_TEXTURE
+	auto const texturePages = startup.add("texture: pages", Worker, [&] {
+		build_virtual_texture("assets/cw2/L4343A-4k.jpeg", "assets/cw2/L4343A-4k.cw2vt");
+	});
+	#else
+	auto const textureLoad = startup.add("texture: load", Worker, [&] {
+		textureImage = load_texture("assets/cw2/L4343A-4k.jpeg", "assets/cw2/L4343A-4k.ktx");
+	});
+	#endif
 
-	// Create space vehicle mesh and create VAO
-	SimpleMeshData vehicleMesh = create_space_vehicle();
-	std::print("Created space vehicle: {} vertices\n", vehicleMesh.positions.size());
-	GLuint vehicleVAO = create_vao(vehicleMesh);
-	std::size_t vehicleVertexCount = vehicleMesh.positions.size();
+	startup.add("terrain: upload", Main, [&] { upload_mesh(terrainMesh); }, { terrainLoad });
+	startup.add("landing pad: upload", Main, [&] { upload_mesh(padMesh); }, { padLoad });
+	startup.add("vehicle: upload", Main, [&] {
+		vehicleGpu = create_vao(vehicleVao);
+		vehicleVao = {};
+	}, { vehicleBuild });
+	#ifdef ENABLE_VIRTUAL_TEXTURE
+	startup.add("texture: virtual", Main, [&] {
+		create_virtual_texture(virtualTexture, "assets/cw2/L4343A-4k.cw2vt");
+	}, { texturePages });
+	#else
+	startup.add("texture: upload", Main, [&] {
+		create_texture(terrainTexture, std::move(textureImage));
+		textureImage = {};
+	}, { textureLoad });
+	#endif
 
-	// Load texture
-	GLuint texture = loadTexture("assets/cw2/L4343A-4k.jpeg");
+	startup.start();
+	while (!startup.done())
+	{
+		glfwPollEvents();
+		if (glfwWindowShouldClose(window))
+			return 0; // waits for running worker tasks
+
+		// Leave the rest of the frame to GL work queued by the tasks
+		startup.run_main(std::chrono::milliseconds(8));
+
+		glfwGetFramebufferSize(window, &iwidth, &iheight);
+		draw_loading_frame(iwidth, iheight, startup.progress());
+		glfwSwapBuffers(window);
+	}
+	startup.print_report();
+
+	glfwSetMouseButtonCallback(window, &glfw_callback_mouse_button_);
+	glfwSetKeyCallback( window, &glfw_callback_key_ );
+	glfwSetCursorPosCallback(window, &glfw_callback_motion_);
+
+	GpuMesh terrainGpu = terrainMesh.gpu;
+	Aabb3f terrainBounds = terrainMesh.bounds;
 
+	GpuMesh padGpu = padMesh.gpu;
+	std::vector<Material> padMaterials = std::move(padMesh.materials);
+	Aabb3f padBounds = padMesh.bounds;
+
+	Aabb3f vehicleBounds = make_aabb(vehicleMesh.positions);
+
+	auto last = Clock::now();
+	auto const textureStreamStart = last;
 
 	OGL_CHECKPOINT_ALWAYS();
 
@@ -1890,6 +2491,20 @@ int main() try
 			ui_resize(state, nwidth, nheight);
 		}
 
+		// Upload the next part of the terrain texture, or the pages that the
+		// previous frames asked for
+		if (virtualTexture)
+			virtualTexture->update();
+		else if (!terrainTexture->done())
+		{
+			terrainTexture->update();
+			if (terrainTexture->done())
+			{
+				auto const ms = std::chrono::duration<float, std::milli>(Clock::now() - textureStreamStart).count();
+				std::print("Streamed remaining texture levels in {:.1f} ms\n", ms);
+			}
+		}
+
 		// Update state
 		auto const now = Clock::now();
 		float dt = std::chrono::duration_cast<Secondsf>(now - last).count();
@@ -1959,57 +2574,43 @@ int main() try
 		}
 
 		Vec3f currentVehiclePos;
+		Vec3f currentVehicleDir{ 0.0f, 1.0f, 0.0f };
 		Mat44f vehicleModel;
+		Mat44fCM vehicleModelCM;
+
+		Vec3f const vehicleScale{ 0.5f, 0.5f, 0.5f };
 
 		if (anim.isActive)
 		{
 			AnimationState animState = compute_vehicle_animation(anim.time, anim.startPosition);
 			currentVehiclePos = animState.position;
+			currentVehicleDir = animState.direction;
 
-			Vec3f dir = normalize(animState.direction);
-			Vec3f worldUp{ 0.0f, 1.0f, 0.0f };
-
-			if (std::abs(dot(dir, worldUp)) > 0.99f)
-			{
-				worldUp = Vec3f{ 1.0f, 0.0f, 0.0f };
-			}
-
-			Vec3f yAxis = dir;
-			Vec3f zAxis = normalize(cross(yAxis, worldUp));
-			Vec3f xAxis = normalize(cross(zAxis, yAxis));
-
-			Mat44f rotation{
-				xAxis.x, yAxis.x, zAxis.x, 0.0f,
-				xAxis.y, yAxis.y, zAxis.y, 0.0f,
-				xAxis.z, yAxis.z, zAxis.z, 0.0f,
-				0.0f,    0.0f,    0.0f,    1.0f
-			};
-
-			vehicleModel = make_translation(currentVehiclePos)
-				* rotation
-				* make_scaling(0.5f, 0.5f, 0.5f);
+			vehicleModel = make_trs(currentVehiclePos, animState.orientation, vehicleScale);
+			vehicleModelCM = make_trs_cm(currentVehiclePos, animState.orientation, vehicleScale);
 		}
 		else
 		{
 			currentVehiclePos = vehiclePosition;
-			vehicleModel = make_translation(vehiclePosition)
-				* make_scaling(0.5f, 0.5f, 0.5f)
-				* make_rotation_y(kPi);
+			Quatf const orientation = make_quat_axis_angle(Vec3f{ 0.0f, 1.0f, 0.0f }, kPi);
+			vehicleModel = make_trs(vehiclePosition, orientation, vehicleScale);
+			vehicleModelCM = make_trs_cm(vehiclePosition, orientation, vehicleScale);
 		}
 
 
 		// Draw scene(s)
 		OGL_CHECKPOINT_DEBUG();
-		DefaultData terrain = { terrainVAO, terrainVertexCount, texture, kIdentity44f };
-		PadData pad = { padVAO, padVertexCount, padMaterials };
-		DefaultData vehicle = { vehicleVAO, vehicleVertexCount, 0, vehicleModel };
+		DefaultData terrain = { terrainGpu, terrainTexture ? terrainTexture->texture() : 0, kIdentity44f, kIdentity44fCM, terrainBounds, terrainMesh.lod.empty() ? nullptr : &terrainMesh.lod, virtualTexture ? &*virtualTexture : nullptr };
+		PadData pad = { padGpu, padMaterials, padBounds };
+		DefaultData vehicle = { vehicleGpu, 0, vehicleModel, vehicleModelCM, vehicleBounds };
 
 		// Update particles
 		update_particles(state, dt, currentVehiclePos, vehicleModel, anim.isActive&& anim.isPlaying);
 
 		// Render main or left screen
-		CamFinal result = processCameraMode(state.cameraMode, cam.position, basis.forward, basis.up, basis.right, state.animation, currentVehiclePos);
+		CamFinal result = processCameraMode(state.cameraMode, cam.position, basis.forward, basis.up, basis.right, state.animation, currentVehiclePos, currentVehicleDir);
 		Mat44f camera_view = construct_camera_view(result.camForwardFinal, result.camUpFinal, result.camRightFinal, result.camPosFinal);
+		Mat44fCM camera_viewCM = construct_camera_view_cm(result.camForwardFinal, result.camUpFinal, result.camRightFinal, result.camPosFinal);
 
 		float aspectRatio = fbwidth / float(fbheight);
 		if (state.splitScreen)
@@ -2020,6 +2621,7 @@ int main() try
 			aspectRatio,
 			0.1f, 1000.0f
 		);
+		Mat44fCM projectionCM = make_perspective_projection_cm(60.f * kPi / 180.f, aspectRatio, 0.1f, 1000.0f);
 
 		// Clear and draw frame
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -2029,15 +2631,20 @@ int main() try
 			width = fbwidth * 0.5f;
 
 		glViewport(0, 0, width, fbheight);
-		RenderContext baseContext = { projection, camera_view, cam.position };
-		drawScene(baseContext, terrain, pad, vehicle, progDefault.programId(), progPads.programId());
-		draw_particles(state, camera_view, projection, result.camRightFinal, result.camUpFinal);
+		float const lodPixelScale = terrain_lod_pixel_scale(60.f * kPi / 180.f, float(fbheight));
+
+		RenderContext baseContext = { projection, camera_view, projectionCM * camera_viewCM, cam.position, result.camPosFinal, lodPixelScale, state.terrainLodError };
+		set_frame_uniforms(frameUniforms, 0, baseContext);
+		std::size_t terrainTriangles = drawScene(baseContext, terrain, pad, vehicle, *progDefault, *progPads);
+		draw_particles(state, baseContext.projView, result.camRightFinal, result.camUpFinal);
 
 		// Render right screen if necessary
+		std::optional<RenderContext> contextR;
 		if (state.splitScreen)
 		{
-			CamFinal resultR = processCameraMode(state.cameraModeR, camR.position, basisR.forward, basisR.up, basisR.right, state.animation, currentVehiclePos);
+			CamFinal resultR = processCameraMode(state.cameraModeR, camR.position, basisR.forward, basisR.up, basisR.right, state.animation, currentVehiclePos, currentVehicleDir);
 			Mat44f right_view = construct_camera_view(resultR.camForwardFinal, resultR.camUpFinal, resultR.camRightFinal, resultR.camPosFinal);
+			Mat44fCM right_viewCM = construct_camera_view_cm(resultR.camForwardFinal, resultR.camUpFinal, resultR.camRightFinal, resultR.camPosFinal);
 
 			float halfWidth = (fbwidth * 0.5f);
 
@@ -2047,11 +2654,28 @@ int main() try
 				aspectRatio,
 				0.1f, 1000.0f
 			);
+			Mat44fCM projectionRCM = make_perspective_projection_cm(60.f * kPi / 180.f, aspectRatio, 0.1f, 1000.0f);
 
 			glViewport(halfWidth, 0, halfWidth, fbheight);
-			RenderContext baseContextR = { projectionR, right_view, camR.position };
-			drawScene(baseContextR, terrain, pad, vehicle, progDefault.programId(), progPads.programId());
-			draw_particles(state, right_view, projectionR, resultR.camRightFinal, resultR.camUpFinal);
+			RenderContext baseContextR = { projectionR, right_view, projectionRCM * right_viewCM, camR.position, resultR.camPosFinal, lodPixelScale, state.terrainLodError };
+			set_frame_uniforms(frameUniforms, 1, baseContextR);
+			terrainTriangles += drawScene(baseContextR, terrain, pad, vehicle, *progDefault, *progPads);
+			draw_particles(state, baseContextR.projView, resultR.camRightFinal, resultR.camUpFinal);
+			contextR = baseContextR;
+		}
+
+		// Virtual texture feedback for the views drawn above
+		if (virtualTexture)
+		{
+			virtualTexture->begin_feedback(int(fbwidth), int(fbheight));
+			virtualTexture->feedback_viewport(0, 0, int(width), int(fbheight));
+			drawTerrainFeedback(baseContext, *progFeedback, terrain);
+			if (contextR)
+			{
+				virtualTexture->feedback_viewport(int(width), 0, int(width), int(fbheight));
+				drawTerrainFeedback(*contextR, *progFeedback, terrain);
+			}
+			virtualTexture->end_feedback();
 		}
 
 		// Draw UI overlay
@@ -2065,6 +2689,8 @@ int main() try
 		#ifdef ENABLE_GPU_TIMERS
 		// finished rendering
 			glQueryCounter(gpuTimers.queries[slot * gpuTimers.points + 4], GL_TIMESTAMP);
+			gpuTimers.slotLodError[slot] = state.terrainLodError;
+			gpuTimers.slotTerrainTriangles[slot] = terrainTriangles;
 		#endif
 
 		OGL_CHECKPOINT_DEBUG();
@@ -2082,6 +2708,8 @@ int main() try
 		{
 			GPUTimers::Result r;
 			r.frameIndex = frameCounter - gpuTimers.ringSize + 1;
+			r.lodError = gpuTimers.slotLodError[read];
+			r.terrainTriangles = gpuTimers.slotTerrainTriangles[read];
 			for (int p = 0; p < gpuTimers.points; ++p)
 			{
 				GLuint q = gpuTimers.queries[read * gpuTimers.points + p];
@@ -2108,7 +2736,7 @@ int main() try
 		}
 
 		std::ofstream csv("gpu_stats.csv");
-		csv << "frame,terrain,pads,vehicle,full\n";
+		csv << "frame,terrain,pads,vehicle,full,lod_error,terrain_triangles\n";
 		for (auto& r : gpuTimers.results)
 		{	
 			r.diff_ms[3] = double(r.timestamps[4] - r.timestamps[0]) * 1e-6;
@@ -2116,22 +2744,41 @@ int main() try
 				<< r.diff_ms[0] << ","
 				<< r.diff_ms[1] << ","
 				<< r.diff_ms[2] << ","
-				<< r.diff_ms[3] << "\n";
+				<< r.diff_ms[3] << ","
+				<< r.lodError << ","
+				<< r.terrainTriangles << "\n";
 		}
 		csv.close();
 
+		// Averages per terrain LOD threshold
+		struct LodSummary { std::size_t frames = 0; double terrainMs = 0., fullMs = 0., triangles = 0.; };
+		std::map<float, LodSummary> lodSummary;
+		for (auto const& r : gpuTimers.results)
+		{
+			auto& sum = lodSummary[r.lodError];
+			++sum.frames;
+			sum.terrainMs += r.diff_ms[0];
+			sum.fullMs += r.diff_ms[3];
+			sum.triangles += double(r.terrainTriangles);
+		}
+		for (auto const& [error, sum] : lodSummary)
+		{
+			std::print("Terrain LOD {:5.2f} px: {:9.0f} triangles, terrain {:.3f} ms, frame {:.3f} ms ({} frames)\n",
+				error, sum.triangles / sum.frames, sum.terrainMs / sum.frames, sum.fullMs / sum.frames, sum.frames);
+		}
+
 	#endif
 
 	// Cleanup.
-	glDeleteVertexArrays(1, &terrainVAO);
-	glDeleteVertexArrays(1, &padVAO);
-	glDeleteVertexArrays(1, &vehicleVAO);
+	glDeleteVertexArrays(1, &terrainGpu.vao);
+	glDeleteVertexArrays(1, &padGpu.vao);
+	glDeleteVertexArrays(1, &vehicleGpu.vao);
 
-	glDeleteTextures(1, &texture);
 	glDeleteTextures(1, &state.particles.texture);
+	glDeleteBuffers(1, &frameUniforms.buffer);
 
-	glDeleteProgram(progDefault.programId());
-	glDeleteProgram(progPads.programId());
+	glDeleteProgram(progDefault->programId());
+	glDeleteProgram(progPads->programId());
 	ui_cleanup(state);
 	
 	return 0;
@@ -2297,6 +2944,14 @@ namespace
 			// Split Screen Toggle
 			if (GLFW_KEY_V == aKey && GLFW_PRESS == aAction)
 				state->splitScreen = !state->splitScreen;
+
+			// Terrain LOD error threshold
+			if ((GLFW_KEY_MINUS == aKey || GLFW_KEY_EQUAL == aKey) && GLFW_PRESS == aAction)
+			{
+				float& error = state->terrainLodError;
+				error = std::clamp(GLFW_KEY_MINUS == aKey ? 0.5f * error : 2.f * error, kTerrainLodMinError, kTerrainLodMaxError);
+				std::print("Terrain LOD error threshold: {} px\n", error);
+			}
 		}
 
 		if (GLFW_PRESS == aAction)
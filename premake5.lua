@@ -74,6 +74,28 @@ workspace "COMP3811-glcode"
 
 defines( "SOLUTION_CODE=1" )
 
+-- vmlib SIMD backend (see vmlib/simd.hpp). "auto" follows the target ISA.
+newoption {
+	trigger = "vmlib-simd",
+	value = "BACKEND",
+	description = "SIMD backend used by vmlib",
+	default = "auto",
+	allowed = {
+		{ "auto", "Widest backend supported by the target" },
+		{ "scalar", "Portable scalar code" },
+		{ "sse", "SSE" },
+		{ "avx2", "AVX2 + FMA" }
+	}
+}
+
+filter "options:vmlib-simd=scalar"
+	defines( "VMLIB_CONF_SIMD=0" )
+filter "options:vmlib-simd=sse"
+	defines( "VMLIB_CONF_SIMD=1" )
+filter "options:vmlib-simd=avx2"
+	defines( "VMLIB_CONF_SIMD=2" )
+filter "*"
+
 
 -- Third party dependencies
 include "third_party" 
@@ -93,10 +115,11 @@ project "main"
 	files( sources )
 
 	dependson "main-shaders"
+	dependson "asset-cook"
 	dependson "x-rapidobj"
 
-	links "vmlib"
 	links "support"
+	links "vmlib"
 
 	links "x-stb"
 	links "x-glad"
@@ -135,6 +158,59 @@ project "vmlib-test"
 
 	links "x-catch2"
 
+project "support-test"
+	local sources = { 
+		"support-test/**.cpp",
+		"support-test/**.hpp",
+		"support-test/**.hxx",
+		"support-test/**.inl"
+	}
+
+	kind "ConsoleApp"
+	location "support-test"
+
+	files( sources )
+
+	links "support"
+	links "vmlib"
+
+	links "x-catch2"
+
+project "vmlib-bench"
+	local sources = { 
+		"vmlib-bench/**.cpp",
+		"vmlib-bench/**.hpp",
+		"vmlib-bench/**.hxx",
+		"vmlib-bench/**.inl"
+	}
+
+	kind "ConsoleApp"
+	location "vmlib-bench"
+
+	files( sources )
+
+	links "vmlib"
+
+	links "x-catch2"
+
+project "asset-cook"
+	local sources = { 
+		"asset-cook/**.cpp",
+		"asset-cook/**.hpp",
+		"asset-cook/**.hxx",
+		"asset-cook/**.inl"
+	}
+
+	kind "ConsoleApp"
+	location "asset-cook"
+
+	files( sources )
+
+	dependson "x-rapidobj"
+
+	links "support"
+	links "vmlib"
+
 project "support"
 	local sources = { 
 		"support/**.cpp",
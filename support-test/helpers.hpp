@@ -0,0 +1,63 @@
+#ifndef HELPERS_HPP
+#define HELPERS_HPP
+
+#include <span>
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdint>
+
+#include "../support/mesh.hpp"
+
+// aSize x aSize quads with unit spacing in XZ, two triangles per quad, front
+// facing towards +Y. Vertex (x,z) has index z*(aSize+1)+x and the texture
+// coordinates (x,z). The heights are a gentle swell, so that the grid is not
+// perfectly flat.
+inline SimpleMeshData make_grid(std::size_t aSize) {
+	SimpleMeshData ret;
+
+	std::size_t const side = aSize + 1;
+	for (std::size_t z = 0; z < side; ++z) {
+		for (std::size_t x = 0; x < side; ++x) {
+			float const fx = float(x), fz = float(z);
+			ret.positions.emplace_back(Vec3f{ fx, 2.f * std::sin(0.05f * fx) * std::cos(0.07f * fz), fz });
+			ret.normals.emplace_back(Vec3f{ 0.f, 1.f, 0.f });
+			ret.texcoords.emplace_back(Vec2f{ fx, fz });
+		}
+	}
+
+	for (std::size_t z = 0; z < aSize; ++z) {
+		for (std::size_t x = 0; x < aSize; ++x) {
+			auto const v00 = std::uint32_t(z * side + x);
+			auto const v10 = v00 + 1;
+			auto const v01 = v00 + std::uint32_t(side);
+			auto const v11 = v01 + 1;
+			ret.indices.insert(ret.indices.end(), { v00, v01, v10, v10, v01, v11 });
+		}
+	}
+
+	return ret;
+}
+
+// triangle rotated so that its smallest index comes first; keeps the winding
+using Triangle = std::array<std::uint32_t, 3>;
+
+inline Triangle make_triangle(std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+	if (b < a && b < c) return { b, c, a };
+	if (c < a && c < b) return { c, a, b };
+	return { a, b, c };
+}
+
+// triangles of an index buffer, in a canonical order
+inline std::vector<Triangle> sorted_triangles(std::span<std::uint32_t const> aIndices) {
+	std::vector<Triangle> ret;
+	for (std::size_t i = 0; i + 2 < aIndices.size(); i += 3)
+		ret.emplace_back(make_triangle(aIndices[i], aIndices[i + 1], aIndices[i + 2]));
+
+	std::ranges::sort(ret);
+	return ret;
+}
+
+#endif // HELPERS_HPP
@@ -0,0 +1,117 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include <cstring>
+
+#include "../support/mesh_file.hpp"
+#include "../support/mesh_layouts.hpp"
+#include "../support/terrain_lod.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	template< typename tLayout >
+	std::vector<std::byte> interleave_bytes_( MeshStreams const& aMesh )
+	{
+		std::vector<typename tLayout::Vertex> vertices( aMesh.positions.size() );
+		interleave_mesh<tLayout>( std::span( vertices ), aMesh );
+
+		auto const bytes = std::as_bytes( std::span( vertices ) );
+		return std::vector<std::byte>( bytes.begin(), bytes.end() );
+	}
+
+	// The vector types have no operator==
+	template< typename tType >
+	bool same_bytes_( std::span<tType const> aA, std::vector<tType> const& aB )
+	{
+		return std::ranges::equal( std::as_bytes( aA ), std::as_bytes( std::span( aB ) ) );
+	}
+}
+
+TEST_CASE("Mesh file round trip", "[mesh_file]")
+{
+	auto const mesh = make_grid( 8 );
+	auto const vertices = interleave_bytes_<TexturedVertexLayout>( mesh_streams( mesh ) );
+	Material const materials[] = { { { 1.f, 0.5f, 0.25f }, 16.f } };
+
+	auto const path = std::filesystem::temp_directory_path() / "support-test.cw2mesh";
+	write_mesh_file( path, mesh, materials, mesh_file_layout<TexturedVertexLayout>(), vertices, TerrainLod{}, TerrainLodOptions{}, SourceFingerprint{} );
+
+	{
+		MeshFile const file( path );
+		auto const& hdr = file.header();
+		auto const streams = file.streams();
+
+		REQUIRE( hdr.vertexCount == mesh.positions.size() );
+		REQUIRE( 2 == hdr.indexSize );
+		REQUIRE( hdr.layout == mesh_file_layout<TexturedVertexLayout>() );
+		REQUIRE( hdr.layout != mesh_file_layout<MaterialVertexLayout>() );
+		REQUIRE( file.lod().empty() );
+
+		SECTION( "streams" )
+		{
+			REQUIRE( same_bytes_( streams.positions, mesh.positions ) );
+			REQUIRE( same_bytes_( streams.normals, mesh.normals ) );
+			REQUIRE( same_bytes_( streams.texcoords, mesh.texcoords ) );
+			REQUIRE( streams.materialIds.empty() );
+			REQUIRE( std::ranges::equal( streams.indices16, mesh.indices ) );
+			REQUIRE( streams.indices32.empty() );
+		}
+
+		SECTION( "interleaved vertices match the streams" )
+		{
+			REQUIRE( std::ranges::equal( file.vertices(), vertices ) );
+			REQUIRE( std::ranges::equal( file.vertices(), interleave_bytes_<TexturedVertexLayout>( streams ) ) );
+			REQUIRE( 0 == reinterpret_cast<std::uintptr_t>(file.vertices().data()) % kMeshFileAlign );
+		}
+
+		SECTION( "materials" )
+		{
+			REQUIRE( 1 == file.materials().size() );
+			REQUIRE( 0 == std::memcmp( file.materials().data(), materials, sizeof(materials) ) );
+		}
+	}
+
+	std::filesystem::remove( path );
+}
+
+TEST_CASE("Mesh file with terrain LOD", "[mesh_file][terrain_lod]")
+{
+	TerrainLodOptions const options{ .tileGrid = 4, .levelCount = 3 };
+
+	auto mesh = make_grid( 32 );
+	auto const lod = build_terrain_lod( mesh, options );
+	auto const vertices = interleave_bytes_<TexturedVertexLayout>( mesh_streams( mesh ) );
+
+	auto const path = std::filesystem::temp_directory_path() / "support-test-lod.cw2mesh";
+	write_mesh_file( path, mesh, {}, mesh_file_layout<TexturedVertexLayout>(), vertices, lod, options, SourceFingerprint{} );
+
+	{
+		MeshFile const file( path );
+		auto const& hdr = file.header();
+
+		// The file holds the mesh with the skirts
+		REQUIRE( hdr.vertexCount == mesh.positions.size() );
+		REQUIRE( hdr.indexCount == mesh.indices.size() );
+		REQUIRE( same_bytes_( file.streams().positions, mesh.positions ) );
+
+		auto const bounds = make_aabb( mesh.positions );
+		REQUIRE( 0 == std::memcmp( &hdr.bounds, &bounds, sizeof(bounds) ) );
+
+		REQUIRE( options.tileGrid == hdr.lod.tileGrid );
+		REQUIRE( options.levelCount == hdr.lod.levelCount );
+
+		auto const loaded = file.lod();
+		REQUIRE( loaded.tileCount == lod.tileCount );
+		REQUIRE( loaded.levelCount == lod.levelCount );
+		REQUIRE( same_bytes_( std::span<Aabb3f const>( loaded.bounds ), lod.bounds ) );
+		REQUIRE( loaded.firstIndex == lod.firstIndex );
+		REQUIRE( loaded.indexCount == lod.indexCount );
+		REQUIRE( loaded.error == lod.error );
+	}
+
+	std::filesystem::remove( path );
+}
@@ -0,0 +1,104 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+#include <algorithm>
+
+#include "../support/mesh_optimize.hpp"
+#include "helpers.hpp"
+
+TEST_CASE("Vertex cache optimization", "[mesh_optimize]")
+{
+	auto mesh = make_grid( 300 );
+	auto const original = sorted_triangles( mesh.indices );
+	auto const before = analyze_vertex_cache( mesh.indices, mesh.positions.size() );
+
+	auto const clusters = optimize_vertex_cache( mesh.indices, mesh.positions.size() );
+
+	SECTION("Permutation of the input triangles") {
+		REQUIRE(mesh.indices.size() == 6 * 300 * 300);
+		REQUIRE(sorted_triangles(mesh.indices) == original);
+	}
+
+	SECTION("Cluster starts") {
+		REQUIRE(!clusters.empty());
+		REQUIRE(clusters.front() == 0);
+		REQUIRE(std::ranges::is_sorted(clusters));
+		REQUIRE(clusters.back() < mesh.indices.size() / 3);
+	}
+
+	SECTION("Fewer cache misses") {
+		auto const after = analyze_vertex_cache( mesh.indices, mesh.positions.size() );
+		REQUIRE(before.acmr > 0.95f);
+		REQUIRE(after.acmr < 0.7f);
+		REQUIRE(after.atvr < before.atvr);
+	}
+
+	SECTION("Overdraw ordering keeps the triangles") {
+		optimize_overdraw( mesh.indices, mesh.positions, clusters );
+		REQUIRE(sorted_triangles(mesh.indices) == original);
+	}
+}
+
+TEST_CASE("Vertex fetch optimization", "[mesh_optimize]")
+{
+	auto mesh = make_grid( 300 );
+	std::size_t const used = mesh.positions.size();
+
+	// Unreferenced vertices before and after the grid, and a triangle order
+	// that is unrelated to the vertex order.
+	std::size_t const pad = 17;
+	Vec3f const far{ 1e6f, 1e6f, 1e6f };
+	mesh.positions.insert( mesh.positions.begin(), pad, far );
+	mesh.normals.insert( mesh.normals.begin(), pad, Vec3f{ 0.f, 1.f, 0.f } );
+	mesh.texcoords.insert( mesh.texcoords.begin(), pad, Vec2f{ -1.f, -1.f } );
+	mesh.positions.insert( mesh.positions.end(), pad, far );
+	mesh.normals.insert( mesh.normals.end(), pad, Vec3f{ 0.f, 1.f, 0.f } );
+	mesh.texcoords.insert( mesh.texcoords.end(), pad, Vec2f{ -1.f, -1.f } );
+
+	for( auto& v : mesh.indices )
+		v += std::uint32_t(pad);
+	for( std::size_t i = 0; i < mesh.indices.size() / 2; i += 3 )
+		std::swap_ranges( mesh.indices.begin() + i, mesh.indices.begin() + i + 3, mesh.indices.end() - i - 3 );
+
+	auto const original = mesh;
+	optimize_vertex_fetch( mesh );
+
+	SECTION("No unreferenced vertices") {
+		REQUIRE(mesh.positions.size() == used);
+		REQUIRE(mesh.normals.size() == used);
+		REQUIRE(mesh.texcoords.size() == used);
+
+		REQUIRE(std::ranges::max(mesh.indices) < used);
+
+		std::vector<bool> referenced( used, false );
+		for( auto const v : mesh.indices )
+			referenced[v] = true;
+		REQUIRE(std::ranges::all_of(referenced, [] (bool aRef) { return aRef; }));
+	}
+
+	SECTION("Vertices in order of first use") {
+		std::uint32_t next = 0;
+		bool ordered = true;
+		for( auto const v : mesh.indices )
+		{
+			ordered = ordered && v <= next;
+			if( v == next )
+				++next;
+		}
+		REQUIRE(ordered);
+	}
+
+	SECTION("Same triangles, same order") {
+		REQUIRE(mesh.indices.size() == original.indices.size());
+		bool same = true;
+		for( std::size_t i = 0; i < mesh.indices.size(); ++i )
+		{
+			Vec3f const p = mesh.positions[mesh.indices[i]];
+			Vec3f const q = original.positions[original.indices[i]];
+			Vec2f const t = mesh.texcoords[mesh.indices[i]];
+			Vec2f const u = original.texcoords[original.indices[i]];
+			same = same && p.x == q.x && p.y == q.y && p.z == q.z && t.x == u.x && t.y == u.y;
+		}
+		REQUIRE(same);
+	}
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <map>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "../support/mesh_tiles.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	// Tile of a point in a aTilesX x aTilesZ grid over the XZ extent of aBox
+	std::size_t tile_of_( Vec3f const& aP, Aabb3f const& aBox, std::size_t aTilesX, std::size_t aTilesZ )
+	{
+		auto const cell = [] (float aV, float aMin, float aMax, std::size_t aCount) {
+			auto const i = std::size_t(std::max( 0.f, (aV - aMin) / (aMax - aMin) * float(aCount) ));
+			return std::min( i, aCount-1 );
+		};
+		return cell( aP.z, aBox.min.z, aBox.max.z, aTilesZ ) * aTilesX + cell( aP.x, aBox.min.x, aBox.max.x, aTilesX );
+	}
+
+	bool contains_( Aabb3f const& aBox, Vec3f const& aP )
+	{
+		return aP.x >= aBox.min.x && aP.y >= aBox.min.y && aP.z >= aBox.min.z
+			&& aP.x <= aBox.max.x && aP.y <= aBox.max.y && aP.z <= aBox.max.z;
+	}
+}
+
+TEST_CASE("Mesh tiles", "[mesh_tiles]")
+{
+	auto mesh = make_grid( 300 );
+	Aabb3f const box = make_aabb( mesh.positions );
+
+	auto const original = mesh.indices;
+
+	// Position of each triangle in the original order, to check that the
+	// order within a tile is kept
+	std::map<Triangle, std::uint32_t> number;
+	for( std::size_t j = 0; j < original.size(); j += 3 )
+		number.emplace( make_triangle( original[j], original[j+1], original[j+2] ), std::uint32_t(j / 3) );
+
+	using Grid = std::pair<std::size_t, std::size_t>;
+	auto const [tilesX, tilesZ] = GENERATE( Grid{ 16, 16 }, Grid{ 7, 5 }, Grid{ 1, 1 } );
+
+	MeshTiles const tiles = tile_mesh( mesh.positions, mesh.indices, tilesX, tilesZ );
+
+	SECTION("Triangles are a permutation") {
+		REQUIRE(sorted_triangles(mesh.indices) == sorted_triangles(original));
+	}
+
+	SECTION("Each range holds the triangles whose centroid lies in its tile") {
+		// Every tile of the grid is non-empty, so range i is tile i
+		REQUIRE(tiles.size() == tilesX * tilesZ);
+		REQUIRE(tiles.firstIndex.size() == tiles.size());
+		REQUIRE(tiles.indexCount.size() == tiles.size());
+
+		std::uint32_t next = 0;
+		bool inTile = true, inBounds = true, stable = true;
+		for( std::size_t i = 0; i < tiles.size(); ++i )
+		{
+			REQUIRE(tiles.firstIndex[i] == next);
+			REQUIRE(tiles.indexCount[i] % 3 == 0);
+			next += tiles.indexCount[i];
+
+			std::uint32_t previous = 0;
+			for( std::uint32_t j = tiles.firstIndex[i]; j < next; j += 3 )
+			{
+				Vec3f const& a = mesh.positions[mesh.indices[j+0]];
+				Vec3f const& b = mesh.positions[mesh.indices[j+1]];
+				Vec3f const& c = mesh.positions[mesh.indices[j+2]];
+
+				inTile = inTile && i == tile_of_( (1.f/3.f) * (a + b + c), box, tilesX, tilesZ );
+				inBounds = inBounds && contains_( tiles.bounds[i], a ) && contains_( tiles.bounds[i], b ) && contains_( tiles.bounds[i], c );
+
+				std::uint32_t const n = number.at( make_triangle( mesh.indices[j], mesh.indices[j+1], mesh.indices[j+2] ) );
+				stable = stable && (j == tiles.firstIndex[i] || n > previous);
+				previous = n;
+			}
+		}
+
+		REQUIRE(next == mesh.indices.size());
+		REQUIRE(inTile);
+		REQUIRE(inBounds);
+		REQUIRE(stable);
+	}
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+
+#include "../support/terrain_lod.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	std::uint64_t edge_( std::uint32_t aA, std::uint32_t aB )
+	{
+		return (std::uint64_t(aA) << 32) | aB;
+	}
+
+	bool contains_( Aabb3f const& aBox, Vec3f const& aP )
+	{
+		return aP.x >= aBox.min.x && aP.y >= aBox.min.y && aP.z >= aBox.min.z
+			&& aP.x <= aBox.max.x && aP.y <= aBox.max.y && aP.z <= aBox.max.z;
+	}
+}
+
+TEST_CASE("Terrain LOD", "[terrain_lod]")
+{
+	auto mesh = make_grid( 300 );
+	auto const original = mesh.indices;
+	std::size_t const gridVertices = mesh.positions.size();
+
+	TerrainLod const lod = build_terrain_lod( mesh, TerrainLodOptions{ 16, 4 } );
+
+	std::size_t const tileCount = lod.tileCount;
+	std::size_t const rangeCount = lod.levelCount * tileCount;
+
+	REQUIRE(tileCount == 16 * 16);
+	REQUIRE(lod.levelCount == 4);
+	REQUIRE(lod.bounds.size() == tileCount);
+	REQUIRE(lod.firstIndex.size() == rangeCount);
+	REQUIRE(lod.indexCount.size() == rangeCount);
+	REQUIRE(lod.error.size() == rangeCount);
+
+	REQUIRE(mesh.normals.size() == mesh.positions.size());
+	REQUIRE(mesh.texcoords.size() == mesh.positions.size());
+
+	// The skirts are the triangles that use appended vertices
+	auto const surface = [&] (std::size_t aRange) {
+		std::vector<std::uint32_t> ret;
+		for( std::uint32_t j = lod.firstIndex[aRange]; j < lod.firstIndex[aRange] + lod.indexCount[aRange]; j += 3 )
+		{
+			if( mesh.indices[j] < gridVertices && mesh.indices[j+1] < gridVertices && mesh.indices[j+2] < gridVertices )
+				ret.insert( ret.end(), { mesh.indices[j], mesh.indices[j+1], mesh.indices[j+2] } );
+		}
+		return ret;
+	};
+
+	SECTION("Level 0 is the original mesh") {
+		std::vector<std::uint32_t> level0;
+		for( std::size_t t = 0; t < tileCount; ++t )
+		{
+			REQUIRE(lod.error[t] == 0.f);
+
+			auto const tris = surface( t );
+			level0.insert( level0.end(), tris.begin(), tris.end() );
+		}
+
+		REQUIRE(sorted_triangles(level0) == sorted_triangles(original));
+	}
+
+	SECTION("Errors never decrease") {
+		float maxError = 0.f;
+		for( std::size_t k = 1; k < lod.levelCount; ++k )
+		{
+			for( std::size_t t = 0; t < tileCount; ++t )
+			{
+				REQUIRE(lod.error[k * tileCount + t] >= lod.error[(k-1) * tileCount + t]);
+				REQUIRE(surface(k * tileCount + t).size() <= surface((k-1) * tileCount + t).size());
+				maxError = std::max( maxError, lod.error[k * tileCount + t] );
+			}
+		}
+
+		REQUIRE(maxError > 0.f);
+	}
+
+	SECTION("Skirts hang from border edges only") {
+		float const depth = 2.f * *std::max_element( lod.error.begin(), lod.error.end() );
+
+		bool onBorder = true, lowered = true;
+		for( std::size_t i = 0; i < rangeCount; ++i )
+		{
+			auto const tris = surface( i );
+
+			std::unordered_set<std::uint64_t> edges;
+			for( std::size_t j = 0; j < tris.size(); j += 3 )
+			{
+				for( std::size_t e = 0; e < 3; ++e )
+					edges.insert( edge_( tris[j+e], tris[j+(e+1)%3] ) );
+			}
+
+			std::size_t borderEdges = 0;
+			for( auto const e : edges )
+			{
+				if( !edges.contains( (e << 32) | (e >> 32) ) )
+					++borderEdges;
+			}
+
+			// Skirt quads are (a, a', b), (b, a', b'), after the surface
+			std::uint32_t const end = lod.firstIndex[i] + lod.indexCount[i];
+			std::uint32_t const first = lod.firstIndex[i] + std::uint32_t(tris.size());
+			REQUIRE((end - first) % 6 == 0);
+			REQUIRE((end - first) / 6 == borderEdges);
+
+			for( std::uint32_t j = first; j < end; j += 6 )
+			{
+				std::uint32_t const a = mesh.indices[j+0], la = mesh.indices[j+1], b = mesh.indices[j+2];
+				std::uint32_t const lb = mesh.indices[j+5];
+				REQUIRE(mesh.indices[j+3] == b);
+				REQUIRE(mesh.indices[j+4] == la);
+				REQUIRE((a < gridVertices && b < gridVertices && la >= gridVertices && lb >= gridVertices));
+
+				onBorder = onBorder && edges.contains( edge_( a, b ) ) && !edges.contains( edge_( b, a ) );
+
+				lowered = lowered
+					&& mesh.positions[la].x == mesh.positions[a].x && mesh.positions[la].z == mesh.positions[a].z
+					&& mesh.positions[lb].x == mesh.positions[b].x && mesh.positions[lb].z == mesh.positions[b].z
+					&& std::abs( mesh.positions[a].y - mesh.positions[la].y - depth ) < 1e-4f
+					&& std::abs( mesh.positions[b].y - mesh.positions[lb].y - depth ) < 1e-4f;
+			}
+		}
+
+		REQUIRE(depth > 0.f);
+		REQUIRE(onBorder);
+		REQUIRE(lowered);
+	}
+
+	SECTION("Bounds include the skirts") {
+		bool inside = true;
+		for( std::size_t i = 0; i < rangeCount; ++i )
+		{
+			Aabb3f const& box = lod.bounds[i % tileCount];
+			for( std::uint32_t j = lod.firstIndex[i]; j < lod.firstIndex[i] + lod.indexCount[i]; ++j )
+				inside = inside && contains_( box, mesh.positions[mesh.indices[j]] );
+		}
+
+		REQUIRE(inside);
+	}
+
+	SECTION("Level selection") {
+		float const pixelScale = terrain_lod_pixel_scale( 1.f, 1080.f );
+
+		std::vector<std::uint8_t> visible( tileCount, 1 );
+		std::vector<std::uint8_t> levels( tileCount, 0 );
+		visible[1] = 0;
+
+		// Inside the first tile, far from the last one
+		Vec3f const eye = 0.5f * (lod.bounds[0].min + lod.bounds[0].max);
+		std::size_t const triangles = select_terrain_lod( lod, eye, pixelScale, 8.f, visible, levels );
+
+		REQUIRE(levels[0] == 0);
+		REQUIRE(levels[1] == kTerrainLodCulled);
+		REQUIRE(levels[tileCount-1] > 0);
+
+		std::size_t expected = 0;
+		for( std::size_t t = 0; t < tileCount; ++t )
+		{
+			if( kTerrainLodCulled != levels[t] )
+				expected += lod.indexCount[levels[t] * tileCount + t] / 3;
+		}
+		REQUIRE(triangles == expected);
+
+		// Far away, every tile uses the coarsest level
+		select_terrain_lod( lod, Vec3f{ 150.f, 1e6f, 150.f }, pixelScale, 8.f, visible, levels );
+		for( std::size_t t = 0; t < tileCount; ++t )
+			REQUIRE(levels[t] == (visible[t] ? lod.levelCount-1 : kTerrainLodCulled));
+	}
+}
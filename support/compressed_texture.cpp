@@ -0,0 +1,252 @@
+#include "compressed_texture.hpp"
+
+#include <bit>
+#include <array>
+#include <memory>
+#include <algorithm>
+
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+
+#include "error.hpp"
+#include "parallel_for.hpp"
+
+#include "../vmlib/bc7.hpp"
+
+static_assert( std::endian::native == std::endian::little, "Texture files are little endian" );
+
+namespace
+{
+	constexpr std::uint8_t kKtxIdentifier_[12] = {
+		0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+	};
+	constexpr std::uint32_t kKtxEndianness_ = 0x04030201;
+
+	constexpr char kSourceKey_[] = "cw2.source"; // includes the terminating zero
+
+	// Blocks per thread, at least
+	constexpr std::size_t kGrain_ = 1024;
+
+	struct KtxHeader_
+	{
+		std::uint8_t identifier[12];
+		std::uint32_t endianness;
+		std::uint32_t glType;
+		std::uint32_t glTypeSize;
+		std::uint32_t glFormat;
+		std::uint32_t glInternalFormat;
+		std::uint32_t glBaseInternalFormat;
+		std::uint32_t pixelWidth;
+		std::uint32_t pixelHeight;
+		std::uint32_t pixelDepth;
+		std::uint32_t numberOfArrayElements;
+		std::uint32_t numberOfFaces;
+		std::uint32_t numberOfMipmapLevels;
+		std::uint32_t bytesOfKeyValueData;
+	};
+
+	static_assert( sizeof(KtxHeader_) == 64 );
+
+	struct FileCloser_
+	{
+		void operator() (std::FILE* aFile) const noexcept { std::fclose( aFile ); }
+	};
+	using FilePtr_ = std::unique_ptr<std::FILE, FileCloser_>;
+
+	FilePtr_ open_file_( std::filesystem::path const& aPath, char const* aMode )
+	{
+		return FilePtr_( std::fopen( aPath.string().c_str(), aMode ) );
+	}
+
+	constexpr std::uint32_t pad4_( std::uint32_t aSize ) noexcept
+	{
+		return (aSize + 3) / 4 * 4;
+	}
+
+	// Size of the single key/value pair, including its size field and padding
+	constexpr std::uint32_t kKeyValueBytes_ = 4 + pad4_( sizeof(kSourceKey_) + sizeof(SourceFingerprint) );
+
+	// Reads the header and the source fingerprint. Returns false if the file
+	// does not start like one written by write_texture_file().
+	bool read_header_( std::FILE* aFile, KtxHeader_& aHeader, SourceFingerprint& aSource )
+	{
+		if( 1 != std::fread( &aHeader, sizeof(aHeader), 1, aFile ) )
+			return false;
+
+		if( 0 != std::memcmp( aHeader.identifier, kKtxIdentifier_, sizeof(kKtxIdentifier_) ) )
+			return false;
+		if( kKtxEndianness_ != aHeader.endianness || kKeyValueBytes_ != aHeader.bytesOfKeyValueData )
+			return false;
+
+		std::array<std::uint8_t, kKeyValueBytes_> kv;
+		if( 1 != std::fread( kv.data(), kv.size(), 1, aFile ) )
+			return false;
+
+		std::uint32_t kvSize;
+		std::memcpy( &kvSize, kv.data(), sizeof(kvSize) );
+		if( sizeof(kSourceKey_) + sizeof(SourceFingerprint) != kvSize )
+			return false;
+		if( 0 != std::memcmp( kv.data() + 4, kSourceKey_, sizeof(kSourceKey_) ) )
+			return false;
+
+		std::memcpy( &aSource, kv.data() + 4 + sizeof(kSourceKey_), sizeof(aSource) );
+		return true;
+	}
+}
+
+std::size_t CompressedTexture::size_bytes() const noexcept
+{
+	std::size_t ret = 0;
+	for( auto const& level : levels )
+		ret += level.size();
+	return ret;
+}
+
+CompressedTexture compress_bc7_srgb( std::span<std::uint8_t const> aRgba, std::size_t aWidth, std::size_t aHeight, std::span<MipLevel const> aMips )
+{
+	assert( aRgba.size() >= aWidth * aHeight * 4 );
+
+	CompressedTexture ret;
+	ret.internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+	ret.width = std::uint32_t(aWidth);
+	ret.height = std::uint32_t(aHeight);
+	ret.levels.reserve( 1 + aMips.size() );
+
+	auto const encode = [&ret] (std::span<std::uint8_t const> aLevel, std::size_t aW, std::size_t aH) {
+		auto& out = ret.levels.emplace_back( bc7_size( aW, aH ) );
+
+		std::size_t const blockCols = (aW + 3) / 4;
+		std::size_t const blockRows = (aH + 3) / 4;
+		parallel_for( blockRows, std::max<std::size_t>( kGrain_ / blockCols, 1 ), [&] (std::size_t aBegin, std::size_t aEnd) {
+			encode_bc7( aLevel, aW, aH, out, aBegin, aEnd );
+		} );
+	};
+
+	encode( aRgba, aWidth, aHeight );
+	for( auto const& mip : aMips )
+		encode( mip.rgba, mip.width, mip.height );
+
+	return ret;
+}
+
+void write_texture_file( std::filesystem::path const& aPath, CompressedTexture const& aTexture, SourceFingerprint const& aSource )
+{
+	KtxHeader_ header{};
+	std::memcpy( header.identifier, kKtxIdentifier_, sizeof(kKtxIdentifier_) );
+	header.endianness = kKtxEndianness_;
+	header.glType = 0; // compressed
+	header.glTypeSize = 1;
+	header.glFormat = 0; // compressed
+	header.glInternalFormat = aTexture.internalFormat;
+	header.glBaseInternalFormat = GL_RGBA;
+	header.pixelWidth = aTexture.width;
+	header.pixelHeight = aTexture.height;
+	header.numberOfFaces = 1;
+	header.numberOfMipmapLevels = std::uint32_t(aTexture.levels.size());
+	header.bytesOfKeyValueData = kKeyValueBytes_;
+
+	std::array<std::uint8_t, kKeyValueBytes_> kv{};
+	std::uint32_t const kvSize = sizeof(kSourceKey_) + sizeof(SourceFingerprint);
+	std::memcpy( kv.data(), &kvSize, sizeof(kvSize) );
+	std::memcpy( kv.data() + 4, kSourceKey_, sizeof(kSourceKey_) );
+	std::memcpy( kv.data() + 4 + sizeof(kSourceKey_), &aSource, sizeof(aSource) );
+
+	// See write_mesh_file()
+	auto tmpPath = aPath;
+	tmpPath += ".tmp";
+
+	{
+		auto const file = open_file_( tmpPath, "wb" );
+		if( !file )
+			throw Error( "Unable to open '{}' for writing", tmpPath.string() );
+
+		bool ok = 1 == std::fwrite( &header, sizeof(header), 1, file.get() );
+		ok = ok && 1 == std::fwrite( kv.data(), kv.size(), 1, file.get() );
+
+		for( auto const& level : aTexture.levels )
+		{
+			// Block compressed levels are multiples of four bytes, so no mip
+			// padding is needed.
+			assert( 0 == level.size() % 4 );
+
+			std::uint32_t const imageSize = std::uint32_t(level.size());
+			ok = ok && 1 == std::fwrite( &imageSize, sizeof(imageSize), 1, file.get() );
+			ok = ok && level.size() == std::fwrite( level.data(), 1, level.size(), file.get() );
+		}
+
+		if( !ok || 0 != std::fflush( file.get() ) )
+			throw Error( "Unable to write '{}'", tmpPath.string() );
+	}
+
+	std::error_code ec;
+	std::filesystem::rename( tmpPath, aPath, ec );
+	if( ec )
+		throw Error( "Unable to rename '{}' to '{}': {}", tmpPath.string(), aPath.string(), ec.message() );
+}
+
+bool is_texture_file_current( std::filesystem::path const& aCached, std::filesystem::path const& aSource )
+{
+	auto const file = open_file_( aCached, "rb" );
+	if( !file )
+		return false;
+
+	KtxHeader_ header;
+	SourceFingerprint source;
+	if( !read_header_( file.get(), header, source ) )
+		return false;
+
+	return is_source_current( source, aSource );
+}
+
+CompressedTexture read_texture_file( std::filesystem::path const& aPath )
+{
+	auto const invalid = [&] (char const* aReason) {
+		return Error( "Invalid texture file '{}': {}", aPath.string(), aReason );
+	};
+
+	auto const file = open_file_( aPath, "rb" );
+	if( !file )
+		throw Error( "Unable to open texture file '{}'", aPath.string() );
+
+	KtxHeader_ header;
+	SourceFingerprint source;
+	if( !read_header_( file.get(), header, source ) )
+		throw invalid( "not a supported KTX file" );
+
+	if( GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM != header.glInternalFormat || 0 != header.glType )
+		throw invalid( "unsupported format" );
+	if( 0 == header.pixelWidth || 0 == header.pixelHeight || 0 != header.pixelDepth )
+		throw invalid( "unsupported dimensions" );
+	if( 0 != header.numberOfArrayElements || 1 != header.numberOfFaces )
+		throw invalid( "arrays and cube maps are not supported" );
+
+	std::uint32_t const levels = std::uint32_t(std::bit_width( std::max( header.pixelWidth, header.pixelHeight ) ));
+	if( levels != header.numberOfMipmapLevels )
+		throw invalid( "incomplete mip chain" );
+
+	CompressedTexture ret;
+	ret.internalFormat = header.glInternalFormat;
+	ret.width = header.pixelWidth;
+	ret.height = header.pixelHeight;
+	ret.levels.reserve( levels );
+
+	std::size_t w = ret.width, h = ret.height;
+	for( std::uint32_t i = 0; i < levels; ++i )
+	{
+		std::uint32_t imageSize;
+		if( 1 != std::fread( &imageSize, sizeof(imageSize), 1, file.get() ) )
+			throw invalid( "truncated" );
+		if( bc7_size( w, h ) != imageSize )
+			throw invalid( "level size mismatch" );
+
+		auto& level = ret.levels.emplace_back( imageSize );
+		if( imageSize != std::fread( level.data(), 1, level.size(), file.get() ) )
+			throw invalid( "truncated" );
+
+		w = std::max<std::size_t>( w / 2, 1 );
+		h = std::max<std::size_t>( h / 2, 1 );
+	}
+
+	return ret;
+}
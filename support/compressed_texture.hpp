@@ -0,0 +1,67 @@
+#ifndef COMPRESSED_TEXTURE_HPP_41A6E0C9_7B2D_4F85_9C13_D85E2A07B6F4
+#define COMPRESSED_TEXTURE_HPP_41A6E0C9_7B2D_4F85_9C13_D85E2A07B6F4
+
+#include <glad/glad.h>
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "source_fingerprint.hpp"
+#include "mip_chain.hpp"
+
+/* Compressed textures (.ktx)
+ *
+ * Block compressed mip chains, encoded on the CPU (see vmlib/bc7.hpp) and
+ * cached next to their source image, so that only the first run pays for
+ * the encoding. Later runs pass the blocks to glCompressedTexImage2D()
+ * directly.
+ *
+ * The cache files are KTX 1.1, so standard tools can inspect them. Only the
+ * subset used here is read and written: little endian, 2D, one face, no
+ * array elements, compressed formats (glType = 0) with all mip levels. The
+ * fingerprint of the source image (see source_fingerprint.hpp) is stored
+ * under the key "cw2.source", and checked with is_source_current().
+ */
+
+struct CompressedTexture
+{
+	GLenum internalFormat = GL_NONE;
+	std::uint32_t width = 0; // level 0
+	std::uint32_t height = 0;
+
+	std::vector<std::vector<std::uint8_t>> levels; // level 0 first
+
+	std::size_t size_bytes() const noexcept;
+};
+
+// Encodes an sRGB RGBA8 image (level 0) and its other levels (see
+// make_srgb_mip_chain()) as GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM. The blocks
+// of each level are split across threads.
+CompressedTexture compress_bc7_srgb(
+	std::span<std::uint8_t const> aRgba,
+	std::size_t aWidth,
+	std::size_t aHeight,
+	std::span<MipLevel const> aMips
+);
+
+// Throws Error on failure. The file is written to a temporary path first.
+void write_texture_file(
+	std::filesystem::path const& aPath,
+	CompressedTexture const& aTexture,
+	SourceFingerprint const& aSource
+);
+
+// True if aCached exists and was created from the current version of
+// aSource.
+bool is_texture_file_current(
+	std::filesystem::path const& aCached,
+	std::filesystem::path const& aSource
+);
+
+// Throws Error if the file cannot be read or is not a supported KTX file.
+CompressedTexture read_texture_file( std::filesystem::path const& aPath );
+
+#endif // COMPRESSED_TEXTURE_HPP_41A6E0C9_7B2D_4F85_9C13_D85E2A07B6F4
@@ -0,0 +1,77 @@
+#ifndef FRAME_DATA_HPP_5D0B83E2_6C1F_4A97_B3D8_29E4F7A1C640
+#define FRAME_DATA_HPP_5D0B83E2_6C1F_4A97_B3D8_29E4F7A1C640
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "../vmlib/vec3.hpp"
+
+/* Per-frame uniform data
+ *
+ * C++ mirror of the std140 uniform block FrameData, which holds the data
+ * that is shared by all draws of a view: camera position, ambient term and
+ * lights. It is declared identically in default.frag and material.frag, and
+ * bound to kFrameDataBinding.
+ *
+ * In std140, a vec3 is aligned to 16 bytes, but the following scalar may
+ * use its fourth component; structs and array elements are padded to a
+ * multiple of 16 bytes. The members are ordered accordingly, and their
+ * offsets checked below. bool is a 32 bit value.
+ *
+ * Up to kMaxPointLights point lights (kMaxPointLights in the shaders, which
+ * must match) are stored; pointLightCount are used.
+ */
+
+inline constexpr GLuint kFrameDataBinding = 0;
+inline constexpr std::size_t kMaxPointLights = 16;
+
+struct FrameDirLight
+{
+	Vec3f direction;
+	std::uint32_t enabled;
+	Vec3f color;
+	float pad_;
+};
+
+struct FramePointLight
+{
+	Vec3f position;
+	std::uint32_t enabled;
+	Vec3f color;
+	float pad_;
+};
+
+struct FrameData
+{
+	Vec3f cameraPos;
+	std::uint32_t pointLightCount;
+	Vec3f sceneAmbient;
+	float pad_;
+
+	FrameDirLight globalLight;
+	FramePointLight pointLights[kMaxPointLights];
+};
+
+static_assert( std::is_standard_layout_v<FrameData> && std::is_trivially_copyable_v<FrameData> );
+
+static_assert( sizeof(FrameDirLight) == 32 );
+static_assert( offsetof(FrameDirLight, direction) == 0 );
+static_assert( offsetof(FrameDirLight, enabled) == 12 );
+static_assert( offsetof(FrameDirLight, color) == 16 );
+
+static_assert( sizeof(FramePointLight) == 32 ); // array stride
+static_assert( offsetof(FramePointLight, position) == 0 );
+static_assert( offsetof(FramePointLight, enabled) == 12 );
+static_assert( offsetof(FramePointLight, color) == 16 );
+
+static_assert( offsetof(FrameData, cameraPos) == 0 );
+static_assert( offsetof(FrameData, pointLightCount) == 12 );
+static_assert( offsetof(FrameData, sceneAmbient) == 16 );
+static_assert( offsetof(FrameData, globalLight) == 32 );
+static_assert( offsetof(FrameData, pointLights) == 64 );
+static_assert( sizeof(FrameData) == 64 + kMaxPointLights * sizeof(FramePointLight) );
+
+#endif // FRAME_DATA_HPP_5D0B83E2_6C1F_4A97_B3D8_29E4F7A1C640
@@ -0,0 +1,279 @@
+#include "mesh.hpp"
+
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+
+#include <rapidobj/rapidobj.hpp>
+
+#include "error.hpp"
+#include "parallel_for.hpp"
+
+#include "../vmlib/vec3_soa.hpp"
+
+namespace
+{
+	// The OBJ indices of a triangle corner (plus its material) identify its
+	// attribute values, so corners with equal keys become the same vertex.
+	struct CornerKey_
+	{
+		int position, normal, texcoord, material;
+
+		bool operator== (CornerKey_ const&) const = default;
+	};
+
+	std::uint64_t hash_( CornerKey_ const& aKey ) noexcept
+	{
+		std::uint64_t h = std::uint32_t(aKey.position);
+		h = h * 0x9e3779b97f4a7c15ull + std::uint32_t(aKey.normal);
+		h = h * 0x9e3779b97f4a7c15ull + std::uint32_t(aKey.texcoord);
+		h = h * 0x9e3779b97f4a7c15ull + std::uint32_t(aKey.material);
+		return h ^ (h >> 32);
+	}
+
+	struct CornerHash_
+	{
+		std::size_t operator() (CornerKey_ const& aKey) const noexcept
+		{
+			return std::size_t(hash_( aKey ));
+		}
+	};
+
+	constexpr std::size_t kGrain_ = 16*1024;
+}
+
+MeshStreams mesh_streams( SimpleMeshData const& aMesh ) noexcept
+{
+	MeshStreams ret;
+	ret.positions = aMesh.positions;
+	ret.normals = aMesh.normals;
+	ret.texcoords = aMesh.texcoords;
+	ret.materialIds = aMesh.materialIds;
+	ret.indices32 = aMesh.indices;
+	return ret;
+}
+
+SimpleMeshData load_wavefront_obj( char const* aPath, std::vector<Material>* aMaterials )
+{
+	auto result = rapidobj::ParseFile( aPath );
+	if( result.error )
+		throw Error( "Unable to load OBJ file '{}': {}", aPath, result.error.code.message() );
+
+	rapidobj::Triangulate( result );
+
+	// only if required
+	if( aMaterials )
+	{
+		aMaterials->resize( result.materials.size() );
+		for( std::size_t i = 0; i < result.materials.size(); ++i )
+		{
+			auto const& mat = result.materials[i];
+			(*aMaterials)[i].diffuse = Vec3f{ mat.diffuse[0], mat.diffuse[1], mat.diffuse[2] };
+			(*aMaterials)[i].shine = float(mat.shininess);
+		}
+	}
+
+	// The conversion runs in passes over all triangle corners. Each pass
+	// writes disjoint ranges of preallocated arrays, so that the passes can be
+	// split across threads. Vertices are numbered in the order of the first
+	// corner that references them, i.e., the result is the same as that of a
+	// sequential loop over the corners.
+	auto const& shapes = result.shapes;
+	auto const& attribs = result.attributes;
+
+	// Corner offset of each shape (prefix sum)
+	std::vector<std::size_t> shapeStart( shapes.size()+1, 0 );
+	for( std::size_t i = 0; i < shapes.size(); ++i )
+		shapeStart[i+1] = shapeStart[i] + shapes[i].mesh.indices.size();
+
+	std::size_t const cornerCount = shapeStart.back();
+
+	// Pass 1: flatten the corners into keys
+	std::vector<CornerKey_> keys( cornerCount );
+	std::vector<std::uint64_t> hashes( cornerCount );
+
+	parallel_for( cornerCount, kGrain_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		std::size_t s = std::size_t(std::upper_bound( shapeStart.begin(), shapeStart.end(), aBegin ) - shapeStart.begin()) - 1;
+		for( std::size_t c = aBegin; c < aEnd; ++c )
+		{
+			while( c >= shapeStart[s+1] )
+				++s;
+
+			auto const& mesh = shapes[s].mesh;
+			std::size_t const i = c - shapeStart[s];
+			auto const& idx = mesh.indices[i];
+
+			int matId = -1;
+			if( aMaterials && i/3 < mesh.material_ids.size() )
+				matId = mesh.material_ids[i/3];
+
+			keys[c] = CornerKey_{ idx.position_index, idx.normal_index, idx.texcoord_index, matId };
+			hashes[c] = hash_( keys[c] );
+		}
+	} );
+
+	// Passes 2 and 3 split the corners into contiguous blocks, one per
+	// worker.
+	std::size_t const blocks = std::clamp<std::size_t>( cornerCount / kGrain_, 1, worker_count() );
+	auto const blockBegin = [&] (std::size_t aBlock) { return cornerCount * aBlock / blocks; };
+
+	// Pass 2: find the first corner with the same key. Corners are sharded by
+	// their hash, and each shard has its own map.
+	//
+	// The corners are first bucketed by shard with a counting sort: a
+	// histogram per block, a prefix sum over (shard, block), and a scatter.
+	// The sort is stable, so each bucket lists its corners in order, and the
+	// map of each shard records the first occurrence of each key.
+	std::size_t const shards = blocks;
+	auto const shard_of = [&] (std::size_t aCorner) { return std::size_t((hashes[aCorner] >> 32) % shards); };
+
+	std::vector<std::uint32_t> bucketStart( shards * blocks + 1, 0 ); // [shard * blocks + block]
+
+	parallel_for( blocks, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t b = aBegin; b < aEnd; ++b )
+		{
+			for( std::size_t c = blockBegin( b ); c < blockBegin( b+1 ); ++c )
+				++bucketStart[shard_of( c ) * blocks + b + 1];
+		}
+	} );
+
+	std::partial_sum( bucketStart.begin(), bucketStart.end(), bucketStart.begin() );
+
+	std::vector<std::uint32_t> buckets( cornerCount );
+	parallel_for( blocks, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		std::vector<std::uint32_t> next( shards );
+		for( std::size_t b = aBegin; b < aEnd; ++b )
+		{
+			for( std::size_t shard = 0; shard < shards; ++shard )
+				next[shard] = bucketStart[shard * blocks + b];
+
+			for( std::size_t c = blockBegin( b ); c < blockBegin( b+1 ); ++c )
+				buckets[next[shard_of( c )]++] = std::uint32_t(c);
+		}
+	} );
+
+	std::vector<std::uint32_t> first( cornerCount );
+	parallel_for( shards, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t shard = aBegin; shard < aEnd; ++shard )
+		{
+			std::uint32_t const begin = bucketStart[shard * blocks];
+			std::uint32_t const end = bucketStart[(shard+1) * blocks];
+
+			std::unordered_map<CornerKey_, std::uint32_t, CornerHash_> seen;
+			seen.reserve( end - begin );
+
+			for( std::uint32_t i = begin; i < end; ++i )
+			{
+				std::uint32_t const c = buckets[i];
+				auto const [it, inserted] = seen.try_emplace( keys[c], c );
+				first[c] = it->second;
+			}
+		}
+	} );
+
+	// Pass 3: number the vertices, i.e., an exclusive prefix sum over the
+	// corners that start a new vertex. Per block first, then across blocks.
+	std::vector<std::uint32_t> vertexId( cornerCount );
+	std::vector<std::uint32_t> blockStart( blocks+1, 0 );
+
+	parallel_for( blocks, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t b = aBegin; b < aEnd; ++b )
+		{
+			std::uint32_t count = 0;
+			for( std::size_t c = blockBegin( b ); c < blockBegin( b+1 ); ++c )
+				count += (first[c] == c);
+			blockStart[b+1] = count;
+		}
+	} );
+
+	std::partial_sum( blockStart.begin(), blockStart.end(), blockStart.begin() );
+	std::size_t const vertexCount = blockStart.back();
+
+	parallel_for( blocks, 1, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t b = aBegin; b < aEnd; ++b )
+		{
+			std::uint32_t id = blockStart[b];
+			for( std::size_t c = blockBegin( b ); c < blockBegin( b+1 ); ++c )
+			{
+				if( first[c] == c )
+					vertexId[c] = id++;
+			}
+		}
+	} );
+
+	// Pass 4: write the indices and the attributes of each new vertex.
+	// Corners without a normal or texture coordinate (in an OBJ that has
+	// some) get +Y and (0,0), respectively.
+	bool const hasNormals = !attribs.normals.empty();
+	bool const hasTexcoords = !attribs.texcoords.empty();
+
+	SimpleMeshData ret;
+	ret.indices.resize( cornerCount );
+	ret.positions.resize( vertexCount );
+	if( hasNormals )
+		ret.normals.resize( vertexCount );
+	if( hasTexcoords )
+		ret.texcoords.resize( vertexCount );
+	if( aMaterials )
+		ret.materialIds.resize( vertexCount );
+
+	parallel_for( cornerCount, kGrain_, [&] (std::size_t aBegin, std::size_t aEnd) {
+		for( std::size_t c = aBegin; c < aEnd; ++c )
+		{
+			ret.indices[c] = vertexId[first[c]];
+			if( first[c] != c )
+				continue;
+
+			auto const& key = keys[c];
+			std::uint32_t const v = vertexId[c];
+
+			ret.positions[v] = Vec3f{
+				attribs.positions[key.position * 3 + 0],
+				attribs.positions[key.position * 3 + 1],
+				attribs.positions[key.position * 3 + 2]
+			};
+
+			if( hasNormals )
+			{
+				ret.normals[v] = key.normal < 0 ? Vec3f{ 0.f, 1.f, 0.f } : Vec3f{
+					attribs.normals[key.normal * 3 + 0],
+					attribs.normals[key.normal * 3 + 1],
+					attribs.normals[key.normal * 3 + 2]
+				};
+			}
+
+			if( hasTexcoords )
+			{
+				ret.texcoords[v] = key.texcoord < 0 ? Vec2f{ 0.f, 0.f } : Vec2f{
+					attribs.texcoords[key.texcoord * 2 + 0],
+					attribs.texcoords[key.texcoord * 2 + 1]
+				};
+			}
+
+			if( aMaterials )
+				ret.materialIds[v] = float(key.material);
+		}
+	} );
+
+	// Pass 5: normalize the normals, in SIMD batches
+	if( hasNormals )
+	{
+		parallel_for( vertexCount, kGrain_, [&] (std::size_t aBegin, std::size_t aEnd) {
+			constexpr std::size_t kBatch = 4096;
+
+			Vec3fSoA batch;
+			batch.reserve( kBatch );
+
+			for( std::size_t i = aBegin; i < aEnd; i += kBatch )
+			{
+				std::span<Vec3f> const normals( ret.normals.data() + i, std::min( kBatch, aEnd - i ) );
+
+				batch.assign( normals );
+				normalize( batch, batch );
+				batch.copy_to( normals );
+			}
+		} );
+	}
+
+	return ret;
+}
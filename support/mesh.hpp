@@ -0,0 +1,53 @@
+#ifndef MESH_HPP_EEF1C850_0F19_44DD_9820_D05F14037CCE
+#define MESH_HPP_EEF1C850_0F19_44DD_9820_D05F14037CCE
+
+#include <span>
+#include <vector>
+
+#include <cstdint>
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/vec3.hpp"
+
+struct Material
+{
+	Vec3f diffuse;
+	float shine;
+};
+
+// Vertex attributes are stored per vertex. If indices is empty, every three
+// consecutive vertices form a triangle; otherwise indices does.
+struct SimpleMeshData
+{
+	std::vector<Vec3f> positions;
+	std::vector<Vec3f> normals;
+	std::vector<Vec2f> texcoords;
+	std::vector<float> materialIds;
+	std::vector<std::uint32_t> indices;
+};
+
+// Non-owning view of the vertex streams and indices of a mesh, either from
+// a SimpleMeshData or from a cooked mesh file (see mesh_file.hpp). At most
+// one of indices16 and indices32 is non-empty.
+struct MeshStreams
+{
+	std::span<Vec3f const> positions;
+	std::span<Vec3f const> normals;
+	std::span<Vec2f const> texcoords;
+	std::span<float const> materialIds;
+	std::span<std::uint16_t const> indices16;
+	std::span<std::uint32_t const> indices32;
+};
+
+MeshStreams mesh_streams( SimpleMeshData const& ) noexcept;
+
+// Loads and triangulates a Wavefront OBJ file. Identical corners are welded
+// into a single vertex, so the result is always indexed. Material IDs (and
+// the materials themselves) are only loaded if aMaterials is non-null.
+//
+// The conversion of large meshes is split across hardware threads.
+//
+// Throws Error on failure.
+SimpleMeshData load_wavefront_obj( char const* aPath, std::vector<Material>* aMaterials = nullptr );
+
+#endif // MESH_HPP_EEF1C850_0F19_44DD_9820_D05F14037CCE
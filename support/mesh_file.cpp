@@ -0,0 +1,430 @@
+#include "mesh_file.hpp"
+
+#include <bit>
+#include <memory>
+#include <utility>
+#include <algorithm>
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+
+#if defined(_WIN32)
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else // POSIX
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif // ~ platform
+
+#include "error.hpp"
+
+static_assert( std::endian::native == std::endian::little, "Mesh files are little endian" );
+
+namespace
+{
+	struct FileCloser_
+	{
+		void operator() (std::FILE* aFile) const noexcept { std::fclose( aFile ); }
+	};
+	using FilePtr_ = std::unique_ptr<std::FILE, FileCloser_>;
+
+	FilePtr_ open_file_( std::filesystem::path const& aPath, char const* aMode )
+	{
+		return FilePtr_( std::fopen( aPath.string().c_str(), aMode ) );
+	}
+
+	std::uint64_t align_( std::uint64_t aOffset ) noexcept
+	{
+		return (aOffset + kMeshFileAlign - 1) / kMeshFileAlign * kMeshFileAlign;
+	}
+
+	bool read_header_( std::filesystem::path const& aPath, MeshFileHeader& aHeader )
+	{
+		auto const file = open_file_( aPath, "rb" );
+		if( !file )
+			return false;
+
+		if( 1 != std::fread( &aHeader, sizeof(aHeader), 1, file.get() ) )
+			return false;
+
+		return 0 == std::memcmp( aHeader.magic, kMeshFileMagic, sizeof(kMeshFileMagic) )
+			&& kMeshFileVersion == aHeader.version
+		;
+	}
+
+	// Maps the whole file read-only. Returns null on failure; the caller then
+	// falls back to reading the file.
+	std::byte const* map_file_( std::filesystem::path const& aPath, std::size_t& aSize )
+	{
+#		if defined(_WIN32)
+		HANDLE const file = CreateFileW( aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if( INVALID_HANDLE_VALUE == file )
+			return nullptr;
+
+		LARGE_INTEGER size;
+		if( !GetFileSizeEx( file, &size ) || 0 == size.QuadPart )
+		{
+			CloseHandle( file );
+			return nullptr;
+		}
+
+		// The view keeps the mapping (and the file) alive; the handles can be
+		// closed right away.
+		HANDLE const mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		CloseHandle( file );
+		if( !mapping )
+			return nullptr;
+
+		void const* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+		CloseHandle( mapping );
+		if( !view )
+			return nullptr;
+
+		aSize = std::size_t(size.QuadPart);
+		return static_cast<std::byte const*>(view);
+#		else // POSIX
+		int const fd = ::open( aPath.c_str(), O_RDONLY );
+		if( -1 == fd )
+			return nullptr;
+
+		struct stat st;
+		if( -1 == ::fstat( fd, &st ) || 0 == st.st_size )
+		{
+			::close( fd );
+			return nullptr;
+		}
+
+		void* const view = ::mmap( nullptr, std::size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0 );
+		::close( fd );
+		if( MAP_FAILED == view )
+			return nullptr;
+
+		aSize = std::size_t(st.st_size);
+		return static_cast<std::byte const*>(view);
+#		endif // ~ platform
+	}
+
+	void unmap_file_( std::byte const* aData, std::size_t aSize ) noexcept
+	{
+#		if defined(_WIN32)
+		(void)aSize;
+		UnmapViewOfFile( aData );
+#		else // POSIX
+		::munmap( const_cast<std::byte*>(aData), aSize );
+#		endif // ~ platform
+	}
+}
+
+void write_mesh_file( std::filesystem::path const& aPath, SimpleMeshData const& aMesh, std::span<Material const> aMaterials, MeshFileVertexLayout const& aLayout, std::span<std::byte const> aVertices, TerrainLod const& aLod, TerrainLodOptions const& aLodOptions, SourceFingerprint const& aSource )
+{
+	std::size_t const vertexCount = aMesh.positions.size();
+	assert( aVertices.size() == vertexCount * aLayout.stride );
+	assert( aLod.bounds.size() == aLod.tileCount && aLod.error.size() == aLod.tileCount * aLod.levelCount );
+	assert( aMesh.normals.empty() || aMesh.normals.size() == vertexCount );
+	assert( aMesh.texcoords.empty() || aMesh.texcoords.size() == vertexCount );
+	assert( aMesh.materialIds.empty() || aMesh.materialIds.size() == vertexCount );
+
+	bool const use16 = vertexCount <= 0x10000;
+	std::vector<std::uint16_t> indices16;
+	if( use16 )
+		indices16.assign( aMesh.indices.begin(), aMesh.indices.end() );
+
+	MeshFileHeader header{};
+	std::memcpy( header.magic, kMeshFileMagic, sizeof(kMeshFileMagic) );
+	header.version = kMeshFileVersion;
+	header.indexSize = use16 ? 2 : 4;
+	header.vertexCount = std::uint32_t(vertexCount);
+	header.indexCount = std::uint32_t(aMesh.indices.size());
+	header.materialCount = std::uint32_t(aMaterials.size());
+	header.bounds = make_aabb( aMesh.positions );
+	header.source = aSource;
+	header.layout = aLayout;
+	if( !aLod.empty() )
+	{
+		header.lod.tileGrid = std::uint32_t(aLodOptions.tileGrid);
+		header.lod.levelCount = std::uint32_t(aLod.levelCount);
+		header.lod.tileCount = std::uint32_t(aLod.tileCount);
+	}
+
+	// Lay out the sections
+	struct Payload_
+	{
+		MeshFileSection* section;
+		void const* data;
+		std::size_t size;
+	} const payloads[] = {
+		{ &header.vertices, aVertices.data(), aVertices.size() },
+		{ &header.positions, aMesh.positions.data(), aMesh.positions.size() * sizeof(Vec3f) },
+		{ &header.normals, aMesh.normals.data(), aMesh.normals.size() * sizeof(Vec3f) },
+		{ &header.texcoords, aMesh.texcoords.data(), aMesh.texcoords.size() * sizeof(Vec2f) },
+		{ &header.materialIds, aMesh.materialIds.data(), aMesh.materialIds.size() * sizeof(float) },
+		{ &header.indices,
+			use16 ? static_cast<void const*>(indices16.data()) : static_cast<void const*>(aMesh.indices.data()),
+			aMesh.indices.size() * header.indexSize
+		},
+		{ &header.materials, aMaterials.data(), aMaterials.size() * sizeof(Material) },
+		{ &header.lodBounds, aLod.bounds.data(), aLod.bounds.size() * sizeof(Aabb3f) },
+		{ &header.lodFirstIndex, aLod.firstIndex.data(), aLod.firstIndex.size() * sizeof(std::uint32_t) },
+		{ &header.lodIndexCount, aLod.indexCount.data(), aLod.indexCount.size() * sizeof(std::uint32_t) },
+		{ &header.lodError, aLod.error.data(), aLod.error.size() * sizeof(float) }
+	};
+
+	std::uint64_t offset = sizeof(MeshFileHeader);
+	for( auto const& payload : payloads )
+	{
+		offset = align_( offset );
+		*payload.section = MeshFileSection{ offset, payload.size };
+		offset += payload.size;
+	}
+
+	// Write to a temporary file first, so that an interrupted cook does not
+	// leave a truncated file behind.
+	auto tmpPath = aPath;
+	tmpPath += ".tmp";
+
+	{
+		auto const file = open_file_( tmpPath, "wb" );
+		if( !file )
+			throw Error( "Unable to open '{}' for writing", tmpPath.string() );
+
+		bool ok = 1 == std::fwrite( &header, sizeof(header), 1, file.get() );
+
+		std::byte const padding[kMeshFileAlign] = {};
+		std::uint64_t written = sizeof(header);
+		for( auto const& payload : payloads )
+		{
+			std::uint64_t const pad = payload.section->offset - written;
+			if( pad )
+				ok = ok && pad == std::fwrite( padding, 1, pad, file.get() );
+			if( payload.size )
+				ok = ok && payload.size == std::fwrite( payload.data, 1, payload.size, file.get() );
+
+			written = payload.section->offset + payload.size;
+		}
+
+		if( !ok || 0 != std::fflush( file.get() ) )
+			throw Error( "Unable to write '{}'", tmpPath.string() );
+	}
+
+	std::error_code ec;
+	std::filesystem::rename( tmpPath, aPath, ec );
+	if( ec )
+		throw Error( "Unable to rename '{}' to '{}': {}", tmpPath.string(), aPath.string(), ec.message() );
+}
+
+bool is_mesh_file_current( std::filesystem::path const& aCooked, std::filesystem::path const& aSource )
+{
+	MeshFileHeader header;
+	if( !read_header_( aCooked, header ) )
+		return false;
+
+	return is_source_current( header.source, aSource );
+}
+
+// MeshFile
+
+MeshFile::MeshFile( std::filesystem::path const& aPath )
+	: mData( nullptr )
+	, mSize( 0 )
+	, mMapped( false )
+{
+	mData = map_file_( aPath, mSize );
+	mMapped = nullptr != mData;
+
+	if( !mMapped )
+	{
+		std::error_code ec;
+		auto const size = std::filesystem::file_size( aPath, ec );
+		auto const file = open_file_( aPath, "rb" );
+		if( ec || !file )
+			throw Error( "Unable to open mesh file '{}'", aPath.string() );
+
+		mBuffer.resize( std::size_t(size) );
+		if( size != std::fread( mBuffer.data(), 1, mBuffer.size(), file.get() ) )
+			throw Error( "Unable to read mesh file '{}'", aPath.string() );
+
+		mData = mBuffer.data();
+		mSize = mBuffer.size();
+	}
+
+	try
+	{
+		validate_( aPath );
+	}
+	catch( ... )
+	{
+		if( mMapped )
+			unmap_file_( mData, mSize );
+		throw;
+	}
+}
+
+MeshFile::~MeshFile()
+{
+	if( mMapped )
+		unmap_file_( mData, mSize );
+}
+
+MeshFile::MeshFile( MeshFile&& aOther ) noexcept
+	: mData( std::exchange( aOther.mData, nullptr ) )
+	, mSize( std::exchange( aOther.mSize, 0 ) )
+	, mMapped( std::exchange( aOther.mMapped, false ) )
+	, mBuffer( std::move(aOther.mBuffer) )
+{}
+MeshFile& MeshFile::operator= (MeshFile&& aOther) noexcept
+{
+	std::swap( mData, aOther.mData );
+	std::swap( mSize, aOther.mSize );
+	std::swap( mMapped, aOther.mMapped );
+	std::swap( mBuffer, aOther.mBuffer );
+	return *this;
+}
+
+void MeshFile::validate_( std::filesystem::path const& aPath ) const
+{
+	auto const invalid = [&] (char const* aReason) {
+		return Error( "Invalid mesh file '{}': {}", aPath.string(), aReason );
+	};
+
+	if( mSize < sizeof(MeshFileHeader) )
+		throw invalid( "truncated header" );
+
+	auto const& hdr = header();
+	if( 0 != std::memcmp( hdr.magic, kMeshFileMagic, sizeof(kMeshFileMagic) ) )
+		throw invalid( "bad magic" );
+	if( kMeshFileVersion != hdr.version )
+		throw invalid( "unsupported version" );
+	if( 2 != hdr.indexSize && 4 != hdr.indexSize )
+		throw invalid( "bad index size" );
+
+	MeshFileSection const* const sections[] = {
+		&hdr.vertices, &hdr.positions, &hdr.normals, &hdr.texcoords, &hdr.materialIds, &hdr.indices, &hdr.materials,
+		&hdr.lodBounds, &hdr.lodFirstIndex, &hdr.lodIndexCount, &hdr.lodError
+	};
+	for( auto const* section : sections )
+	{
+		if( section->offset % kMeshFileAlign || section->offset > mSize || section->size > mSize - section->offset )
+			throw invalid( "section out of bounds" );
+	}
+
+	std::uint64_t const vc = hdr.vertexCount;
+	auto const& layout = hdr.layout;
+	if( 0 == layout.stride || 0 == layout.attribCount || layout.attribCount > kMeshFileMaxAttribs )
+		throw invalid( "bad vertex layout" );
+	for( std::uint32_t i = 0; i < layout.attribCount; ++i )
+	{
+		if( layout.attribs[i].offset >= layout.stride )
+			throw invalid( "attribute out of bounds" );
+	}
+	if( hdr.vertices.size != vc * layout.stride )
+		throw invalid( "vertex count mismatch" );
+	if( hdr.positions.size != vc * sizeof(Vec3f) )
+		throw invalid( "position count mismatch" );
+	if( hdr.normals.size && hdr.normals.size != vc * sizeof(Vec3f) )
+		throw invalid( "normal count mismatch" );
+	if( hdr.texcoords.size && hdr.texcoords.size != vc * sizeof(Vec2f) )
+		throw invalid( "texcoord count mismatch" );
+	if( hdr.materialIds.size && hdr.materialIds.size != vc * sizeof(float) )
+		throw invalid( "material ID count mismatch" );
+	if( hdr.indices.size != std::uint64_t(hdr.indexCount) * hdr.indexSize )
+		throw invalid( "index count mismatch" );
+	if( hdr.materials.size != std::uint64_t(hdr.materialCount) * sizeof(Material) )
+		throw invalid( "material count mismatch" );
+
+	// Indices are uploaded as-is, so an index past the last vertex would make
+	// the GPU read out of bounds. One pass over the indices, at load time.
+	auto const max_index = [] (auto aIndices) -> std::uint64_t {
+		return aIndices.empty() ? 0 : *std::ranges::max_element( aIndices );
+	};
+
+	auto const mesh = streams();
+	std::uint64_t const maxIndex = 2 == hdr.indexSize ? max_index( mesh.indices16 ) : max_index( mesh.indices32 );
+	if( hdr.indexCount && maxIndex >= vc )
+		throw invalid( "index out of range" );
+
+	// LOD ranges are drawn as they are, too
+	std::uint64_t const ranges = std::uint64_t(hdr.lod.tileCount) * hdr.lod.levelCount;
+	if( hdr.lod.tileCount && (0 == hdr.lod.tileGrid || 0 == hdr.lod.levelCount) )
+		throw invalid( "bad LOD" );
+	if( hdr.lodBounds.size != hdr.lod.tileCount * sizeof(Aabb3f) )
+		throw invalid( "LOD tile count mismatch" );
+	if( hdr.lodFirstIndex.size != ranges * sizeof(std::uint32_t) || hdr.lodIndexCount.size != ranges * sizeof(std::uint32_t) || hdr.lodError.size != ranges * sizeof(float) )
+		throw invalid( "LOD range count mismatch" );
+
+	auto const firstIndex = section_<std::uint32_t>( hdr.lodFirstIndex );
+	auto const indexCount = section_<std::uint32_t>( hdr.lodIndexCount );
+	for( std::size_t i = 0; i < ranges; ++i )
+	{
+		if( firstIndex[i] > hdr.indexCount || indexCount[i] > hdr.indexCount - firstIndex[i] )
+			throw invalid( "LOD range out of bounds" );
+	}
+}
+
+MeshFileHeader const& MeshFile::header() const noexcept
+{
+	assert( mData );
+	return *reinterpret_cast<MeshFileHeader const*>(mData);
+}
+
+MeshStreams MeshFile::streams() const noexcept
+{
+	auto const& hdr = header();
+
+	MeshStreams ret;
+	ret.positions = section_<Vec3f>( hdr.positions );
+	ret.normals = section_<Vec3f>( hdr.normals );
+	ret.texcoords = section_<Vec2f>( hdr.texcoords );
+	ret.materialIds = section_<float>( hdr.materialIds );
+
+	if( 2 == hdr.indexSize )
+		ret.indices16 = section_<std::uint16_t>( hdr.indices );
+	else
+		ret.indices32 = section_<std::uint32_t>( hdr.indices );
+
+	return ret;
+}
+
+std::span<std::byte const> MeshFile::vertices() const noexcept
+{
+	return section_<std::byte>( header().vertices );
+}
+
+std::span<Material const> MeshFile::materials() const noexcept
+{
+	return section_<Material>( header().materials );
+}
+
+TerrainLod MeshFile::lod() const
+{
+	auto const& hdr = header();
+	auto const bounds = section_<Aabb3f>( hdr.lodBounds );
+	auto const firstIndex = section_<std::uint32_t>( hdr.lodFirstIndex );
+	auto const indexCount = section_<std::uint32_t>( hdr.lodIndexCount );
+	auto const error = section_<float>( hdr.lodError );
+
+	TerrainLod ret;
+	ret.tileCount = hdr.lod.tileCount;
+	ret.levelCount = hdr.lod.levelCount;
+	ret.bounds.assign( bounds.begin(), bounds.end() );
+	ret.firstIndex.assign( firstIndex.begin(), firstIndex.end() );
+	ret.indexCount.assign( indexCount.begin(), indexCount.end() );
+	ret.error.assign( error.begin(), error.end() );
+	return ret;
+}
+
+bool MeshFile::is_mapped() const noexcept
+{
+	return mMapped;
+}
+
+template< typename tType >
+std::span<tType const> MeshFile::section_( MeshFileSection const& aSection ) const noexcept
+{
+	return std::span<tType const>(
+		reinterpret_cast<tType const*>(mData + aSection.offset),
+		std::size_t(aSection.size / sizeof(tType))
+	);
+}
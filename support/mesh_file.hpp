@@ -0,0 +1,199 @@
+#ifndef MESH_FILE_HPP_906D06AB_B6D9_4DB4_AFCD_35716FE05197
+#define MESH_FILE_HPP_906D06AB_B6D9_4DB4_AFCD_35716FE05197
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+#include "mesh.hpp"
+#include "terrain_lod.hpp"
+#include "source_fingerprint.hpp"
+
+#include "../vmlib/bounds.hpp"
+
+/* Cooked mesh files (.cw2mesh)
+ *
+ * Binary form of a mesh returned by load_wavefront_obj(), written by the
+ * asset-cook tool after optimize_mesh() (see mesh_optimize.hpp) and, for
+ * the terrain, build_terrain_lod() (see terrain_lod.hpp). The file
+ * starts with a MeshFileHeader, followed by the sections that it
+ * references. Each section starts at a multiple of kMeshFileAlign bytes.
+ * All values are little endian.
+ *
+ *   vertices     vertexCount x layout.stride bytes, interleaved
+ *   positions    vertexCount x Vec3f
+ *   normals      vertexCount x Vec3f     (may be empty)
+ *   texcoords    vertexCount x Vec2f     (may be empty)
+ *   materialIds  vertexCount x float     (may be empty)
+ *   indices      indexCount x uint16 or uint32, see indexSize
+ *   materials    materialCount x Material
+ *   lodBounds    lod.tileCount x Aabb3f  (empty without LOD, as are these:)
+ *   lodFirstIndex, lodIndexCount
+ *                lod.levelCount x lod.tileCount x uint32
+ *   lodError     lod.levelCount x lod.tileCount x float
+ *
+ * With LOD, the vertices include the skirts, the indices are those of all
+ * levels, and the lod* sections hold the tables of the TerrainLod. The
+ * bounds in the header include the skirts as well.
+ *
+ * The vertices section holds the same vertices as the streams after it,
+ * interleaved in the layout that the header describes (one of the layouts in
+ * mesh_layouts.hpp). If that is the layout that a loader wants, the mapped
+ * section is passed to glBufferData() without any copies. The separate
+ * streams are kept for everything else, e.g., for quantization; pages that
+ * are never touched cost disk space, but no load time.
+ *
+ * The header records a fingerprint (see source_fingerprint.hpp) of the OBJ
+ * that the file was cooked from. Only the OBJ is fingerprinted; re-run
+ * asset-cook after editing an MTL file.
+ */
+
+inline constexpr char kMeshFileMagic[8] = { 'C', 'W', '2', 'M', 'E', 'S', 'H', '\0' };
+inline constexpr std::uint32_t kMeshFileVersion = 4; // 2: meshes are optimized, 3: interleaved vertices, 4: terrain LOD
+inline constexpr std::size_t kMeshFileAlign = 16;
+inline constexpr std::size_t kMeshFileMaxAttribs = 4;
+
+struct MeshFileSection
+{
+	std::uint64_t offset; // bytes, from the start of the file
+	std::uint64_t size;   // bytes
+};
+
+// One attribute of the interleaved vertices, see VertexAttrib
+struct MeshFileAttrib
+{
+	std::uint16_t location;
+	std::uint16_t count;
+	std::uint32_t glType;
+	std::uint32_t normalized;
+	std::uint32_t offset; // bytes, from the start of the vertex
+
+	bool operator== (MeshFileAttrib const&) const = default;
+};
+
+// Interleaved vertex layout, see VertexLayout. Unused attributes are zero.
+struct MeshFileVertexLayout
+{
+	std::uint32_t stride; // bytes
+	std::uint32_t attribCount;
+	std::uint32_t reserved[2];
+	MeshFileAttrib attribs[kMeshFileMaxAttribs];
+
+	bool operator== (MeshFileVertexLayout const&) const = default;
+};
+
+// Terrain LOD, see TerrainLod. The options that it was built with are
+// recorded, so that a loader can check them. All zero without LOD.
+struct MeshFileLod
+{
+	std::uint32_t tileGrid;   // see TerrainLodOptions
+	std::uint32_t levelCount; // see TerrainLodOptions
+	std::uint32_t tileCount;
+	std::uint32_t reserved;
+};
+
+struct MeshFileHeader
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t indexSize; // 2 or 4 bytes
+
+	std::uint32_t vertexCount;
+	std::uint32_t indexCount;
+	std::uint32_t materialCount;
+	std::uint32_t reserved;
+
+	Aabb3f bounds;
+
+	SourceFingerprint source;
+	MeshFileVertexLayout layout;
+	MeshFileLod lod;
+
+	MeshFileSection vertices;
+	MeshFileSection positions;
+	MeshFileSection normals;
+	MeshFileSection texcoords;
+	MeshFileSection materialIds;
+	MeshFileSection indices;
+	MeshFileSection materials;
+	MeshFileSection lodBounds;
+	MeshFileSection lodFirstIndex;
+	MeshFileSection lodIndexCount;
+	MeshFileSection lodError;
+};
+
+static_assert( std::is_trivially_copyable_v<MeshFileHeader> );
+static_assert( sizeof(MeshFileHeader) % kMeshFileAlign == 0 );
+static_assert( sizeof(Material) == 4*sizeof(float) );
+
+// Writes aMesh to aPath in the format described above. aVertices holds the
+// vertices of aMesh interleaved in aLayout (see mesh_layouts.hpp). If aLod
+// is not empty, build_terrain_lod() built it from aMesh with aLodOptions,
+// so aMesh includes the skirts. 16-bit indices are used if all vertices can
+// be addressed with them.
+//
+// Throws Error on failure.
+void write_mesh_file(
+	std::filesystem::path const& aPath,
+	SimpleMeshData const& aMesh,
+	std::span<Material const> aMaterials,
+	MeshFileVertexLayout const& aLayout,
+	std::span<std::byte const> aVertices,
+	TerrainLod const& aLod,
+	TerrainLodOptions const& aLodOptions,
+	SourceFingerprint const& aSource
+);
+
+// True if aCooked exists and was cooked from the current version of aSource
+// (see is_source_current()).
+bool is_mesh_file_current(
+	std::filesystem::path const& aCooked,
+	std::filesystem::path const& aSource
+);
+
+// Read-only view of a cooked mesh file. The file is memory mapped where
+// possible, and read into memory otherwise.
+class MeshFile final
+{
+	public:
+		// Throws Error if the file cannot be opened or is not a valid mesh
+		// file of the current version.
+		explicit MeshFile( std::filesystem::path const& );
+		~MeshFile();
+
+		MeshFile( MeshFile const& ) = delete;
+		MeshFile& operator= (MeshFile const&) = delete;
+
+		MeshFile( MeshFile&& ) noexcept;
+		MeshFile& operator= (MeshFile&&) noexcept;
+
+	public:
+		MeshFileHeader const& header() const noexcept;
+
+		MeshStreams streams() const noexcept;
+		std::span<std::byte const> vertices() const noexcept; // see header().layout
+		std::span<Material const> materials() const noexcept;
+
+		// Copies the LOD tables; empty if the file has none
+		TerrainLod lod() const;
+
+		bool is_mapped() const noexcept;
+
+	private:
+		void validate_( std::filesystem::path const& ) const;
+
+		template< typename tType >
+		std::span<tType const> section_( MeshFileSection const& ) const noexcept;
+
+	private:
+		std::byte const* mData;
+		std::size_t mSize;
+		bool mMapped;
+
+		std::vector<std::byte> mBuffer; // if not mapped
+};
+
+#endif // MESH_FILE_HPP_906D06AB_B6D9_4DB4_AFCD_35716FE05197
@@ -0,0 +1,114 @@
+#ifndef MESH_LAYOUTS_HPP_253EED8B_70BA_4971_9754_DDC5693FA55F
+#define MESH_LAYOUTS_HPP_253EED8B_70BA_4971_9754_DDC5693FA55F
+
+#include <span>
+#include <array>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "error.hpp"
+#include "mesh.hpp"
+#include "mesh_file.hpp"
+#include "terrain_lod.hpp"
+#include "vertex_layout.hpp"
+
+#include "../vmlib/packing.hpp"
+
+/* Vertex layouts of the meshes in assets/cw2
+ *
+ * The layouts match the inputs of the shaders in assets/cw2. main uploads
+ * meshes with them, and asset-cook stores the vertices of cooked mesh files
+ * in them (see mesh_file.hpp), so that main can upload those as they are.
+ * Likewise, asset-cook bakes the terrain LOD with kTerrainLod.
+ */
+
+// Terrain tiles and levels of detail, see terrain_lod.hpp
+inline constexpr TerrainLodOptions kTerrainLod{ .tileGrid = 16, .levelCount = 4 };
+
+using TexturedVertexLayout = VertexLayout< // default.vert
+	VertexAttrib<0, Vec3f>,
+	VertexAttrib<1, Vec3f>,
+	VertexAttrib<2, Vec2f>
+>;
+using MaterialVertexLayout = VertexLayout< // material.vert
+	VertexAttrib<0, Vec3f>,
+	VertexAttrib<1, Vec3f>,
+	VertexAttrib<3, float>
+>;
+using UntexturedVertexLayout = VertexLayout< // default.vert, texturing disabled
+	VertexAttrib<0, Vec3f>,
+	VertexAttrib<1, Vec3f>
+>;
+
+// Quantized versions (see mesh_quantize.hpp); the shaders decode them if
+// uQuantized is set
+using QuantizedTexturedVertexLayout = VertexLayout<
+	VertexAttrib<0, std::array<std::uint16_t, 3>, true>,
+	VertexAttrib<1, OctNormal16, true>,
+	VertexAttrib<2, Half2>
+>;
+using QuantizedMaterialVertexLayout = VertexLayout<
+	VertexAttrib<0, std::array<std::uint16_t, 3>, true>,
+	VertexAttrib<1, OctNormal16, true>,
+	VertexAttrib<3, std::uint8_t>
+>;
+
+// Stream of a MeshStreams or QuantizedMesh that feeds the attribute at
+// tLocation
+template< GLuint tLocation, typename tMesh >
+auto mesh_stream( tMesh const& aMesh )
+{
+	static_assert( tLocation <= 3, "No mesh stream for this attribute location" );
+
+	if constexpr( 0 == tLocation ) return std::span( aMesh.positions );
+	else if constexpr( 1 == tLocation ) return std::span( aMesh.normals );
+	else if constexpr( 2 == tLocation ) return std::span( aMesh.texcoords );
+	else return std::span( aMesh.materialIds );
+}
+
+// Interleaves the streams of aMesh (a MeshStreams or a QuantizedMesh) that
+// tLayout uses into aOut, which holds one vertex per position.
+//
+// Throws Error if the mesh lacks a stream that the layout requires.
+template< typename tLayout, typename tMesh >
+void interleave_mesh( std::span<typename tLayout::Vertex> aOut, tMesh const& aMesh )
+{
+	[&]<std::size_t... tI>( std::index_sequence<tI...> ) {
+		std::size_t const sizes[] = { mesh_stream<tLayout::template Attrib<tI>::location>( aMesh ).size()... };
+		GLuint const locations[] = { tLayout::template Attrib<tI>::location... };
+		for( std::size_t i = 0; i < sizeof...(tI); ++i )
+		{
+			if( sizes[i] != aOut.size() )
+				throw Error( "Mesh has {} vertices, but {} values for attribute {}", aOut.size(), sizes[i], locations[i] );
+		}
+
+		interleave_into<tLayout>( aOut, mesh_stream<tLayout::template Attrib<tI>::location>( aMesh )... );
+	}( std::make_index_sequence<tLayout::kAttribCount>() );
+}
+
+// Description of tLayout for MeshFileHeader::layout
+template< typename tLayout >
+constexpr MeshFileVertexLayout mesh_file_layout() noexcept
+{
+	static_assert( tLayout::kAttribCount <= kMeshFileMaxAttribs );
+
+	MeshFileVertexLayout ret{};
+	ret.stride = std::uint32_t(tLayout::kStride);
+	ret.attribCount = std::uint32_t(tLayout::kAttribCount);
+
+	[&]<std::size_t... tI>( std::index_sequence<tI...> ) {
+		( (ret.attribs[tI] = MeshFileAttrib{
+			std::uint16_t(tLayout::template Attrib<tI>::location),
+			std::uint16_t(tLayout::template Attrib<tI>::count),
+			std::uint32_t(tLayout::template Attrib<tI>::glType),
+			std::uint32_t(tLayout::template Attrib<tI>::normalized),
+			std::uint32_t(tLayout::kOffsets[tI])
+		}), ... );
+	}( std::make_index_sequence<tLayout::kAttribCount>() );
+
+	return ret;
+}
+
+#endif // MESH_LAYOUTS_HPP_253EED8B_70BA_4971_9754_DDC5693FA55F
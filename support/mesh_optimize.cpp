@@ -0,0 +1,348 @@
+#include "mesh_optimize.hpp"
+
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <unordered_set>
+
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	constexpr std::uint32_t kNone_ = std::numeric_limits<std::uint32_t>::max();
+
+	// Triangles adjacent to each vertex, in compressed row form.
+	struct Adjacency_
+	{
+		std::vector<std::uint32_t> offsets; // vertexCount+1
+		std::vector<std::uint32_t> triangles;
+	};
+
+	Adjacency_ build_adjacency_( std::span<std::uint32_t const> aIndices, std::size_t aVertexCount )
+	{
+		Adjacency_ ret;
+		ret.offsets.assign( aVertexCount+1, 0 );
+		for( auto const v : aIndices )
+			++ret.offsets[v+1];
+
+		std::partial_sum( ret.offsets.begin(), ret.offsets.end(), ret.offsets.begin() );
+
+		std::vector<std::uint32_t> fill( ret.offsets.begin(), ret.offsets.end()-1 );
+		ret.triangles.resize( aIndices.size() );
+		for( std::size_t i = 0; i < aIndices.size(); ++i )
+			ret.triangles[fill[aIndices[i]]++] = std::uint32_t(i / 3);
+
+		return ret;
+	}
+
+	Vec3f triangle_centroid_( std::span<Vec3f const> aPositions, std::uint32_t const* aTri ) noexcept
+	{
+		return (1.f/3.f) * (aPositions[aTri[0]] + aPositions[aTri[1]] + aPositions[aTri[2]]);
+	}
+	// Area-weighted normal (twice the area)
+	Vec3f triangle_normal_( std::span<Vec3f const> aPositions, std::uint32_t const* aTri ) noexcept
+	{
+		Vec3f const p0 = aPositions[aTri[0]];
+		return cross( aPositions[aTri[1]] - p0, aPositions[aTri[2]] - p0 );
+	}
+}
+
+VertexCacheStats analyze_vertex_cache( std::span<std::uint32_t const> aIndices, std::size_t aVertexCount, std::size_t aCacheSize )
+{
+	assert( aIndices.size() % 3 == 0 );
+
+	// FIFO: a vertex is in the cache if fewer than aCacheSize misses have
+	// happened since it was inserted.
+	std::vector<std::size_t> insertedAt( aVertexCount, std::numeric_limits<std::size_t>::max() );
+	std::size_t misses = 0, referenced = 0;
+
+	for( auto const v : aIndices )
+	{
+		assert( v < aVertexCount );
+		if( std::numeric_limits<std::size_t>::max() == insertedAt[v] )
+			++referenced;
+		else if( misses - insertedAt[v] < aCacheSize )
+			continue;
+
+		insertedAt[v] = misses++;
+	}
+
+	std::size_t const triangles = aIndices.size() / 3;
+	return VertexCacheStats{
+		triangles ? float(misses) / float(triangles) : 0.f,
+		referenced ? float(misses) / float(referenced) : 0.f
+	};
+}
+
+void index_mesh( SimpleMeshData& aMesh )
+{
+	if( !aMesh.indices.empty() )
+		return;
+
+	std::size_t const count = aMesh.positions.size();
+	bool const hasNormals = aMesh.normals.size() == count;
+	bool const hasTexcoords = aMesh.texcoords.size() == count;
+	bool const hasMaterials = aMesh.materialIds.size() == count;
+
+	// Attributes of each vertex as raw words; vertices are identical if all
+	// words are.
+	std::size_t const stride = 3 + (hasNormals ? 3 : 0) + (hasTexcoords ? 2 : 0) + (hasMaterials ? 1 : 0);
+	std::vector<std::uint32_t> words( count * stride );
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		std::uint32_t* w = words.data() + i*stride;
+		std::memcpy( w, &aMesh.positions[i], sizeof(Vec3f) ); w += 3;
+		if( hasNormals ) { std::memcpy( w, &aMesh.normals[i], sizeof(Vec3f) ); w += 3; }
+		if( hasTexcoords ) { std::memcpy( w, &aMesh.texcoords[i], sizeof(Vec2f) ); w += 2; }
+		if( hasMaterials ) { std::memcpy( w, &aMesh.materialIds[i], sizeof(float) ); }
+	}
+
+	auto const hash = [&] (std::uint32_t aV) {
+		std::uint64_t h = 0xcbf29ce484222325ull;
+		for( std::size_t j = 0; j < stride; ++j )
+			h = (h ^ words[aV*stride+j]) * 0x100000001b3ull;
+		return std::size_t(h ^ (h >> 32));
+	};
+	auto const equal = [&] (std::uint32_t aA, std::uint32_t aB) {
+		return std::equal( words.begin() + aA*stride, words.begin() + (aA+1)*stride, words.begin() + aB*stride );
+	};
+
+	std::unordered_set<std::uint32_t, decltype(hash), decltype(equal)> unique( count, hash, equal );
+
+	// Indices refer to the first copy of each vertex; optimize_vertex_fetch()
+	// compacts the vertex arrays afterwards.
+	aMesh.indices.resize( count );
+	for( std::uint32_t i = 0; i < count; ++i )
+		aMesh.indices[i] = *unique.insert( i ).first;
+}
+
+std::vector<std::uint32_t> optimize_vertex_cache( std::span<std::uint32_t> aIndices, std::size_t aVertexCount, std::size_t aCacheSize )
+{
+	assert( aIndices.size() % 3 == 0 );
+	std::size_t const triangleCount = aIndices.size() / 3;
+
+	std::vector<std::uint32_t> clusters;
+	if( 0 == triangleCount )
+		return clusters;
+
+	auto const adjacency = build_adjacency_( aIndices, aVertexCount );
+
+	// Live triangle count per vertex
+	std::vector<std::uint32_t> live( aVertexCount );
+	for( std::size_t v = 0; v < aVertexCount; ++v )
+		live[v] = adjacency.offsets[v+1] - adjacency.offsets[v];
+
+	std::vector<std::size_t> cacheTime( aVertexCount, 0 );
+	std::vector<std::uint8_t> emitted( triangleCount, 0 );
+	std::vector<std::uint32_t> deadEnd;
+	std::vector<std::uint32_t> candidates;
+
+	std::vector<std::uint32_t> out;
+	out.reserve( aIndices.size() );
+
+	std::size_t time = aCacheSize + 1;
+	std::size_t cursor = 0;
+
+	// Next vertex with live triangles after a dead end: most recently
+	// referenced first, then in input order.
+	auto const skip_dead_end = [&] () -> std::uint32_t {
+		while( !deadEnd.empty() )
+		{
+			std::uint32_t const d = deadEnd.back();
+			deadEnd.pop_back();
+			if( live[d] > 0 )
+				return d;
+		}
+		for( ; cursor < aVertexCount; ++cursor )
+		{
+			if( live[cursor] > 0 )
+				return std::uint32_t(cursor);
+		}
+		return kNone_;
+	};
+
+	std::uint32_t fan = skip_dead_end();
+	bool restarted = true;
+	while( kNone_ != fan )
+	{
+		if( restarted )
+			clusters.push_back( std::uint32_t(out.size() / 3) );
+
+		// Emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for( auto k = adjacency.offsets[fan]; k < adjacency.offsets[fan+1]; ++k )
+		{
+			std::uint32_t const t = adjacency.triangles[k];
+			if( emitted[t] )
+				continue;
+
+			for( std::size_t j = 0; j < 3; ++j )
+			{
+				std::uint32_t const v = aIndices[t*3+j];
+				out.push_back( v );
+				deadEnd.push_back( v );
+				candidates.push_back( v );
+				--live[v];
+
+				if( time - cacheTime[v] > aCacheSize )
+					cacheTime[v] = time++;
+			}
+
+			emitted[t] = 1;
+		}
+
+		// Pick the candidate that has been in the cache longest, but that
+		// will not be evicted before its remaining triangles are emitted. If
+		// there is none, restart from a dead end.
+		std::uint32_t best = kNone_;
+		std::size_t bestPriority = 0;
+		for( auto const v : candidates )
+		{
+			if( 0 == live[v] )
+				continue;
+
+			std::size_t priority = 0;
+			std::size_t const age = time - cacheTime[v];
+			if( age + 2*live[v] <= aCacheSize )
+				priority = age;
+
+			if( priority > bestPriority )
+			{
+				best = v;
+				bestPriority = priority;
+			}
+		}
+
+		restarted = kNone_ == best;
+		fan = restarted ? skip_dead_end() : best;
+	}
+
+	assert( out.size() == aIndices.size() );
+	std::copy( out.begin(), out.end(), aIndices.begin() );
+	return clusters;
+}
+
+void optimize_overdraw( std::span<std::uint32_t> aIndices, std::span<Vec3f const> aPositions, std::span<std::uint32_t const> aClusters, float aThreshold, std::size_t aCacheSize )
+{
+	std::size_t const triangleCount = aIndices.size() / 3;
+	std::size_t const clusterCount = aClusters.size();
+	if( clusterCount < 2 )
+		return;
+
+	auto const cluster_end = [&] (std::size_t aC) {
+		return aC+1 < clusterCount ? std::size_t(aClusters[aC+1]) : triangleCount;
+	};
+
+	// Area-weighted centroid of the mesh
+	Vec3f meshCentroid{ 0.f, 0.f, 0.f };
+	float meshArea = 0.f;
+	for( std::size_t t = 0; t < triangleCount; ++t )
+	{
+		float const area = length( triangle_normal_( aPositions, &aIndices[t*3] ) );
+		meshCentroid += area * triangle_centroid_( aPositions, &aIndices[t*3] );
+		meshArea += area;
+	}
+	if( meshArea > 0.f )
+		meshCentroid = (1.f / meshArea) * meshCentroid;
+
+	// Clusters facing away from the centre are likely to occlude the others,
+	// so they go first.
+	std::vector<float> sortKey( clusterCount );
+	for( std::size_t c = 0; c < clusterCount; ++c )
+	{
+		Vec3f centroid{ 0.f, 0.f, 0.f }, normal{ 0.f, 0.f, 0.f };
+		float area = 0.f;
+		for( std::size_t t = aClusters[c]; t < cluster_end( c ); ++t )
+		{
+			Vec3f const n = triangle_normal_( aPositions, &aIndices[t*3] );
+			float const a = length( n );
+			centroid += a * triangle_centroid_( aPositions, &aIndices[t*3] );
+			normal += n;
+			area += a;
+		}
+		if( area > 0.f )
+			centroid = (1.f / area) * centroid;
+
+		sortKey[c] = dot( centroid - meshCentroid, normal );
+	}
+
+	std::vector<std::uint32_t> order( clusterCount );
+	std::iota( order.begin(), order.end(), 0u );
+	std::stable_sort( order.begin(), order.end(), [&] (std::uint32_t aA, std::uint32_t aB) {
+		return sortKey[aA] > sortKey[aB];
+	} );
+
+	std::vector<std::uint32_t> sorted;
+	sorted.reserve( aIndices.size() );
+	for( auto const c : order )
+		sorted.insert( sorted.end(), aIndices.begin() + aClusters[c]*3, aIndices.begin() + cluster_end( c )*3 );
+
+	// Keep the new order only if the vertex cache does not suffer too much
+	std::size_t vertexCount = 0;
+	for( auto const v : aIndices )
+		vertexCount = std::max<std::size_t>( vertexCount, v+1 );
+
+	float const before = analyze_vertex_cache( aIndices, vertexCount, aCacheSize ).acmr;
+	float const after = analyze_vertex_cache( sorted, vertexCount, aCacheSize ).acmr;
+	if( after <= aThreshold * before )
+		std::copy( sorted.begin(), sorted.end(), aIndices.begin() );
+}
+
+void optimize_vertex_fetch( SimpleMeshData& aMesh )
+{
+	std::size_t const count = aMesh.positions.size();
+
+	std::vector<std::uint32_t> remap( count, kNone_ );
+	std::uint32_t next = 0;
+	for( auto& v : aMesh.indices )
+	{
+		if( kNone_ == remap[v] )
+			remap[v] = next++;
+		v = remap[v];
+	}
+
+	auto const apply = [&] (auto& aStream) {
+		if( aStream.size() != count )
+			return;
+
+		std::remove_reference_t<decltype(aStream)> reordered( next );
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			if( kNone_ != remap[i] )
+				reordered[remap[i]] = aStream[i];
+		}
+		aStream = std::move(reordered);
+	};
+
+	apply( aMesh.positions );
+	apply( aMesh.normals );
+	apply( aMesh.texcoords );
+	apply( aMesh.materialIds );
+}
+
+MeshOptimizeReport optimize_mesh( SimpleMeshData& aMesh, MeshOptimizeOptions const& aOptions )
+{
+	MeshOptimizeReport ret;
+
+	// The statistics of a non-indexed mesh are those of trivial indices
+	if( aMesh.indices.empty() )
+	{
+		std::size_t const count = aMesh.positions.size();
+		ret.before = VertexCacheStats{ count ? 3.f : 0.f, count ? 1.f : 0.f };
+		index_mesh( aMesh );
+	}
+	else
+	{
+		ret.before = analyze_vertex_cache( aMesh.indices, aMesh.positions.size(), aOptions.cacheSize );
+	}
+
+	auto const clusters = optimize_vertex_cache( aMesh.indices, aMesh.positions.size(), aOptions.cacheSize );
+	if( aOptions.overdraw )
+		optimize_overdraw( aMesh.indices, aMesh.positions, clusters, aOptions.overdrawThreshold, aOptions.cacheSize );
+
+	optimize_vertex_fetch( aMesh );
+
+	ret.after = analyze_vertex_cache( aMesh.indices, aMesh.positions.size(), aOptions.cacheSize );
+	return ret;
+}
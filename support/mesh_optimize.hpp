@@ -0,0 +1,90 @@
+#ifndef MESH_OPTIMIZE_HPP_40CC1EC6_1DAB_45A2_9640_095C49EE9137
+#define MESH_OPTIMIZE_HPP_40CC1EC6_1DAB_45A2_9640_095C49EE9137
+
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh.hpp"
+
+/* Mesh optimization
+ *
+ * Reorders indexed triangle meshes for the GPU:
+ *
+ *   optimize_vertex_cache()  -- triangle order for the post-transform vertex
+ *                               cache, with the Tipsify algorithm (Sander et
+ *                               al. 2007, "Fast Triangle Reordering for
+ *                               Vertex Locality and Reduced Overdraw").
+ *   optimize_overdraw()      -- view-independent overdraw reduction (ibid.):
+ *                               sorts the clusters found by Tipsify so that
+ *                               outward facing ones are drawn first.
+ *   optimize_vertex_fetch()  -- vertex order matching the first use in the
+ *                               index buffer, for locality of vertex fetches.
+ *
+ * optimize_mesh() runs all three. The cache is modelled as a FIFO with
+ * kDefaultCacheSize entries; analyze_vertex_cache() reports the average
+ * cache miss ratio per triangle (ACMR, >= 0.5 for closed meshes, 3 at
+ * worst) and per vertex (ATVR, 1 at best).
+ */
+
+inline constexpr std::size_t kDefaultCacheSize = 16;
+
+struct VertexCacheStats
+{
+	float acmr; // misses per triangle
+	float atvr; // misses per referenced vertex
+};
+
+VertexCacheStats analyze_vertex_cache(
+	std::span<std::uint32_t const> aIndices,
+	std::size_t aVertexCount,
+	std::size_t aCacheSize = kDefaultCacheSize
+);
+
+// Welds identical vertices of a non-indexed mesh (see SimpleMeshData) and
+// fills in its indices. Does nothing if the mesh is already indexed.
+void index_mesh( SimpleMeshData& );
+
+// Reorders the triangles in aIndices in place. Returns the first triangle
+// of each cluster, i.e., the points where the algorithm had to restart from
+// a dead end. These are valid split points for optimize_overdraw().
+std::vector<std::uint32_t> optimize_vertex_cache(
+	std::span<std::uint32_t> aIndices,
+	std::size_t aVertexCount,
+	std::size_t aCacheSize = kDefaultCacheSize
+);
+
+// Reorders the clusters (see optimize_vertex_cache()) in aIndices in place.
+// The new order is only kept if its ACMR stays within aThreshold times the
+// original ACMR.
+void optimize_overdraw(
+	std::span<std::uint32_t> aIndices,
+	std::span<Vec3f const> aPositions,
+	std::span<std::uint32_t const> aClusters,
+	float aThreshold = 1.05f,
+	std::size_t aCacheSize = kDefaultCacheSize
+);
+
+// Renumbers the vertices of aMesh in order of their first use. Unreferenced
+// vertices are removed.
+void optimize_vertex_fetch( SimpleMeshData& aMesh );
+
+struct MeshOptimizeOptions
+{
+	std::size_t cacheSize = kDefaultCacheSize;
+	bool overdraw = true;
+	float overdrawThreshold = 1.05f;
+};
+
+struct MeshOptimizeReport
+{
+	VertexCacheStats before;
+	VertexCacheStats after;
+};
+
+// Indexes aMesh if required, then runs the optimizations above.
+MeshOptimizeReport optimize_mesh( SimpleMeshData& aMesh, MeshOptimizeOptions const& = {} );
+
+#endif // MESH_OPTIMIZE_HPP_40CC1EC6_1DAB_45A2_9640_095C49EE9137
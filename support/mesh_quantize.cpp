@@ -0,0 +1,68 @@
+#include "mesh_quantize.hpp"
+
+#include <span>
+#include <algorithm>
+
+#include "error.hpp"
+
+#include "../vmlib/bounds.hpp"
+
+QuantizedMesh quantize_mesh( MeshStreams const& aMesh )
+{
+	std::size_t const count = aMesh.positions.size();
+
+	QuantizedMesh ret;
+
+	// Positions: unorm16 relative to the bounds. Flat axes get a scale of zero
+	// and quantize to zero.
+	Aabb3f const bounds = make_aabb( aMesh.positions );
+	Vec3f const extent = count ? bounds.max - bounds.min : Vec3f{ 0.f, 0.f, 0.f };
+
+	ret.positionOffset = count ? bounds.min : Vec3f{ 0.f, 0.f, 0.f };
+	ret.positionScale = extent;
+	ret.maxPositionError = 0.f;
+
+	auto const inv = [] (float aExtent) { return aExtent > 0.f ? 1.f / aExtent : 0.f; };
+	Vec3f const rcp{ inv( extent.x ), inv( extent.y ), inv( extent.z ) };
+
+	ret.positions.resize( count );
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		Vec3f const rel = aMesh.positions[i] - ret.positionOffset;
+		auto& q = ret.positions[i];
+		q[0] = pack_unorm16( rel.x * rcp.x );
+		q[1] = pack_unorm16( rel.y * rcp.y );
+		q[2] = pack_unorm16( rel.z * rcp.z );
+
+		// Decode like the shader does
+		Vec3f const decoded{
+			ret.positionOffset.x + ret.positionScale.x * unpack_unorm16( q[0] ),
+			ret.positionOffset.y + ret.positionScale.y * unpack_unorm16( q[1] ),
+			ret.positionOffset.z + ret.positionScale.z * unpack_unorm16( q[2] )
+		};
+		ret.maxPositionError = std::max( ret.maxPositionError, length( decoded - aMesh.positions[i] ) );
+	}
+
+	// Normals and texture coordinates, with the batched encoders
+	ret.normals.resize( aMesh.normals.size() );
+	pack_oct16( aMesh.normals, std::span<OctNormal16>( ret.normals ) );
+
+	static_assert( sizeof(Vec2f) == 2*sizeof(float) && sizeof(Half2) == 2*sizeof(std::uint16_t) );
+	ret.texcoords.resize( aMesh.texcoords.size() );
+	pack_half(
+		std::span<float const>( reinterpret_cast<float const*>(aMesh.texcoords.data()), 2*aMesh.texcoords.size() ),
+		std::span<std::uint16_t>( reinterpret_cast<std::uint16_t*>(ret.texcoords.data()), 2*ret.texcoords.size() )
+	);
+
+	ret.materialIds.resize( aMesh.materialIds.size() );
+	for( std::size_t i = 0; i < aMesh.materialIds.size(); ++i )
+	{
+		float const id = aMesh.materialIds[i];
+		if( id >= 255.f )
+			throw Error( "Material ID {} does not fit into 8 bits", id );
+
+		ret.materialIds[i] = id < 0.f ? std::uint8_t(255) : std::uint8_t(id);
+	}
+
+	return ret;
+}
@@ -0,0 +1,48 @@
+#ifndef MESH_QUANTIZE_HPP_6F5F0198_52B2_4F3B_97C9_339DB2C17793
+#define MESH_QUANTIZE_HPP_6F5F0198_52B2_4F3B_97C9_339DB2C17793
+
+#include <array>
+#include <vector>
+
+#include <cstdint>
+
+#include "mesh.hpp"
+#include "../vmlib/packing.hpp"
+
+/* Quantized vertex streams
+ *
+ * Compact versions of the vertex streams of a mesh (see MeshStreams):
+ *
+ *   positions    3 x unorm16, relative to the bounds of the mesh (8 bytes
+ *                in a vertex layout, due to padding)
+ *   normals      octahedral, 2 x snorm16 (4 bytes)
+ *   texcoords    2 x half (4 bytes)
+ *   materialIds  uint8 (4 bytes in a vertex layout)
+ *
+ * Compared to 12+12+8 or 12+12+4 bytes for the float streams. The shaders
+ * decode positions as positionOffset + positionScale * p (where p is the
+ * normalized attribute) and normals with the inverse octahedral mapping.
+ */
+
+struct QuantizedMesh
+{
+	std::vector<std::array<std::uint16_t, 3>> positions;
+	std::vector<OctNormal16> normals;
+	std::vector<Half2> texcoords;
+	std::vector<std::uint8_t> materialIds;
+
+	Vec3f positionScale;
+	Vec3f positionOffset;
+
+	// Largest distance between an original and a decoded position
+	float maxPositionError;
+};
+
+// Quantizes the vertex streams of aMesh. Streams that are empty in aMesh are
+// empty in the result; indices are not copied. Negative material IDs (no
+// material) become 255.
+//
+// Throws Error if a material ID does not fit into 8 bits.
+QuantizedMesh quantize_mesh( MeshStreams const& aMesh );
+
+#endif // MESH_QUANTIZE_HPP_6F5F0198_52B2_4F3B_97C9_339DB2C17793
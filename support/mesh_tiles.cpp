@@ -0,0 +1,74 @@
+#include "mesh_tiles.hpp"
+
+#include <numeric>
+#include <algorithm>
+
+#include <cassert>
+
+MeshTiles tile_mesh( std::span<Vec3f const> aPositions, std::span<std::uint32_t> aIndices, std::size_t aTilesX, std::size_t aTilesZ )
+{
+	assert( aIndices.size() % 3 == 0 );
+	assert( aTilesX > 0 && aTilesZ > 0 );
+
+	std::size_t const triangleCount = aIndices.size() / 3;
+	std::size_t const tileCount = aTilesX * aTilesZ;
+
+	Aabb3f bounds = kEmptyAabb3f;
+	for( auto const v : aIndices )
+		bounds = extend( bounds, aPositions[v] );
+
+	float const sx = bounds.max.x > bounds.min.x ? float(aTilesX) / (bounds.max.x - bounds.min.x) : 0.f;
+	float const sz = bounds.max.z > bounds.min.z ? float(aTilesZ) / (bounds.max.z - bounds.min.z) : 0.f;
+
+	// Tile of each triangle, and the number of triangles per tile
+	std::vector<std::uint32_t> tileOf( triangleCount );
+	std::vector<std::uint32_t> start( tileCount+1, 0 );
+
+	for( std::size_t t = 0; t < triangleCount; ++t )
+	{
+		Vec3f const c = (1.f/3.f) * (aPositions[aIndices[t*3+0]] + aPositions[aIndices[t*3+1]] + aPositions[aIndices[t*3+2]]);
+
+		auto const cell = [] (float aV, std::size_t aCount) {
+			return std::min( std::size_t(std::max( aV, 0.f )), aCount-1 );
+		};
+		std::size_t const tx = cell( (c.x - bounds.min.x) * sx, aTilesX );
+		std::size_t const tz = cell( (c.z - bounds.min.z) * sz, aTilesZ );
+
+		tileOf[t] = std::uint32_t(tz * aTilesX + tx);
+		++start[tileOf[t]+1];
+	}
+
+	std::partial_sum( start.begin(), start.end(), start.begin() );
+
+	// Stable counting sort of the triangles by tile
+	std::vector<std::uint32_t> sorted( aIndices.size() );
+	std::vector<std::uint32_t> fill( start.begin(), start.end()-1 );
+	std::vector<Aabb3f> tileBounds( tileCount, kEmptyAabb3f );
+
+	for( std::size_t t = 0; t < triangleCount; ++t )
+	{
+		std::uint32_t const tile = tileOf[t];
+		std::uint32_t const dst = fill[tile]++;
+		for( std::size_t j = 0; j < 3; ++j )
+		{
+			std::uint32_t const v = aIndices[t*3+j];
+			sorted[dst*3+j] = v;
+			tileBounds[tile] = extend( tileBounds[tile], aPositions[v] );
+		}
+	}
+
+	std::copy( sorted.begin(), sorted.end(), aIndices.begin() );
+
+	MeshTiles ret;
+	for( std::size_t i = 0; i < tileCount; ++i )
+	{
+		if( start[i+1] == start[i] )
+			continue;
+
+		ret.firstIndex.emplace_back( start[i]*3 );
+		ret.indexCount.emplace_back( (start[i+1]-start[i])*3 );
+		ret.bounds.emplace_back( tileBounds[i] );
+	}
+
+	return ret;
+}
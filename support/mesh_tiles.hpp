@@ -0,0 +1,50 @@
+#ifndef MESH_TILES_HPP_472E6162_A3AA_4447_8A1A_4EABD8EB3549
+#define MESH_TILES_HPP_472E6162_A3AA_4447_8A1A_4EABD8EB3549
+
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/bounds.hpp"
+
+/* Mesh tiles
+ *
+ * Splits a large, mostly flat mesh (i.e., the terrain) into a grid of tiles
+ * in the XZ plane, so that tiles outside of the view frustum can be skipped
+ * (see cull_aabbs()). Each triangle belongs to the tile that contains its
+ * centroid. The triangles of a tile are contiguous in the index buffer, so
+ * a tile is drawn with a single glDrawElements() from the shared VAO.
+ *
+ * Tile bounds include all vertices of the tile's triangles, i.e., triangles
+ * that cross tile borders are never culled incorrectly.
+ */
+
+// Tile i covers indices [firstIndex[i], firstIndex[i]+indexCount[i]). The
+// bounds are stored separately so that they can be passed to cull_aabbs().
+struct MeshTiles
+{
+	std::vector<std::uint32_t> firstIndex;
+	std::vector<std::uint32_t> indexCount;
+	std::vector<Aabb3f> bounds; // model space
+
+	std::size_t size() const noexcept { return bounds.size(); }
+	bool empty() const noexcept { return bounds.empty(); }
+};
+
+// Reorders the triangles in aIndices (in place) by tile, for a grid of
+// aTilesX x aTilesZ tiles spanning the bounds of the referenced positions.
+// The order of triangles within a tile is kept, so an optimized triangle
+// order (see optimize_vertex_cache()) is largely preserved.
+//
+// Returns the non-empty tiles, in row major order (X fastest).
+MeshTiles tile_mesh(
+	std::span<Vec3f const> aPositions,
+	std::span<std::uint32_t> aIndices,
+	std::size_t aTilesX,
+	std::size_t aTilesZ
+);
+
+#endif // MESH_TILES_HPP_472E6162_A3AA_4447_8A1A_4EABD8EB3549
@@ -0,0 +1,82 @@
+#include "mip_chain.hpp"
+
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+
+#include "parallel_for.hpp"
+
+#include "../vmlib/srgb.hpp"
+
+namespace
+{
+	// Pixels per thread, at least
+	constexpr std::size_t kGrain_ = 64*1024;
+
+	// Output rows of level 1 per strip of converted input rows
+	constexpr std::size_t kStripRows_ = 8;
+
+	std::size_t row_grain_( std::size_t aWidth ) noexcept
+	{
+		return std::max<std::size_t>( kGrain_ / aWidth, 1 );
+	}
+}
+
+std::vector<MipLevel> make_srgb_mip_chain( std::span<std::uint8_t const> aRgba, std::size_t aWidth, std::size_t aHeight )
+{
+	assert( aWidth > 0 && aHeight > 0 );
+	assert( aRgba.size() >= aWidth * aHeight * 4 );
+
+	std::vector<MipLevel> ret;
+	if( 1 == aWidth && 1 == aHeight )
+		return ret;
+
+	// Level 1, from strips of the sRGB8 input
+	std::size_t width = mip_size( aWidth );
+	std::size_t height = mip_size( aHeight );
+
+	std::vector<std::uint16_t> linear( width * height * 4 );
+	MipLevel& first = ret.emplace_back( width, height, std::vector<std::uint8_t>( width * height * 4 ) );
+
+	parallel_for( height, row_grain_( aWidth ), [&] (std::size_t aBegin, std::size_t aEnd) {
+		std::vector<std::uint16_t> strip( 2 * kStripRows_ * aWidth * 4 );
+
+		for( std::size_t y = aBegin; y < aEnd; y += kStripRows_ )
+		{
+			std::size_t const rows = std::min( kStripRows_, aEnd - y );
+			std::size_t const inBegin = 2*y;
+			std::size_t const inRows = std::min( 2*rows, aHeight - inBegin );
+
+			srgba8_to_linear15( aRgba.subspan( inBegin * aWidth * 4, inRows * aWidth * 4 ), strip );
+
+			auto const out = std::span( linear ).subspan( y * width * 4, rows * width * 4 );
+			downsample_linear15( strip, aWidth, inRows, out, 0, rows );
+			linear15_to_srgba8( out, std::span( first.rgba ).subspan( y * width * 4 ) );
+		}
+	} );
+
+	// Remaining levels, from the linear version of the previous one
+	std::vector<std::uint16_t> next;
+	while( width > 1 || height > 1 )
+	{
+		std::size_t const nw = mip_size( width );
+		std::size_t const nh = mip_size( height );
+
+		next.resize( nw * nh * 4 );
+		MipLevel& level = ret.emplace_back( nw, nh, std::vector<std::uint8_t>( nw * nh * 4 ) );
+
+		parallel_for( nh, row_grain_( width ), [&] (std::size_t aBegin, std::size_t aEnd) {
+			downsample_linear15( linear, width, height, next, aBegin, aEnd );
+
+			auto const rows = std::span( next ).subspan( aBegin * nw * 4, (aEnd - aBegin) * nw * 4 );
+			linear15_to_srgba8( rows, std::span( level.rgba ).subspan( aBegin * nw * 4 ) );
+		} );
+
+		std::swap( linear, next );
+		width = nw;
+		height = nh;
+	}
+
+	return ret;
+}
@@ -0,0 +1,37 @@
+#ifndef MIP_CHAIN_HPP_E2F05B7A_93C1_4D68_B4A9_0C7D5E18F236
+#define MIP_CHAIN_HPP_E2F05B7A_93C1_4D68_B4A9_0C7D5E18F236
+
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/* sRGB mip chains
+ *
+ * Builds the mip levels of an sRGB RGBA8 image on the CPU, so that the
+ * texture can be uploaded level by level instead of relying on
+ * glGenerateMipmap(). Each level is a 2x2 box filter of the previous one,
+ * computed in linear space (see vmlib/srgb.hpp). The rows of each level are
+ * split across threads (see parallel_for()).
+ *
+ * Level 1 is filtered directly from the sRGB8 input, converting a few rows
+ * at a time, so the full resolution image is never held in linear form.
+ */
+
+struct MipLevel
+{
+	std::size_t width;
+	std::size_t height;
+	std::vector<std::uint8_t> rgba; // sRGB8, tightly packed rows
+};
+
+// Returns levels 1 to N of the image, down to 1x1. Level 0 is aRgba itself,
+// which holds aWidth x aHeight pixels.
+std::vector<MipLevel> make_srgb_mip_chain(
+	std::span<std::uint8_t const> aRgba,
+	std::size_t aWidth,
+	std::size_t aHeight
+);
+
+#endif // MIP_CHAIN_HPP_E2F05B7A_93C1_4D68_B4A9_0C7D5E18F236
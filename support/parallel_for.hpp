@@ -0,0 +1,36 @@
+#ifndef PARALLEL_FOR_HPP_B7D2E913_4C6A_4F0E_8A35_2E9F61C08D74
+#define PARALLEL_FOR_HPP_B7D2E913_4C6A_4F0E_8A35_2E9F61C08D74
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include <cstddef>
+
+inline
+std::size_t worker_count() noexcept
+{
+	return std::max( 1u, std::thread::hardware_concurrency() );
+}
+
+// Splits [0,aCount) into contiguous ranges and runs aFunc( begin, end ) on
+// each, in parallel. Ranges have at least aGrain elements (except if aCount
+// is smaller); small inputs thus run on the calling thread only.
+template< typename tFunc >
+void parallel_for( std::size_t aCount, std::size_t aGrain, tFunc const& aFunc )
+{
+	std::size_t const tasks = std::clamp<std::size_t>( aCount / std::max<std::size_t>( aGrain, 1 ), 1, worker_count() );
+
+	auto const begin = [&] (std::size_t aTask) { return aCount * aTask / tasks; };
+
+	{
+		std::vector<std::jthread> workers;
+		workers.reserve( tasks-1 );
+		for( std::size_t i = 1; i < tasks; ++i )
+			workers.emplace_back( [&aFunc, b = begin( i ), e = begin( i+1 )] { aFunc( b, e ); } );
+
+		aFunc( 0, begin( 1 ) );
+	} // join
+}
+
+#endif // PARALLEL_FOR_HPP_B7D2E913_4C6A_4F0E_8A35_2E9F61C08D74
@@ -1,10 +1,15 @@
 #include "program.hpp"
 
+#include <bit>
+#include <map>
 #include <print>
+#include <string>
 #include <vector>
 #include <utility>
+#include <algorithm>
 
 #include <cstdio>
+#include <cstdlib>
 
 #include <glad/glad.h>
 
@@ -35,6 +40,38 @@ namespace
 	{
 		return ScopeExit_<tFunc>( std::forward<tFunc>(aFunc) );
 	}
+
+	// FNV-1a, 64 bit (as in mesh_file.cpp)
+	std::uint64_t hash_name_( std::string_view aName ) noexcept
+	{
+		std::uint64_t hash = 0xcbf29ce484222325ull;
+		for( char const c : aName )
+			hash = (hash ^ std::uint8_t(c)) * 0x100000001b3ull;
+		return hash;
+	}
+
+	struct TableEntry_
+	{
+		std::string name;
+		std::uint32_t first;
+		std::uint32_t count;
+	};
+
+	// Position of the first array subscript of aName that is followed by a
+	// struct member ("a[2].b"), or npos
+	std::size_t struct_subscript_( std::string_view aName ) noexcept
+	{
+		for( std::size_t open = aName.find( '[' ); std::string_view::npos != open; open = aName.find( '[', open+1 ) )
+		{
+			auto const close = aName.find( ']', open );
+			if( std::string_view::npos == close )
+				break;
+			if( close+1 < aName.size() && '.' == aName[close+1] )
+				return open;
+		}
+
+		return std::string_view::npos;
+	}
 }
 
 ShaderProgram::ShaderProgram( std::vector<ShaderSource> aShaderSources )
@@ -53,11 +90,13 @@ ShaderProgram::~ShaderProgram()
 ShaderProgram::ShaderProgram( ShaderProgram&& aOther ) noexcept
 	: mProgram( std::exchange( aOther.mProgram, 0 ) )
 	, mSources( std::move(aOther.mSources) )
+	, mReflection( std::move(aOther.mReflection) )
 {}
 ShaderProgram& ShaderProgram::operator= (ShaderProgram&& aOther) noexcept
 {
 	std::swap( mProgram, aOther.mProgram );
 	std::swap( mSources, aOther.mSources );
+	std::swap( mReflection, aOther.mReflection );
 	return *this;
 }
 
@@ -134,8 +173,181 @@ void ShaderProgram::reload()
 	
 	OGL_CHECKPOINT_ALWAYS();
 
+	auto reflection = reflect_( prog );
+
+	OGL_CHECKPOINT_ALWAYS();
+
 	// Replace the old shader program (if any) with the new one
 	std::swap( mProgram, prog );
+	mReflection = std::move(reflection);
+}
+
+ShaderProgram::Uniform ShaderProgram::uniform( std::string_view aName ) const noexcept
+{
+	if( auto const* slot = find_( mReflection.uniformTable, aName ) )
+		return mReflection.uniforms[slot->first];
+
+	return {};
+}
+ShaderProgram::Uniform ShaderProgram::uniform( std::string_view aIndexedName, std::size_t aIndex ) const noexcept
+{
+	if( auto const* slot = find_( mReflection.uniformTable, aIndexedName ); slot && aIndex < slot->count )
+		return mReflection.uniforms[slot->first + aIndex];
+
+	return {};
+}
+
+ShaderProgram::UniformBlock ShaderProgram::uniform_block( std::string_view aName ) const noexcept
+{
+	if( auto const* slot = find_( mReflection.blockTable, aName ) )
+		return mReflection.blocks[slot->first];
+
+	return {};
+}
+
+ShaderProgram::Reflection_ ShaderProgram::reflect_( GLuint aProgram )
+{
+	Reflection_ ret;
+
+	auto const build_table = [] (std::vector<TableEntry_>& aEntries) {
+		std::vector<Slot_> table( std::bit_ceil( std::max<std::size_t>( 2*aEntries.size(), 8 ) ) );
+		std::size_t const mask = table.size() - 1;
+
+		for( auto& entry : aEntries )
+		{
+			auto const hash = hash_name_( entry.name );
+
+			std::size_t i = hash & mask;
+			while( !table[i].name.empty() && table[i].name != entry.name )
+				i = (i+1) & mask;
+
+			if( table[i].name.empty() )
+				table[i] = Slot_{ std::move(entry.name), hash, entry.first, entry.count };
+		}
+
+		return table;
+	};
+
+	auto const resource_name = [aProgram] (GLenum aInterface, GLuint aIndex, std::vector<GLchar>& aBuffer) {
+		GLsizei length = 0;
+		glGetProgramResourceName( aProgram, aInterface, aIndex, GLsizei(aBuffer.size()), &length, aBuffer.data() );
+		return std::string( aBuffer.data(), std::size_t(length) );
+	};
+
+	// Uniforms of the default block
+	GLint count = 0, maxName = 0;
+	glGetProgramInterfaceiv( aProgram, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count );
+	glGetProgramInterfaceiv( aProgram, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxName );
+
+	std::vector<GLchar> buffer( std::size_t(maxName) + 1 );
+	std::vector<TableEntry_> entries;
+	std::map<std::string, std::map<std::uint32_t, std::uint32_t>> indexed; // name with "[]" -> index -> uniform
+
+	for( GLint i = 0; i < count; ++i )
+	{
+		GLenum const props[] = { GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION, GL_BLOCK_INDEX };
+		GLint values[4] = {};
+		glGetProgramResourceiv( aProgram, GL_UNIFORM, GLuint(i), 4, props, 4, nullptr, values );
+
+		if( -1 != values[3] )
+			continue; // member of a uniform block
+
+		auto name = resource_name( GL_UNIFORM, GLuint(i), buffer );
+		GLenum const type = GLenum(values[0]);
+		GLint const arraySize = values[1];
+		GLint const location = values[2];
+
+		auto const first = std::uint32_t(ret.uniforms.size());
+
+		// Arrays of basic types are a single resource, "a[0]". Query the
+		// locations of the other elements.
+		if( name.ends_with( "[0]" ) )
+		{
+			std::string const base = name.substr( 0, name.size() - 3 );
+
+			for( GLint e = 0; e < arraySize; ++e )
+			{
+				auto element = base + '[' + std::to_string( e ) + ']';
+				GLint const loc = 0 == e ? location : glGetUniformLocation( aProgram, element.c_str() );
+
+				ret.uniforms.emplace_back( Uniform{ loc, type, arraySize } );
+				entries.emplace_back( TableEntry_{ std::move(element), first + std::uint32_t(e), 1 } );
+			}
+
+			entries.emplace_back( TableEntry_{ base, first, 1 } );
+			entries.emplace_back( TableEntry_{ base + "[]", first, std::uint32_t(arraySize) } );
+			name = base; // for the struct subscript below, if any
+		}
+		else
+		{
+			ret.uniforms.emplace_back( Uniform{ location, type, arraySize } );
+			entries.emplace_back( TableEntry_{ name, first, 1 } );
+		}
+
+		// Elements of arrays of structs are separate resources, "a[2].b".
+		// Group them under "a[].b".
+		if( auto const open = struct_subscript_( name ); std::string::npos != open )
+		{
+			auto const close = name.find( ']', open );
+			auto const index = std::uint32_t(std::strtoul( name.c_str() + open + 1, nullptr, 10 ));
+
+			auto key = name.substr( 0, open+1 ) + name.substr( close );
+			indexed[std::move(key)][index] = first;
+		}
+	}
+
+	for( auto& [key, elements] : indexed )
+	{
+		// Elements that are not active keep location -1
+		auto const first = std::uint32_t(ret.uniforms.size());
+		auto const size = elements.rbegin()->first + 1;
+
+		ret.uniforms.resize( first + size );
+		for( auto const& [index, uniform] : elements )
+			ret.uniforms[first + index] = ret.uniforms[uniform];
+
+		entries.emplace_back( TableEntry_{ key, first, size } );
+	}
+
+	ret.uniformTable = build_table( entries );
+
+	// Uniform blocks
+	entries.clear();
+
+	glGetProgramInterfaceiv( aProgram, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &count );
+	glGetProgramInterfaceiv( aProgram, GL_UNIFORM_BLOCK, GL_MAX_NAME_LENGTH, &maxName );
+	buffer.resize( std::size_t(maxName) + 1 );
+
+	for( GLint i = 0; i < count; ++i )
+	{
+		GLenum const props[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+		GLint values[2] = {};
+		glGetProgramResourceiv( aProgram, GL_UNIFORM_BLOCK, GLuint(i), 2, props, 2, nullptr, values );
+
+		ret.blocks.emplace_back( UniformBlock{ GLuint(i), values[0], values[1] } );
+		entries.emplace_back( TableEntry_{ resource_name( GL_UNIFORM_BLOCK, GLuint(i), buffer ), std::uint32_t(i), 1 } );
+	}
+
+	ret.blockTable = build_table( entries );
+
+	return ret;
+}
+
+ShaderProgram::Slot_ const* ShaderProgram::find_( std::vector<Slot_> const& aTable, std::string_view aName ) noexcept
+{
+	if( aTable.empty() )
+		return nullptr;
+
+	auto const hash = hash_name_( aName );
+	std::size_t const mask = aTable.size() - 1;
+
+	for( std::size_t i = hash & mask; !aTable[i].name.empty(); i = (i+1) & mask )
+	{
+		if( hash == aTable[i].hash && aTable[i].name == aName )
+			return &aTable[i];
+	}
+
+	return nullptr;
 }
 
 namespace
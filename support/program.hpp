@@ -5,10 +5,28 @@
 
 #include <string>
 #include <vector>
+#include <string_view>
 
 #include <cstdint>
 #include <cstdlib>
 
+/* Shader program
+ *
+ * Besides linking, reload() reflects the program's active uniforms and
+ * uniform blocks into flat hash tables, so that draw code can look up
+ * uniforms by name without calling glGetUniformLocation() or building
+ * strings each frame:
+ *
+ *   glUniform1i( prog.uniform( "uTexture" ), 0 );
+ *   glUniform1f( prog.uniform( "uMaterialShine[]", i ), shine );
+ *
+ * Each element of an array is reachable by its full name ("a[2]",
+ * "a[2].b"), and, with its index as a separate argument, through the name
+ * with an empty subscript ("a[]", "a[].b"). The locations of all elements
+ * are queried once, when the program is linked. The bare name of an array
+ * of basic types ("a") refers to its first element, as in GL. Members of
+ * uniform blocks have no location, and are not included.
+ */
 class ShaderProgram final
 {
 	public:
@@ -18,6 +36,28 @@ class ShaderProgram final
 			std::string sourcePath;
 		};
 
+		// Active uniform (or array element) of the default uniform block.
+		// Converts to its location, so it can be passed to glUniform*()
+		// directly; unknown names have location -1, which GL ignores.
+		struct Uniform
+		{
+			GLint location = -1;
+			GLenum type = GL_NONE;   // e.g. GL_FLOAT_VEC3
+			GLint arraySize = 0;     // elements, 1 for non-arrays
+
+			explicit operator bool() const noexcept { return -1 != location; }
+			operator GLint() const noexcept { return location; }
+		};
+
+		struct UniformBlock
+		{
+			GLuint index = GL_INVALID_INDEX;
+			GLint binding = -1;      // as linked, e.g. layout(binding = N)
+			GLint dataSize = 0;      // bytes
+
+			explicit operator bool() const noexcept { return GL_INVALID_INDEX != index; }
+		};
+
 	public:
 		explicit ShaderProgram( 
 			std::vector<ShaderSource> = {}
@@ -34,11 +74,45 @@ class ShaderProgram final
 	public:
 		GLuint programId() const noexcept;
 
+		// Recompiles and relinks the program, and reflects its uniforms
+		// again. On failure, throws Error and keeps the old program (and its
+		// uniforms).
 		void reload();
 
+	public:
+		Uniform uniform( std::string_view ) const noexcept;
+		Uniform uniform( std::string_view aIndexedName, std::size_t aIndex ) const noexcept;
+
+		UniformBlock uniform_block( std::string_view ) const noexcept;
+
+	private:
+		// Slot of a flat (open addressing, linear probing) hash table. The
+		// tables are at most half full, and have a power of two size.
+		struct Slot_
+		{
+			std::string name;        // empty: unused slot
+			std::uint64_t hash = 0;
+			std::uint32_t first = 0; // into uniforms / blocks
+			std::uint32_t count = 0; // elements, for indexed names
+		};
+
+		struct Reflection_
+		{
+			std::vector<Slot_> uniformTable;
+			std::vector<Uniform> uniforms;
+
+			std::vector<Slot_> blockTable;
+			std::vector<UniformBlock> blocks;
+		};
+
+		static Reflection_ reflect_( GLuint );
+		static Slot_ const* find_( std::vector<Slot_> const&, std::string_view ) noexcept;
+
 	private:
 		GLuint mProgram;
 		std::vector<ShaderSource> mSources;
+
+		Reflection_ mReflection;
 };
 
 #endif // PROGRAM_HPP_EEC27A62_D86E_4D88_A66C_7A8E7142515A
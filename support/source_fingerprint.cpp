@@ -0,0 +1,71 @@
+#include "source_fingerprint.hpp"
+
+#include <memory>
+#include <cstdio>
+
+#include "error.hpp"
+
+namespace
+{
+	struct FileCloser_
+	{
+		void operator() (std::FILE* aFile) const noexcept { std::fclose( aFile ); }
+	};
+	using FilePtr_ = std::unique_ptr<std::FILE, FileCloser_>;
+}
+
+SourceFingerprint fingerprint_source( std::filesystem::path const& aPath, bool aHash )
+{
+	std::error_code ec;
+
+	SourceFingerprint ret{};
+	ret.size = std::filesystem::file_size( aPath, ec );
+	if( ec )
+		throw Error( "Unable to stat '{}': {}", aPath.string(), ec.message() );
+
+	ret.mtime = std::int64_t(std::filesystem::last_write_time( aPath, ec ).time_since_epoch().count());
+	if( ec )
+		throw Error( "Unable to stat '{}': {}", aPath.string(), ec.message() );
+
+	if( aHash )
+	{
+		FilePtr_ const file( std::fopen( aPath.string().c_str(), "rb" ) );
+		if( !file )
+			throw Error( "Unable to open '{}' for reading", aPath.string() );
+
+		std::uint64_t hash = 0xcbf29ce484222325ull;
+
+		unsigned char buffer[64*1024];
+		while( std::size_t const read = std::fread( buffer, 1, sizeof(buffer), file.get() ) )
+		{
+			for( std::size_t i = 0; i < read; ++i )
+				hash = (hash ^ buffer[i]) * 0x100000001b3ull;
+		}
+
+		ret.hash = hash;
+	}
+
+	return ret;
+}
+
+bool is_source_current( SourceFingerprint const& aRecorded, std::filesystem::path const& aSource )
+{
+	std::error_code ec;
+	if( !std::filesystem::exists( aSource, ec ) )
+		return true;
+
+	try
+	{
+		auto const current = fingerprint_source( aSource, false );
+		if( current.size != aRecorded.size )
+			return false;
+		if( current.mtime == aRecorded.mtime )
+			return true;
+
+		return fingerprint_source( aSource, true ).hash == aRecorded.hash;
+	}
+	catch( Error const& )
+	{
+		return false;
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef SOURCE_FINGERPRINT_HPP_AAD59427_C296_443B_9F9E_D8420C61D6AB
+#define SOURCE_FINGERPRINT_HPP_AAD59427_C296_443B_9F9E_D8420C61D6AB
+
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+/* Source fingerprints
+ *
+ * Cached files that are derived from an asset (cooked meshes, compressed
+ * textures, virtual texture pages) record a fingerprint of the file they
+ * were built from, and are rebuilt once it no longer matches. The
+ * fingerprint is stored as-is in the cached files, so its layout is part of
+ * their formats.
+ */
+
+struct SourceFingerprint
+{
+	std::uint64_t size;
+	std::int64_t mtime; // std::filesystem::file_time_type ticks
+	std::uint64_t hash; // FNV-1a, 64 bit, of the file contents
+};
+
+static_assert( std::is_trivially_copyable_v<SourceFingerprint> );
+static_assert( sizeof(SourceFingerprint) == 24 );
+
+// Fingerprint of a source file. The hash is only computed if aHash is set
+// (it requires reading the whole file), otherwise it is zero.
+//
+// Throws Error if the file cannot be read.
+SourceFingerprint fingerprint_source( std::filesystem::path const&, bool aHash = true );
+
+// True if aRecorded is the fingerprint of the current version of aSource.
+// The modification time is checked first; if it differs (e.g., after a fresh
+// checkout), the contents hash decides. A missing source counts as current,
+// so that cached files can be shipped without their sources.
+bool is_source_current(
+	SourceFingerprint const& aRecorded,
+	std::filesystem::path const& aSource
+);
+
+#endif // SOURCE_FINGERPRINT_HPP_AAD59427_C296_443B_9F9E_D8420C61D6AB
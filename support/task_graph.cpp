@@ -0,0 +1,279 @@
+#include "task_graph.hpp"
+
+#include <print>
+#include <ranges>
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+
+#include "parallel_for.hpp"
+
+namespace
+{
+	float ms_( TaskGraph::Clock::duration aDuration ) noexcept
+	{
+		return std::chrono::duration<float, std::milli>( aDuration ).count();
+	}
+}
+
+TaskGraph::TaskGraph( std::size_t aWorkerCount )
+	: mWorkerCount( aWorkerCount ? aWorkerCount : worker_count() )
+{}
+
+TaskGraph::~TaskGraph()
+{
+	{
+		std::scoped_lock const lock( mMutex );
+		mStop = true;
+		mWorkerQueue.clear();
+	}
+	mWorkerCv.notify_all();
+
+	mWorkers.clear(); // joins
+}
+
+TaskGraph::TaskId TaskGraph::add( std::string aName, Thread aThread, std::function<void()> aFunc, std::initializer_list<TaskId> aDependencies )
+{
+	assert( mWorkers.empty() ); // before start()
+
+	TaskId const id = mTasks.size();
+
+	Task_& task = mTasks.emplace_back();
+	task.name = std::move(aName);
+	task.thread = aThread;
+	task.func = std::move(aFunc);
+	task.dependencies.assign( aDependencies.begin(), aDependencies.end() );
+	task.pending = aDependencies.size();
+
+	for( auto const dep : aDependencies )
+	{
+		assert( dep < id );
+		mTasks[dep].dependents.emplace_back( id );
+	}
+
+	return id;
+}
+
+void TaskGraph::start()
+{
+	assert( mWorkers.empty() );
+
+	mStart = Clock::now();
+
+	{
+		std::scoped_lock const lock( mMutex );
+		for( TaskId i = 0; i < mTasks.size(); ++i )
+		{
+			if( 0 != mTasks[i].pending )
+				continue;
+
+			if( Thread::Worker == mTasks[i].thread )
+				mWorkerQueue.emplace_back( i );
+			else
+				mMainQueue.emplace_back( i );
+		}
+	}
+
+	mWorkers.reserve( mWorkerCount );
+	for( std::size_t i = 0; i < mWorkerCount; ++i )
+		mWorkers.emplace_back( [this] { worker_(); } );
+}
+
+std::size_t TaskGraph::run_main( Clock::duration aBudget )
+{
+	auto const deadline = aBudget < Clock::time_point::max() - Clock::now()
+		? Clock::now() + aBudget
+		: Clock::time_point::max()
+	;
+
+	std::size_t count = 0;
+	do
+	{
+		TaskId id;
+		{
+			std::scoped_lock const lock( mMutex );
+			if( mError )
+				std::rethrow_exception( mError );
+
+			if( mMainQueue.empty() )
+				break;
+
+			id = mMainQueue.front();
+			mMainQueue.pop_front();
+		}
+
+		mTasks[id].begin = Clock::now();
+
+		std::exception_ptr error;
+		try
+		{
+			mTasks[id].func();
+		}
+		catch( ... )
+		{
+			error = std::current_exception();
+		}
+
+		finish_( id, error );
+		++count;
+	} while( Clock::now() < deadline );
+
+	std::scoped_lock const lock( mMutex );
+	if( mError )
+		std::rethrow_exception( mError );
+
+	return count;
+}
+
+void TaskGraph::wait()
+{
+	while( !done() )
+	{
+		if( 0 != run_main() )
+			continue;
+
+		std::unique_lock lock( mMutex );
+		mMainCv.wait( lock, [this] {
+			return !mMainQueue.empty() || mError || mFinished == mTasks.size();
+		} );
+	}
+}
+
+bool TaskGraph::done() const
+{
+	std::scoped_lock const lock( mMutex );
+	return mFinished == mTasks.size();
+}
+
+float TaskGraph::progress() const
+{
+	std::scoped_lock const lock( mMutex );
+	return mTasks.empty() ? 1.f : float(mFinished) / float(mTasks.size());
+}
+
+void TaskGraph::print_report() const
+{
+	std::scoped_lock const lock( mMutex );
+
+	Clock::time_point end = mStart;
+	TaskId last = mTasks.size();
+	for( TaskId i = 0; i < mTasks.size(); ++i )
+	{
+		if( mTasks[i].finished && mTasks[i].end >= end )
+		{
+			end = mTasks[i].end;
+			last = i;
+		}
+	}
+
+	std::print( "Startup: {} tasks in {:.1f} ms ({} workers)\n", mTasks.size(), ms_( end - mStart ), mWorkerCount );
+	for( auto const& task : mTasks )
+	{
+		if( !task.finished )
+		{
+			std::print( "  {:<24} {:<6} not run\n", task.name, Thread::Worker == task.thread ? "worker" : "main" );
+			continue;
+		}
+
+		std::print( "  {:<24} {:<6} {:8.1f} ms -> {:8.1f} ms  {:8.1f} ms\n",
+			task.name, Thread::Worker == task.thread ? "worker" : "main",
+			ms_( task.begin - mStart ), ms_( task.end - mStart ), ms_( task.end - task.begin ) );
+	}
+
+	if( last == mTasks.size() )
+		return;
+
+	// Walk back from the last task, each time to the dependency that
+	// finished last, i.e., the one that the task was waiting for.
+	std::vector<TaskId> path;
+	for( TaskId id = last; ; )
+	{
+		path.emplace_back( id );
+
+		auto const& deps = mTasks[id].dependencies;
+		if( deps.empty() )
+			break;
+
+		id = *std::ranges::max_element( deps, {}, [this] (TaskId aId) { return mTasks[aId].end; } );
+	}
+
+	Clock::duration busy{};
+	for( auto const id : path )
+		busy += mTasks[id].end - mTasks[id].begin;
+
+	std::print( "  critical path ({:.1f} ms running, {:.1f} ms waiting):\n", ms_( busy ), ms_( end - mStart - busy ) );
+	for( auto const id : path | std::views::reverse )
+		std::print( "    {:<24} {:8.1f} ms\n", mTasks[id].name, ms_( mTasks[id].end - mTasks[id].begin ) );
+}
+
+void TaskGraph::worker_()
+{
+	for( ;; )
+	{
+		TaskId id;
+		{
+			std::unique_lock lock( mMutex );
+			mWorkerCv.wait( lock, [this] { return mStop || !mWorkerQueue.empty(); } );
+
+			if( mStop )
+				return;
+
+			id = mWorkerQueue.front();
+			mWorkerQueue.pop_front();
+		}
+
+		mTasks[id].begin = Clock::now();
+
+		std::exception_ptr error;
+		try
+		{
+			mTasks[id].func();
+		}
+		catch( ... )
+		{
+			error = std::current_exception();
+		}
+
+		finish_( id, error );
+	}
+}
+
+void TaskGraph::finish_( TaskId aId, std::exception_ptr aError )
+{
+	auto const now = Clock::now();
+
+	{
+		std::scoped_lock const lock( mMutex );
+
+		Task_& task = mTasks[aId];
+		task.end = now;
+		task.func = nullptr; // release captured state early
+
+		if( aError )
+		{
+			// Dependents are never scheduled. Keep the first error only.
+			if( !mError )
+				mError = aError;
+		}
+		else
+		{
+			task.finished = true;
+			++mFinished;
+
+			for( auto const dep : task.dependents )
+			{
+				if( 0 != --mTasks[dep].pending )
+					continue;
+
+				if( Thread::Worker == mTasks[dep].thread )
+					mWorkerQueue.emplace_back( dep );
+				else
+					mMainQueue.emplace_back( dep );
+			}
+		}
+	}
+
+	mWorkerCv.notify_all();
+	mMainCv.notify_all();
+}
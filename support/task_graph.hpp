@@ -0,0 +1,123 @@
+#ifndef TASK_GRAPH_HPP_3B0E8C51_9F4A_4D27_B6E2_58C1A7D40F93
+#define TASK_GRAPH_HPP_3B0E8C51_9F4A_4D27_B6E2_58C1A7D40F93
+
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <condition_variable>
+
+#include <cstddef>
+
+/* Task graph
+ *
+ * Small dependency-aware scheduler for the work done at startup. Each task
+ * runs once all of its dependencies have finished. Worker tasks run on a
+ * pool of threads; main tasks run on the thread that calls run_main(),
+ * i.e., the thread that owns the OpenGL context. A typical split is to
+ * parse or decode an asset in a worker task, and to upload it in a main
+ * task that depends on the former.
+ *
+ * Tasks are added before start(). The main thread then calls run_main()
+ * regularly (e.g., once per frame while showing a loading screen) until
+ * done() returns true.
+ *
+ * If a task throws, the tasks that depend on it are never run, and the
+ * exception is rethrown by the next call to run_main().
+ *
+ * print_report() lists the duration of each task and the critical path:
+ * the chain of dependencies that ends with the last task to finish, where
+ * each step goes to the dependency that finished last. Shortening tasks on
+ * that path is what shortens the startup.
+ */
+
+class TaskGraph final
+{
+	public:
+		using TaskId = std::size_t;
+		using Clock = std::chrono::steady_clock;
+
+		enum class Thread
+		{
+			Worker,
+			Main
+		};
+
+	public:
+		// aWorkerCount = 0 uses one worker per hardware thread
+		explicit TaskGraph( std::size_t aWorkerCount = 0 );
+
+		// Waits for running worker tasks; tasks that have not started yet are
+		// dropped.
+		~TaskGraph();
+
+		TaskGraph( TaskGraph const& ) = delete;
+		TaskGraph& operator= (TaskGraph const&) = delete;
+
+	public:
+		TaskId add(
+			std::string aName,
+			Thread aThread,
+			std::function<void()> aFunc,
+			std::initializer_list<TaskId> aDependencies = {}
+		);
+
+		void start();
+
+		// Runs ready main tasks until none are ready or aBudget has elapsed.
+		// At least one ready task is run, regardless of aBudget. Returns the
+		// number of tasks that were run.
+		std::size_t run_main( Clock::duration aBudget = Clock::duration::max() );
+
+		// Calls run_main() until all tasks have finished
+		void wait();
+
+		bool done() const;
+
+		// Finished tasks / all tasks
+		float progress() const;
+
+		void print_report() const;
+
+	private:
+		struct Task_
+		{
+			std::string name;
+			Thread thread;
+			std::function<void()> func;
+
+			std::vector<TaskId> dependencies;
+			std::vector<TaskId> dependents;
+			std::size_t pending = 0; // unfinished dependencies
+
+			Clock::time_point begin, end;
+			bool finished = false;
+		};
+
+		void worker_();
+		void finish_( TaskId, std::exception_ptr );
+
+	private:
+		std::vector<Task_> mTasks;
+
+		mutable std::mutex mMutex;
+		std::condition_variable mWorkerCv; // mWorkerQueue or mStop
+		std::condition_variable mMainCv;   // mMainQueue or a task finished
+
+		std::deque<TaskId> mWorkerQueue;
+		std::deque<TaskId> mMainQueue;
+		std::size_t mFinished = 0;
+		std::exception_ptr mError;
+		bool mStop = false;
+
+		std::size_t mWorkerCount;
+		std::vector<std::jthread> mWorkers;
+		Clock::time_point mStart;
+};
+
+#endif // TASK_GRAPH_HPP_3B0E8C51_9F4A_4D27_B6E2_58C1A7D40F93
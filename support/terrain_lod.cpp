@@ -0,0 +1,325 @@
+#include "terrain_lod.hpp"
+
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <cassert>
+
+#include "mesh_tiles.hpp"
+
+namespace
+{
+	constexpr std::uint32_t kNone_ = std::numeric_limits<std::uint32_t>::max();
+
+	std::uint64_t edge_key_( std::uint32_t aA, std::uint32_t aB ) noexcept
+	{
+		return (std::uint64_t(aA) << 32) | aB;
+	}
+
+	// Triangle with its vertices rotated so that the smallest index comes
+	// first; keeps the winding, so equal triangles have equal keys.
+	struct TriangleKey_
+	{
+		std::uint32_t v[3];
+
+		bool operator== (TriangleKey_ const&) const = default;
+	};
+
+	TriangleKey_ make_triangle_key_( std::uint32_t aA, std::uint32_t aB, std::uint32_t aC ) noexcept
+	{
+		if( aB < aA && aB < aC ) return TriangleKey_{ { aB, aC, aA } };
+		if( aC < aA && aC < aB ) return TriangleKey_{ { aC, aA, aB } };
+		return TriangleKey_{ { aA, aB, aC } };
+	}
+
+	struct TriangleHash_
+	{
+		std::size_t operator() (TriangleKey_ const& aKey) const noexcept
+		{
+			std::uint64_t h = aKey.v[0];
+			h = h * 0x9e3779b97f4a7c15ull + aKey.v[1];
+			h = h * 0x9e3779b97f4a7c15ull + aKey.v[2];
+			return std::size_t(h ^ (h >> 32));
+		}
+	};
+
+	// Clusters the vertices of one tile into aRes x aRes cells in XZ and
+	// returns the triangles of aTriangles with each vertex replaced by the
+	// representative of its cell. Degenerate and duplicate triangles are
+	// dropped. aError receives the largest vertex displacement.
+	std::vector<std::uint32_t> cluster_tile_(
+		std::span<Vec3f const> aPositions,
+		std::span<std::uint32_t const> aTriangles,
+		std::span<std::uint32_t const> aTileVertices,
+		Aabb3f const& aBounds,
+		std::size_t aRes,
+		std::vector<std::uint32_t>& aRepOf,
+		float& aError
+	)
+	{
+		float const sx = aBounds.max.x > aBounds.min.x ? float(aRes) / (aBounds.max.x - aBounds.min.x) : 0.f;
+		float const sz = aBounds.max.z > aBounds.min.z ? float(aRes) / (aBounds.max.z - aBounds.min.z) : 0.f;
+
+		auto const cell_of = [&] (Vec3f const& aP) {
+			auto const axis = [&] (float aV) {
+				return std::min( std::size_t(std::max( aV, 0.f )), aRes-1 );
+			};
+			return axis( (aP.z - aBounds.min.z) * sz ) * aRes + axis( (aP.x - aBounds.min.x) * sx );
+		};
+		auto const center_distance = [&] (Vec3f const& aP, std::size_t aCell) {
+			float const cx = aBounds.min.x + (float(aCell % aRes) + 0.5f) / (sx > 0.f ? sx : 1.f);
+			float const cz = aBounds.min.z + (float(aCell / aRes) + 0.5f) / (sz > 0.f ? sz : 1.f);
+			return (aP.x-cx)*(aP.x-cx) + (aP.z-cz)*(aP.z-cz);
+		};
+
+		// Representative per cell: the vertex closest to the cell center
+		std::vector<std::uint32_t> rep( aRes*aRes, kNone_ );
+		for( auto const v : aTileVertices )
+		{
+			std::size_t const cell = cell_of( aPositions[v] );
+			if( kNone_ == rep[cell] || center_distance( aPositions[v], cell ) < center_distance( aPositions[rep[cell]], cell ) )
+				rep[cell] = v;
+		}
+
+		aError = 0.f;
+		for( auto const v : aTileVertices )
+		{
+			aRepOf[v] = rep[cell_of( aPositions[v] )];
+			aError = std::max( aError, length( aPositions[v] - aPositions[aRepOf[v]] ) );
+		}
+
+		std::vector<std::uint32_t> ret;
+		std::unordered_set<TriangleKey_, TriangleHash_> seen;
+		for( std::size_t i = 0; i < aTriangles.size(); i += 3 )
+		{
+			std::uint32_t const a = aRepOf[aTriangles[i+0]];
+			std::uint32_t const b = aRepOf[aTriangles[i+1]];
+			std::uint32_t const c = aRepOf[aTriangles[i+2]];
+			if( a == b || b == c || c == a )
+				continue;
+
+			if( !seen.insert( make_triangle_key_( a, b, c ) ).second )
+				continue;
+
+			ret.insert( ret.end(), { a, b, c } );
+		}
+
+		return ret;
+	}
+
+	// Vertices with the same position get the same ID (the smallest index).
+	// OBJ meshes often have several vertices per position, e.g., with
+	// per-face normals, which would otherwise look like borders.
+	std::vector<std::uint32_t> position_ids_( std::span<Vec3f const> aPositions )
+	{
+		struct Hash
+		{
+			std::size_t operator() (Vec3f const& aP) const noexcept
+			{
+				std::uint64_t h = std::bit_cast<std::uint32_t>( aP.x );
+				h = h * 0x9e3779b97f4a7c15ull + std::bit_cast<std::uint32_t>( aP.y );
+				h = h * 0x9e3779b97f4a7c15ull + std::bit_cast<std::uint32_t>( aP.z );
+				return std::size_t(h ^ (h >> 32));
+			}
+		};
+		struct Equal
+		{
+			bool operator() (Vec3f const& aA, Vec3f const& aB) const noexcept
+			{
+				return aA.x == aB.x && aA.y == aB.y && aA.z == aB.z;
+			}
+		};
+
+		std::unordered_map<Vec3f, std::uint32_t, Hash, Equal> first;
+		first.reserve( aPositions.size() );
+
+		std::vector<std::uint32_t> ret( aPositions.size() );
+		for( std::size_t i = 0; i < aPositions.size(); ++i )
+			ret[i] = first.try_emplace( aPositions[i], std::uint32_t(i) ).first->second;
+
+		return ret;
+	}
+
+	// Distance from a point to a box; zero inside.
+	float distance_( Aabb3f const& aBox, Vec3f const& aP ) noexcept
+	{
+		float const dx = std::max( { aBox.min.x - aP.x, 0.f, aP.x - aBox.max.x } );
+		float const dy = std::max( { aBox.min.y - aP.y, 0.f, aP.y - aBox.max.y } );
+		float const dz = std::max( { aBox.min.z - aP.z, 0.f, aP.z - aBox.max.z } );
+		return std::sqrt( dx*dx + dy*dy + dz*dz );
+	}
+}
+
+TerrainLod build_terrain_lod( SimpleMeshData& aMesh, TerrainLodOptions const& aOptions )
+{
+	assert( aOptions.levelCount >= 1 && aOptions.levelCount < kTerrainLodCulled );
+
+	TerrainLod ret;
+	if( aMesh.indices.empty() )
+		return ret;
+
+	MeshTiles const tiles = tile_mesh( aMesh.positions, aMesh.indices, aOptions.tileGrid, aOptions.tileGrid );
+
+	std::size_t const tileCount = tiles.size();
+	std::size_t const levelCount = aOptions.levelCount;
+
+	// Triangles of each level and tile, at [level * tileCount + tile]
+	std::vector<std::vector<std::uint32_t>> triangles( levelCount * tileCount );
+	std::vector<float> error( levelCount * tileCount, 0.f );
+
+	auto const positionId = position_ids_( aMesh.positions );
+
+	std::vector<std::uint32_t> repOf( aMesh.positions.size(), kNone_ );
+	std::vector<std::uint32_t> tileOf( aMesh.positions.size(), kNone_ );
+	std::vector<std::uint32_t> positionTileOf( aMesh.positions.size(), kNone_ );
+	std::vector<std::uint32_t> tileVertices;
+	std::size_t tilePositions;
+
+	for( std::size_t t = 0; t < tileCount; ++t )
+	{
+		std::span<std::uint32_t const> const level0( aMesh.indices.data() + tiles.firstIndex[t], tiles.indexCount[t] );
+		triangles[t].assign( level0.begin(), level0.end() );
+
+		tileVertices.clear();
+		tilePositions = 0;
+		for( auto const v : level0 )
+		{
+			if( tileOf[v] != t )
+			{
+				tileOf[v] = std::uint32_t(t);
+				tileVertices.emplace_back( v );
+			}
+			if( positionTileOf[positionId[v]] != t )
+			{
+				positionTileOf[positionId[v]] = std::uint32_t(t);
+				++tilePositions;
+			}
+		}
+
+		// Cells per side at level 0, assuming a roughly regular grid
+		std::size_t const res0 = std::max<std::size_t>( 1, std::size_t(std::lround( std::sqrt( double(tilePositions) ) )) );
+		for( std::size_t k = 1; k < levelCount; ++k )
+		{
+			std::size_t const i = k * tileCount + t;
+			triangles[i] = cluster_tile_( aMesh.positions, level0, tileVertices, tiles.bounds[t], std::max<std::size_t>( 1, res0 >> k ), repOf, error[i] );
+			error[i] = std::max( error[i], error[i - tileCount] );
+		}
+	}
+
+	float const maxError = *std::max_element( error.begin(), error.end() );
+	float const skirtDepth = 2.f * maxError;
+
+	// Emit the levels with their skirts, level major
+	bool const hasNormals = aMesh.normals.size() == aMesh.positions.size();
+	bool const hasTexcoords = aMesh.texcoords.size() == aMesh.positions.size();
+	bool const hasMaterials = aMesh.materialIds.size() == aMesh.positions.size();
+
+	ret.tileCount = tileCount;
+	ret.levelCount = levelCount;
+	ret.bounds = tiles.bounds;
+	ret.firstIndex.resize( levelCount * tileCount );
+	ret.indexCount.resize( levelCount * tileCount );
+	ret.error = std::move(error);
+
+	for( auto& box : ret.bounds )
+		box.min.y -= skirtDepth;
+
+	std::vector<std::uint32_t> indices;
+	indices.reserve( aMesh.indices.size() * 2 );
+
+	std::unordered_set<std::uint64_t> edges;
+	std::unordered_map<std::uint32_t, std::uint32_t> skirtVertex;
+
+	for( std::size_t i = 0; i < levelCount * tileCount; ++i )
+	{
+		auto const& tris = triangles[i];
+
+		ret.firstIndex[i] = std::uint32_t(indices.size());
+		indices.insert( indices.end(), tris.begin(), tris.end() );
+
+		if( skirtDepth > 0.f )
+		{
+			edges.clear();
+			for( std::size_t j = 0; j < tris.size(); j += 3 )
+			{
+				for( std::size_t e = 0; e < 3; ++e )
+					edges.insert( edge_key_( positionId[tris[j+e]], positionId[tris[j+(e+1)%3]] ) );
+			}
+
+			// Vertices of the skirt are shared within a tile and level
+			skirtVertex.clear();
+			auto const lowered = [&] (std::uint32_t aV) {
+				auto const [it, inserted] = skirtVertex.try_emplace( aV, std::uint32_t(aMesh.positions.size()) );
+				if( inserted )
+				{
+					Vec3f p = aMesh.positions[aV];
+					p.y -= skirtDepth;
+					aMesh.positions.emplace_back( p );
+					if( hasNormals ) aMesh.normals.emplace_back( aMesh.normals[aV] );
+					if( hasTexcoords ) aMesh.texcoords.emplace_back( aMesh.texcoords[aV] );
+					if( hasMaterials ) aMesh.materialIds.emplace_back( aMesh.materialIds[aV] );
+				}
+				return it->second;
+			};
+
+			// Border edges are those without a twin in the opposite
+			// direction (by position). The tile's surface lies to the left of a->b (seen
+			// from above), so (a, a', b) and (b, a', b') face outwards.
+			for( std::size_t j = 0; j < tris.size(); j += 3 )
+			{
+				for( std::size_t e = 0; e < 3; ++e )
+				{
+					std::uint32_t const a = tris[j+e];
+					std::uint32_t const b = tris[j+(e+1)%3];
+					if( edges.contains( edge_key_( positionId[b], positionId[a] ) ) )
+						continue;
+
+					std::uint32_t const la = lowered( a );
+					std::uint32_t const lb = lowered( b );
+					indices.insert( indices.end(), { a, la, b, b, la, lb } );
+				}
+			}
+		}
+
+		ret.indexCount[i] = std::uint32_t(indices.size()) - ret.firstIndex[i];
+	}
+
+	aMesh.indices = std::move(indices);
+	return ret;
+}
+
+float terrain_lod_pixel_scale( float aFovY, float aViewportHeight ) noexcept
+{
+	return aViewportHeight / (2.f * std::tan( 0.5f * aFovY ));
+}
+
+std::size_t select_terrain_lod( TerrainLod const& aLod, Vec3f const& aEye, float aPixelScale, float aMaxPixelError, std::span<std::uint8_t const> aVisible, std::span<std::uint8_t> aLevels ) noexcept
+{
+	assert( aVisible.size() >= aLod.tileCount && aLevels.size() >= aLod.tileCount );
+
+	std::size_t triangles = 0;
+	for( std::size_t t = 0; t < aLod.tileCount; ++t )
+	{
+		if( !aVisible[t] )
+		{
+			aLevels[t] = kTerrainLodCulled;
+			continue;
+		}
+
+		// Projected error: error * aPixelScale / distance
+		float const d = distance_( aLod.bounds[t], aEye );
+
+		std::size_t level = aLod.levelCount-1;
+		while( level > 0 && aLod.error[level * aLod.tileCount + t] * aPixelScale > aMaxPixelError * d )
+			--level;
+
+		aLevels[t] = std::uint8_t(level);
+		triangles += aLod.indexCount[level * aLod.tileCount + t] / 3;
+	}
+
+	return triangles;
+}
@@ -0,0 +1,81 @@
+#ifndef TERRAIN_LOD_HPP_6791DF2A_62C6_4DCD_AEE7_6A65F05E7C8F
+#define TERRAIN_LOD_HPP_6791DF2A_62C6_4DCD_AEE7_6A65F05E7C8F
+
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mesh.hpp"
+#include "../vmlib/bounds.hpp"
+
+/* Chunked terrain LOD
+ *
+ * The terrain is split into tiles (see tile_mesh()), and each tile gets
+ * levelCount levels of detail. Level 0 is the original mesh. Level k
+ * clusters the tile's vertices in an XZ grid with 2^k times fewer cells per
+ * side than level 0, and keeps one vertex per cell (the one closest to the
+ * cell center). All levels therefore share the original vertices, and only
+ * the index ranges differ.
+ *
+ * The geometric error of a level is the largest distance between an
+ * original vertex and the vertex that replaces it. At runtime, each visible
+ * tile uses the coarsest level whose error, projected to the screen at the
+ * distance of the tile's bounds, is at most a given number of pixels (see
+ * select_terrain_lod()).
+ *
+ * Neighbouring tiles at different levels do not share their borders. The
+ * cracks are hidden by skirts: vertical strips that hang down from the
+ * border edges of each tile at each level. The skirts are as deep as twice
+ * the largest error of any level, and face away from their tile.
+ */
+
+struct TerrainLodOptions
+{
+	std::size_t tileGrid = 16;  // tileGrid x tileGrid tiles
+	std::size_t levelCount = 4; // including the full resolution level
+};
+
+struct TerrainLod
+{
+	std::size_t tileCount = 0;
+	std::size_t levelCount = 0;
+
+	std::vector<Aabb3f> bounds; // per tile, model space, including skirts
+
+	// Per level and tile, at [level * tileCount + tile]. Ranges of adjacent
+	// tiles at the same level are adjacent in the index buffer.
+	std::vector<std::uint32_t> firstIndex;
+	std::vector<std::uint32_t> indexCount;
+	std::vector<float> error; // model units
+
+	bool empty() const noexcept { return 0 == tileCount; }
+};
+
+// Level of a tile that is not drawn
+inline constexpr std::uint8_t kTerrainLodCulled = 0xff;
+
+// Builds the levels of an indexed mesh. Replaces aMesh.indices with the
+// indices of all levels (including skirts) and appends the skirt vertices
+// to the vertex streams.
+TerrainLod build_terrain_lod( SimpleMeshData& aMesh, TerrainLodOptions const& = {} );
+
+// Pixels per model unit at unit distance, for a vertical field of view
+// aFovY and a viewport that is aViewportHeight pixels high.
+float terrain_lod_pixel_scale( float aFovY, float aViewportHeight ) noexcept;
+
+// Selects a level for each tile whose aVisible flag is set, and writes it
+// to aLevels (kTerrainLodCulled for the others). aEye is the camera position
+// in the model space of the terrain. Returns the number of triangles of the
+// selected levels, skirts included.
+std::size_t select_terrain_lod(
+	TerrainLod const& aLod,
+	Vec3f const& aEye,
+	float aPixelScale,
+	float aMaxPixelError,
+	std::span<std::uint8_t const> aVisible,
+	std::span<std::uint8_t> aLevels
+) noexcept;
+
+#endif // TERRAIN_LOD_HPP_6791DF2A_62C6_4DCD_AEE7_6A65F05E7C8F
@@ -0,0 +1,261 @@
+#include "texture_stream.hpp"
+
+#include <utility>
+#include <algorithm>
+
+#include <cassert>
+#include <cstring>
+
+#include "error.hpp"
+#include "checkpoint.hpp"
+
+#include "../vmlib/bc7.hpp"
+
+namespace
+{
+	// The levels at the end of the chain that are uploaded by the constructor
+	// take up at most this many bytes.
+	constexpr std::size_t kTailBytes_ = 128*1024;
+
+	std::size_t level_size_( std::size_t aSize, std::size_t aLevel ) noexcept
+	{
+		return std::max<std::size_t>( aSize >> aLevel, 1 );
+	}
+
+	std::size_t block_row_bytes_( std::size_t aWidth ) noexcept
+	{
+		return (aWidth + 3) / 4 * kBc7BlockBytes;
+	}
+}
+
+StreamingTexture::StreamingTexture( CompressedTexture aTexture, std::size_t aFrameBudget )
+	: mTexture( 0 )
+	, mSource( std::move(aTexture) )
+	, mResident( mSource.levels.size() )
+	, mNextRow( 0 )
+	, mSegmentSize( 0 )
+	, mNextSegment( 0 )
+	, mPersistent( false )
+{
+	assert( !mSource.levels.empty() );
+
+	OGL_CHECKPOINT_ALWAYS();
+
+	glGenTextures( 1, &mTexture );
+	glBindTexture( GL_TEXTURE_2D, mTexture );
+	glTexStorage2D( GL_TEXTURE_2D, GLsizei(mSource.levels.size()), mSource.internalFormat, GLsizei(mSource.width), GLsizei(mSource.height) );
+
+	// Levels that are uploaded directly: all of them, or the tail
+	std::size_t tail = 0;
+	while( mResident > 0 )
+	{
+		std::size_t const bytes = mSource.levels[mResident-1].size();
+		if( 0 != aFrameBudget && tail + bytes > kTailBytes_ )
+			break;
+
+		tail += bytes;
+		upload_level_( --mResident );
+	}
+
+	// The coarsest level is always uploaded, so that the texture is complete
+	if( mResident == mSource.levels.size() )
+		upload_level_( --mResident );
+
+	set_resident_( mResident );
+
+	if( done() )
+		return;
+
+	// Ring of upload buffers. Each segment holds at least one block row of
+	// level 0, so that every update makes progress.
+	mSegmentSize = std::max( aFrameBudget, block_row_bytes_( mSource.width ) );
+	mPersistent = 0 != GLAD_GL_VERSION_4_4;
+
+	for( auto& segment : mRing )
+	{
+		glGenBuffers( 1, &segment.buffer );
+		glBindBuffer( GL_PIXEL_UNPACK_BUFFER, segment.buffer );
+
+		if( mPersistent )
+		{
+			GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage( GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(mSegmentSize), nullptr, flags );
+			segment.mapped = static_cast<std::byte*>(glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(mSegmentSize), flags ));
+			if( !segment.mapped )
+			{
+				glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+				release_ring_();
+				glDeleteTextures( 1, &mTexture );
+				throw Error( "Unable to map texture upload buffer" );
+			}
+		}
+		else
+		{
+			glBufferData( GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(mSegmentSize), nullptr, GL_STREAM_DRAW );
+		}
+	}
+
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+	OGL_CHECKPOINT_ALWAYS();
+}
+
+StreamingTexture::~StreamingTexture()
+{
+	release_ring_();
+
+	if( 0 != mTexture )
+		glDeleteTextures( 1, &mTexture );
+}
+
+GLuint StreamingTexture::texture() const noexcept
+{
+	return mTexture;
+}
+
+std::size_t StreamingTexture::update()
+{
+	if( done() )
+		return 0;
+
+	auto& segment = mRing[mNextSegment];
+	if( segment.fence )
+	{
+		GLenum const status = glClientWaitSync( segment.fence, 0, 0 );
+		if( GL_TIMEOUT_EXPIRED == status )
+			return 0;
+
+		glDeleteSync( segment.fence );
+		segment.fence = nullptr;
+	}
+
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, segment.buffer );
+
+	std::byte* dest = segment.mapped;
+	if( !mPersistent )
+	{
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+		dest = static_cast<std::byte*>(glMapBufferRange( GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(mSegmentSize), flags ));
+		if( !dest )
+		{
+			glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+			throw Error( "Unable to map texture upload buffer" );
+		}
+	}
+
+	// Fill the segment with whole block rows of the next levels
+	mChunks.clear();
+
+	std::size_t used = 0;
+	std::size_t level = mResident;
+	std::size_t row = mNextRow;
+	while( level > 0 )
+	{
+		std::size_t const next = level-1;
+		std::size_t const rowBytes = block_row_bytes_( level_size_( mSource.width, next ) );
+		std::size_t const blockRows = (level_size_( mSource.height, next ) + 3) / 4;
+
+		std::size_t const rows = std::min( (mSegmentSize - used) / rowBytes, blockRows - row );
+		if( 0 == rows )
+			break;
+
+		std::memcpy( dest + used, mSource.levels[next].data() + row * rowBytes, rows * rowBytes );
+		mChunks.emplace_back( Chunk_{ next, row, rows, used } );
+
+		used += rows * rowBytes;
+		row += rows;
+
+		if( row == blockRows )
+		{
+			level = next;
+			row = 0;
+		}
+	}
+
+	if( !mPersistent )
+		glUnmapBuffer( GL_PIXEL_UNPACK_BUFFER );
+
+	// Upload from the buffer
+	glBindTexture( GL_TEXTURE_2D, mTexture );
+	for( auto const& chunk : mChunks )
+	{
+		GLsizei const width = GLsizei(level_size_( mSource.width, chunk.level ));
+		GLsizei const height = GLsizei(level_size_( mSource.height, chunk.level ));
+
+		// The last chunk of a level may extend past its edge (partial blocks)
+		GLint const y = GLint(chunk.blockRow * 4);
+		GLsizei const rows = std::min( GLsizei(chunk.blockRows * 4), height - y );
+		GLsizei const bytes = GLsizei(chunk.blockRows * block_row_bytes_( std::size_t(width) ));
+
+		glCompressedTexSubImage2D( GL_TEXTURE_2D, GLint(chunk.level), 0, y, width, rows, mSource.internalFormat, bytes, reinterpret_cast<void const*>(chunk.offset) );
+	}
+
+	glBindBuffer( GL_PIXEL_UNPACK_BUFFER, 0 );
+	segment.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	mNextSegment = (mNextSegment + 1) % kRingSize_;
+
+	// Expose the completed levels. The GL executes the uploads above before
+	// any draw that is issued later, so they are safe to sample.
+	mNextRow = row;
+	if( level != mResident )
+	{
+		for( std::size_t i = level; i < mResident; ++i )
+			mSource.levels[i] = {};
+
+		set_resident_( level );
+	}
+
+	if( done() )
+		release_ring_();
+
+	return used;
+}
+
+bool StreamingTexture::done() const noexcept
+{
+	return 0 == mResident;
+}
+
+std::size_t StreamingTexture::resident_level() const noexcept
+{
+	return mResident;
+}
+std::size_t StreamingTexture::level_count() const noexcept
+{
+	return mSource.levels.size();
+}
+
+void StreamingTexture::upload_level_( std::size_t aLevel ) const
+{
+	auto const& data = mSource.levels[aLevel];
+	glCompressedTexSubImage2D( GL_TEXTURE_2D, GLint(aLevel), 0, 0,
+		GLsizei(level_size_( mSource.width, aLevel )),
+		GLsizei(level_size_( mSource.height, aLevel )),
+		mSource.internalFormat,
+		GLsizei(data.size()),
+		data.data()
+	);
+}
+
+void StreamingTexture::set_resident_( std::size_t aLevel )
+{
+	mResident = aLevel;
+
+	glBindTexture( GL_TEXTURE_2D, mTexture );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, GLint(aLevel) );
+}
+
+void StreamingTexture::release_ring_() noexcept
+{
+	// Deleting a buffer also unmaps it. The GL defers the deletion until
+	// pending uploads from it have completed.
+	for( auto& segment : mRing )
+	{
+		if( segment.fence )
+			glDeleteSync( segment.fence );
+		if( 0 != segment.buffer )
+			glDeleteBuffers( 1, &segment.buffer );
+
+		segment = Segment_{};
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef TEXTURE_STREAM_HPP_6C0F3A85_D2E7_4B19_A46E_95B18D7C23F0
+#define TEXTURE_STREAM_HPP_6C0F3A85_D2E7_4B19_A46E_95B18D7C23F0
+
+#include <glad/glad.h>
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+#include "compressed_texture.hpp"
+
+/* Progressive texture streaming
+ *
+ * Uploads a compressed mip chain (see compressed_texture.hpp) over several
+ * frames, smallest levels first, so that a large texture can be drawn right
+ * away. The constructor creates the texture with storage for all levels and
+ * uploads the small levels at the end of the chain directly. Each call to
+ * update() then copies up to a fixed number of bytes of the next levels
+ * into one of a ring of pixel buffer objects and issues the uploads from
+ * there. Levels are streamed whole block rows at a time.
+ *
+ * GL_TEXTURE_BASE_LEVEL is kept at the finest level that is fully
+ * resident, so sampling never reaches a level that is still (partially)
+ * undefined. (GL_TEXTURE_MIN_LOD is relative to the base level and would
+ * not prevent this when magnifying.)
+ *
+ * The buffers are mapped persistently if the context supports GL 4.4, and
+ * mapped for each update otherwise. A fence per buffer protects it from
+ * being overwritten while the GL still reads from it; if the next buffer is
+ * still in use, update() skips the frame.
+ */
+
+class StreamingTexture final
+{
+	public:
+		// Uploads all levels at once if aFrameBudget is zero. Otherwise,
+		// update() uploads at most max( aFrameBudget, one block row of
+		// level 0 ) bytes per call.
+		explicit StreamingTexture(
+			CompressedTexture aTexture,
+			std::size_t aFrameBudget
+		);
+		~StreamingTexture();
+
+		StreamingTexture( StreamingTexture const& ) = delete;
+		StreamingTexture& operator= (StreamingTexture const&) = delete;
+
+	public:
+		GLuint texture() const noexcept;
+
+		// Uploads the next part of the texture. Returns the number of bytes
+		// queued for upload (zero when done or when the next buffer is
+		// still in use).
+		std::size_t update();
+
+		bool done() const noexcept;
+
+		// Finest level that can be sampled, i.e., GL_TEXTURE_BASE_LEVEL
+		std::size_t resident_level() const noexcept;
+		std::size_t level_count() const noexcept;
+
+	private:
+		struct Segment_
+		{
+			GLuint buffer = 0;
+			GLsync fence = nullptr;
+			std::byte* mapped = nullptr; // if persistent
+		};
+
+		struct Chunk_
+		{
+			std::size_t level;
+			std::size_t blockRow;
+			std::size_t blockRows;
+			std::size_t offset; // in the segment's buffer
+		};
+
+		static constexpr std::size_t kRingSize_ = 3;
+
+	private:
+		void upload_level_( std::size_t ) const;
+		void set_resident_( std::size_t );
+		void release_ring_() noexcept;
+
+	private:
+		GLuint mTexture;
+		CompressedTexture mSource; // levels are freed once uploaded
+
+		std::size_t mResident; // finest fully uploaded level
+		std::size_t mNextRow;  // next block row of level mResident-1
+
+		std::size_t mSegmentSize;
+		std::array<Segment_, kRingSize_> mRing;
+		std::size_t mNextSegment;
+		bool mPersistent;
+
+		std::vector<Chunk_> mChunks; // scratch, see update()
+};
+
+#endif // TEXTURE_STREAM_HPP_6C0F3A85_D2E7_4B19_A46E_95B18D7C23F0
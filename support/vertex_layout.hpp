@@ -0,0 +1,270 @@
+#ifndef VERTEX_LAYOUT_HPP_307C8207_8D9C_453F_9ADD_2FA21F3819D1
+#define VERTEX_LAYOUT_HPP_307C8207_8D9C_453F_9ADD_2FA21F3819D1
+
+#include <glad/glad.h>
+
+#include <span>
+#include <array>
+#include <tuple>
+#include <vector>
+#include <ranges>
+#include <utility>
+#include <type_traits>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "../vmlib/vec2.hpp"
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/packing.hpp"
+
+/* Compile-time vertex layouts
+ *
+ * A VertexLayout lists the attributes of an interleaved vertex, e.g.
+ *
+ *   using MeshLayout = VertexLayout<
+ *     VertexAttrib<0, Vec3f>,   // location 0: position
+ *     VertexAttrib<1, Vec3f>,   // location 1: normal
+ *     VertexAttrib<2, Vec2f>    // location 2: texture coordinate
+ *   >;
+ *
+ * From this, the layout derives the byte offset of each attribute and the
+ * stride (kOffsets, kStride), the interleaved vertex type (Vertex) and the
+ * matching glVertexAttribPointer() calls (setup_attribs()). Attributes are
+ * packed in order, each starting at a multiple of four bytes.
+ *
+ * The GL type and component count of an attribute follow from its C++ type
+ * via VertexAttribTraits, which can be specialized for new types. Invalid
+ * layouts (unsupported types, duplicate locations) and streams that do not
+ * match a layout (see interleave()) fail to compile.
+ */
+
+// Scalar types:
+template< typename tType >
+struct VertexAttribTraits; // not defined: type cannot be used as an attribute
+
+namespace detail
+{
+	template< GLenum tType, GLint tCount >
+	struct VertexAttribTraitsBase
+	{
+		static constexpr GLenum type = tType;
+		static constexpr GLint count = tCount;
+	};
+}
+
+template<> struct VertexAttribTraits<float> : detail::VertexAttribTraitsBase<GL_FLOAT, 1> {};
+template<> struct VertexAttribTraits<std::int8_t> : detail::VertexAttribTraitsBase<GL_BYTE, 1> {};
+template<> struct VertexAttribTraits<std::uint8_t> : detail::VertexAttribTraitsBase<GL_UNSIGNED_BYTE, 1> {};
+template<> struct VertexAttribTraits<std::int16_t> : detail::VertexAttribTraitsBase<GL_SHORT, 1> {};
+template<> struct VertexAttribTraits<std::uint16_t> : detail::VertexAttribTraitsBase<GL_UNSIGNED_SHORT, 1> {};
+template<> struct VertexAttribTraits<std::int32_t> : detail::VertexAttribTraitsBase<GL_INT, 1> {};
+template<> struct VertexAttribTraits<std::uint32_t> : detail::VertexAttribTraitsBase<GL_UNSIGNED_INT, 1> {};
+
+// Vector types:
+template<> struct VertexAttribTraits<Vec2f> : detail::VertexAttribTraitsBase<GL_FLOAT, 2> {};
+template<> struct VertexAttribTraits<Vec3f> : detail::VertexAttribTraitsBase<GL_FLOAT, 3> {};
+template<> struct VertexAttribTraits<Vec4f> : detail::VertexAttribTraitsBase<GL_FLOAT, 4> {};
+
+// Packed types (see packing.hpp):
+template<> struct VertexAttribTraits<Half2> : detail::VertexAttribTraitsBase<GL_HALF_FLOAT, 2> {};
+template<> struct VertexAttribTraits<OctNormal16> : detail::VertexAttribTraitsBase<GL_SHORT, 2> {};
+
+template< typename tScalar, std::size_t tCount >
+struct VertexAttribTraits<std::array<tScalar, tCount>>
+	: detail::VertexAttribTraitsBase<VertexAttribTraits<tScalar>::type, GLint(tCount)>
+{
+	static_assert( 1 == VertexAttribTraits<tScalar>::count );
+};
+
+
+// A single attribute. Integer types are converted to floats in the shader,
+// either normalized (tNormalized) or as is.
+template< GLuint tLocation, typename tType, bool tNormalized = false >
+struct VertexAttrib
+{
+	using Type = tType;
+
+	static constexpr GLuint location = tLocation;
+	static constexpr GLenum glType = VertexAttribTraits<tType>::type;
+	static constexpr GLint count = VertexAttribTraits<tType>::count;
+	static constexpr bool normalized = tNormalized;
+
+	static_assert( std::is_trivially_copyable_v<tType> );
+	static_assert( count >= 1 && count <= 4, "GL attributes have 1 to 4 components" );
+	static_assert( !tNormalized || GL_FLOAT != glType, "Only integer attributes can be normalized" );
+};
+
+namespace detail
+{
+	constexpr std::size_t kVertexAttribAlign = 4;
+
+	template< typename... tAttribs >
+	constexpr auto vertex_offsets() noexcept
+	{
+		std::size_t const sizes[] = { sizeof(typename tAttribs::Type)... };
+
+		std::array<std::size_t, sizeof...(tAttribs)+1> ret{}; // last = stride
+		std::size_t offset = 0;
+		for( std::size_t i = 0; i < sizeof...(tAttribs); ++i )
+		{
+			ret[i] = offset;
+			offset += sizes[i];
+			offset = (offset + kVertexAttribAlign - 1) / kVertexAttribAlign * kVertexAttribAlign;
+		}
+		ret.back() = offset;
+		return ret;
+	}
+
+	template< typename... tAttribs >
+	constexpr bool unique_locations() noexcept
+	{
+		GLuint const locations[] = { tAttribs::location... };
+		for( std::size_t i = 0; i < sizeof...(tAttribs); ++i )
+		{
+			for( std::size_t j = i+1; j < sizeof...(tAttribs); ++j )
+			{
+				if( locations[i] == locations[j] )
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+template< typename... tAttribs >
+struct VertexLayout
+{
+	static_assert( sizeof...(tAttribs) > 0 );
+	static_assert( detail::unique_locations<tAttribs...>(), "Attribute locations must be unique" );
+
+	static constexpr std::size_t kAttribCount = sizeof...(tAttribs);
+
+	static constexpr std::array<std::size_t, kAttribCount+1> kOffsetsAndStride_ = detail::vertex_offsets<tAttribs...>();
+	static constexpr std::size_t kStride = kOffsetsAndStride_.back();
+
+	static constexpr std::array<std::size_t, kAttribCount> kOffsets = [] {
+		std::array<std::size_t, kAttribCount> ret{};
+		for( std::size_t i = 0; i < kAttribCount; ++i )
+			ret[i] = kOffsetsAndStride_[i];
+		return ret;
+	}();
+
+	template< std::size_t tIndex >
+	using Attrib = std::tuple_element_t<tIndex, std::tuple<tAttribs...>>;
+
+	// Index of the attribute at tLocation, or kAttribCount if there is none
+	template< GLuint tLocation >
+	static constexpr std::size_t index_of() noexcept
+	{
+		GLuint const locations[] = { tAttribs::location... };
+		for( std::size_t i = 0; i < kAttribCount; ++i )
+		{
+			if( tLocation == locations[i] )
+				return i;
+		}
+		return kAttribCount;
+	}
+
+	template< GLuint tLocation >
+	static constexpr bool has_location() noexcept
+	{
+		return index_of<tLocation>() < kAttribCount;
+	}
+
+	// Interleaved vertex
+	struct Vertex
+	{
+		alignas(detail::kVertexAttribAlign) std::byte bytes[kStride];
+
+		template< std::size_t tIndex >
+		void set( typename Attrib<tIndex>::Type const& aValue ) noexcept
+		{
+			std::memcpy( bytes + kOffsets[tIndex], &aValue, sizeof(aValue) );
+		}
+
+		template< std::size_t tIndex >
+		typename Attrib<tIndex>::Type get() const noexcept
+		{
+			typename Attrib<tIndex>::Type ret;
+			std::memcpy( &ret, bytes + kOffsets[tIndex], sizeof(ret) );
+			return ret;
+		}
+	};
+
+	static_assert( sizeof(Vertex) == kStride );
+
+	// Enables and sets up all attributes for the currently bound VAO. The
+	// vertices are sourced from the currently bound GL_ARRAY_BUFFER, starting
+	// at aBaseOffset bytes.
+	static void setup_attribs( std::size_t aBaseOffset = 0 ) noexcept
+	{
+		std::size_t i = 0;
+		( setup_attrib_<tAttribs>( aBaseOffset + kOffsets[i++] ), ... );
+	}
+
+	private:
+		template< typename tAttrib >
+		static void setup_attrib_( std::size_t aOffset ) noexcept
+		{
+			glEnableVertexAttribArray( tAttrib::location );
+			glVertexAttribPointer(
+				tAttrib::location,
+				tAttrib::count,
+				tAttrib::glType,
+				tAttrib::normalized ? GL_TRUE : GL_FALSE,
+				GLsizei(kStride),
+				reinterpret_cast<void const*>(aOffset)
+			);
+		}
+};
+
+
+namespace detail
+{
+	template< typename tLayout, std::size_t... tIndices, typename... tStreams >
+	void interleave_( std::span<typename tLayout::Vertex> aOut, std::index_sequence<tIndices...>, tStreams const&... aStreams )
+	{
+		static_assert(
+			(std::is_same_v<std::ranges::range_value_t<tStreams>, typename tLayout::template Attrib<tIndices>::Type> && ...),
+			"Stream element types do not match the vertex layout"
+		);
+
+		assert( ((std::size_t(std::ranges::size( aStreams )) == aOut.size()) && ...) );
+
+		for( std::size_t i = 0; i < aOut.size(); ++i )
+			( aOut[i].template set<tIndices>( std::ranges::data( aStreams )[i] ), ... );
+	}
+}
+
+// As interleave(), but writes to aOut, which must hold one vertex per
+// stream element (e.g., a buffer that is uploaded later)
+template< typename tLayout, typename... tStreams >
+void interleave_into( std::span<typename tLayout::Vertex> aOut, tStreams const&... aStreams )
+{
+	static_assert( sizeof...(tStreams) == tLayout::kAttribCount, "Need one stream per attribute" );
+	static_assert( (std::ranges::contiguous_range<tStreams> && ...) );
+
+	detail::interleave_<tLayout>( aOut, std::make_index_sequence<tLayout::kAttribCount>(), aStreams... );
+}
+
+// Interleaves separate attribute streams, one per attribute of tLayout (in
+// the same order), into vertices. Streams are contiguous ranges, e.g.,
+// std::vector or std::span, and must all have the same size.
+template< typename tLayout, typename... tStreams >
+std::vector<typename tLayout::Vertex> interleave( tStreams const&... aStreams )
+{
+	static_assert( sizeof...(tStreams) == tLayout::kAttribCount, "Need one stream per attribute" );
+	static_assert( (std::ranges::contiguous_range<tStreams> && ...) );
+
+	std::size_t const count = std::size_t(std::ranges::size( std::get<0>( std::tie( aStreams... ) ) ));
+
+	std::vector<typename tLayout::Vertex> ret( count );
+	interleave_into<tLayout>( std::span( ret ), aStreams... );
+	return ret;
+}
+
+#endif // VERTEX_LAYOUT_HPP_307C8207_8D9C_453F_9ADD_2FA21F3819D1
@@ -0,0 +1,465 @@
+#include "virtual_texture.hpp"
+
+#include <cmath>
+#include <utility>
+#include <algorithm>
+#include <functional>
+
+#include <cassert>
+
+#include "error.hpp"
+#include "checkpoint.hpp"
+
+namespace
+{
+	// Slots are stored in 8 bits per axis in the page table
+	constexpr std::uint32_t kMaxCachePages_ = 256;
+}
+
+VirtualTexture::VirtualTexture( std::filesystem::path const& aPath, VirtualTextureOptions const& aOptions )
+	: mOptions( aOptions )
+	, mPageTable( 0 )
+	, mPageCache( 0 )
+	, mFeedbackFbo( 0 )
+	, mFeedbackColor( 0 )
+	, mFeedbackDepth( 0 )
+	, mFeedbackWidth( 0 )
+	, mFeedbackHeight( 0 )
+	, mNextReadback( 0 )
+	, mPinnedSlots( 0 )
+	, mFrame( 0 )
+	, mRequested( 0 )
+	, mTableDirty( true )
+	, mStop( false )
+{
+	VirtualTextureFile file( aPath );
+	mLayout = file.layout();
+
+	std::uint32_t const coarsest = mLayout.level_count() - 1;
+	std::size_t const pinned = std::size_t(mLayout.pages_x( coarsest )) * mLayout.pages_y( coarsest );
+	std::size_t const slots = std::size_t(mOptions.cachePages) * mOptions.cachePages;
+	if( mOptions.cachePages > kMaxCachePages_ || pinned >= slots )
+		throw Error( "Virtual texture '{}': a cache of {}x{} pages is not supported", aPath.string(), mOptions.cachePages, mOptions.cachePages );
+
+	mPages.resize( mLayout.page_count() );
+	mSlots.assign( slots, kNoPage_ );
+	mTableTexels.resize( mLayout.page_count() );
+
+	OGL_CHECKPOINT_ALWAYS();
+
+	// Page cache
+	GLsizei const cacheSize = GLsizei(cache_size());
+
+	glGenTextures( 1, &mPageCache );
+	glBindTexture( GL_TEXTURE_2D, mPageCache );
+	glTexStorage2D( GL_TEXTURE_2D, 1, file.header().internalFormat, cacheSize, cacheSize );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+	// Page table; integer textures are only complete with NEAREST filtering
+	glGenTextures( 1, &mPageTable );
+	glBindTexture( GL_TEXTURE_2D, mPageTable );
+	glTexStorage2D( GL_TEXTURE_2D, GLsizei(mLayout.level_count()), GL_RGBA8UI, GLsizei(mLayout.pages_x( 0 )), GLsizei(mLayout.pages_y( 0 )) );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+
+	// Feedback; the attachments are (re-)created by begin_feedback()
+	glGenFramebuffers( 1, &mFeedbackFbo );
+	glGenRenderbuffers( 1, &mFeedbackColor );
+	glGenRenderbuffers( 1, &mFeedbackDepth );
+
+	for( auto& readback : mReadbacks )
+		glGenBuffers( 1, &readback.buffer );
+
+	// Pinned pages: the coarsest level, in the first slots
+	LoadedPage_ page{ 0, std::vector<std::uint8_t>( kVtPageBytes ) };
+	for( std::uint32_t y = 0; y < mLayout.pages_y( coarsest ); ++y )
+	{
+		for( std::uint32_t x = 0; x < mLayout.pages_x( coarsest ); ++x )
+		{
+			page.index = mLayout.page_index( coarsest, x, y );
+			file.read_page( page.index, std::span<std::uint8_t, kVtPageBytes>( page.data.data(), kVtPageBytes ) );
+
+			[[maybe_unused]] bool const uploaded = upload_( page );
+			assert( uploaded );
+		}
+	}
+	mPinnedSlots = pinned;
+
+	update_page_table_();
+
+	OGL_CHECKPOINT_ALWAYS();
+
+	std::size_t const loaders = std::max<std::size_t>( mOptions.loaderThreads, 1 );
+	mLoaders.reserve( loaders );
+	for( std::size_t i = 0; i < loaders; ++i )
+		mLoaders.emplace_back( [this, aPath] { loader_( aPath ); } );
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	{
+		std::scoped_lock const lock( mMutex );
+		mStop = true;
+		mQueue.clear();
+	}
+	mLoaderCv.notify_all();
+
+	mLoaders.clear(); // joins
+
+	for( auto& readback : mReadbacks )
+	{
+		if( readback.fence )
+			glDeleteSync( readback.fence );
+		glDeleteBuffers( 1, &readback.buffer );
+	}
+
+	glDeleteRenderbuffers( 1, &mFeedbackDepth );
+	glDeleteRenderbuffers( 1, &mFeedbackColor );
+	glDeleteFramebuffers( 1, &mFeedbackFbo );
+
+	glDeleteTextures( 1, &mPageTable );
+	glDeleteTextures( 1, &mPageCache );
+}
+
+void VirtualTexture::update()
+{
+	{
+		std::scoped_lock const lock( mMutex );
+		if( mError )
+			std::rethrow_exception( mError );
+
+		for( auto& page : mLoaded )
+			mReady.emplace_back( std::move(page) );
+		mLoaded.clear();
+	}
+
+	read_feedback_();
+
+	// Upload loaded pages. A page that finds no slot is dropped, and
+	// requested again by later feedback if still needed.
+	std::size_t uploads = 0, processed = 0;
+	for( ; processed < mReady.size() && uploads < mOptions.uploadsPerFrame; ++processed )
+	{
+		auto const& page = mReady[processed];
+		mPages[page.index].pending = false;
+
+		if( upload_( page ) )
+			++uploads;
+	}
+	mReady.erase( mReady.begin(), mReady.begin() + std::ptrdiff_t(processed) );
+
+	if( mTableDirty )
+		update_page_table_();
+}
+
+void VirtualTexture::begin_feedback( int aFbWidth, int aFbHeight )
+{
+	int const width = std::max( aFbWidth / int(mOptions.feedbackDivisor), 1 );
+	int const height = std::max( aFbHeight / int(mOptions.feedbackDivisor), 1 );
+
+	glBindFramebuffer( GL_FRAMEBUFFER, mFeedbackFbo );
+
+	if( width != mFeedbackWidth || height != mFeedbackHeight )
+	{
+		glBindRenderbuffer( GL_RENDERBUFFER, mFeedbackColor );
+		glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8UI, width, height );
+		glBindRenderbuffer( GL_RENDERBUFFER, mFeedbackDepth );
+		glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height );
+		glBindRenderbuffer( GL_RENDERBUFFER, 0 );
+
+		glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mFeedbackColor );
+		glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mFeedbackDepth );
+
+		if( GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus( GL_FRAMEBUFFER ) )
+		{
+			glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+			throw Error( "Virtual texture feedback framebuffer is incomplete" );
+		}
+
+		mFeedbackWidth = width;
+		mFeedbackHeight = height;
+	}
+
+	glViewport( 0, 0, width, height );
+
+	// Alpha zero marks texels without a request
+	GLuint const noRequest[4] = { 0, 0, 0, 0 };
+	GLfloat const farDepth = 1.f;
+	glDepthMask( GL_TRUE );
+	glClearBufferuiv( GL_COLOR, 0, noRequest );
+	glClearBufferfv( GL_DEPTH, 0, &farDepth );
+}
+
+void VirtualTexture::feedback_viewport( int aX, int aY, int aWidth, int aHeight ) const
+{
+	int const div = int(mOptions.feedbackDivisor);
+	glViewport( aX / div, aY / div, std::max( aWidth / div, 1 ), std::max( aHeight / div, 1 ) );
+}
+
+void VirtualTexture::end_feedback()
+{
+	// If the oldest readback is still in flight, this frame's feedback is
+	// dropped rather than waited for.
+	auto& readback = mReadbacks[mNextReadback];
+	if( !readback.fence )
+	{
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, readback.buffer );
+		if( readback.width != mFeedbackWidth || readback.height != mFeedbackHeight )
+		{
+			glBufferData( GL_PIXEL_PACK_BUFFER, GLsizeiptr(mFeedbackWidth) * mFeedbackHeight * 4, nullptr, GL_STREAM_READ );
+			readback.width = mFeedbackWidth;
+			readback.height = mFeedbackHeight;
+		}
+
+		glReadBuffer( GL_COLOR_ATTACHMENT0 );
+		glReadPixels( 0, 0, mFeedbackWidth, mFeedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, nullptr );
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+
+		readback.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		mNextReadback = (mNextReadback + 1) % kReadbackCount_;
+	}
+
+	glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+}
+
+float VirtualTexture::feedback_lod_bias() const noexcept
+{
+	return -std::log2( float(mOptions.feedbackDivisor) );
+}
+
+VtLayout const& VirtualTexture::layout() const noexcept
+{
+	return mLayout;
+}
+
+GLuint VirtualTexture::page_table() const noexcept
+{
+	return mPageTable;
+}
+GLuint VirtualTexture::page_cache() const noexcept
+{
+	return mPageCache;
+}
+std::uint32_t VirtualTexture::cache_size() const noexcept
+{
+	return mOptions.cachePages * std::uint32_t(kVtPageStride);
+}
+
+VirtualTextureStats VirtualTexture::stats() const noexcept
+{
+	VirtualTextureStats ret{};
+	ret.residentPages = mSlots.size() - std::size_t(std::count( mSlots.begin(), mSlots.end(), kNoPage_ ));
+	ret.cacheSlots = mSlots.size();
+	ret.requestedPages = mRequested;
+	ret.pendingPages = std::size_t(std::count_if( mPages.begin(), mPages.end(), [] (Page_ const& aPage) { return aPage.pending; } ));
+	return ret;
+}
+
+void VirtualTexture::loader_( std::filesystem::path aPath )
+{
+	try
+	{
+		VirtualTextureFile file( aPath );
+
+		while( true )
+		{
+			LoadedPage_ page;
+			{
+				std::unique_lock lock( mMutex );
+				mLoaderCv.wait( lock, [this] { return mStop || !mQueue.empty(); } );
+				if( mStop )
+					return;
+
+				page.index = mQueue.front();
+				mQueue.pop_front();
+			}
+
+			page.data.resize( kVtPageBytes );
+			file.read_page( page.index, std::span<std::uint8_t, kVtPageBytes>( page.data.data(), kVtPageBytes ) );
+
+			std::scoped_lock const lock( mMutex );
+			mLoaded.emplace_back( std::move(page) );
+		}
+	}
+	catch( ... )
+	{
+		std::scoped_lock const lock( mMutex );
+		if( !mError )
+			mError = std::current_exception();
+	}
+}
+
+void VirtualTexture::read_feedback_()
+{
+	// Oldest first; stop at the first readback that has not completed
+	bool any = false;
+	for( std::size_t i = 0; i < kReadbackCount_; ++i )
+	{
+		auto& readback = mReadbacks[(mNextReadback + i) % kReadbackCount_];
+		if( !readback.fence )
+			continue;
+
+		if( GL_TIMEOUT_EXPIRED == glClientWaitSync( readback.fence, 0, 0 ) )
+			break;
+
+		glDeleteSync( readback.fence );
+		readback.fence = nullptr;
+
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, readback.buffer );
+		std::size_t const bytes = std::size_t(readback.width) * std::size_t(readback.height) * 4;
+		auto const* texels = static_cast<std::uint8_t const*>(glMapBufferRange( GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(bytes), GL_MAP_READ_BIT ));
+		if( texels )
+		{
+			++mFrame;
+			mRequested = 0;
+			mRequests.clear();
+
+			std::uint32_t const levels = mLayout.level_count();
+			for( std::size_t t = 0; t < bytes; t += 4 )
+			{
+				std::uint32_t const x = texels[t+0], y = texels[t+1], level = texels[t+2];
+				if( 0 == texels[t+3] || level >= levels || x >= mLayout.pages_x( level ) || y >= mLayout.pages_y( level ) )
+					continue;
+
+				request_( level, x, y );
+			}
+
+			glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+			any = true;
+		}
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+	}
+
+	if( any )
+		queue_requests_();
+}
+
+void VirtualTexture::request_( std::uint32_t aLevel, std::uint32_t aX, std::uint32_t aY )
+{
+	// The page and its ancestors, which are the fallbacks while it loads
+	for( std::uint32_t level = aLevel; level < mLayout.level_count(); ++level )
+	{
+		std::uint32_t const shift = level - aLevel;
+		auto& page = mPages[mLayout.page_index( level, aX >> shift, aY >> shift )];
+		if( mFrame == page.used )
+			break; // ancestors are marked as well
+
+		page.used = mFrame;
+		++mRequested;
+
+		if( page.slot < 0 )
+			mRequests.emplace_back( mLayout.page_index( level, aX >> shift, aY >> shift ) );
+	}
+}
+
+void VirtualTexture::queue_requests_()
+{
+	// Finer levels have larger indices, so this puts the coarsest first
+	std::sort( mRequests.begin(), mRequests.end(), std::greater<>() );
+
+	{
+		std::scoped_lock const lock( mMutex );
+
+		// Replace the queue; pages that loaders already took stay pending
+		for( auto const index : mQueue )
+			mPages[index].pending = false;
+		mQueue.clear();
+
+		for( auto const index : mRequests )
+		{
+			if( mPages[index].pending )
+				continue;
+
+			mPages[index].pending = true;
+			mQueue.emplace_back( index );
+		}
+	}
+	mLoaderCv.notify_all();
+}
+
+bool VirtualTexture::upload_( LoadedPage_ const& aPage )
+{
+	auto& page = mPages[aPage.index];
+	if( page.slot >= 0 )
+		return false;
+
+	// A free slot, or the least recently used one. Pinned slots and pages
+	// requested by the latest feedback are never evicted.
+	std::size_t slot = mSlots.size();
+	std::uint32_t oldest = mFrame;
+	for( std::size_t i = mPinnedSlots; i < mSlots.size(); ++i )
+	{
+		if( kNoPage_ == mSlots[i] )
+		{
+			slot = i;
+			break;
+		}
+
+		std::uint32_t const used = mPages[mSlots[i]].used;
+		if( used < oldest )
+		{
+			slot = i;
+			oldest = used;
+		}
+	}
+
+	if( slot == mSlots.size() )
+		return false;
+
+	if( kNoPage_ != mSlots[slot] )
+		mPages[mSlots[slot]].slot = -1;
+
+	mSlots[slot] = aPage.index;
+	page.slot = std::int32_t(slot);
+
+	GLint const x = GLint(slot % mOptions.cachePages * kVtPageStride);
+	GLint const y = GLint(slot / mOptions.cachePages * kVtPageStride);
+
+	glBindTexture( GL_TEXTURE_2D, mPageCache );
+	glCompressedTexSubImage2D( GL_TEXTURE_2D, 0, x, y, GLsizei(kVtPageStride), GLsizei(kVtPageStride), GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, GLsizei(kVtPageBytes), aPage.data.data() );
+
+	mTableDirty = true;
+	return true;
+}
+
+void VirtualTexture::update_page_table_()
+{
+	glBindTexture( GL_TEXTURE_2D, mPageTable );
+
+	// Coarsest level first, so that missing pages can copy their parent
+	for( std::uint32_t level = mLayout.level_count(); level-- > 0; )
+	{
+		std::uint32_t const pagesX = mLayout.pages_x( level ), pagesY = mLayout.pages_y( level );
+		for( std::uint32_t y = 0; y < pagesY; ++y )
+		{
+			for( std::uint32_t x = 0; x < pagesX; ++x )
+			{
+				std::uint32_t const index = mLayout.page_index( level, x, y );
+				std::int32_t const slot = mPages[index].slot;
+
+				if( slot >= 0 )
+				{
+					mTableTexels[index] = {
+						std::uint8_t(std::uint32_t(slot) % mOptions.cachePages),
+						std::uint8_t(std::uint32_t(slot) / mOptions.cachePages),
+						std::uint8_t(level),
+						1
+					};
+				}
+				else
+				{
+					// The coarsest level is pinned, so there is always a parent
+					assert( level + 1 < mLayout.level_count() );
+					mTableTexels[index] = mTableTexels[mLayout.page_index( level+1, x/2, y/2 )];
+				}
+			}
+		}
+
+		glTexSubImage2D( GL_TEXTURE_2D, GLint(level), 0, 0, GLsizei(pagesX), GLsizei(pagesY), GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, mTableTexels.data() + mLayout.page_index( level, 0, 0 ) );
+	}
+
+	mTableDirty = false;
+}
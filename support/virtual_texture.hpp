@@ -0,0 +1,178 @@
+#ifndef VIRTUAL_TEXTURE_HPP_7E29B4D1_0C65_4A83_B1F7_64D8A2E95C3B
+#define VIRTUAL_TEXTURE_HPP_7E29B4D1_0C65_4A83_B1F7_64D8A2E95C3B
+
+#include <glad/glad.h>
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <condition_variable>
+
+#include "virtual_texture_file.hpp"
+
+/* Virtual texturing
+ *
+ * Keeps only the pages of a virtual texture file (see
+ * virtual_texture_file.hpp) that are visible in a fixed size page cache
+ * texture, so that texture memory no longer depends on the size of the
+ * source image.
+ *
+ *  - The page cache is a single level texture with room for cachePages x
+ *    cachePages pages, including their borders.
+ *  - The page table (or indirection texture) has one texel per page of the
+ *    virtual texture, with one mip level per level of the page grid. Each
+ *    texel holds the cache slot (x, y) of the page and its level. Pages that
+ *    are not resident point to the finest resident ancestor, so lookups
+ *    always succeed, at a coarser level if necessary. The pages of the
+ *    coarsest level are loaded by the constructor and never evicted.
+ *  - Each frame, the terrain is also drawn into a small feedback buffer,
+ *    aFeedbackDivisor times smaller than the framebuffer, by a shader that
+ *    writes the page (x, y, level) each fragment would like to sample. The
+ *    buffer is read back asynchronously, through pixel buffer objects.
+ *  - update() reads completed feedback, marks the requested pages and
+ *    their ancestors as used, and queues the missing ones, coarsest first,
+ *    for a pool of loader threads that read them from the file. Loaded pages
+ *    are uploaded into free cache slots, or replace the least recently used
+ *    pages that were not requested by the latest feedback.
+ *
+ * Shaders compute the desired level from the screen space derivatives of
+ * the level 0 texel coordinates (see default.frag and vt_feedback.frag).
+ * Filtering is bilinear within the selected level.
+ */
+
+struct VirtualTextureOptions
+{
+	std::uint32_t cachePages = 16;      // per side of the page cache
+	std::size_t loaderThreads = 2;
+	std::size_t uploadsPerFrame = 8;     // pages
+	std::uint32_t feedbackDivisor = 8;   // feedback buffer size, relative to the framebuffer
+};
+
+struct VirtualTextureStats
+{
+	std::size_t residentPages;
+	std::size_t cacheSlots;
+	std::size_t requestedPages; // by the latest feedback, including ancestors
+	std::size_t pendingPages;   // queued, being loaded or waiting for upload
+};
+
+class VirtualTexture final
+{
+	public:
+		// Throws Error if the file cannot be opened or its pinned pages do
+		// not fit into the cache.
+		explicit VirtualTexture(
+			std::filesystem::path const&,
+			VirtualTextureOptions const& = {}
+		);
+
+		// Stops the loader threads; pages that are being loaded are dropped.
+		~VirtualTexture();
+
+		VirtualTexture( VirtualTexture const& ) = delete;
+		VirtualTexture& operator= (VirtualTexture const&) = delete;
+
+	public:
+		// Processes feedback, queues requests and uploads loaded pages.
+		// Rethrows errors from the loader threads.
+		void update();
+
+		// Binds the feedback buffer, resized to match aFbWidth x aFbHeight,
+		// and clears it. Draw the terrain with the feedback shader (and
+		// feedback_lod_bias()) before calling end_feedback().
+		void begin_feedback( int aFbWidth, int aFbHeight );
+
+		// Equivalent of glViewport() for a framebuffer rectangle, while the
+		// feedback buffer is bound
+		void feedback_viewport( int aX, int aY, int aWidth, int aHeight ) const;
+
+		// Starts reading back the feedback and binds the default framebuffer.
+		void end_feedback();
+
+		// Level bias for the feedback shader, compensating for the reduced
+		// resolution of the feedback buffer
+		float feedback_lod_bias() const noexcept;
+
+	public:
+		VtLayout const& layout() const noexcept;
+
+		GLuint page_table() const noexcept;
+		GLuint page_cache() const noexcept;
+		std::uint32_t cache_size() const noexcept; // texels, per side
+
+		VirtualTextureStats stats() const noexcept;
+
+	private:
+		struct Page_
+		{
+			std::int32_t slot = -1;   // -1: not resident
+			std::uint32_t used = 0;   // frame of the latest request
+			bool pending = false;     // queued or being loaded
+		};
+
+		struct LoadedPage_
+		{
+			std::uint32_t index;
+			std::vector<std::uint8_t> data; // kVtPageBytes
+		};
+
+		struct Readback_
+		{
+			GLuint buffer = 0;
+			GLsync fence = nullptr;
+			int width = 0, height = 0;
+		};
+
+		static constexpr std::uint32_t kNoPage_ = ~std::uint32_t(0);
+		static constexpr std::size_t kReadbackCount_ = 3;
+
+		void loader_( std::filesystem::path );
+
+		void read_feedback_();
+		void request_( std::uint32_t aLevel, std::uint32_t aX, std::uint32_t aY );
+		void queue_requests_();
+		bool upload_( LoadedPage_ const& );
+		void update_page_table_();
+
+	private:
+		VtLayout mLayout;
+		VirtualTextureOptions mOptions;
+
+		GLuint mPageTable;
+		GLuint mPageCache;
+		GLuint mFeedbackFbo;
+		GLuint mFeedbackColor;
+		GLuint mFeedbackDepth;
+		int mFeedbackWidth, mFeedbackHeight;
+
+		std::array<Readback_, kReadbackCount_> mReadbacks;
+		std::size_t mNextReadback;
+
+		std::vector<Page_> mPages;
+		std::vector<std::uint32_t> mSlots; // page per cache slot, or kNoPage_
+		std::size_t mPinnedSlots;          // first slots, coarsest level
+		std::uint32_t mFrame;              // feedback frames processed
+		std::size_t mRequested;
+
+		std::vector<std::uint32_t> mRequests; // scratch, see update()
+		std::vector<LoadedPage_> mReady;      // loaded, not yet uploaded
+		std::vector<std::array<std::uint8_t, 4>> mTableTexels; // all levels
+		bool mTableDirty;
+
+		std::mutex mMutex;
+		std::condition_variable mLoaderCv; // mQueue or mStop
+		std::deque<std::uint32_t> mQueue;
+		std::vector<LoadedPage_> mLoaded;
+		std::exception_ptr mError;
+		bool mStop;
+
+		std::vector<std::jthread> mLoaders;
+};
+
+#endif // VIRTUAL_TEXTURE_HPP_7E29B4D1_0C65_4A83_B1F7_64D8A2E95C3B
@@ -0,0 +1,235 @@
+#include "virtual_texture_file.hpp"
+
+#include <bit>
+#include <array>
+#include <cassert>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "error.hpp"
+#include "parallel_for.hpp"
+
+static_assert( std::endian::native == std::endian::little, "Virtual texture files are little endian" );
+
+namespace
+{
+	// Pages per thread, at least
+	constexpr std::size_t kGrain_ = 4;
+
+	struct FileCloser_
+	{
+		void operator() (std::FILE* aFile) const noexcept { std::fclose( aFile ); }
+	};
+	using FilePtr_ = std::unique_ptr<std::FILE, FileCloser_>;
+
+	FilePtr_ open_file_( std::filesystem::path const& aPath, char const* aMode )
+	{
+		return FilePtr_( std::fopen( aPath.string().c_str(), aMode ) );
+	}
+
+	bool read_header_( std::FILE* aFile, VtFileHeader& aHeader )
+	{
+		if( 1 != std::fread( &aHeader, sizeof(aHeader), 1, aFile ) )
+			return false;
+
+		return 0 == std::memcmp( aHeader.magic, kVtFileMagic, sizeof(kVtFileMagic) )
+			&& kVtFileVersion == aHeader.version
+		;
+	}
+
+	// Copies page (aX,aY) of an aWidth x aHeight image, including its border,
+	// into aOut (kVtPageStride x kVtPageStride texels).
+	void extract_page_( std::span<std::uint8_t const> aRgba, std::size_t aWidth, std::size_t aHeight, std::size_t aX, std::size_t aY, std::span<std::uint8_t> aOut ) noexcept
+	{
+		// Power of two sizes, so wrapping is a mask
+		std::size_t const maskX = aWidth - 1, maskY = aHeight - 1;
+		std::size_t const x0 = aX * kVtPageSize - kVtPageBorder;
+		std::size_t const y0 = aY * kVtPageSize - kVtPageBorder;
+
+		for( std::size_t y = 0; y < kVtPageStride; ++y )
+		{
+			std::uint8_t const* row = aRgba.data() + ((y0 + y) & maskY) * aWidth * 4;
+			std::uint8_t* out = aOut.data() + y * kVtPageStride * 4;
+
+			for( std::size_t x = 0; x < kVtPageStride; ++x )
+				std::memcpy( out + x*4, row + ((x0 + x) & maskX) * 4, 4 );
+		}
+	}
+}
+
+// VtLayout
+
+VtLayout::VtLayout( std::uint32_t aWidth, std::uint32_t aHeight )
+	: mWidth( aWidth )
+	, mHeight( aHeight )
+{
+	if( !std::has_single_bit( aWidth ) || !std::has_single_bit( aHeight ) || aWidth < kVtPageSize || aHeight < kVtPageSize )
+		throw Error( "Virtual textures must be powers of two of at least {} texels, not {}x{}", kVtPageSize, aWidth, aHeight );
+
+	std::uint32_t const levels = std::uint32_t(std::bit_width( std::min( aWidth, aHeight ) / kVtPageSize ));
+
+	std::uint32_t first = 0;
+	for( std::uint32_t level = 0; level < levels; ++level )
+	{
+		mFirstPage.emplace_back( first );
+		first += pages_x( level ) * pages_y( level );
+	}
+	mFirstPage.emplace_back( first );
+}
+
+std::uint32_t VtLayout::width() const noexcept
+{
+	return mWidth;
+}
+std::uint32_t VtLayout::height() const noexcept
+{
+	return mHeight;
+}
+
+std::uint32_t VtLayout::level_count() const noexcept
+{
+	return mFirstPage.empty() ? 0 : std::uint32_t(mFirstPage.size() - 1);
+}
+std::uint32_t VtLayout::page_count() const noexcept
+{
+	return mFirstPage.empty() ? 0 : mFirstPage.back();
+}
+
+std::uint32_t VtLayout::pages_x( std::uint32_t aLevel ) const noexcept
+{
+	return std::uint32_t((mWidth >> aLevel) / kVtPageSize);
+}
+std::uint32_t VtLayout::pages_y( std::uint32_t aLevel ) const noexcept
+{
+	return std::uint32_t((mHeight >> aLevel) / kVtPageSize);
+}
+
+std::uint32_t VtLayout::page_index( std::uint32_t aLevel, std::uint32_t aX, std::uint32_t aY ) const noexcept
+{
+	assert( aLevel < level_count() );
+	assert( aX < pages_x( aLevel ) && aY < pages_y( aLevel ) );
+	return mFirstPage[aLevel] + aY * pages_x( aLevel ) + aX;
+}
+
+// Writing
+
+void write_virtual_texture_file( std::filesystem::path const& aPath, std::span<std::uint8_t const> aRgba, std::size_t aWidth, std::size_t aHeight, std::span<MipLevel const> aMips, SourceFingerprint const& aSource )
+{
+	VtLayout const layout( static_cast<std::uint32_t>(aWidth), static_cast<std::uint32_t>(aHeight) );
+	assert( aMips.size() + 1 >= layout.level_count() );
+
+	VtFileHeader header{};
+	std::memcpy( header.magic, kVtFileMagic, sizeof(kVtFileMagic) );
+	header.version = kVtFileVersion;
+	header.internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+	header.width = layout.width();
+	header.height = layout.height();
+	header.levelCount = layout.level_count();
+	header.pageCount = layout.page_count();
+	header.source = aSource;
+
+	// See write_mesh_file()
+	auto tmpPath = aPath;
+	tmpPath += ".tmp";
+
+	{
+		auto const file = open_file_( tmpPath, "wb" );
+		if( !file )
+			throw Error( "Unable to open '{}' for writing", tmpPath.string() );
+
+		bool ok = 1 == std::fwrite( &header, sizeof(header), 1, file.get() );
+
+		std::vector<std::uint8_t> pages;
+		for( std::uint32_t level = 0; ok && level < layout.level_count(); ++level )
+		{
+			auto const rgba = 0 == level ? aRgba : std::span<std::uint8_t const>( aMips[level-1].rgba );
+			std::size_t const width = std::size_t(layout.width() >> level);
+			std::size_t const height = std::size_t(layout.height() >> level);
+
+			std::size_t const pagesX = layout.pages_x( level );
+			std::size_t const count = pagesX * layout.pages_y( level );
+			pages.resize( count * kVtPageBytes );
+
+			parallel_for( count, kGrain_, [&] (std::size_t aBegin, std::size_t aEnd) {
+				std::vector<std::uint8_t> texels( kVtPageStride * kVtPageStride * 4 );
+				for( std::size_t i = aBegin; i < aEnd; ++i )
+				{
+					extract_page_( rgba, width, height, i % pagesX, i / pagesX, texels );
+
+					auto const out = std::span( pages ).subspan( i * kVtPageBytes, kVtPageBytes );
+					encode_bc7( texels, kVtPageStride, kVtPageStride, out, 0, kVtPageStride / 4 );
+				}
+			} );
+
+			ok = pages.size() == std::fwrite( pages.data(), 1, pages.size(), file.get() );
+		}
+
+		if( !ok || 0 != std::fflush( file.get() ) )
+			throw Error( "Unable to write '{}'", tmpPath.string() );
+	}
+
+	std::error_code ec;
+	std::filesystem::rename( tmpPath, aPath, ec );
+	if( ec )
+		throw Error( "Unable to rename '{}' to '{}': {}", tmpPath.string(), aPath.string(), ec.message() );
+}
+
+bool is_virtual_texture_file_current( std::filesystem::path const& aPath, std::filesystem::path const& aSource )
+{
+	auto const file = open_file_( aPath, "rb" );
+	if( !file )
+		return false;
+
+	VtFileHeader header;
+	if( !read_header_( file.get(), header ) )
+		return false;
+
+	return is_source_current( header.source, aSource );
+}
+
+// VirtualTextureFile
+
+VirtualTextureFile::VirtualTextureFile( std::filesystem::path const& aPath )
+	: mFile( std::fopen( aPath.string().c_str(), "rb" ) )
+	, mPath( aPath )
+{
+	auto const invalid = [&] (char const* aReason) {
+		return Error( "Invalid virtual texture file '{}': {}", aPath.string(), aReason );
+	};
+
+	if( !mFile )
+		throw Error( "Unable to open virtual texture file '{}'", aPath.string() );
+
+	if( !read_header_( mFile.get(), mHeader ) )
+		throw invalid( "bad magic or unsupported version" );
+	if( GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM != mHeader.internalFormat )
+		throw invalid( "unsupported format" );
+
+	mLayout = VtLayout( mHeader.width, mHeader.height );
+	if( mLayout.level_count() != mHeader.levelCount || mLayout.page_count() != mHeader.pageCount )
+		throw invalid( "page count mismatch" );
+
+	std::error_code ec;
+	auto const size = std::filesystem::file_size( aPath, ec );
+	if( ec || size != sizeof(VtFileHeader) + std::uint64_t(mHeader.pageCount) * kVtPageBytes )
+		throw invalid( "truncated" );
+}
+
+VtFileHeader const& VirtualTextureFile::header() const noexcept
+{
+	return mHeader;
+}
+VtLayout const& VirtualTextureFile::layout() const noexcept
+{
+	return mLayout;
+}
+
+void VirtualTextureFile::read_page( std::uint32_t aIndex, std::span<std::uint8_t, kVtPageBytes> aOut )
+{
+	assert( aIndex < mHeader.pageCount );
+
+	long const offset = long(sizeof(VtFileHeader) + std::size_t(aIndex) * kVtPageBytes);
+	if( 0 != std::fseek( mFile.get(), offset, SEEK_SET ) || kVtPageBytes != std::fread( aOut.data(), 1, kVtPageBytes, mFile.get() ) )
+		throw Error( "Unable to read page {} of '{}'", aIndex, mPath.string() );
+}
@@ -0,0 +1,145 @@
+#ifndef VIRTUAL_TEXTURE_FILE_HPP_A3E51C07_48D9_4B6F_92E8_1F7C06B5D3A2
+#define VIRTUAL_TEXTURE_FILE_HPP_A3E51C07_48D9_4B6F_92E8_1F7C06B5D3A2
+
+#include <span>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+#include "source_fingerprint.hpp"
+#include "mip_chain.hpp"
+
+#include "../vmlib/bc7.hpp"
+
+/* Tiled virtual texture files (.cw2vt)
+ *
+ * Source of a virtual texture (see virtual_texture.hpp): every mip level of
+ * an image, cut into pages of kVtPageSize x kVtPageSize texels. Each page
+ * is stored with a border of kVtPageBorder texels taken from its neighbours
+ * (wrapping around at the edges of the image, like GL_REPEAT), so that
+ * bilinear filtering within a page never reads from another page. With the
+ * border, pages are kVtPageStride texels wide, a multiple of the 4x4 block
+ * size, and are stored BC7 encoded (see vmlib/bc7.hpp), ready for upload.
+ *
+ * Levels stop at the first one that is a single page wide or high. Both
+ * dimensions of the image must therefore be powers of two, and at least one
+ * page.
+ *
+ * The file starts with a VtFileHeader, followed by the pages of level 0, 1
+ * and so on, each level in row major order (see VtLayout::page_index()).
+ * All pages have the same size, kVtPageBytes. Values are little endian.
+ */
+
+inline constexpr char kVtFileMagic[8] = { 'C', 'W', '2', 'V', 'T', 'E', 'X', '\0' };
+inline constexpr std::uint32_t kVtFileVersion = 1;
+
+inline constexpr std::size_t kVtPageSize = 128;  // texels
+inline constexpr std::size_t kVtPageBorder = 4;  // texels, on each side
+inline constexpr std::size_t kVtPageStride = kVtPageSize + 2*kVtPageBorder;
+inline constexpr std::size_t kVtPageBytes = bc7_size( kVtPageStride, kVtPageStride );
+
+static_assert( 0 == kVtPageStride % 4, "Pages must consist of whole BC7 blocks" );
+
+struct VtFileHeader
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t internalFormat; // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+
+	std::uint32_t width; // level 0, texels
+	std::uint32_t height;
+	std::uint32_t levelCount;
+	std::uint32_t pageCount; // all levels
+
+	SourceFingerprint source;
+	std::uint64_t reserved;
+};
+
+static_assert( std::is_trivially_copyable_v<VtFileHeader> );
+static_assert( sizeof(VtFileHeader) == 64 );
+
+// Page grid of each level of a virtual texture
+class VtLayout final
+{
+	public:
+		VtLayout() = default;
+
+		// Throws Error if aWidth or aHeight is not a power of two or smaller
+		// than a page.
+		VtLayout( std::uint32_t aWidth, std::uint32_t aHeight );
+
+	public:
+		std::uint32_t width() const noexcept;
+		std::uint32_t height() const noexcept;
+
+		std::uint32_t level_count() const noexcept;
+		std::uint32_t page_count() const noexcept;
+
+		std::uint32_t pages_x( std::uint32_t aLevel ) const noexcept;
+		std::uint32_t pages_y( std::uint32_t aLevel ) const noexcept;
+
+		std::uint32_t page_index( std::uint32_t aLevel, std::uint32_t aX, std::uint32_t aY ) const noexcept;
+
+	private:
+		std::uint32_t mWidth = 0;
+		std::uint32_t mHeight = 0;
+		std::vector<std::uint32_t> mFirstPage; // per level, plus the total
+};
+
+// Cuts aRgba (level 0, sRGB8) and its other levels (see
+// make_srgb_mip_chain()) into pages, encodes them and writes them to aPath.
+// The pages of each level are encoded in parallel. Levels below the last
+// one of the page grid are ignored.
+//
+// Throws Error on failure, including if the image size is not supported
+// (see VtLayout).
+void write_virtual_texture_file(
+	std::filesystem::path const& aPath,
+	std::span<std::uint8_t const> aRgba,
+	std::size_t aWidth,
+	std::size_t aHeight,
+	std::span<MipLevel const> aMips,
+	SourceFingerprint const& aSource
+);
+
+// True if aPath exists and was created from the current version of aSource
+// (see is_source_current()).
+bool is_virtual_texture_file_current(
+	std::filesystem::path const& aPath,
+	std::filesystem::path const& aSource
+);
+
+// Reader for the pages of a virtual texture file. Not thread-safe; threads
+// that read pages concurrently each open their own.
+class VirtualTextureFile final
+{
+	public:
+		// Throws Error if the file cannot be opened or is not a valid file of
+		// the current version.
+		explicit VirtualTextureFile( std::filesystem::path const& );
+
+	public:
+		VtFileHeader const& header() const noexcept;
+		VtLayout const& layout() const noexcept;
+
+		// Throws Error on failure.
+		void read_page( std::uint32_t aIndex, std::span<std::uint8_t, kVtPageBytes> aOut );
+
+	private:
+		struct FileCloser_
+		{
+			void operator() (std::FILE* aFile) const noexcept { std::fclose( aFile ); }
+		};
+
+		std::unique_ptr<std::FILE, FileCloser_> mFile;
+		std::filesystem::path mPath;
+
+		VtFileHeader mHeader;
+		VtLayout mLayout;
+};
+
+#endif // VIRTUAL_TEXTURE_FILE_HPP_A3E51C07_48D9_4B6F_92E8_1F7C06B5D3A2
@@ -0,0 +1,31 @@
+// vmlib micro-benchmarks
+//
+// Build the release configuration and run, e.g.,
+//
+//   bin/vmlib-bench-release-x64-gcc.exe --reporter console --reporter JSON::out=bench-avx2.json
+//
+// To compare backends on the same host, regenerate the build files with
+// "premake5 gmake --vmlib-simd=scalar" (or sse/avx2), rebuild, and write the
+// results to a different file. The JSON output contains the backend (see the
+// test case below), and the mean/std. deviation of each benchmark.
+//
+// Use "[single]" or "[batch]" to run only one group; batch sizes range from
+// 1k to 1M elements (see BENCH_BATCH_SIZES).
+
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/simd.hpp"
+
+TEST_CASE("vmlib configuration", "[config]")
+{
+#	if VMLIB_CONF_SIMD >= 2
+	char const* backend = "avx2";
+#	elif VMLIB_CONF_SIMD == 1
+	char const* backend = "sse";
+#	else
+	char const* backend = "scalar";
+#	endif
+
+	WARN("VMLIB_CONF_SIMD backend: " << backend);
+	SUCCEED();
+}
@@ -0,0 +1,33 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cstdint>
+
+#include "../vmlib/frustum.hpp"
+#include "helpers.hpp"
+
+TEST_CASE("Frustum culling batch", "[frustum][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	Frustumf const frustum = make_frustum(make_perspective_projection(1.f, 16.f / 9.f, 0.1f, 100.f) * random_trs(rng));
+
+	auto const boxes = make_batch<Aabb3f>(count, rng, [](std::minstd_rand& r) {
+		Vec3f const c = random_vec3(r);
+		return Aabb3f{ c - Vec3f{ 1.f, 1.f, 1.f }, c + Vec3f{ 1.f, 1.f, 1.f } };
+	});
+	std::vector<std::uint8_t> visible(count);
+
+	BENCHMARK(batch_name("intersects per box", count)) {
+		std::size_t n = 0;
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			visible[i] = intersects(frustum, boxes[i]) ? 1 : 0;
+			n += visible[i];
+		}
+		return n;
+	};
+	BENCHMARK(batch_name("cull_aabbs", count)) {
+		return cull_aabbs(frustum, boxes, visible);
+	};
+}
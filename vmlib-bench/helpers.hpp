@@ -0,0 +1,56 @@
+#ifndef HELPERS_HPP
+#define HELPERS_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+#include <numbers>
+
+#include "../vmlib/vec3.hpp"
+#include "../vmlib/vec4.hpp"
+#include "../vmlib/mat44.hpp"
+
+// Batch sizes used by the batched benchmarks
+#define BENCH_BATCH_SIZES std::size_t(1'000), std::size_t(10'000), std::size_t(100'000), std::size_t(1'000'000)
+
+// Fixed seed, so that scalar and SIMD builds see the same data.
+inline std::minstd_rand bench_rng() {
+	return std::minstd_rand(3811);
+}
+
+// "name x1000" etc.
+inline std::string batch_name(char const* name, std::size_t count) {
+	return std::string(name) + " x" + std::to_string(count);
+}
+
+inline Vec3f random_vec3(std::minstd_rand& rng) {
+	std::uniform_real_distribution<float> dist(-100.f, 100.f);
+	return Vec3f{ dist(rng), dist(rng), dist(rng) };
+}
+
+inline Vec4f random_vec4(std::minstd_rand& rng) {
+	Vec3f v = random_vec3(rng);
+	return Vec4f{ v.x, v.y, v.z, 1.f };
+}
+
+// Model-style matrix: translation * rotation * scaling
+inline Mat44f random_trs(std::minstd_rand& rng) {
+	std::uniform_real_distribution<float> angle(-std::numbers::pi_v<float>, std::numbers::pi_v<float>);
+	std::uniform_real_distribution<float> scale(0.1f, 4.f);
+
+	return make_translation(random_vec3(rng))
+		* make_rotation_y(angle(rng))
+		* make_rotation_x(angle(rng))
+		* make_scaling(scale(rng), scale(rng), scale(rng));
+}
+
+template< typename T, typename F >
+std::vector<T> make_batch(std::size_t count, std::minstd_rand& rng, F&& gen) {
+	std::vector<T> ret;
+	ret.reserve(count);
+	for (std::size_t i = 0; i < count; ++i)
+		ret.emplace_back(gen(rng));
+	return ret;
+}
+
+#endif // HELPERS_HPP
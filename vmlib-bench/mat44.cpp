@@ -0,0 +1,111 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+#include "../vmlib/mat44_expr.hpp"
+#include "helpers.hpp"
+
+TEST_CASE("Mat44f single", "[Mat44f][single]")
+{
+	auto rng = bench_rng();
+	Mat44f const A = random_trs(rng);
+	Mat44f const B = random_trs(rng);
+	Vec4f const v = random_vec4(rng);
+
+	BENCHMARK("Mat44f * Mat44f") { return A * B; };
+	BENCHMARK("Mat44f * Vec4f") { return A * v; };
+	BENCHMARK("transpose") { return transpose(A); };
+
+	BENCHMARK("invert") { return invert(A); };
+	BENCHMARK("invert_affine") { return invert_affine(A); };
+	BENCHMARK("normal_matrix") { return normal_matrix(A); };
+	BENCHMARK("mat44_to_mat33(transpose(invert()))") { return mat44_to_mat33(transpose(invert(A))); };
+}
+
+TEST_CASE("Camera matrices single", "[Mat44f][camera][single]")
+{
+	auto rng = bench_rng();
+	std::uniform_real_distribution<float> fov(0.5f, 1.5f);
+	float const f = fov(rng);
+
+	Vec3f const forward = normalize(random_vec3(rng));
+	Vec3f const right = normalize(cross(forward, Vec3f{ 0.f, 1.f, 0.f }));
+	Vec3f const up = cross(right, forward);
+	Vec3f const pos = random_vec3(rng);
+
+	BENCHMARK("make_perspective_projection") { return make_perspective_projection(f, 16.f / 9.f, 0.1f, 1000.f); };
+	BENCHMARK("construct_camera_view") { return construct_camera_view(forward, up, right, pos); };
+}
+
+TEST_CASE("Mat44f batch", "[Mat44f][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	auto const as = make_batch<Mat44f>(count, rng, random_trs);
+	auto const bs = make_batch<Mat44f>(count, rng, random_trs);
+	auto const vs = make_batch<Vec4f>(count, rng, random_vec4);
+	std::vector<Mat44f> out(count);
+	std::vector<Vec4f> outv(count);
+
+	BENCHMARK(batch_name("Mat44f * Mat44f", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = as[i] * bs[i];
+		return out.back();
+	};
+	BENCHMARK(batch_name("mul_batch", count)) {
+		mul_batch(as, bs, out);
+		return out.back();
+	};
+	BENCHMARK(batch_name("Mat44f * Vec4f", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			outv[i] = as[i] * vs[i];
+		return outv.back();
+	};
+	BENCHMARK(batch_name("transpose", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = transpose(as[i]);
+		return out.back();
+	};
+	BENCHMARK(batch_name("invert", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = invert(as[i]);
+		return out.back();
+	};
+	BENCHMARK(batch_name("invert_batch", count)) {
+		invert_batch(as, out);
+		return out.back();
+	};
+	BENCHMARK(batch_name("invert_affine", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = invert_affine(as[i]);
+		return out.back();
+	};
+	BENCHMARK(batch_name("invert_rigid", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = invert_rigid(as[i]);
+		return out.back();
+	};
+}
+
+TEST_CASE("MVP composition batch", "[Mat44f][expr][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	Mat44f const P = make_perspective_projection(1.f, 16.f / 9.f, 0.1f, 1000.f);
+	Mat44f const V = random_trs(rng);
+	auto const ms = make_batch<Mat44f>(count, rng, random_trs);
+	std::vector<Mat44f> out(count);
+
+	BENCHMARK(batch_name("P * V * M", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = P * V * ms[i];
+		return out.back();
+	};
+	BENCHMARK(batch_name("P * as_affine(V) * as_affine(M)", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = P * as_affine(V) * as_affine(ms[i]);
+		return out.back();
+	};
+}
@@ -0,0 +1,47 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cstdint>
+
+#include "../vmlib/packing.hpp"
+#include "helpers.hpp"
+
+TEST_CASE("Vertex packing batch", "[packing][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	auto const ns = make_batch<Vec3f>(count, rng, [](std::minstd_rand& r) { return normalize(random_vec3(r)); });
+	std::span<float const> const fs(&ns[0].x, 3 * count);
+
+	std::vector<std::uint16_t> halfs(fs.size());
+	std::vector<std::int16_t> snorms(fs.size());
+	std::vector<OctNormal16> octs(count);
+	std::vector<Vec3f> out(count);
+
+	BENCHMARK(batch_name("pack_half per float", count)) {
+		for (std::size_t i = 0; i < fs.size(); ++i)
+			halfs[i] = pack_half(fs[i]);
+		return halfs.back();
+	};
+	BENCHMARK(batch_name("pack_half", count)) {
+		pack_half(fs, halfs);
+		return halfs.back();
+	};
+	BENCHMARK(batch_name("pack_snorm16", count)) {
+		pack_snorm16(fs, snorms);
+		return snorms.back();
+	};
+	BENCHMARK(batch_name("pack_oct16 per normal", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			octs[i] = pack_oct16(ns[i]);
+		return octs.back().x;
+	};
+	BENCHMARK(batch_name("pack_oct16", count)) {
+		pack_oct16(ns, octs);
+		return octs.back().x;
+	};
+	BENCHMARK(batch_name("unpack_oct16", count)) {
+		unpack_oct16(octs, out);
+		return out.back();
+	};
+}
@@ -0,0 +1,38 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/transform.hpp"
+#include "helpers.hpp"
+
+TEST_CASE("Vertex transform batch", "[transform][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	Mat44f const M = random_trs(rng);
+	Mat33f const N = normal_matrix(M);
+	auto const ps = make_batch<Vec3f>(count, rng, random_vec3);
+	std::vector<Vec3f> out(count);
+
+	BENCHMARK(batch_name("Mat44f * Vec4f per point", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Vec4f const t = M * Vec4f{ ps[i].x, ps[i].y, ps[i].z, 1.f };
+			out[i] = Vec3f{ t.x, t.y, t.z };
+		}
+		return out.back();
+	};
+	BENCHMARK(batch_name("transform_points", count)) {
+		transform_points(M, ps, out);
+		return out.back();
+	};
+
+	BENCHMARK(batch_name("normalize(Mat33f * Vec3f) per normal", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = normalize(N * ps[i]);
+		return out.back();
+	};
+	BENCHMARK(batch_name("transform_normals", count)) {
+		transform_normals(N, ps, out);
+		return out.back();
+	};
+}
@@ -0,0 +1,42 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/vec3.hpp"
+#include "helpers.hpp"
+
+TEST_CASE("Vec3f single", "[Vec3f][single]")
+{
+	auto rng = bench_rng();
+	Vec3f const a = random_vec3(rng);
+	Vec3f const b = random_vec3(rng);
+
+	BENCHMARK("normalize") { return normalize(a); };
+	BENCHMARK("cross") { return cross(a, b); };
+	BENCHMARK("dot") { return dot(a, b); };
+}
+
+TEST_CASE("Vec3f batch", "[Vec3f][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	auto const a = make_batch<Vec3f>(count, rng, random_vec3);
+	auto const b = make_batch<Vec3f>(count, rng, random_vec3);
+	std::vector<Vec3f> out(count);
+	std::vector<float> outf(count);
+
+	BENCHMARK(batch_name("normalize", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = normalize(a[i]);
+		return out.back();
+	};
+	BENCHMARK(batch_name("cross", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			out[i] = cross(a[i], b[i]);
+		return out.back();
+	};
+	BENCHMARK(batch_name("dot", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			outf[i] = dot(a[i], b[i]);
+		return outf.back();
+	};
+}
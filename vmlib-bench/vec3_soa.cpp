@@ -0,0 +1,44 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include "../vmlib/vec3_soa.hpp"
+#include "helpers.hpp"
+
+// Particle-style update, p += dt * v, on an array of structures versus the
+// structure-of-arrays container.
+TEST_CASE("Vec3fSoA batch", "[soa][batch]")
+{
+	auto const count = GENERATE(BENCH_BATCH_SIZES);
+
+	auto rng = bench_rng();
+	auto ps = make_batch<Vec3f>(count, rng, random_vec3);
+	auto const vs = make_batch<Vec3f>(count, rng, random_vec3);
+
+	Vec3fSoA sp(ps), sv(vs);
+	std::vector<float> lengths(count);
+
+	float const dt = 1.f / 60.f;
+
+	BENCHMARK(batch_name("p += dt*v AoS", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			ps[i] += dt * vs[i];
+		return ps.back();
+	};
+	BENCHMARK(batch_name("p += dt*v SoA", count)) {
+		madd(dt, sv, sp, sp);
+		return sp.x()[0];
+	};
+	BENCHMARK(batch_name("length AoS", count)) {
+		for (std::size_t i = 0; i < count; ++i)
+			lengths[i] = length(vs[i]);
+		return lengths.back();
+	};
+	BENCHMARK(batch_name("length SoA", count)) {
+		length(sv, lengths);
+		return lengths.back();
+	};
+	BENCHMARK(batch_name("assign + copy_to", count)) {
+		sp.assign(ps);
+		sp.copy_to(ps);
+		return ps.back();
+	};
+}
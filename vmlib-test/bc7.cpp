@@ -0,0 +1,203 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cmath>
+#include <array>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+#include "../vmlib/bc7.hpp"
+
+namespace
+{
+	using Block_ = std::array<std::uint8_t, 64>;
+
+	Block_ round_trip_( Block_ const& aIn )
+	{
+		std::array<std::uint8_t, 16> encoded;
+		encode_bc7_block( aIn, encoded );
+
+		Block_ ret;
+		decode_bc7_block( encoded, ret );
+		return ret;
+	}
+
+	int max_error_( std::span<std::uint8_t const> aA, std::span<std::uint8_t const> aB )
+	{
+		int ret = 0;
+		for( std::size_t i = 0; i < aA.size(); ++i )
+			ret = std::max( ret, std::abs( int(aA[i]) - int(aB[i]) ) );
+		return ret;
+	}
+
+	// Smooth image with some noise, similar to a photo
+	std::vector<std::uint8_t> smooth_image_( std::size_t aW, std::size_t aH, std::minstd_rand& aRng )
+	{
+		std::uniform_int_distribution<int> noise( -3, 3 );
+
+		std::vector<std::uint8_t> ret( aW * aH * 4 );
+		for( std::size_t y = 0; y < aH; ++y )
+		{
+			for( std::size_t x = 0; x < aW; ++x )
+			{
+				std::uint8_t* p = ret.data() + (y*aW + x) * 4;
+				p[0] = std::uint8_t(std::clamp( int(128 + 90 * std::sin( float(x) * 0.1f )) + noise( aRng ), 0, 255 ));
+				p[1] = std::uint8_t(std::clamp( int(128 + 90 * std::cos( float(y) * 0.07f )) + noise( aRng ), 0, 255 ));
+				p[2] = std::uint8_t(std::clamp( int(x + y) / 2 + noise( aRng ), 0, 255 ));
+				p[3] = 255;
+			}
+		}
+		return ret;
+	}
+
+	static_assert( bc7_size( 4, 4 ) == 16 );
+	static_assert( bc7_size( 5, 3 ) == 32 );
+	static_assert( bc7_size( 4096, 4096 ) == 4096 * 4096 );
+}
+
+TEST_CASE("BC7 blocks", "[bc7]")
+{
+	SECTION("Mode 6") {
+		Block_ in{};
+		std::array<std::uint8_t, 16> encoded;
+		encode_bc7_block( in, encoded );
+
+		REQUIRE((encoded[0] & 0x7f) == 0x40);
+	}
+
+	SECTION("Solid colors") {
+		for( auto const& color : { std::array<int, 4>{ 0, 0, 0, 0 }, { 255, 255, 255, 255 }, { 17, 200, 99, 255 }, { 1, 2, 3, 4 } } )
+		{
+			Block_ in;
+			for( std::size_t i = 0; i < 64; ++i )
+				in[i] = std::uint8_t(color[i % 4]);
+
+			REQUIRE(max_error_( in, round_trip_( in ) ) <= 1);
+		}
+	}
+
+	SECTION("Two colors") {
+		// Both colors are endpoints, so they are represented (nearly) exactly
+		Block_ in;
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			bool const first = (i * 7) % 3 == 0;
+			in[i*4+0] = first ? 10 : 240;
+			in[i*4+1] = first ? 20 : 130;
+			in[i*4+2] = first ? 200 : 40;
+			in[i*4+3] = 255;
+		}
+
+		REQUIRE(max_error_( in, round_trip_( in ) ) <= 1);
+	}
+
+	SECTION("Gradient") {
+		Block_ in;
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			in[i*4+0] = std::uint8_t(i * 16);
+			in[i*4+1] = std::uint8_t(255 - i * 8);
+			in[i*4+2] = std::uint8_t(64 + i * 4);
+			in[i*4+3] = std::uint8_t(255 - i * 2);
+		}
+
+		REQUIRE(max_error_( in, round_trip_( in ) ) <= 6);
+	}
+
+	SECTION("Anchor index") {
+		// Ramps in both directions: the first pixel's index must fit into
+		// three bits, whichever way the fitted line points. A wrong anchor
+		// would scramble all indices; the palette's uneven weights alone
+		// cost a few steps.
+		Block_ in;
+		for( std::size_t i = 0; i < 16; ++i )
+		{
+			in[i*4+0] = in[i*4+1] = std::uint8_t(255 - i * 17);
+			in[i*4+2] = std::uint8_t(i * 17);
+			in[i*4+3] = 255;
+		}
+
+		std::array<std::uint8_t, 16> encoded;
+		encode_bc7_block( in, encoded );
+
+		Block_ out;
+		decode_bc7_block( encoded, out );
+		REQUIRE(max_error_( in, out ) <= 4);
+	}
+
+	SECTION("Other modes") {
+		std::array<std::uint8_t, 16> encoded{};
+		encoded[0] = 0x01; // mode 0
+
+		Block_ out;
+		out.fill( 1 );
+		decode_bc7_block( encoded, out );
+		REQUIRE(max_error_( out, Block_{} ) == 0);
+	}
+}
+
+TEST_CASE("BC7 images", "[bc7]")
+{
+	std::minstd_rand rng( 42 );
+
+	SECTION("Quality") {
+		std::size_t const w = 64, h = 64;
+		auto const in = smooth_image_( w, h, rng );
+
+		std::vector<std::uint8_t> encoded( bc7_size( w, h ) );
+		encode_bc7( in, w, h, encoded, 0, h/4 );
+
+		double se = 0.0;
+		for( std::size_t b = 0; b < encoded.size() / kBc7BlockBytes; ++b )
+		{
+			Block_ out;
+			decode_bc7_block( std::span( encoded ).subspan( b * kBc7BlockBytes ).first<kBc7BlockBytes>(), out );
+
+			std::size_t const bx = b % (w/4), by = b / (w/4);
+			for( std::size_t i = 0; i < 64; ++i )
+			{
+				std::size_t const x = bx*4 + (i/4) % 4, y = by*4 + i/16;
+				double const d = double(out[i]) - double(in[(y*w + x) * 4 + i % 4]);
+				se += d*d;
+			}
+		}
+
+		double const psnr = 10.0 * std::log10( 255.0 * 255.0 / (se / double(w * h * 4)) );
+		REQUIRE(psnr > 38.0);
+	}
+
+	SECTION("Partial blocks") {
+		// Pixels outside the image repeat the last row/column
+		std::size_t const w = 5, h = 3;
+		auto const in = smooth_image_( w, h, rng );
+
+		std::vector<std::uint8_t> encoded( bc7_size( w, h ) );
+		encode_bc7( in, w, h, encoded, 0, 1 );
+
+		Block_ padded;
+		for( std::size_t y = 0; y < 4; ++y )
+		{
+			for( std::size_t x = 0; x < 4; ++x )
+			{
+				std::size_t const sx = std::min( 4 + x, w-1 ), sy = std::min( y, h-1 );
+				for( std::size_t c = 0; c < 4; ++c )
+					padded[(y*4 + x)*4 + c] = in[(sy*w + sx)*4 + c];
+			}
+		}
+
+		std::array<std::uint8_t, 16> expected;
+		encode_bc7_block( padded, expected );
+		REQUIRE(std::equal( expected.begin(), expected.end(), encoded.begin() + kBc7BlockBytes ));
+	}
+
+	SECTION("Row ranges") {
+		std::size_t const w = 20, h = 24;
+		auto const in = smooth_image_( w, h, rng );
+
+		std::vector<std::uint8_t> full( bc7_size( w, h ) ), split( bc7_size( w, h ) );
+		encode_bc7( in, w, h, full, 0, h/4 );
+		encode_bc7( in, w, h, split, 0, 2 );
+		encode_bc7( in, w, h, split, 2, h/4 );
+		REQUIRE(full == split);
+	}
+}
@@ -0,0 +1,233 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <numbers>
+
+#include "../vmlib/column_major.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	// Element-wise comparison through operator[], i.e., independent of the
+	// storage order.
+	template< typename tLeft, typename tRight >
+	bool isEqualElems_( tLeft const& aA, tRight const& aB, float aEps = 1e-5f )
+	{
+		for( std::size_t r = 0; r < 4; ++r )
+		{
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				if( std::fabs( aA[r,c] - aB[r,c] ) > aEps )
+					return false;
+			}
+		}
+		return true;
+	}
+
+	Mat44f const kA_ = { {
+		2.f, 1.f, 5.f, 2.f,
+		0.f, 6.f, 7.f, 3.f,
+		3.f, 1.f, 4.f, 5.f,
+		2.f, 1.f, 0.f, 1.f
+	} };
+	Mat44f const kB_ = { {
+		1.f, 2.f, 0.f, 1.f,
+		3.f, 0.f, 2.f, 1.f,
+		4.f, 1.f, 3.f, 0.f,
+		2.f, 5.f, 1.f, 4.f
+	} };
+
+	// Compile time checks
+	constexpr Mat44fCM kT_ = to_column_major( Mat44f{ {
+		1.f, 0.f, 0.f, 1.f,
+		0.f, 1.f, 0.f, 2.f,
+		0.f, 0.f, 1.f, 3.f,
+		0.f, 0.f, 0.f, 1.f
+	} } );
+	static_assert( kT_.v[12] == 1.f && kT_.v[13] == 2.f && kT_.v[14] == 3.f );
+	static_assert( kT_[0,3] == 1.f && kT_[3,3] == 1.f );
+	static_assert( (kT_ * Vec4f{ 1.f, 1.f, 1.f, 1.f }).z == 4.f );
+	static_assert( (kT_ * kT_)[1,3] == 4.f );
+}
+
+TEST_CASE("Column-major storage", "[Mat44fCM]")
+{
+	Mat44fCM const a = to_column_major( kA_ );
+
+	SECTION("Layout") {
+		for( std::size_t r = 0; r < 4; ++r )
+		{
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				REQUIRE(a.v[c*4 + r] == kA_[r,c]);
+				REQUIRE((a[r,c] == kA_[r,c]));
+			}
+		}
+	}
+
+	SECTION("Round trip") {
+		REQUIRE(isEqual(to_row_major( a ), kA_, 0.f));
+	}
+
+	SECTION("Identity") {
+		REQUIRE(isEqualElems_(kIdentity44fCM, kIdentity44f));
+	}
+
+	SECTION("3x3 and std140") {
+		Mat33f const m = { { 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f } };
+		Mat33fCM const cm = to_column_major( m );
+
+		float const expected[] = { 1.f, 4.f, 7.f, 2.f, 5.f, 8.f, 3.f, 6.f, 9.f };
+		for( std::size_t i = 0; i < 9; ++i )
+			REQUIRE(cm.v[i] == expected[i]);
+
+		Mat33f const back = to_row_major( cm );
+		for( std::size_t i = 0; i < 9; ++i )
+			REQUIRE(back.v[i] == m.v[i]);
+
+		Mat33fStd140 const ubo = to_std140( cm );
+		for( std::size_t c = 0; c < 3; ++c )
+		{
+			for( std::size_t r = 0; r < 3; ++r )
+				REQUIRE((ubo.v[c*4 + r] == m[r,c]));
+			REQUIRE(ubo.v[c*4 + 3] == 0.f);
+		}
+	}
+}
+
+// Same cases as in mult.cpp and projection.cpp, in column-major layout.
+TEST_CASE("Column-major operators", "[Mat44fCM][operator]")
+{
+	Mat44fCM const a = to_column_major( kA_ );
+	Mat44fCM const b = to_column_major( kB_ );
+
+	SECTION("Multiplication with expected result") {
+		Mat44f const expected = { {
+			29.f, 19.f, 19.f, 11.f,
+			52.f, 22.f, 36.f, 18.f,
+			32.f, 35.f, 19.f, 24.f,
+			7.f, 9.f, 3.f, 7.f
+		} };
+		REQUIRE(isEqualElems_(a * b, expected));
+		REQUIRE(isEqualElems_(a * kIdentity44fCM, kA_));
+	}
+
+	SECTION("Matrix-vector multiplication") {
+		Vec4f const v = { 1.f, 3.f, 7.f, 4.f };
+		Vec4f const res = a * v;
+		Vec4f const ref = kA_ * v;
+		for( std::size_t i = 0; i < 4; ++i )
+			REQUIRE(res[i] == Catch::Approx( ref[i] ));
+	}
+
+	SECTION("Transpose") {
+		REQUIRE(isEqualElems_(transpose( a ), transpose( kA_ )));
+	}
+
+	SECTION("Projection") {
+		auto const proj = make_perspective_projection(
+			60.f * std::numbers::pi_v<float> / 180.f,
+			1280/float(720),
+			0.1f, 100.f
+		);
+		auto const cm = to_column_major( proj );
+
+		REQUIRE_THAT( (cm[0,0]), Catch::Matchers::WithinAbs( 0.974279, 1e-6f ) );
+		REQUIRE_THAT( (cm[1,1]), Catch::Matchers::WithinAbs( 1.732051f, 1e-6f ) );
+		REQUIRE_THAT( (cm[2,3]), Catch::Matchers::WithinAbs( -0.200200f, 1e-6f ) );
+		REQUIRE_THAT( (cm[3,2]), Catch::Matchers::WithinAbs( -1.f, 1e-6f ) );
+		REQUIRE(isEqualElems_(cm, proj, 0.f));
+	}
+
+	SECTION("Random") {
+		std::minstd_rand rng( 42 );
+		std::uniform_real_distribution<float> dist( -1.f, 1.f );
+
+		for( std::size_t i = 0; i < 100; ++i )
+		{
+			Mat44f x, y;
+			for( auto& e : x.v ) e = dist( rng );
+			for( auto& e : y.v ) e = dist( rng );
+
+			// Make sure that x is well conditioned
+			for( std::size_t k = 0; k < 4; ++k )
+				x[k,k] += 4.f;
+
+			Mat44fCM const xc = to_column_major( x );
+			Mat44fCM const yc = to_column_major( y );
+
+			REQUIRE(isEqualElems_(xc * yc, x * y, 1e-5f));
+			REQUIRE(isEqualElems_(invert( xc ), invert( x ), 1e-5f));
+		}
+	}
+}
+
+TEST_CASE("Column-major construction", "[Mat44fCM][make]")
+{
+	std::minstd_rand rng( 43 );
+	std::uniform_real_distribution<float> dist( -3.f, 3.f );
+
+	for( std::size_t i = 0; i < 20; ++i )
+	{
+		float const a = dist( rng );
+		Vec3f const t{ dist( rng ), dist( rng ), dist( rng ) };
+		Vec3f const s{ 1.f + std::fabs( t.z ), 0.5f, 2.f };
+
+		// Same arithmetic as the row-major functions, so the results must
+		// match exactly.
+		REQUIRE(isEqualElems_(make_rotation_x_cm( a ), make_rotation_x( a ), 0.f));
+		REQUIRE(isEqualElems_(make_rotation_y_cm( a ), make_rotation_y( a ), 0.f));
+		REQUIRE(isEqualElems_(make_rotation_z_cm( a ), make_rotation_z( a ), 0.f));
+		REQUIRE(isEqualElems_(make_translation_cm( t ), make_translation( t ), 0.f));
+		REQUIRE(isEqualElems_(make_scaling_cm( s.x, s.y, s.z ), make_scaling( s.x, s.y, s.z ), 0.f));
+
+		Quatf const q = make_quat_axis_angle( normalize( Vec3f{ t.y, 1.f, t.x } ), a );
+		REQUIRE(isEqualElems_(make_trs_cm( t, q, s ), make_trs( t, q, s ), 0.f));
+
+		Vec3f const forward = normalize( Vec3f{ t.x, t.y, -4.f } );
+		Vec3f const right = normalize( cross( forward, Vec3f{ 0.f, 1.f, 0.f } ) );
+		Vec3f const up = cross( right, forward );
+		REQUIRE(isEqualElems_(construct_camera_view_cm( forward, up, right, s ), construct_camera_view( forward, up, right, s ), 0.f));
+	}
+
+	float const fov = 60.f * std::numbers::pi_v<float> / 180.f;
+	REQUIRE(isEqualElems_(make_perspective_projection_cm( fov, 16.f/9.f, 0.1f, 1000.f ), make_perspective_projection( fov, 16.f/9.f, 0.1f, 1000.f ), 0.f));
+
+	static_assert( make_translation_cm( { 1.f, 2.f, 3.f } ).v[13] == 2.f );
+}
+
+TEST_CASE("Column-major normal matrix and batches", "[Mat44fCM]")
+{
+	std::minstd_rand rng( 44 );
+	std::uniform_real_distribution<float> dist( -3.f, 3.f );
+
+	Mat44fCM const projView = make_perspective_projection_cm( 1.f, 1.5f, 0.1f, 100.f ) * make_translation_cm( { 0.f, -2.f, -10.f } );
+
+	std::vector<Mat44f> models;
+	std::vector<Mat44fCM> modelsCM;
+	for( std::size_t i = 0; i < 20; ++i )
+	{
+		Vec3f const t{ dist( rng ), dist( rng ), dist( rng ) };
+		Vec3f const s{ 0.5f, 2.f, 1.f + std::fabs( t.x ) };
+		Quatf const q = make_quat_axis_angle( normalize( Vec3f{ t.z, t.x, 1.f } ), t.y );
+
+		models.emplace_back( make_trs( t, q, s ) );
+		modelsCM.emplace_back( make_trs_cm( t, q, s ) );
+
+		Mat33fCM const n = normal_matrix( modelsCM.back() );
+		Mat33f const ref = normal_matrix( models.back() );
+		for( std::size_t r = 0; r < 3; ++r )
+		{
+			for( std::size_t c = 0; c < 3; ++c )
+				REQUIRE((n[r,c] == Catch::Approx( ref[r,c] ).margin( 1e-6f )));
+		}
+	}
+
+	std::vector<Mat44fCM> mvps( modelsCM.size() );
+	mul_batch( projView, modelsCM, mvps );
+
+	Mat44f const projViewRM = to_row_major( projView );
+	for( std::size_t i = 0; i < models.size(); ++i )
+		REQUIRE(isEqualElems_(mvps[i], projViewRM * models[i], 1e-5f));
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <cstring>
+#include <numbers>
+
+#include "../vmlib/mat44_expr.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	constexpr float kPi_ = std::numbers::pi_v<float>;
+
+	Mat44f random_affine_( std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> angle( -kPi_, kPi_ );
+		std::uniform_real_distribution<float> offset( -5.f, 5.f );
+		std::uniform_real_distribution<float> scale( 0.5f, 2.f );
+
+		return make_translation( { offset( aRng ), offset( aRng ), offset( aRng ) } )
+			* make_rotation_y( angle( aRng ) )
+			* make_rotation_x( angle( aRng ) )
+			* make_scaling( scale( aRng ), scale( aRng ), scale( aRng ) );
+	}
+
+	bool isIdentical( Mat44f const& aA, Mat44f const& aB )
+	{
+		return 0 == std::memcmp( aA.v, aB.v, sizeof(aA.v) );
+	}
+}
+
+TEST_CASE("Lazy products in constant expressions", "[Mat44f][expr]")
+{
+	constexpr Mat44f T = { {
+		1.f, 0.f, 0.f, 2.f,
+		0.f, 1.f, 0.f, 3.f,
+		0.f, 0.f, 1.f, 4.f,
+		0.f, 0.f, 0.f, 1.f
+	} };
+	constexpr Mat44f TTT = as_affine( T ) * as_affine( T ) * as_affine( T );
+	static_assert( TTT[0,3] == 6.f && TTT[1,3] == 9.f && TTT[2,3] == 12.f && TTT[3,3] == 1.f );
+
+	static_assert( decltype(as_affine( T ) * as_affine( T ))::kAffine );
+	static_assert( !decltype(as_expr( T ) * as_affine( T ))::kAffine );
+}
+
+TEST_CASE("Single lazy products are bit-identical to operator*", "[Mat44f][expr]")
+{
+	std::minstd_rand rng( 21 );
+
+	Mat44f const P = make_perspective_projection( kPi_ / 3.f, 16.f / 9.f, 0.1f, 1000.f );
+
+	for( int i = 0; i < 100; ++i )
+	{
+		Mat44f const A = random_affine_( rng );
+		Mat44f const B = random_affine_( rng );
+
+		REQUIRE(isIdentical(as_affine(A) * as_affine(B), A * B));
+		REQUIRE(isIdentical(P * as_affine(B), P * B));
+		REQUIRE(isIdentical(as_affine(A) * P, A * P));
+		REQUIRE(isIdentical(as_expr(P) * as_expr(A), P * A));
+	}
+}
+
+TEST_CASE("Lazy MVP matches eager MVP", "[Mat44f][expr]")
+{
+	std::minstd_rand rng( 22 );
+
+	Mat44f const P = make_perspective_projection( kPi_ / 3.f, 16.f / 9.f, 0.1f, 100.f );
+
+	for( int i = 0; i < 100; ++i )
+	{
+		Mat44f const V = random_affine_( rng );
+		Mat44f const M = random_affine_( rng );
+
+		Mat44f const lazy = P * as_affine( V ) * as_affine( M );
+		REQUIRE(isEqual(lazy, P * V * M));
+
+		Vec4f const p{ 1.f, -2.f, 0.5f, 1.f };
+		REQUIRE(isEqual(P * as_affine( V ) * as_affine( M ) * p, (P * V * M) * p, 1e-4f));
+	}
+
+	SECTION("Longer affine chains") {
+		Mat44f const A = random_affine_( rng );
+		Mat44f const B = random_affine_( rng );
+		Mat44f const C = random_affine_( rng );
+
+		Mat44f const lazy = as_affine( A ) * as_affine( B ) * as_affine( C );
+		REQUIRE(isEqual(lazy, A * B * C, 1e-4f));
+		REQUIRE(lazy[3,0] == 0.f);
+		REQUIRE(lazy[3,3] == 1.f);
+	}
+}
@@ -0,0 +1,174 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <numbers>
+
+#include "../vmlib/bounds.hpp"
+#include "../vmlib/frustum.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	constexpr float kPi_ = std::numbers::pi_v<float>;
+
+	// Camera at the origin, looking down -z.
+	Mat44f const kProj_ = make_perspective_projection( 0.5f * kPi_, 1.f, 1.f, 100.f );
+
+	std::vector<Aabb3f> random_boxes_( std::size_t aCount, std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> pos( -150.f, 150.f );
+		std::uniform_real_distribution<float> size( 0.1f, 20.f );
+
+		std::vector<Aabb3f> ret( aCount );
+		for( auto& b : ret )
+		{
+			b.min = Vec3f{ pos( aRng ), pos( aRng ), pos( aRng ) };
+			b.max = b.min + Vec3f{ size( aRng ), size( aRng ), size( aRng ) };
+		}
+		return ret;
+	}
+}
+
+TEST_CASE("Bounding volumes", "[bounds]")
+{
+	SECTION("Point set") {
+		Vec3f const pts[] = { { 1.f, 2.f, 3.f }, { -1.f, 5.f, 0.f }, { 0.f, -2.f, 4.f } };
+		Aabb3f const box = make_aabb( pts );
+
+		REQUIRE(isEqual(box.min, Vec3f{ -1.f, -2.f, 0.f }));
+		REQUIRE(isEqual(box.max, Vec3f{ 1.f, 5.f, 4.f }));
+
+		for( auto const& p : pts )
+			REQUIRE(contains( box, p ));
+		REQUIRE(!contains( box, Vec3f{ 0.f, 0.f, 5.f } ));
+	}
+
+	SECTION("Transform") {
+		Aabb3f const box{ { -1.f, 0.f, 2.f }, { 3.f, 1.f, 5.f } };
+		Mat44f const xform = make_translation( { 4.f, -1.f, 2.f } )
+			* make_rotation_y( 0.3f * kPi_ )
+			* make_scaling( 2.f, 0.5f, 1.f );
+
+		// Reference: bounds of the eight transformed corners
+		Aabb3f ref = kEmptyAabb3f;
+		for( unsigned i = 0; i < 8; ++i )
+		{
+			Vec4f const p{
+				(i & 1) ? box.max.x : box.min.x,
+				(i & 2) ? box.max.y : box.min.y,
+				(i & 4) ? box.max.z : box.min.z,
+				1.f
+			};
+			Vec4f const t = xform * p;
+			ref = extend( ref, Vec3f{ t.x, t.y, t.z } );
+		}
+
+		Aabb3f const res = transform( xform, box );
+		REQUIRE(isEqual(res.min, ref.min, 1e-4f));
+		REQUIRE(isEqual(res.max, ref.max, 1e-4f));
+	}
+
+	SECTION("Plane") {
+		Planef const p = make_plane( { 0.f, 2.f, 0.f }, { 0.f, 1.f, 0.f } );
+		REQUIRE(distance( p, Vec3f{ 5.f, 3.f, -2.f } ) == Catch::Approx( 2.f ));
+		REQUIRE(distance( p, Vec3f{ 0.f, 0.f, 0.f } ) == Catch::Approx( -1.f ));
+
+		Planef const q = normalize( Planef{ { 0.f, 0.f, 4.f }, 8.f } );
+		REQUIRE(distance( q, Vec3f{ 0.f, 0.f, 0.f } ) == Catch::Approx( 2.f ));
+	}
+
+	SECTION("Overlap") {
+		Aabb3f const a{ { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f } };
+		REQUIRE(overlaps( a, Aabb3f{ { 0.5f, 0.5f, 0.5f }, { 2.f, 2.f, 2.f } } ));
+		REQUIRE(!overlaps( a, Aabb3f{ { 1.5f, 0.f, 0.f }, { 2.f, 1.f, 1.f } } ));
+	}
+}
+
+TEST_CASE("Frustum extraction", "[frustum]")
+{
+	Frustumf const f = make_frustum( kProj_ );
+
+	for( auto const& p : f.planes )
+		REQUIRE(length( p.n ) == Catch::Approx( 1.f ));
+
+	// Near and far planes
+	REQUIRE(distance( f.planes[Frustumf::eNear], Vec3f{ 0.f, 0.f, -1.f } ) == Catch::Approx( 0.f ).margin( 1e-5f ));
+	REQUIRE(distance( f.planes[Frustumf::eFar], Vec3f{ 0.f, 0.f, -100.f } ) == Catch::Approx( 0.f ).margin( 1e-3f ));
+
+	REQUIRE(contains( f, Vec3f{ 0.f, 0.f, -10.f } ));
+	REQUIRE(contains( f, Vec3f{ 9.f, -9.f, -10.f } ));
+	REQUIRE(!contains( f, Vec3f{ 11.f, 0.f, -10.f } ));   // 90 degree fov
+	REQUIRE(!contains( f, Vec3f{ 0.f, 0.f, 10.f } ));     // behind
+	REQUIRE(!contains( f, Vec3f{ 0.f, 0.f, -0.5f } ));    // before near
+	REQUIRE(!contains( f, Vec3f{ 0.f, 0.f, -101.f } ));   // past far
+
+	SECTION("With view") {
+		// Camera at (10,0,0) looking down +x. The view matrix moves the world,
+		// so the frustum is extracted from projection * view.
+		Mat44f const view = make_rotation_y( 0.5f * kPi_ ) * make_translation( { -10.f, 0.f, 0.f } );
+		Frustumf const fv = make_frustum( kProj_ * view );
+
+		REQUIRE(contains( fv, Vec3f{ 20.f, 0.f, 0.f } ));
+		REQUIRE(!contains( fv, Vec3f{ 0.f, 0.f, 0.f } ));
+	}
+}
+
+TEST_CASE("Frustum culling", "[frustum]")
+{
+	Frustumf const f = make_frustum( kProj_ );
+
+	SECTION("Spheres") {
+		REQUIRE(intersects( f, Spheref{ { 0.f, 0.f, -50.f }, 1.f } ));
+		REQUIRE(intersects( f, Spheref{ { 0.f, 0.f, 1.f }, 2.5f } ));
+		REQUIRE(!intersects( f, Spheref{ { 0.f, 0.f, 1.f }, 1.5f } ));
+		REQUIRE(!intersects( f, Spheref{ { 0.f, 0.f, -200.f }, 50.f } ));
+	}
+
+	SECTION("Boxes") {
+		REQUIRE(intersects( f, Aabb3f{ { -1.f, -1.f, -11.f }, { 1.f, 1.f, -9.f } } ));
+		// Straddles the left plane
+		REQUIRE(intersects( f, Aabb3f{ { -12.f, -1.f, -11.f }, { -9.f, 1.f, -9.f } } ));
+		// Contains the whole frustum
+		REQUIRE(intersects( f, Aabb3f{ { -500.f, -500.f, -500.f }, { 500.f, 500.f, 500.f } } ));
+
+		REQUIRE(!intersects( f, Aabb3f{ { -1.f, -1.f, 1.f }, { 1.f, 1.f, 3.f } } ));
+		REQUIRE(!intersects( f, Aabb3f{ { 15.f, -1.f, -11.f }, { 20.f, 1.f, -9.f } } ));
+		REQUIRE(!intersects( f, Aabb3f{ { -1.f, -1.f, -120.f }, { 1.f, 1.f, -110.f } } ));
+	}
+}
+
+TEST_CASE("Batched frustum culling", "[frustum][batch]")
+{
+	std::minstd_rand rng( 42 );
+	Frustumf const f = make_frustum( kProj_ );
+
+	// Cover the empty case, the scalar tail and several SIMD iterations.
+	for( std::size_t count : { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 17u, 100u, 1000u } )
+	{
+		auto const boxes = random_boxes_( count, rng );
+
+		std::vector<std::uint8_t> visible( count, 0xff );
+		std::size_t const n = cull_aabbs( f, boxes, visible );
+
+		std::size_t expected = 0;
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			bool const ref = intersects( f, boxes[i] );
+			REQUIRE(visible[i] == (ref ? 1 : 0));
+			expected += ref;
+		}
+		REQUIRE(n == expected);
+	}
+
+	SECTION("All visible") {
+		std::vector<Aabb3f> const boxes( 13, Aabb3f{ { -1.f, -1.f, -11.f }, { 1.f, 1.f, -9.f } } );
+		std::vector<std::uint8_t> visible( boxes.size() );
+		REQUIRE(cull_aabbs( f, boxes, visible ) == boxes.size());
+	}
+	SECTION("All culled") {
+		std::vector<Aabb3f> const boxes( 13, Aabb3f{ { -1.f, -1.f, 1.f }, { 1.f, 1.f, 3.f } } );
+		std::vector<std::uint8_t> visible( boxes.size() );
+		REQUIRE(cull_aabbs( f, boxes, visible ) == 0);
+	}
+}
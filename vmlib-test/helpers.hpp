@@ -16,6 +16,13 @@ inline bool isEqual(const Mat44f& a, const Mat44f& b, float eps = 1e-5f) {
 	return true;
 }
 
+// compare 3x1 vectors
+inline bool isEqual(const Vec3f& a, const Vec3f& b, float eps = 1e-5f) {
+	return	std::fabs(a.x - b.x) < eps &&
+		std::fabs(a.y - b.y) < eps &&
+		std::fabs(a.z - b.z) < eps;
+}
+
 // compare 4x1 vectors
 inline bool isEqual(const Vec4f& a, const Vec4f& b, float eps = 1e-5f) {
 	return	std::fabs(a.x - b.x) < eps &&
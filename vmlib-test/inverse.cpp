@@ -0,0 +1,86 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <numbers>
+
+#include "../vmlib/mat33.hpp"
+#include "../vmlib/mat44.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	constexpr float kPi_ = std::numbers::pi_v<float>;
+
+	Mat44f random_rigid_( std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> angle( -kPi_, kPi_ );
+		std::uniform_real_distribution<float> offset( -50.f, 50.f );
+
+		return make_translation( { offset( aRng ), offset( aRng ), offset( aRng ) } )
+			* make_rotation_z( angle( aRng ) )
+			* make_rotation_y( angle( aRng ) )
+			* make_rotation_x( angle( aRng ) );
+	}
+
+	// Same as the scene's model matrices: translation * rotation * scaling
+	Mat44f random_trs_( std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> scale( 0.1f, 4.f );
+		std::uniform_real_distribution<float> sign( -1.f, 1.f );
+
+		// Include mirroring (negative determinant) every now and then
+		float const sx = scale( aRng ) * (sign( aRng ) < -0.8f ? -1.f : 1.f);
+
+		return random_rigid_( aRng ) * make_scaling( sx, scale( aRng ), scale( aRng ) );
+	}
+
+	bool isEqual( Mat33f const& aA, Mat33f const& aB, float aEps = 1e-5f )
+	{
+		for( std::size_t i = 0; i < 9; ++i )
+		{
+			if( std::fabs( aA.v[i] - aB.v[i] ) > aEps )
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST_CASE("Affine inverse matches the general inverse", "[Mat44f][invert]")
+{
+	std::minstd_rand rng( 7 );
+
+	for( int i = 0; i < 200; ++i )
+	{
+		Mat44f const M = random_trs_( rng );
+		REQUIRE(isEqual(invert_affine(M), invert(M), 1e-4f));
+		REQUIRE(isEqual(M * invert_affine(M), kIdentity44f, 1e-4f));
+	}
+}
+
+TEST_CASE("Rigid inverse matches the general inverse", "[Mat44f][invert]")
+{
+	std::minstd_rand rng( 8 );
+
+	for( int i = 0; i < 200; ++i )
+	{
+		Mat44f const M = random_rigid_( rng );
+		REQUIRE(isEqual(invert_rigid(M), invert(M), 1e-4f));
+	}
+}
+
+TEST_CASE("Normal matrix", "[Mat33f][normal]")
+{
+	std::minstd_rand rng( 9 );
+
+	SECTION("Identity") {
+		REQUIRE(isEqual(normal_matrix(kIdentity44f), kIdentity33f));
+	}
+
+	SECTION("Matches the inverse transpose") {
+		for( int i = 0; i < 200; ++i )
+		{
+			Mat44f const M = random_trs_( rng );
+			REQUIRE(isEqual(normal_matrix(M), mat44_to_mat33(transpose(invert(M))), 1e-4f));
+		}
+	}
+}
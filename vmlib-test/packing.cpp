@@ -0,0 +1,226 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../vmlib/packing.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	// Cover the empty case, the scalar tails and several SIMD iterations.
+	constexpr std::size_t kCounts_[] = { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 15u, 16u, 17u, 33u, 100u };
+
+	std::vector<float> random_floats_( std::size_t aCount, float aMin, float aMax, std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> dist( aMin, aMax );
+
+		std::vector<float> ret( aCount );
+		for( auto& v : ret )
+			v = dist( aRng );
+		return ret;
+	}
+
+	std::vector<Vec3f> random_unit_vectors_( std::size_t aCount, std::minstd_rand& aRng )
+	{
+		std::normal_distribution<float> dist( 0.f, 1.f );
+
+		std::vector<Vec3f> ret( aCount );
+		for( auto& v : ret )
+			v = normalize( Vec3f{ dist( aRng ), dist( aRng ), dist( aRng ) } );
+		return ret;
+	}
+
+	// Compile time checks
+	static_assert( pack_half( 1.f ) == 0x3c00 );
+	static_assert( pack_half( -2.f ) == 0xc000 );
+	static_assert( unpack_half( 0x3555 ) > 0.333f && unpack_half( 0x3555 ) < 0.334f );
+}
+
+TEST_CASE("Half floats", "[packing][half]")
+{
+	SECTION("Special values") {
+		REQUIRE(pack_half( 0.f ) == 0x0000);
+		REQUIRE(pack_half( -0.f ) == 0x8000);
+		REQUIRE(pack_half( 65504.f ) == 0x7bff);   // largest half
+		REQUIRE(pack_half( 65519.f ) == 0x7bff);   // still rounds down
+		REQUIRE(pack_half( 65520.f ) == 0x7c00);   // rounds to Inf
+		REQUIRE(pack_half( std::numeric_limits<float>::infinity() ) == 0x7c00);
+		REQUIRE(pack_half( -std::numeric_limits<float>::infinity() ) == 0xfc00);
+		REQUIRE((pack_half( std::numeric_limits<float>::quiet_NaN() ) & 0x7fff) > 0x7c00);
+		REQUIRE(pack_half( 0x1p-14f ) == 0x0400);  // smallest normal
+		REQUIRE(pack_half( 0x1p-24f ) == 0x0001);  // smallest subnormal
+		REQUIRE(pack_half( 0x1p-26f ) == 0x0000);  // underflow
+
+		// Ties to even: 1 + 2^-11 is halfway between 1 and 1 + 2^-10
+		REQUIRE(pack_half( 1.f + 0x1p-11f ) == 0x3c00);
+		REQUIRE(pack_half( 1.f + 3*0x1p-11f ) == 0x3c02);
+	}
+
+	SECTION("Exhaustive round trip") {
+		for( std::uint32_t h = 0; h < 0x10000; ++h )
+		{
+			float const f = unpack_half( std::uint16_t(h) );
+			if( f != f ) // NaN
+				continue;
+
+			REQUIRE(pack_half( f ) == h);
+		}
+	}
+
+	SECTION("Relative error") {
+		std::minstd_rand rng( 42 );
+		for( float const v : random_floats_( 10000, -65504.f, 65504.f, rng ) )
+		{
+			if( std::abs( v ) < 0x1p-14f )
+				continue;
+
+			float const r = unpack_half( pack_half( v ) );
+			REQUIRE(std::abs( r - v ) <= std::abs( v ) * 0x1p-11f);
+		}
+	}
+
+	SECTION("Batch") {
+		std::minstd_rand rng( 42 );
+		for( std::size_t count : kCounts_ )
+		{
+			// Mix of normals, subnormals and out-of-range values
+			auto in = random_floats_( count, -1.f, 1.f, rng );
+			for( std::size_t i = 0; i < count; ++i )
+				in[i] *= (i % 3 == 0) ? 1e5f : (i % 3 == 1) ? 1e-6f : 100.f;
+
+			std::vector<std::uint16_t> packed( count );
+			pack_half( in, packed );
+
+			std::vector<float> out( count );
+			unpack_half( packed, out );
+
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				REQUIRE(packed[i] == pack_half( in[i] ));
+				REQUIRE(out[i] == unpack_half( packed[i] ));
+			}
+		}
+	}
+}
+
+TEST_CASE("Normalized integers", "[packing][norm]")
+{
+	std::minstd_rand rng( 42 );
+
+	SECTION("Exact values") {
+		REQUIRE(pack_snorm16( 1.f ) == 32767);
+		REQUIRE(pack_snorm16( -1.f ) == -32767);
+		REQUIRE(pack_snorm16( 2.f ) == 32767);
+		REQUIRE(pack_snorm16( 0.f ) == 0);
+		REQUIRE(unpack_snorm16( -32768 ) == -1.f);
+		REQUIRE(unpack_snorm16( 32767 ) == 1.f);
+
+		REQUIRE(pack_snorm8( -1.f ) == -127);
+		REQUIRE(unpack_snorm8( -128 ) == -1.f);
+
+		REQUIRE(pack_unorm16( 1.f ) == 65535);
+		REQUIRE(pack_unorm16( -0.5f ) == 0);
+		REQUIRE(unpack_unorm16( 65535 ) == 1.f);
+	}
+
+	SECTION("Error bounds") {
+		for( float const v : random_floats_( 10000, -1.f, 1.f, rng ) )
+		{
+			REQUIRE(std::abs( unpack_snorm16( pack_snorm16( v ) ) - v ) <= 0.5f / 32767.f + 1e-7f);
+			REQUIRE(std::abs( unpack_snorm8( pack_snorm8( v ) ) - v ) <= 0.5f / 127.f + 1e-7f);
+
+			float const u = 0.5f * v + 0.5f;
+			REQUIRE(std::abs( unpack_unorm16( pack_unorm16( u ) ) - u ) <= 0.5f / 65535.f + 1e-7f);
+		}
+	}
+
+	SECTION("Batch") {
+		for( std::size_t count : kCounts_ )
+		{
+			// Slightly out of range, to exercise clamping
+			auto const in = random_floats_( count, -1.2f, 1.2f, rng );
+			std::vector<float> out( count );
+
+			std::vector<std::int16_t> s16( count );
+			pack_snorm16( in, s16 );
+			unpack_snorm16( s16, out );
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				REQUIRE(s16[i] == pack_snorm16( in[i] ));
+				REQUIRE(out[i] == unpack_snorm16( s16[i] ));
+			}
+
+			std::vector<std::int8_t> s8( count );
+			pack_snorm8( in, s8 );
+			unpack_snorm8( s8, out );
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				REQUIRE(s8[i] == pack_snorm8( in[i] ));
+				REQUIRE(out[i] == unpack_snorm8( s8[i] ));
+			}
+
+			std::vector<std::uint16_t> u16( count );
+			pack_unorm16( in, u16 );
+			unpack_unorm16( u16, out );
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				REQUIRE(u16[i] == pack_unorm16( in[i] ));
+				REQUIRE(out[i] == unpack_unorm16( u16[i] ));
+			}
+		}
+	}
+}
+
+TEST_CASE("Octahedral normals", "[packing][oct]")
+{
+	std::minstd_rand rng( 42 );
+
+	SECTION("Axes") {
+		Vec3f const axes[] = {
+			{ 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f },
+			{ 0.f, 1.f, 0.f }, { 0.f, -1.f, 0.f },
+			{ 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f }
+		};
+		for( auto const& n : axes )
+		{
+			REQUIRE(isEqual(oct_decode( oct_encode( n ) ), n, 1e-6f));
+			REQUIRE(isEqual(unpack_oct16( pack_oct16( n ) ), n, 1e-6f));
+		}
+	}
+
+	SECTION("Error bound") {
+		// Without quantization, the mapping is exact up to rounding. With two
+		// snorm16, the angular error (~ chord length) stays below 1e-4 radians.
+		for( auto const& n : random_unit_vectors_( 10000, rng ) )
+		{
+			REQUIRE(isEqual(oct_decode( oct_encode( n ) ), n, 1e-6f));
+
+			Vec3f const d = unpack_oct16( pack_oct16( n ) );
+			REQUIRE(length( d ) == Catch::Approx( 1.f ).epsilon( 1e-6f ));
+			REQUIRE(length( d - n ) <= 1e-4f);
+		}
+	}
+
+	SECTION("Batch") {
+		for( std::size_t count : kCounts_ )
+		{
+			auto const in = random_unit_vectors_( count, rng );
+
+			std::vector<OctNormal16> packed( count );
+			pack_oct16( in, packed );
+
+			std::vector<Vec3f> out( count );
+			unpack_oct16( packed, out );
+
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				OctNormal16 const ref = pack_oct16( in[i] );
+				REQUIRE(packed[i].x == ref.x);
+				REQUIRE(packed[i].y == ref.y);
+				REQUIRE(isEqual(out[i], unpack_oct16( ref ), 1e-6f));
+			}
+		}
+	}
+}
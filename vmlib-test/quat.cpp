@@ -0,0 +1,142 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <numbers>
+
+#include "../vmlib/quat.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	constexpr float kPi_ = std::numbers::pi_v<float>;
+
+	// q and -q represent the same rotation
+	bool isSameRotation( Quatf const& aA, Quatf const& aB, float aEps = 1e-5f )
+	{
+		return std::fabs( std::fabs( dot( aA, aB ) ) - 1.f ) < aEps;
+	}
+}
+
+TEST_CASE("Quaternion to matrix", "[Quatf]")
+{
+	SECTION("Identity") {
+		REQUIRE(isEqual(quat_to_mat44(kIdentityQuatf), kIdentity44f));
+	}
+
+	SECTION("Matches make_rotation_*()") {
+		for( float angle : { -2.5f, -kPi_ / 2.f, 0.1f, 1.f, kPi_ } )
+		{
+			REQUIRE(isEqual(quat_to_mat44(make_quat_axis_angle({ 1.f, 0.f, 0.f }, angle)), make_rotation_x(angle)));
+			REQUIRE(isEqual(quat_to_mat44(make_quat_axis_angle({ 0.f, 1.f, 0.f }, angle)), make_rotation_y(angle)));
+			REQUIRE(isEqual(quat_to_mat44(make_quat_axis_angle({ 0.f, 0.f, 1.f }, angle)), make_rotation_z(angle)));
+		}
+	}
+
+	SECTION("Product matches matrix product") {
+		Quatf const a = make_quat_axis_angle({ 1.f, 2.f, 3.f }, 0.7f);
+		Quatf const b = make_quat_axis_angle({ -1.f, 0.5f, 0.f }, 2.1f);
+		REQUIRE(isEqual(quat_to_mat44(a * b), quat_to_mat44(a) * quat_to_mat44(b)));
+	}
+}
+
+TEST_CASE("Matrix to quaternion round trip", "[Quatf]")
+{
+	std::minstd_rand rng( 11 );
+	std::uniform_real_distribution<float> angle( -kPi_, kPi_ );
+
+	for( int i = 0; i < 200; ++i )
+	{
+		Mat44f const R = make_rotation_z( angle( rng ) ) * make_rotation_y( angle( rng ) ) * make_rotation_x( angle( rng ) );
+		Quatf const q = mat44_to_quat( R );
+
+		REQUIRE(std::fabs(dot(q, q) - 1.f) < 1e-5f);
+		REQUIRE(isEqual(quat_to_mat44(q), R, 1e-4f));
+	}
+
+	SECTION("180 degree rotations") {
+		// Trace is -1 here, so the non-w branches are taken.
+		REQUIRE(isSameRotation(mat44_to_quat(make_rotation_x(kPi_)), Quatf{ 1.f, 0.f, 0.f, 0.f }));
+		REQUIRE(isSameRotation(mat44_to_quat(make_rotation_y(kPi_)), Quatf{ 0.f, 1.f, 0.f, 0.f }));
+		REQUIRE(isSameRotation(mat44_to_quat(make_rotation_z(kPi_)), Quatf{ 0.f, 0.f, 1.f, 0.f }));
+	}
+}
+
+TEST_CASE("Vector rotation", "[Quatf]")
+{
+	Quatf const q = make_quat_axis_angle({ 0.3f, -1.f, 0.2f }, 1.3f);
+	Mat33f const R = quat_to_mat33(q);
+
+	Vec3f const v{ 1.f, 2.f, -3.f };
+	REQUIRE(isEqual(rotate(q, v), R * v));
+}
+
+TEST_CASE("Aligning +Y with a direction", "[Quatf]")
+{
+	Vec3f const dirs[] = {
+		{ 1.f, 0.f, 0.f },
+		{ 0.3f, 0.5f, -0.8f },
+		{ -0.7f, -0.2f, 0.4f },
+		{ 0.f, 0.f, -1.f },
+		{ 0.f, 1.f, 0.f },            // vertical: fallback up vector
+		{ 0.f, -1.f, 0.f },
+		{ 0.05f, 0.998f, -0.03f },    // nearly vertical
+		{ -0.1f, -0.995f, 0.02f }
+	};
+
+	for( auto const& d : dirs )
+	{
+		Vec3f const dir = normalize( d );
+		Quatf const q = make_quat_align_y( dir );
+
+		REQUIRE(std::fabs(dot(q, q) - 1.f) < 1e-5f);
+		REQUIRE(isEqual(rotate(q, Vec3f{ 0.f, 1.f, 0.f }), dir, 1e-4f));
+
+		// A proper rotation: the rotated axes stay right-handed
+		Vec3f const x = rotate(q, Vec3f{ 1.f, 0.f, 0.f });
+		Vec3f const z = rotate(q, Vec3f{ 0.f, 0.f, 1.f });
+		REQUIRE(isEqual(cross(x, dir), z, 1e-4f));
+	}
+}
+
+TEST_CASE("Quaternion interpolation", "[Quatf][slerp]")
+{
+	Quatf const a = make_quat_axis_angle({ 0.f, 1.f, 0.f }, 0.f);
+	Quatf const b = make_quat_axis_angle({ 0.f, 1.f, 0.f }, kPi_ / 2.f);
+
+	SECTION("Endpoints") {
+		REQUIRE(isSameRotation(slerp(a, b, 0.f), a));
+		REQUIRE(isSameRotation(slerp(a, b, 1.f), b));
+		REQUIRE(isSameRotation(nlerp(a, b, 0.f), a));
+		REQUIRE(isSameRotation(nlerp(a, b, 1.f), b));
+	}
+
+	SECTION("Slerp has constant angular velocity") {
+		for( float t : { 0.1f, 0.25f, 0.5f, 0.8f } )
+		{
+			Quatf const expected = make_quat_axis_angle({ 0.f, 1.f, 0.f }, t * kPi_ / 2.f);
+			REQUIRE(isSameRotation(slerp(a, b, t), expected));
+		}
+	}
+
+	SECTION("Nlerp is exact at the midpoint") {
+		Quatf const expected = make_quat_axis_angle({ 0.f, 1.f, 0.f }, kPi_ / 4.f);
+		REQUIRE(isSameRotation(nlerp(a, b, 0.5f), expected));
+	}
+
+	SECTION("Shortest path") {
+		Quatf const nb{ -b.x, -b.y, -b.z, -b.w };
+		Quatf const expected = make_quat_axis_angle({ 0.f, 1.f, 0.f }, kPi_ / 4.f);
+		REQUIRE(isSameRotation(slerp(a, nb, 0.5f), expected));
+		REQUIRE(isSameRotation(nlerp(a, nb, 0.5f), expected));
+	}
+}
+
+TEST_CASE("TRS composition", "[Quatf][Mat44f]")
+{
+	Vec3f const t{ 10.f, -0.5f, 45.f };
+	Quatf const r = make_quat_axis_angle({ 0.2f, 1.f, -0.4f }, 2.f);
+	Vec3f const s{ 0.5f, 0.5f, 0.5f };
+
+	Mat44f const expected = make_translation(t) * quat_to_mat44(r) * make_scaling(s.x, s.y, s.z);
+	REQUIRE(isEqual(make_trs(t, r, s), expected));
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+
+#include "../vmlib/mat44.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	// Random, well-conditioned matrix (diagonally dominant).
+	Mat44f random_mat44_( std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> dist( -1.f, 1.f );
+
+		Mat44f ret;
+		for( auto& v : ret.v )
+			v = dist( aRng );
+		for( std::size_t i = 0; i < 4; ++i )
+			ret[i,i] += 4.f;
+		return ret;
+	}
+}
+
+TEST_CASE("Constant evaluation uses the scalar kernels", "[Mat44f][simd]")
+{
+	constexpr Mat44f T = { {
+		1.f, 0.f, 0.f, 2.f,
+		0.f, 1.f, 0.f, 3.f,
+		0.f, 0.f, 1.f, 4.f,
+		0.f, 0.f, 0.f, 1.f
+	} };
+	constexpr Mat44f TT = T * T;
+	static_assert( TT[0,3] == 4.f && TT[1,3] == 6.f && TT[2,3] == 8.f );
+
+	constexpr Vec4f P = T * Vec4f{ 1.f, 1.f, 1.f, 1.f };
+	static_assert( P.x == 3.f && P.y == 4.f && P.z == 5.f && P.w == 1.f );
+}
+
+TEST_CASE("Operators match the scalar kernels", "[Mat44f][simd]")
+{
+	std::minstd_rand rng( 1234 );
+
+	SECTION("Matrix multiplication") {
+		for( int i = 0; i < 100; ++i )
+		{
+			Mat44f const A = random_mat44_( rng );
+			Mat44f const B = random_mat44_( rng );
+			REQUIRE(isEqual(A * B, detail::mul_scalar(A, B), 1e-4f));
+		}
+	}
+
+	SECTION("Matrix-vector multiplication") {
+		for( int i = 0; i < 100; ++i )
+		{
+			Mat44f const A = random_mat44_( rng );
+			Vec4f const V = { A[0,1], A[1,2], A[2,3], A[3,0] };
+			REQUIRE(isEqual(A * V, detail::mul_scalar(A, V), 1e-4f));
+		}
+	}
+
+	SECTION("Inverse") {
+		for( int i = 0; i < 100; ++i )
+		{
+			Mat44f const A = random_mat44_( rng );
+			REQUIRE(isEqual(invert(A), detail::invert_scalar(A)));
+			REQUIRE(isEqual(A * invert(A), kIdentity44f));
+		}
+	}
+}
+
+TEST_CASE("Batched operations", "[Mat44f][simd][batch]")
+{
+	std::minstd_rand rng( 4321 );
+
+	std::size_t const count = 37; // deliberately not a multiple of the SIMD width
+	std::vector<Mat44f> left, right;
+	for( std::size_t i = 0; i < count; ++i )
+	{
+		left.emplace_back( random_mat44_( rng ) );
+		right.emplace_back( random_mat44_( rng ) );
+	}
+
+	std::vector<Mat44f> out( count );
+
+	SECTION("Element-wise multiplication") {
+		mul_batch( left, right, out );
+		for( std::size_t i = 0; i < count; ++i )
+			REQUIRE(isEqual(out[i], left[i] * right[i]));
+	}
+
+	SECTION("Shared left operand") {
+		mul_batch( left[0], right, out );
+		for( std::size_t i = 0; i < count; ++i )
+			REQUIRE(isEqual(out[i], left[0] * right[i]));
+	}
+
+	SECTION("Inverse") {
+		invert_batch( left, out );
+		for( std::size_t i = 0; i < count; ++i )
+			REQUIRE(isEqual(out[i], invert(left[i])));
+	}
+
+	SECTION("Inverse in place") {
+		out = left;
+		invert_batch( out, out );
+		for( std::size_t i = 0; i < count; ++i )
+			REQUIRE(isEqual(out[i], invert(left[i])));
+	}
+}
@@ -0,0 +1,166 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <cstdint>
+
+#include "../vmlib/srgb.hpp"
+
+namespace
+{
+	// Cover size 1, odd sizes, the scalar tails and several SIMD iterations.
+	constexpr std::size_t kSizes_[] = { 1u, 2u, 3u, 4u, 5u, 7u, 8u, 9u, 16u, 17u, 33u };
+
+	std::vector<std::uint16_t> random_linear15_( std::size_t aCount, std::minstd_rand& aRng )
+	{
+		std::uniform_int_distribution<int> dist( 0, kLinear15Max );
+
+		std::vector<std::uint16_t> ret( aCount );
+		for( auto& v : ret )
+			v = std::uint16_t(dist( aRng ));
+		return ret;
+	}
+
+	// Straightforward version of downsample_linear15()
+	std::vector<std::uint16_t> downsample_reference_( std::vector<std::uint16_t> const& aIn, std::size_t aW, std::size_t aH )
+	{
+		std::size_t const ow = mip_size( aW ), oh = mip_size( aH );
+		auto const at = [&] (std::size_t aX, std::size_t aY, std::size_t aC) {
+			return std::uint32_t(aIn[(std::min( aY, aH-1 ) * aW + std::min( aX, aW-1 )) * 4 + aC]);
+		};
+
+		std::vector<std::uint16_t> ret( ow * oh * 4 );
+		for( std::size_t y = 0; y < oh; ++y )
+		{
+			for( std::size_t x = 0; x < ow; ++x )
+			{
+				for( std::size_t c = 0; c < 4; ++c )
+				{
+					std::uint32_t const sum = at( 2*x, 2*y, c ) + at( 2*x+1, 2*y, c ) + at( 2*x, 2*y+1, c ) + at( 2*x+1, 2*y+1, c );
+					ret[(y*ow + x)*4 + c] = std::uint16_t((sum + 2) / 4);
+				}
+			}
+		}
+		return ret;
+	}
+
+	static_assert( mip_size( 4096 ) == 2048 );
+	static_assert( mip_size( 5 ) == 2 );
+	static_assert( mip_size( 1 ) == 1 );
+}
+
+TEST_CASE("sRGB conversion", "[srgb]")
+{
+	SECTION("Round trip") {
+		for( int i = 0; i < 256; ++i )
+			REQUIRE(linear15_to_srgb8( srgb8_to_linear15( std::uint8_t(i) ) ) == i);
+	}
+
+	SECTION("Known values") {
+		REQUIRE(srgb8_to_linear15( 0 ) == 0);
+		REQUIRE(srgb8_to_linear15( 255 ) == kLinear15Max);
+		REQUIRE(linear15_to_srgb8( kLinear15Max ) == 255);
+
+		// sRGB 0.5 is about 21.4% linear; linear 0.5 is about sRGB 188
+		REQUIRE(std::abs( srgb8_to_linear15( 128 ) - 0.2158f * kLinear15Max ) < 2.f);
+		REQUIRE(linear15_to_srgb8( kLinear15Max / 2 ) == 188);
+	}
+
+	SECTION("Monotonic") {
+		for( std::uint16_t i = 1; i <= kLinear15Max; ++i )
+			REQUIRE(linear15_to_srgb8( i ) >= linear15_to_srgb8( i-1 ));
+	}
+
+	SECTION("Batched") {
+		std::vector<std::uint8_t> in( 256 * 4 );
+		for( std::size_t i = 0; i < 256; ++i )
+		{
+			in[i*4+0] = std::uint8_t(i);
+			in[i*4+1] = std::uint8_t(255-i);
+			in[i*4+2] = std::uint8_t(i*7);
+			in[i*4+3] = std::uint8_t(i);
+		}
+
+		std::vector<std::uint16_t> linear( in.size() );
+		srgba8_to_linear15( in, linear );
+
+		for( std::size_t i = 0; i < in.size(); i += 4 )
+		{
+			REQUIRE(linear[i+0] == srgb8_to_linear15( in[i+0] ));
+			REQUIRE(linear[i+1] == srgb8_to_linear15( in[i+1] ));
+			REQUIRE(linear[i+2] == srgb8_to_linear15( in[i+2] ));
+		}
+
+		// Alpha is rescaled linearly
+		REQUIRE(linear[0*4+3] == 0);
+		REQUIRE(linear[255*4+3] == kLinear15Max);
+		REQUIRE(std::abs( linear[128*4+3] - 128.f/255.f * kLinear15Max ) <= 0.5f);
+
+		std::vector<std::uint8_t> out( in.size() );
+		linear15_to_srgba8( linear, out );
+		REQUIRE(out == in);
+	}
+}
+
+TEST_CASE("Mip downsampling", "[srgb]")
+{
+	std::minstd_rand rng( 42 );
+
+	SECTION("Matches reference") {
+		for( std::size_t w : kSizes_ )
+		{
+			for( std::size_t h : { 1u, 2u, 3u, 6u } )
+			{
+				auto const in = random_linear15_( w * h * 4, rng );
+				auto const expected = downsample_reference_( in, w, h );
+
+				std::vector<std::uint16_t> out( expected.size() );
+				downsample_linear15( in, w, h, out, 0, mip_size( h ) );
+
+				INFO( "w = " << w << ", h = " << h );
+				REQUIRE(out == expected);
+			}
+		}
+	}
+
+	SECTION("Row ranges") {
+		std::size_t const w = 17, h = 12;
+		auto const in = random_linear15_( w * h * 4, rng );
+		auto const expected = downsample_reference_( in, w, h );
+
+		std::vector<std::uint16_t> out( expected.size() );
+		downsample_linear15( in, w, h, out, 0, 2 );
+		downsample_linear15( in, w, h, out, 2, 5 );
+		downsample_linear15( in, w, h, out, 5, mip_size( h ) );
+		REQUIRE(out == expected);
+	}
+
+	SECTION("Known values") {
+		// Rounds to nearest: (1+2+3+5)/4 = 2.75 -> 3, (0+0+0+1)/4 = 0.25 -> 0
+		std::vector<std::uint16_t> const in = {
+			1, 0, kLinear15Max, kLinear15Max,   2, 0, kLinear15Max, kLinear15Max,
+			3, 0, kLinear15Max, kLinear15Max,   5, 1, kLinear15Max, kLinear15Max
+		};
+		std::vector<std::uint16_t> out( 4 );
+		downsample_linear15( in, 2, 2, out, 0, 1 );
+
+		REQUIRE(out[0] == 3);
+		REQUIRE(out[1] == 0);
+		REQUIRE(out[2] == kLinear15Max);
+		REQUIRE(out[3] == kLinear15Max);
+	}
+
+	SECTION("Linear average of sRGB values") {
+		// Black and white average to linear 0.5, i.e., sRGB 188, not 128
+		std::uint16_t const b = srgb8_to_linear15( 0 ), w = srgb8_to_linear15( 255 );
+		std::vector<std::uint16_t> const in = {
+			b, b, b, kLinear15Max,   w, w, w, kLinear15Max,
+			w, w, w, kLinear15Max,   b, b, b, kLinear15Max
+		};
+		std::vector<std::uint16_t> out( 4 );
+		downsample_linear15( in, 2, 2, out, 0, 1 );
+
+		REQUIRE(linear15_to_srgb8( out[0] ) == 188);
+	}
+}
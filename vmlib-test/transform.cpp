@@ -0,0 +1,80 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <numbers>
+
+#include "../vmlib/transform.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	std::vector<Vec3f> random_vec3s_( std::size_t aCount, std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> dist( -10.f, 10.f );
+
+		std::vector<Vec3f> ret( aCount );
+		for( auto& v : ret )
+			v = Vec3f{ dist( aRng ), dist( aRng ), dist( aRng ) };
+		return ret;
+	}
+
+	Mat44f const kXform_ = make_translation( { 1.f, -2.f, 3.f } )
+		* make_rotation_y( 0.3f * std::numbers::pi_v<float> )
+		* make_rotation_x( 0.1f )
+		* make_scaling( 0.5f, 2.f, 1.5f );
+}
+
+TEST_CASE("Batched point transform", "[transform][batch]")
+{
+	std::minstd_rand rng( 42 );
+
+	// Cover the empty case, the scalar tail and several SIMD iterations.
+	for( std::size_t count : { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 17u, 100u } )
+	{
+		auto const in = random_vec3s_( count, rng );
+
+		std::vector<Vec3f> out( count );
+		transform_points( kXform_, in, out );
+
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			Vec4f const ref = kXform_ * Vec4f{ in[i].x, in[i].y, in[i].z, 1.f };
+			REQUIRE(isEqual(out[i], Vec3f{ ref.x, ref.y, ref.z }, 1e-4f));
+		}
+	}
+
+	SECTION("In place") {
+		auto const in = random_vec3s_( 21, rng );
+
+		std::vector<Vec3f> out = in;
+		transform_points( kXform_, out, out );
+
+		for( std::size_t i = 0; i < in.size(); ++i )
+		{
+			Vec4f const ref = kXform_ * Vec4f{ in[i].x, in[i].y, in[i].z, 1.f };
+			REQUIRE(isEqual(out[i], Vec3f{ ref.x, ref.y, ref.z }, 1e-4f));
+		}
+	}
+}
+
+TEST_CASE("Batched normal transform", "[transform][batch]")
+{
+	std::minstd_rand rng( 43 );
+
+	Mat33f const N = mat44_to_mat33( transpose( invert( kXform_ ) ) );
+
+	for( std::size_t count : { 0u, 1u, 5u, 8u, 13u, 64u } )
+	{
+		auto const in = random_vec3s_( count, rng );
+
+		std::vector<Vec3f> out( count );
+		transform_normals( N, in, out );
+
+		for( std::size_t i = 0; i < count; ++i )
+		{
+			REQUIRE(isEqual(out[i], normalize( N * in[i] )));
+			REQUIRE(std::fabs(length(out[i]) - 1.f) < 1e-5f);
+		}
+	}
+}
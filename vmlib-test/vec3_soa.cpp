@@ -0,0 +1,182 @@
+#include <catch2/catch_amalgamated.hpp>
+
+#include <random>
+#include <vector>
+#include <cstdint>
+
+#include "../vmlib/vec3_soa.hpp"
+#include "helpers.hpp"
+
+namespace
+{
+	// Cover the empty case, partial registers and several SIMD iterations.
+	constexpr std::size_t kCounts_[] = { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 15u, 16u, 17u, 33u, 100u };
+
+	std::vector<Vec3f> random_vectors_( std::size_t aCount, std::minstd_rand& aRng )
+	{
+		std::uniform_real_distribution<float> dist( -10.f, 10.f );
+
+		std::vector<Vec3f> ret( aCount );
+		for( auto& v : ret )
+			v = Vec3f{ dist( aRng ), dist( aRng ), dist( aRng ) };
+		return ret;
+	}
+
+	bool is_aligned_( float const* aPtr )
+	{
+		return 0 == reinterpret_cast<std::uintptr_t>(aPtr) % Vec3fSoA::kAlign;
+	}
+}
+
+TEST_CASE("Vec3fSoA container", "[soa]")
+{
+	std::minstd_rand rng( 42 );
+
+	SECTION("Round trip") {
+		for( std::size_t count : kCounts_ )
+		{
+			auto const in = random_vectors_( count, rng );
+			Vec3fSoA const soa( in );
+
+			REQUIRE(soa.size() == count);
+			REQUIRE(soa.padded_size() % Vec3fSoA::kLanes == 0);
+			REQUIRE(soa.padded_size() >= count);
+			if( count )
+			{
+				REQUIRE(is_aligned_( soa.x() ));
+				REQUIRE(is_aligned_( soa.y() ));
+				REQUIRE(is_aligned_( soa.z() ));
+			}
+
+			std::vector<Vec3f> out( count );
+			soa.copy_to( out );
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				REQUIRE(soa[i].x == in[i].x);
+				REQUIRE(soa[i].y == in[i].y);
+				REQUIRE(soa[i].z == in[i].z);
+				REQUIRE(out[i].x == in[i].x);
+				REQUIRE(out[i].y == in[i].y);
+				REQUIRE(out[i].z == in[i].z);
+			}
+		}
+	}
+
+	SECTION("Resize zeroes new elements") {
+		auto const in = random_vectors_( 13, rng );
+		Vec3fSoA soa( in );
+
+		soa.resize( 5 );
+		soa.resize( 20 );
+		REQUIRE(soa.size() == 20);
+		for( std::size_t i = 0; i < 5; ++i )
+			REQUIRE(isEqual(soa[i], in[i]));
+		for( std::size_t i = 5; i < 20; ++i )
+			REQUIRE(isEqual(soa[i], Vec3f{ 0.f, 0.f, 0.f }));
+	}
+
+	SECTION("Push and remove") {
+		auto const in = random_vectors_( 19, rng );
+
+		Vec3fSoA soa;
+		for( auto const& v : in )
+			soa.push_back( v );
+		REQUIRE(soa.size() == in.size());
+
+		// Remove the first element; the last one takes its place
+		soa.swap_remove( 0 );
+		REQUIRE(soa.size() == in.size()-1);
+		REQUIRE(isEqual(soa[0], in.back()));
+		REQUIRE(isEqual(soa[1], in[1]));
+
+		soa.pop_back();
+		REQUIRE(soa.size() == in.size()-2);
+		REQUIRE(isEqual(soa[soa.size()-1], in[in.size()-3]));
+
+		soa.clear();
+		REQUIRE(soa.empty());
+	}
+}
+
+TEST_CASE("Vec3fSoA operations", "[soa]")
+{
+	std::minstd_rand rng( 42 );
+
+	for( std::size_t count : kCounts_ )
+	{
+		auto const a = random_vectors_( count, rng );
+		auto const b = random_vectors_( count, rng );
+		auto const c = random_vectors_( count, rng );
+
+		Vec3fSoA const sa( a ), sb( b ), sc( c );
+		Vec3fSoA out;
+
+		Vec3f const k{ 1.5f, -2.f, 0.25f };
+		float const s = 0.75f;
+
+		SECTION("add") {
+			add( sa, sb, out );
+			REQUIRE(out.size() == count);
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], a[i] + b[i]));
+
+			add( sa, k, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], a[i] + k));
+		}
+		SECTION("sub") {
+			sub( sa, sb, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], a[i] - b[i]));
+		}
+		SECTION("mul") {
+			mul( sa, sb, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], Vec3f{ a[i].x*b[i].x, a[i].y*b[i].y, a[i].z*b[i].z }, 1e-4f));
+
+			mul( s, sa, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], s * a[i]));
+		}
+		SECTION("madd") {
+			madd( sa, sb, sc, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], Vec3f{ a[i].x*b[i].x, a[i].y*b[i].y, a[i].z*b[i].z } + c[i], 1e-4f));
+
+			madd( s, sa, sb, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], s * a[i] + b[i]));
+		}
+		SECTION("cross") {
+			cross( sa, sb, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], cross( a[i], b[i] ), 1e-4f));
+		}
+		SECTION("normalize") {
+			normalize( sa, out );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(out[i], normalize( a[i] ), 1e-6f));
+		}
+		SECTION("dot and length") {
+			std::vector<float> d( count ), l( count );
+			dot( sa, sb, d );
+			length( sa, l );
+			for( std::size_t i = 0; i < count; ++i )
+			{
+				REQUIRE(d[i] == Catch::Approx( dot( a[i], b[i] ) ).margin( 1e-4f ));
+				REQUIRE(l[i] == Catch::Approx( length( a[i] ) ).epsilon( 1e-6f ));
+			}
+		}
+		SECTION("Aliasing") {
+			// p += dt * v, in place
+			Vec3fSoA p( a );
+			madd( s, sb, p, p );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(p[i], s * b[i] + a[i]));
+
+			add( p, p, p );
+			for( std::size_t i = 0; i < count; ++i )
+				REQUIRE(isEqual(p[i], 2.f * (s * b[i] + a[i]), 1e-4f));
+		}
+	}
+}
@@ -0,0 +1,390 @@
+#include "bc7.hpp"
+
+#include <cmath>
+#include <limits>
+#include <cassert>
+#include <algorithm>
+
+namespace
+{
+	// Palette weights of 4 bit indices, out of 64
+	constexpr int kWeights_[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	constexpr std::uint64_t kMode6_ = 1u << 6; // mode 6: six zero bits, then a one
+
+	// Mode 6 endpoints: 7 bits per channel, plus one low bit per endpoint
+	struct Endpoints_
+	{
+		std::uint8_t q[2][4];
+		std::uint8_t p[2];
+	};
+
+	struct BitWriter_
+	{
+		std::uint64_t lo = 0, hi = 0;
+		unsigned pos = 0;
+
+		void put( std::uint64_t aValue, unsigned aBits ) noexcept
+		{
+			if( pos < 64 )
+			{
+				lo |= aValue << pos;
+				if( pos + aBits > 64 )
+					hi |= aValue >> (64 - pos);
+			}
+			else
+			{
+				hi |= aValue << (pos - 64);
+			}
+			pos += aBits;
+		}
+	};
+
+	struct BitReader_
+	{
+		std::uint64_t lo, hi;
+		unsigned pos = 0;
+
+		unsigned get( unsigned aBits ) noexcept
+		{
+			std::uint64_t v;
+			if( pos < 64 )
+			{
+				v = lo >> pos;
+				if( pos + aBits > 64 )
+					v |= hi << (64 - pos);
+			}
+			else
+			{
+				v = hi >> (pos - 64);
+			}
+			pos += aBits;
+			return unsigned(v & ((1u << aBits) - 1));
+		}
+	};
+
+	void palette_( Endpoints_ const& aEnd, int aPalette[16][4] ) noexcept
+	{
+		for( int c = 0; c < 4; ++c )
+		{
+			int const a = (aEnd.q[0][c] << 1) | aEnd.p[0];
+			int const b = (aEnd.q[1][c] << 1) | aEnd.p[1];
+			for( int i = 0; i < 16; ++i )
+				aPalette[i][c] = ((64 - kWeights_[i]) * a + kWeights_[i] * b + 32) >> 6;
+		}
+	}
+
+	// Quantizes an endpoint, with the low bit that gives the smaller error
+	void quantize_( float const aV[4], std::uint8_t aQ[4], std::uint8_t& aP ) noexcept
+	{
+		float bestErr = std::numeric_limits<float>::max();
+		for( int p = 0; p < 2; ++p )
+		{
+			std::uint8_t q[4];
+			float err = 0.f;
+			for( int c = 0; c < 4; ++c )
+			{
+				q[c] = std::uint8_t(std::clamp( int(std::lround( (aV[c] - float(p)) * 0.5f )), 0, 127 ));
+				float const d = float((q[c] << 1) | p) - aV[c];
+				err += d*d;
+			}
+
+			if( err < bestErr )
+			{
+				bestErr = err;
+				std::copy( q, q+4, aQ );
+				aP = std::uint8_t(p);
+			}
+		}
+	}
+
+	int distance2_( std::uint8_t const* aPixel, int const aColor[4] ) noexcept
+	{
+		int ret = 0;
+		for( int c = 0; c < 4; ++c )
+		{
+			int const d = int(aPixel[c]) - aColor[c];
+			ret += d*d;
+		}
+		return ret;
+	}
+
+	// Picks each pixel's index by projecting it onto the endpoint line, and
+	// checking the neighbouring indices. Returns the total squared error.
+	int select_indices_( std::uint8_t const* aPixels, Endpoints_ const& aEnd, std::uint8_t aIndices[16] ) noexcept
+	{
+		int palette[16][4];
+		palette_( aEnd, palette );
+
+		int axis[4], len2 = 0;
+		for( int c = 0; c < 4; ++c )
+		{
+			axis[c] = palette[15][c] - palette[0][c];
+			len2 += axis[c] * axis[c];
+		}
+
+		int ret = 0;
+		for( int i = 0; i < 16; ++i )
+		{
+			std::uint8_t const* px = aPixels + i*4;
+
+			int guess = 0;
+			if( len2 > 0 )
+			{
+				int dot = 0;
+				for( int c = 0; c < 4; ++c )
+					dot += (int(px[c]) - palette[0][c]) * axis[c];
+				guess = std::clamp( int(std::lround( 15.f * float(dot) / float(len2) )), 0, 15 );
+			}
+
+			int best = guess, bestErr = distance2_( px, palette[guess] );
+			for( int j = std::max( guess-1, 0 ); j <= std::min( guess+1, 15 ); ++j )
+			{
+				int const err = distance2_( px, palette[j] );
+				if( err < bestErr )
+				{
+					best = j;
+					bestErr = err;
+				}
+			}
+
+			aIndices[i] = std::uint8_t(best);
+			ret += bestErr;
+		}
+
+		return ret;
+	}
+
+	// Endpoints that minimize the squared error for the given indices
+	bool refit_( std::uint8_t const* aPixels, std::uint8_t const aIndices[16], float aE0[4], float aE1[4] ) noexcept
+	{
+		float aa = 0.f, ab = 0.f, bb = 0.f;
+		float pa[4] = {}, pb[4] = {};
+		for( int i = 0; i < 16; ++i )
+		{
+			float const b = float(kWeights_[aIndices[i]]) / 64.f;
+			float const a = 1.f - b;
+			aa += a*a;
+			ab += a*b;
+			bb += b*b;
+			for( int c = 0; c < 4; ++c )
+			{
+				pa[c] += a * float(aPixels[i*4+c]);
+				pb[c] += b * float(aPixels[i*4+c]);
+			}
+		}
+
+		float const det = aa*bb - ab*ab;
+		if( std::abs( det ) < 1e-6f )
+			return false;
+
+		for( int c = 0; c < 4; ++c )
+		{
+			aE0[c] = std::clamp( (bb*pa[c] - ab*pb[c]) / det, 0.f, 255.f );
+			aE1[c] = std::clamp( (aa*pb[c] - ab*pa[c]) / det, 0.f, 255.f );
+		}
+		return true;
+	}
+
+	// Endpoints along the principal axis of the pixels
+	void principal_endpoints_( std::uint8_t const* aPixels, float aE0[4], float aE1[4] ) noexcept
+	{
+		float mean[4] = {};
+		float lo[4] = { 255.f, 255.f, 255.f, 255.f }, hi[4] = {};
+		for( int i = 0; i < 16; ++i )
+		{
+			for( int c = 0; c < 4; ++c )
+			{
+				float const v = float(aPixels[i*4+c]);
+				mean[c] += v;
+				lo[c] = std::min( lo[c], v );
+				hi[c] = std::max( hi[c], v );
+			}
+		}
+		for( int c = 0; c < 4; ++c )
+			mean[c] *= 1.f / 16.f;
+
+		float cov[4][4] = {};
+		for( int i = 0; i < 16; ++i )
+		{
+			float d[4];
+			for( int c = 0; c < 4; ++c )
+				d[c] = float(aPixels[i*4+c]) - mean[c];
+			for( int r = 0; r < 4; ++r )
+			{
+				for( int c = 0; c < 4; ++c )
+					cov[r][c] += d[r] * d[c];
+			}
+		}
+
+		// Power iteration, starting from the diagonal of the bounding box
+		float axis[4];
+		for( int c = 0; c < 4; ++c )
+			axis[c] = hi[c] - lo[c];
+
+		for( int iter = 0; iter < 8; ++iter )
+		{
+			float next[4] = {};
+			for( int r = 0; r < 4; ++r )
+			{
+				for( int c = 0; c < 4; ++c )
+					next[r] += cov[r][c] * axis[c];
+			}
+
+			float const len = std::sqrt( next[0]*next[0] + next[1]*next[1] + next[2]*next[2] + next[3]*next[3] );
+			if( len < 1e-6f )
+				break;
+
+			for( int c = 0; c < 4; ++c )
+				axis[c] = next[c] / len;
+		}
+
+		float const len2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2] + axis[3]*axis[3];
+		if( len2 < 1e-12f ) // all pixels are equal
+		{
+			std::copy( mean, mean+4, aE0 );
+			std::copy( mean, mean+4, aE1 );
+			return;
+		}
+
+		float tmin = std::numeric_limits<float>::max(), tmax = -tmin;
+		for( int i = 0; i < 16; ++i )
+		{
+			float t = 0.f;
+			for( int c = 0; c < 4; ++c )
+				t += (float(aPixels[i*4+c]) - mean[c]) * axis[c];
+			tmin = std::min( tmin, t );
+			tmax = std::max( tmax, t );
+		}
+
+		for( int c = 0; c < 4; ++c )
+		{
+			aE0[c] = std::clamp( mean[c] + tmin * axis[c] / len2, 0.f, 255.f );
+			aE1[c] = std::clamp( mean[c] + tmax * axis[c] / len2, 0.f, 255.f );
+		}
+	}
+}
+
+void encode_bc7_block( std::span<std::uint8_t const, 64> aRgba, std::span<std::uint8_t, 16> aOut ) noexcept
+{
+	std::uint8_t const* pixels = aRgba.data();
+
+	float e0[4], e1[4];
+	principal_endpoints_( pixels, e0, e1 );
+
+	Endpoints_ best;
+	quantize_( e0, best.q[0], best.p[0] );
+	quantize_( e1, best.q[1], best.p[1] );
+
+	std::uint8_t indices[16];
+	int const err = select_indices_( pixels, best, indices );
+
+	if( err > 0 && refit_( pixels, indices, e0, e1 ) )
+	{
+		Endpoints_ refined;
+		quantize_( e0, refined.q[0], refined.p[0] );
+		quantize_( e1, refined.q[1], refined.p[1] );
+
+		std::uint8_t refinedIndices[16];
+		if( select_indices_( pixels, refined, refinedIndices ) < err )
+		{
+			best = refined;
+			std::copy( refinedIndices, refinedIndices+16, indices );
+		}
+	}
+
+	// The first index is stored with 3 bits, so its top bit must be clear.
+	// Swapping the endpoints mirrors the palette.
+	if( indices[0] & 8 )
+	{
+		std::swap( best.q[0], best.q[1] );
+		std::swap( best.p[0], best.p[1] );
+		for( auto& i : indices )
+			i = std::uint8_t(15 - i);
+	}
+
+	BitWriter_ bits;
+	bits.put( kMode6_, 7 );
+	for( int c = 0; c < 4; ++c )
+	{
+		bits.put( best.q[0][c], 7 );
+		bits.put( best.q[1][c], 7 );
+	}
+	bits.put( best.p[0], 1 );
+	bits.put( best.p[1], 1 );
+
+	bits.put( indices[0], 3 );
+	for( int i = 1; i < 16; ++i )
+		bits.put( indices[i], 4 );
+
+	assert( 128 == bits.pos );
+
+	for( int i = 0; i < 8; ++i )
+	{
+		aOut[i] = std::uint8_t(bits.lo >> (8*i));
+		aOut[8+i] = std::uint8_t(bits.hi >> (8*i));
+	}
+}
+
+void decode_bc7_block( std::span<std::uint8_t const, 16> aBlock, std::span<std::uint8_t, 64> aRgba ) noexcept
+{
+	BitReader_ bits{ 0, 0 };
+	for( int i = 0; i < 8; ++i )
+	{
+		bits.lo |= std::uint64_t(aBlock[i]) << (8*i);
+		bits.hi |= std::uint64_t(aBlock[8+i]) << (8*i);
+	}
+
+	if( kMode6_ != bits.get( 7 ) )
+	{
+		std::fill( aRgba.begin(), aRgba.end(), std::uint8_t(0) );
+		return;
+	}
+
+	Endpoints_ end;
+	for( int c = 0; c < 4; ++c )
+	{
+		end.q[0][c] = std::uint8_t(bits.get( 7 ));
+		end.q[1][c] = std::uint8_t(bits.get( 7 ));
+	}
+	end.p[0] = std::uint8_t(bits.get( 1 ));
+	end.p[1] = std::uint8_t(bits.get( 1 ));
+
+	int palette[16][4];
+	palette_( end, palette );
+
+	for( int i = 0; i < 16; ++i )
+	{
+		unsigned const index = bits.get( 0 == i ? 3 : 4 );
+		for( int c = 0; c < 4; ++c )
+			aRgba[i*4+c] = std::uint8_t(palette[index][c]);
+	}
+}
+
+void encode_bc7( std::span<std::uint8_t const> aRgba, std::size_t aWidth, std::size_t aHeight, std::span<std::uint8_t> aOut, std::size_t aBlockRowBegin, std::size_t aBlockRowEnd ) noexcept
+{
+	std::size_t const blocksX = (aWidth + 3) / 4;
+
+	assert( aRgba.size() >= aWidth * aHeight * 4 );
+	assert( aOut.size() >= bc7_size( aWidth, aHeight ) );
+	assert( aBlockRowBegin <= aBlockRowEnd && aBlockRowEnd <= (aHeight + 3) / 4 );
+
+	std::uint8_t block[64];
+	for( std::size_t by = aBlockRowBegin; by < aBlockRowEnd; ++by )
+	{
+		for( std::size_t bx = 0; bx < blocksX; ++bx )
+		{
+			for( std::size_t y = 0; y < 4; ++y )
+			{
+				std::size_t const sy = std::min( by*4 + y, aHeight-1 );
+				for( std::size_t x = 0; x < 4; ++x )
+				{
+					std::size_t const sx = std::min( bx*4 + x, aWidth-1 );
+					std::copy_n( aRgba.data() + (sy * aWidth + sx) * 4, 4, block + (y*4 + x) * 4 );
+				}
+			}
+
+			encode_bc7_block( block, aOut.subspan( (by * blocksX + bx) * kBc7BlockBytes ).first<kBc7BlockBytes>() );
+		}
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef BC7_HPP_5D8B2F7E_1A43_4C96_8E0D_B37A92C64E15
+#define BC7_HPP_5D8B2F7E_1A43_4C96_8E0D_B37A92C64E15
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+
+/* BC7 block compression
+ *
+ * BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM and its sRGB variant, core since
+ * OpenGL 4.2) stores each 4x4 block of RGBA8 pixels in 16 bytes, i.e., a
+ * quarter of the uncompressed size.
+ *
+ * The encoder only uses mode 6: a single pair of RGBA endpoints (7 bits per
+ * channel plus one shared low bit per endpoint) and a 4 bit palette index
+ * per pixel. Mode 6 handles smooth natural images, such as the terrain
+ * texture, well and is fast to search. Endpoints are fitted along the
+ * principal axis of the block's colors, refined once by least squares, and
+ * the better of the two fits is kept.
+ *
+ * The encoder works on the stored (e.g., sRGB encoded) values; for sRGB
+ * formats, GL interpolates in the encoded space as well.
+ *
+ * The decoder is mainly meant for testing. It supports mode 6 only and
+ * returns transparent black for blocks in other modes.
+ */
+
+inline constexpr std::size_t kBc7BlockBytes = 16;
+
+void encode_bc7_block( std::span<std::uint8_t const, 64> aRgba, std::span<std::uint8_t, 16> aOut ) noexcept;
+void decode_bc7_block( std::span<std::uint8_t const, 16> aBlock, std::span<std::uint8_t, 64> aRgba ) noexcept;
+
+// Bytes of an aWidth x aHeight image in BC7
+constexpr
+std::size_t bc7_size( std::size_t aWidth, std::size_t aHeight ) noexcept
+{
+	return (aWidth + 3) / 4 * ((aHeight + 3) / 4) * kBc7BlockBytes;
+}
+
+// Encodes the block rows [aBlockRowBegin, aBlockRowEnd) of an RGBA8 image
+// with tightly packed rows. aOut receives the whole image (bc7_size() bytes,
+// blocks in row major order), of which only the given block rows are
+// written, so that rows can be split across threads. Blocks that extend past
+// the edge of the image repeat its last row and column.
+void encode_bc7(
+	std::span<std::uint8_t const> aRgba,
+	std::size_t aWidth,
+	std::size_t aHeight,
+	std::span<std::uint8_t> aOut,
+	std::size_t aBlockRowBegin,
+	std::size_t aBlockRowEnd
+) noexcept;
+
+#endif // BC7_HPP_5D8B2F7E_1A43_4C96_8E0D_B37A92C64E15
@@ -0,0 +1,143 @@
+#ifndef BOUNDS_HPP_4BD69A18_75F9_41E7_B8FF_D8D0332C8B9B
+#define BOUNDS_HPP_4BD69A18_75F9_41E7_B8FF_D8D0332C8B9B
+
+#include <span>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "vec3.hpp"
+#include "mat44.hpp"
+
+/* Bounding volumes
+ *
+ * Aabb3f   -- axis aligned box, stored as min and max corners
+ * Spheref  -- sphere, center and radius
+ * Planef   -- plane n.p + d = 0; points with n.p + d >= 0 are on the positive
+ *             ("inside") side. distance() is only a true distance if n has
+ *             unit length.
+ *
+ * See frustum.hpp for culling against a view frustum.
+ */
+struct Aabb3f
+{
+	Vec3f min, max;
+};
+
+struct Spheref
+{
+	Vec3f center;
+	float radius;
+};
+
+struct Planef
+{
+	Vec3f n;
+	float d;
+};
+
+// Empty box: extending it by any point gives a box that contains exactly
+// that point.
+constexpr Aabb3f kEmptyAabb3f = {
+	{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() },
+	{ std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() }
+};
+
+// Functions:
+
+constexpr
+Vec3f center( Aabb3f const& aBox ) noexcept
+{
+	return 0.5f * (aBox.min + aBox.max);
+}
+constexpr
+Vec3f extents( Aabb3f const& aBox ) noexcept
+{
+	return 0.5f * (aBox.max - aBox.min);
+}
+
+constexpr
+Aabb3f extend( Aabb3f const& aBox, Vec3f const& aPoint ) noexcept
+{
+	return Aabb3f{
+		{ std::min( aBox.min.x, aPoint.x ), std::min( aBox.min.y, aPoint.y ), std::min( aBox.min.z, aPoint.z ) },
+		{ std::max( aBox.max.x, aPoint.x ), std::max( aBox.max.y, aPoint.y ), std::max( aBox.max.z, aPoint.z ) }
+	};
+}
+
+// Bounds of a point set. Returns kEmptyAabb3f for an empty set.
+constexpr
+Aabb3f make_aabb( std::span<Vec3f const> aPoints ) noexcept
+{
+	Aabb3f ret = kEmptyAabb3f;
+	for( auto const& p : aPoints )
+		ret = extend( ret, p );
+	return ret;
+}
+
+// Box that encloses aBox after transforming it by the affine aTransform
+// (Arvo's method: the new extents are |M| * extents).
+inline
+Aabb3f transform( Mat44f const& aTransform, Aabb3f const& aBox ) noexcept
+{
+	Vec3f const c = center( aBox );
+	Vec3f const e = extents( aBox );
+
+	Vec3f nc, ne;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		nc[i] = aTransform[i,0]*c.x + aTransform[i,1]*c.y + aTransform[i,2]*c.z + aTransform[i,3];
+		ne[i] = std::abs( aTransform[i,0] )*e.x + std::abs( aTransform[i,1] )*e.y + std::abs( aTransform[i,2] )*e.z;
+	}
+
+	return Aabb3f{ nc - ne, nc + ne };
+}
+
+// Smallest sphere centered on the box center that contains the box.
+inline
+Spheref bounding_sphere( Aabb3f const& aBox ) noexcept
+{
+	return Spheref{ center( aBox ), length( extents( aBox ) ) };
+}
+
+// Plane through aPoint with normal aNormal (normalized here).
+inline
+Planef make_plane( Vec3f const& aNormal, Vec3f const& aPoint ) noexcept
+{
+	Vec3f const n = normalize( aNormal );
+	return Planef{ n, -dot( n, aPoint ) };
+}
+
+// Scales the plane equation so that n has unit length.
+inline
+Planef normalize( Planef const& aPlane ) noexcept
+{
+	float const rl = 1.f / length( aPlane.n );
+	return Planef{ aPlane.n * rl, aPlane.d * rl };
+}
+
+constexpr
+float distance( Planef const& aPlane, Vec3f const& aPoint ) noexcept
+{
+	return dot( aPlane.n, aPoint ) + aPlane.d;
+}
+
+constexpr
+bool contains( Aabb3f const& aBox, Vec3f const& aPoint ) noexcept
+{
+	return aPoint.x >= aBox.min.x && aPoint.x <= aBox.max.x
+		&& aPoint.y >= aBox.min.y && aPoint.y <= aBox.max.y
+		&& aPoint.z >= aBox.min.z && aPoint.z <= aBox.max.z
+	;
+}
+
+constexpr
+bool overlaps( Aabb3f const& aA, Aabb3f const& aB ) noexcept
+{
+	return aA.min.x <= aB.max.x && aA.max.x >= aB.min.x
+		&& aA.min.y <= aB.max.y && aA.max.y >= aB.min.y
+		&& aA.min.z <= aB.max.z && aA.max.z >= aB.min.z
+	;
+}
+
+#endif // BOUNDS_HPP_4BD69A18_75F9_41E7_B8FF_D8D0332C8B9B
@@ -0,0 +1,373 @@
+#ifndef COLUMN_MAJOR_HPP_058507ED_DB5C_410E_94CD_6B40D41A7C9C
+#define COLUMN_MAJOR_HPP_058507ED_DB5C_410E_94CD_6B40D41A7C9C
+
+#include <bit>
+#include <span>
+#include <cmath>
+#include <type_traits>
+
+#include "simd.hpp"
+#include "vec4.hpp"
+#include "quat.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/* Column-major matrices (GPU layout)
+ *
+ * Mat44f and Mat33f are stored in row-major order, which means that they
+ * must be uploaded with transpose = GL_TRUE. Mat44fCM and Mat33fCM hold the
+ * same matrices in column-major order, i.e., the layout that OpenGL/GLSL
+ * expect by default. Their v[] can be passed with transpose = GL_FALSE or
+ * memcpy()'d straight into uniform/storage buffers (for a std140 mat3, each
+ * column must be padded to four floats; see to_std140()).
+ *
+ * Element access with operator[] uses the same (row, column) convention as
+ * Mat44f, so code written against the accessors works with either layout:
+ *
+ *    Mat44fCM m = to_column_major( make_translation( { 1.f, 2.f, 3.f } ) );
+ *    float tx = m[0,3]; // 1.f, stored in m.v[12]
+ *
+ * The column-major storage of M is the row-major storage of transpose(M).
+ * The operators below use this to reuse the Mat44f kernels (including the
+ * SIMD ones) without any transposes, e.g., (A*B)ᵀ = BᵀAᵀ.
+ *
+ * The make_*_cm() functions build the matrices of their make_*()
+ * counterparts directly in column-major storage, so matrices that are only
+ * uploaded never exist in row-major form. The draw code builds its MVP,
+ * model and normal matrices this way and uploads them with transpose =
+ * GL_FALSE. to_column_major() is for matrices that are also needed on the
+ * CPU side in Mat44f form.
+ */
+struct Mat44fCM
+{
+	float v[16];
+
+	constexpr
+	float& operator[] (std::size_t aI, std::size_t aJ) noexcept
+	{
+		assert( aI < 4 && aJ < 4 );
+		return v[aJ*4 + aI];
+	}
+	constexpr
+	float const& operator[] (std::size_t aI, std::size_t aJ) const noexcept
+	{
+		assert( aI < 4 && aJ < 4 );
+		return v[aJ*4 + aI];
+	}
+};
+
+struct Mat33fCM
+{
+	float v[9];
+
+	constexpr
+	float& operator[] (std::size_t aI, std::size_t aJ) noexcept
+	{
+		assert( aI < 3 && aJ < 3 );
+		return v[aJ*3 + aI];
+	}
+	constexpr
+	float const& operator[] (std::size_t aI, std::size_t aJ) const noexcept
+	{
+		assert( aI < 3 && aJ < 3 );
+		return v[aJ*3 + aI];
+	}
+};
+
+// Padded 3x3 matrix, as laid out for a mat3 in a std140 uniform block.
+struct Mat33fStd140
+{
+	float v[12];
+};
+
+static_assert( sizeof(Mat44fCM) == 16*sizeof(float) && std::is_trivially_copyable_v<Mat44fCM> );
+static_assert( sizeof(Mat33fCM) == 9*sizeof(float) && std::is_trivially_copyable_v<Mat33fCM> );
+static_assert( sizeof(Mat44fCM) == sizeof(Mat44f) );
+
+// Identity matrix
+constexpr Mat44fCM kIdentity44fCM = std::bit_cast<Mat44fCM>( kIdentity44f );
+
+namespace detail
+{
+	// Reinterprets the storage: the result is the transpose of the argument.
+	constexpr
+	Mat44f transposed_view( Mat44fCM const& aM ) noexcept
+	{
+		return std::bit_cast<Mat44f>( aM );
+	}
+	constexpr
+	Mat44fCM transposed_view( Mat44f const& aM ) noexcept
+	{
+		return std::bit_cast<Mat44fCM>( aM );
+	}
+
+	constexpr
+	Mat33f transposed_view( Mat33fCM const& aM ) noexcept
+	{
+		return std::bit_cast<Mat33f>( aM );
+	}
+	constexpr
+	Mat33fCM transposed_view( Mat33f const& aM ) noexcept
+	{
+		return std::bit_cast<Mat33fCM>( aM );
+	}
+}
+
+// Conversions:
+
+constexpr
+Mat44fCM to_column_major( Mat44f const& aM ) noexcept
+{
+#	if VMLIB_CONF_SIMD
+	if !consteval
+	{
+		__m128 r0 = _mm_loadu_ps( aM.v+0 );
+		__m128 r1 = _mm_loadu_ps( aM.v+4 );
+		__m128 r2 = _mm_loadu_ps( aM.v+8 );
+		__m128 r3 = _mm_loadu_ps( aM.v+12 );
+
+		_MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+		Mat44fCM ret;
+		_mm_storeu_ps( ret.v+0, r0 );
+		_mm_storeu_ps( ret.v+4, r1 );
+		_mm_storeu_ps( ret.v+8, r2 );
+		_mm_storeu_ps( ret.v+12, r3 );
+		return ret;
+	}
+#	endif // ~ SIMD
+
+	Mat44fCM ret;
+	for( std::size_t i = 0; i < 4; ++i )
+	{
+		for( std::size_t j = 0; j < 4; ++j )
+			ret[i,j] = aM[i,j];
+	}
+	return ret;
+}
+
+constexpr
+Mat44f to_row_major( Mat44fCM const& aM ) noexcept
+{
+	// Transposing is its own inverse.
+	return detail::transposed_view( to_column_major( detail::transposed_view( aM ) ) );
+}
+
+constexpr
+Mat33fCM to_column_major( Mat33f const& aM ) noexcept
+{
+	Mat33fCM ret;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			ret[i,j] = aM[i,j];
+	}
+	return ret;
+}
+
+constexpr
+Mat33f to_row_major( Mat33fCM const& aM ) noexcept
+{
+	Mat33f ret;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			ret[i,j] = aM[i,j];
+	}
+	return ret;
+}
+
+constexpr
+Mat33fStd140 to_std140( Mat33fCM const& aM ) noexcept
+{
+	Mat33fStd140 ret = {};
+	for( std::size_t c = 0; c < 3; ++c )
+	{
+		for( std::size_t r = 0; r < 3; ++r )
+			ret.v[c*4 + r] = aM[r,c];
+	}
+	return ret;
+}
+
+// Common operators for Mat44fCM.
+
+constexpr
+Mat44fCM operator*( Mat44fCM const& aLeft, Mat44fCM const& aRight ) noexcept
+{
+	// (AB)ᵀ = BᵀAᵀ
+	return detail::transposed_view( detail::transposed_view( aRight ) * detail::transposed_view( aLeft ) );
+}
+
+constexpr
+Vec4f operator*( Mat44fCM const& aLeft, Vec4f const& aRight ) noexcept
+{
+#	if VMLIB_CONF_SIMD
+	if !consteval
+	{
+		// Linear combination of the columns
+		using detail::madd;
+		__m128 acc = _mm_mul_ps( _mm_loadu_ps( aLeft.v+0 ), _mm_set1_ps( aRight.x ) );
+		acc = madd( _mm_loadu_ps( aLeft.v+4 ), _mm_set1_ps( aRight.y ), acc );
+		acc = madd( _mm_loadu_ps( aLeft.v+8 ), _mm_set1_ps( aRight.z ), acc );
+		acc = madd( _mm_loadu_ps( aLeft.v+12 ), _mm_set1_ps( aRight.w ), acc );
+
+		Vec4f result;
+		_mm_storeu_ps( &result.x, acc );
+		return result;
+	}
+#	endif // ~ SIMD
+
+	auto const row = [&] (std::size_t aR) {
+		return aLeft[aR,0]*aRight.x + aLeft[aR,1]*aRight.y + aLeft[aR,2]*aRight.z + aLeft[aR,3]*aRight.w;
+	};
+	return Vec4f{ row( 0 ), row( 1 ), row( 2 ), row( 3 ) };
+}
+
+// Functions:
+
+constexpr
+Mat44fCM transpose( Mat44fCM const& aM ) noexcept
+{
+	return detail::transposed_view( to_row_major( aM ) );
+}
+
+// (Aᵀ)⁻¹ = (A⁻¹)ᵀ, so the storage can be inverted as-is.
+inline
+Mat44fCM invert( Mat44fCM const& aM ) noexcept
+{
+	return detail::transposed_view( invert( detail::transposed_view( aM ) ) );
+}
+
+// Same for the normal matrix (see normal_matrix( Mat44f const& )): the
+// cofactors of Aᵀ are the transposed cofactors of A.
+inline
+Mat33fCM normal_matrix( Mat44fCM const& aM ) noexcept
+{
+	return detail::transposed_view( normal_matrix( detail::transposed_view( aM ) ) );
+}
+
+// Batched product with a shared left operand, see mul_batch() in mat44.hpp.
+inline
+void mul_batch( Mat44fCM const& aLeft, std::span<Mat44fCM const> aRight, std::span<Mat44fCM> aOut ) noexcept
+{
+	assert( aOut.size() >= aRight.size() );
+
+	// (AB)ᵀ = BᵀAᵀ, so the shared operand ends up on the right.
+	Mat44f const left = detail::transposed_view( aLeft );
+	for( std::size_t i = 0; i < aRight.size(); ++i )
+		aOut[i] = detail::transposed_view( detail::transposed_view( aRight[i] ) * left );
+}
+
+// Construction. Each function returns the same matrix as its make_*()
+// counterpart in mat44.hpp/quat.hpp, written straight into column-major
+// storage.
+
+inline
+Mat44fCM make_rotation_x_cm( float aAngle ) noexcept
+{
+	Mat44fCM m = kIdentity44fCM;
+	float c = std::cos(aAngle);
+	float s = std::sin(aAngle);
+
+	m[1,1] = c;
+	m[1,2] = -s;
+	m[2,1] = s;
+	m[2,2] = c;
+
+	return m;
+}
+
+inline
+Mat44fCM make_rotation_y_cm( float aAngle ) noexcept
+{
+	Mat44fCM m = kIdentity44fCM;
+	float c = std::cos(aAngle);
+	float s = std::sin(aAngle);
+
+	m[0,0] = c;
+	m[0,2] = s;
+	m[2,0] = -s;
+	m[2,2] = c;
+
+	return m;
+}
+
+inline
+Mat44fCM make_rotation_z_cm( float aAngle ) noexcept
+{
+	Mat44fCM m = kIdentity44fCM;
+	float c = std::cos(aAngle);
+	float s = std::sin(aAngle);
+
+	m[0,0] = c;
+	m[0,1] = -s;
+	m[1,0] = s;
+	m[1,1] = c;
+
+	return m;
+}
+
+constexpr
+Mat44fCM make_translation_cm( Vec3f aTranslation ) noexcept
+{
+	Mat44fCM m = kIdentity44fCM;
+	m[0,3] = aTranslation.x;
+	m[1,3] = aTranslation.y;
+	m[2,3] = aTranslation.z;
+	return m;
+}
+
+constexpr
+Mat44fCM make_scaling_cm( float aSX, float aSY, float aSZ ) noexcept
+{
+	Mat44fCM m = kIdentity44fCM;
+	m[0,0] = aSX;
+	m[1,1] = aSY;
+	m[2,2] = aSZ;
+	return m;
+}
+
+inline
+Mat44fCM make_perspective_projection_cm( float aFovInRadians, float aAspect, float aNear, float aFar ) noexcept
+{
+	Mat44fCM m = { 0.f };
+
+	float tanHalfFov = std::tan(aFovInRadians / 2.f);
+	float s = 1.f / tanHalfFov;
+
+	m[0,0] = s / aAspect;
+	m[1,1] = s;
+	m[2,2] = -(aFar + aNear) / (aFar - aNear);
+	m[2,3] = -(2.f * aFar * aNear) / (aFar - aNear);
+	m[3,2] = -1.f;
+
+	return m;
+}
+
+inline
+Mat44fCM construct_camera_view_cm( Vec3f const& aForward, Vec3f const& aUp, Vec3f const& aRight, Vec3f const& aPosition ) noexcept
+{
+	// One column per line
+	return Mat44fCM{ {
+		aRight.x,                  aUp.x,                  -aForward.x,                0.f,
+		aRight.y,                  aUp.y,                  -aForward.y,                0.f,
+		aRight.z,                  aUp.z,                  -aForward.z,                0.f,
+		-dot( aRight, aPosition ), -dot( aUp, aPosition ), dot( aForward, aPosition ), 1.f
+	} };
+}
+
+inline
+Mat44fCM make_trs_cm( Vec3f const& aT, Quatf const& aR, Vec3f const& aS ) noexcept
+{
+	Mat33f const r = quat_to_mat33( aR );
+
+	// One column per line
+	return Mat44fCM{ {
+		r[0,0]*aS.x, r[1,0]*aS.x, r[2,0]*aS.x, 0.f,
+		r[0,1]*aS.y, r[1,1]*aS.y, r[2,1]*aS.y, 0.f,
+		r[0,2]*aS.z, r[1,2]*aS.z, r[2,2]*aS.z, 0.f,
+		aT.x,        aT.y,        aT.z,        1.f
+	} };
+}
+
+#endif // COLUMN_MAJOR_HPP_058507ED_DB5C_410E_94CD_6B40D41A7C9C
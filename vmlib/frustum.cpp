@@ -0,0 +1,176 @@
+#include "frustum.hpp"
+
+#include "simd.hpp"
+
+namespace
+{
+	// The SIMD paths treat arrays of Aabb3f as flat arrays of six floats.
+	static_assert( sizeof(Aabb3f) == 6*sizeof(float) );
+
+#	if VMLIB_CONF_SIMD
+	template< typename tReg > tReg splat_( float ) noexcept;
+
+	template<> inline
+	__m128 splat_<__m128>( float aV ) noexcept { return _mm_set1_ps( aV ); }
+
+	inline __m128 add_( __m128 aA, __m128 aB ) noexcept { return _mm_add_ps( aA, aB ); }
+	inline __m128 sub_( __m128 aA, __m128 aB ) noexcept { return _mm_sub_ps( aA, aB ); }
+	inline __m128 mul_( __m128 aA, __m128 aB ) noexcept { return _mm_mul_ps( aA, aB ); }
+	inline __m128 or_( __m128 aA, __m128 aB ) noexcept { return _mm_or_ps( aA, aB ); }
+	inline __m128 less_( __m128 aA, __m128 aB ) noexcept { return _mm_cmplt_ps( aA, aB ); }
+	inline unsigned mask_( __m128 aA ) noexcept { return unsigned(_mm_movemask_ps( aA )); }
+
+	// Loads four boxes and transposes them into one register per component.
+	// Each box is read as two overlapping groups of four floats,
+	//   a = minx miny minz maxx,  b = minz maxx maxy maxz
+	// which are transposed separately.
+	inline
+	void load4_soa_( float const* aSrc, __m128 (&aMin)[3], __m128 (&aMax)[3] ) noexcept
+	{
+		__m128 a0 = _mm_loadu_ps( aSrc+0 ),  b0 = _mm_loadu_ps( aSrc+2 );
+		__m128 a1 = _mm_loadu_ps( aSrc+6 ),  b1 = _mm_loadu_ps( aSrc+8 );
+		__m128 a2 = _mm_loadu_ps( aSrc+12 ), b2 = _mm_loadu_ps( aSrc+14 );
+		__m128 a3 = _mm_loadu_ps( aSrc+18 ), b3 = _mm_loadu_ps( aSrc+20 );
+
+		_MM_TRANSPOSE4_PS( a0, a1, a2, a3 );
+		_MM_TRANSPOSE4_PS( b0, b1, b2, b3 );
+
+		aMin[0] = a0; aMin[1] = a1; aMin[2] = a2;
+		aMax[0] = b1; aMax[1] = b2; aMax[2] = b3;
+	}
+
+#	if VMLIB_CONF_SIMD >= 2
+	template<> inline
+	__m256 splat_<__m256>( float aV ) noexcept { return _mm256_set1_ps( aV ); }
+
+	inline __m256 add_( __m256 aA, __m256 aB ) noexcept { return _mm256_add_ps( aA, aB ); }
+	inline __m256 sub_( __m256 aA, __m256 aB ) noexcept { return _mm256_sub_ps( aA, aB ); }
+	inline __m256 mul_( __m256 aA, __m256 aB ) noexcept { return _mm256_mul_ps( aA, aB ); }
+	inline __m256 or_( __m256 aA, __m256 aB ) noexcept { return _mm256_or_ps( aA, aB ); }
+	inline __m256 less_( __m256 aA, __m256 aB ) noexcept { return _mm256_cmp_ps( aA, aB, _CMP_LT_OQ ); }
+	inline unsigned mask_( __m256 aA ) noexcept { return unsigned(_mm256_movemask_ps( aA )); }
+
+	// Eight boxes, as two groups of four.
+	inline
+	void load8_soa_( float const* aSrc, __m256 (&aMin)[3], __m256 (&aMax)[3] ) noexcept
+	{
+		__m128 min0[3], max0[3], min1[3], max1[3];
+		load4_soa_( aSrc+0, min0, max0 );
+		load4_soa_( aSrc+24, min1, max1 );
+
+		for( std::size_t i = 0; i < 3; ++i )
+		{
+			aMin[i] = _mm256_set_m128( min1[i], min0[i] );
+			aMax[i] = _mm256_set_m128( max1[i], max0[i] );
+		}
+	}
+#	endif // ~ SIMD >= 2
+
+	// Plane equations, one element per register: nx ny nz d |nx| |ny| |nz|
+	template< typename tReg > inline
+	void splat_planes_( Frustumf const& aFrustum, tReg (&aOut)[Frustumf::kPlaneCount][7] ) noexcept
+	{
+		for( std::size_t i = 0; i < Frustumf::kPlaneCount; ++i )
+		{
+			Planef const& pl = aFrustum.planes[i];
+			aOut[i][0] = splat_<tReg>( pl.n.x );
+			aOut[i][1] = splat_<tReg>( pl.n.y );
+			aOut[i][2] = splat_<tReg>( pl.n.z );
+			aOut[i][3] = splat_<tReg>( pl.d );
+			aOut[i][4] = splat_<tReg>( std::abs( pl.n.x ) );
+			aOut[i][5] = splat_<tReg>( std::abs( pl.n.y ) );
+			aOut[i][6] = splat_<tReg>( std::abs( pl.n.z ) );
+		}
+	}
+
+	// Returns a bit mask with one bit per box, set if the box is culled.
+	template< typename tReg > inline
+	unsigned outside_( tReg const (&aPlanes)[Frustumf::kPlaneCount][7], tReg const (&aMin)[3], tReg const (&aMax)[3] ) noexcept
+	{
+		using detail::madd;
+
+		tReg const half = splat_<tReg>( 0.5f );
+		tReg const zero = splat_<tReg>( 0.f );
+
+		tReg c[3], e[3];
+		for( std::size_t i = 0; i < 3; ++i )
+		{
+			c[i] = mul_( half, add_( aMin[i], aMax[i] ) );
+			e[i] = mul_( half, sub_( aMax[i], aMin[i] ) );
+		}
+
+		tReg out = less_( zero, zero );
+		for( auto const& p : aPlanes )
+		{
+			tReg const dist = madd( p[0], c[0], madd( p[1], c[1], madd( p[2], c[2], p[3] ) ) );
+			tReg const rad = madd( p[4], e[0], madd( p[5], e[1], mul_( p[6], e[2] ) ) );
+			out = or_( out, less_( add_( dist, rad ), zero ) );
+		}
+
+		return mask_( out );
+	}
+
+	template< std::size_t tN > inline
+	std::size_t write_mask_( unsigned aOutside, std::uint8_t* aVisible ) noexcept
+	{
+		std::size_t count = 0;
+		for( std::size_t k = 0; k < tN; ++k )
+		{
+			std::uint8_t const vis = std::uint8_t(~(aOutside >> k) & 1u);
+			aVisible[k] = vis;
+			count += vis;
+		}
+		return count;
+	}
+#	endif // ~ SIMD
+}
+
+std::size_t cull_aabbs( Frustumf const& aFrustum, std::span<Aabb3f const> aBoxes, std::span<std::uint8_t> aVisible ) noexcept
+{
+	assert( aVisible.size() >= aBoxes.size() );
+
+	std::size_t const count = aBoxes.size();
+	std::size_t visible = 0;
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	auto const* src = reinterpret_cast<float const*>( aBoxes.data() );
+
+#	if VMLIB_CONF_SIMD >= 2
+	if( i + 8 <= count )
+	{
+		__m256 planes[Frustumf::kPlaneCount][7];
+		splat_planes_( aFrustum, planes );
+
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m256 mn[3], mx[3];
+			load8_soa_( src + 6*i, mn, mx );
+			visible += write_mask_<8>( outside_( planes, mn, mx ), aVisible.data() + i );
+		}
+	}
+#	endif // ~ SIMD >= 2
+
+	if( i + 4 <= count )
+	{
+		__m128 planes[Frustumf::kPlaneCount][7];
+		splat_planes_( aFrustum, planes );
+
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128 mn[3], mx[3];
+			load4_soa_( src + 6*i, mn, mx );
+			visible += write_mask_<4>( outside_( planes, mn, mx ), aVisible.data() + i );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+	{
+		bool const vis = intersects( aFrustum, aBoxes[i] );
+		aVisible[i] = vis ? 1 : 0;
+		visible += vis;
+	}
+
+	return visible;
+}
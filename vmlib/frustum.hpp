@@ -0,0 +1,109 @@
+#ifndef FRUSTUM_HPP_203D1284_B0EF_4DA0_A9E9_4ECC15FD41D4
+#define FRUSTUM_HPP_203D1284_B0EF_4DA0_A9E9_4ECC15FD41D4
+
+#include <span>
+#include <cstdint>
+
+#include "vec3.hpp"
+#include "mat44.hpp"
+#include "bounds.hpp"
+
+/* Frustumf: view frustum as six planes
+ *
+ * The planes are extracted from a combined projection * view matrix (Gribb &
+ * Hartmann), so the frustum is in world space. With a projection * view *
+ * model matrix, it is in the model's local space instead. The plane normals
+ * point inwards and are normalized.
+ *
+ * The tests below are conservative: an object is only rejected if it lies
+ * entirely on the outside of one of the planes. Large objects near the
+ * corners of the frustum may therefore be reported as visible.
+ */
+struct Frustumf
+{
+	enum Plane
+	{
+		eLeft, eRight, eBottom, eTop, eNear, eFar,
+		kPlaneCount
+	};
+
+	Planef planes[kPlaneCount];
+};
+
+// Functions:
+
+// Assumes OpenGL clip space conventions, i.e., -w <= z <= w (see
+// make_perspective_projection()).
+inline
+Frustumf make_frustum( Mat44f const& aProjView ) noexcept
+{
+	auto const row = [&] (std::size_t aR) {
+		return Planef{ { aProjView[aR,0], aProjView[aR,1], aProjView[aR,2] }, aProjView[aR,3] };
+	};
+	auto const add = [] (Planef const& aA, Planef const& aB) {
+		return normalize( Planef{ aA.n + aB.n, aA.d + aB.d } );
+	};
+	auto const sub = [] (Planef const& aA, Planef const& aB) {
+		return normalize( Planef{ aA.n - aB.n, aA.d - aB.d } );
+	};
+
+	Planef const r0 = row( 0 ), r1 = row( 1 ), r2 = row( 2 ), r3 = row( 3 );
+
+	Frustumf ret;
+	ret.planes[Frustumf::eLeft] = add( r3, r0 );
+	ret.planes[Frustumf::eRight] = sub( r3, r0 );
+	ret.planes[Frustumf::eBottom] = add( r3, r1 );
+	ret.planes[Frustumf::eTop] = sub( r3, r1 );
+	ret.planes[Frustumf::eNear] = add( r3, r2 );
+	ret.planes[Frustumf::eFar] = sub( r3, r2 );
+	return ret;
+}
+
+constexpr
+bool contains( Frustumf const& aFrustum, Vec3f const& aPoint ) noexcept
+{
+	for( auto const& plane : aFrustum.planes )
+	{
+		if( distance( plane, aPoint ) < 0.f )
+			return false;
+	}
+	return true;
+}
+
+inline
+bool intersects( Frustumf const& aFrustum, Spheref const& aSphere ) noexcept
+{
+	for( auto const& plane : aFrustum.planes )
+	{
+		if( distance( plane, aSphere.center ) < -aSphere.radius )
+			return false;
+	}
+	return true;
+}
+
+// Per plane, compares the distance of the box center to the box' projected
+// radius, |n| . extents.
+inline
+bool intersects( Frustumf const& aFrustum, Aabb3f const& aBox ) noexcept
+{
+	Vec3f const c = center( aBox );
+	Vec3f const e = extents( aBox );
+
+	for( auto const& plane : aFrustum.planes )
+	{
+		float const r = std::abs( plane.n.x )*e.x + std::abs( plane.n.y )*e.y + std::abs( plane.n.z )*e.z;
+		if( distance( plane, c ) + r < 0.f )
+			return false;
+	}
+	return true;
+}
+
+// Tests many boxes at once. Writes 1 (potentially visible) or 0 (culled) to
+// aVisible for each box and returns the number of potentially visible boxes.
+// Results are identical to calling intersects() for each box, up to rounding.
+//
+// With a SIMD backend (see simd.hpp), 4 (SSE) or 8 (AVX2) boxes are tested
+// against all six planes per iteration.
+std::size_t cull_aabbs( Frustumf const& aFrustum, std::span<Aabb3f const> aBoxes, std::span<std::uint8_t> aVisible ) noexcept;
+
+#endif // FRUSTUM_HPP_203D1284_B0EF_4DA0_A9E9_4ECC15FD41D4
@@ -84,4 +84,31 @@ Mat33f mat44_to_mat33( Mat44f const& aM )
 	return ret;
 }
 
+// Normal matrix, i.e., the upper 3x3 block of transpose(invert(aM)).
+//
+// The inverse transpose of a 3x3 matrix is its cofactor matrix divided by
+// its determinant, so there is no need to invert the full 4x4 matrix (which
+// is what mat44_to_mat33(transpose(invert(aM))) does). The translation does
+// not affect the result.
+inline
+Mat33f normal_matrix( Mat44f const& aM ) noexcept
+{
+	Mat33f ret;
+	ret[0,0] = aM[1,1]*aM[2,2] - aM[1,2]*aM[2,1];
+	ret[0,1] = aM[1,2]*aM[2,0] - aM[1,0]*aM[2,2];
+	ret[0,2] = aM[1,0]*aM[2,1] - aM[1,1]*aM[2,0];
+	ret[1,0] = aM[0,2]*aM[2,1] - aM[0,1]*aM[2,2];
+	ret[1,1] = aM[0,0]*aM[2,2] - aM[0,2]*aM[2,0];
+	ret[1,2] = aM[0,1]*aM[2,0] - aM[0,0]*aM[2,1];
+	ret[2,0] = aM[0,1]*aM[1,2] - aM[0,2]*aM[1,1];
+	ret[2,1] = aM[0,2]*aM[1,0] - aM[0,0]*aM[1,2];
+	ret[2,2] = aM[0,0]*aM[1,1] - aM[0,1]*aM[1,0];
+
+	float const rd = 1.f / (aM[0,0]*ret[0,0] + aM[0,1]*ret[0,1] + aM[0,2]*ret[0,2]);
+	for( auto& v : ret.v )
+		v *= rd;
+
+	return ret;
+}
+
 #endif // MAT33_HPP_61F3107B_CBE4_48DE_9F39_EA959B4BF694
@@ -6,6 +6,9 @@
 #include <cassert>
 #include <cstdlib>
 
+#include <span>
+
+#include "simd.hpp"
 #include "vec3.hpp"
 #include "vec4.hpp"
 
@@ -56,45 +59,210 @@ constexpr Mat44f kIdentity44f = { {
 	0.f, 0.f, 0.f, 1.f
 } };
 
-// Common operators for Mat44f.
-// Note that you will need to implement these yourself.
-
-constexpr
-Mat44f operator*( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
+// Kernels used to implement the operators. The scalar versions are always
+// available (and are the ones used in constant evaluation). The SIMD versions
+// are only compiled when VMLIB_CONF_SIMD selects a backend (see simd.hpp).
+namespace detail
 {
-	Mat44f result = { 0.f };
-
-	// Standard Matrix Multiplication: Row of Left * Column of Right
-	for (std::size_t r = 0; r < 4; ++r)
+	constexpr
+	Mat44f mul_scalar( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
 	{
-		for (std::size_t c = 0; c < 4; ++c)
+		Mat44f result = { 0.f };
+
+		// Standard Matrix Multiplication: Row of Left * Column of Right
+		for (std::size_t r = 0; r < 4; ++r)
 		{
-			float sum = 0.f;
-			for (std::size_t k = 0; k < 4; ++k)
+			for (std::size_t c = 0; c < 4; ++c)
 			{
-				sum += aLeft[r, k] * aRight[k, c];
+				float sum = 0.f;
+				for (std::size_t k = 0; k < 4; ++k)
+				{
+					sum += aLeft[r, k] * aRight[k, c];
+				}
+				result[r, c] = sum;
 			}
-			result[r, c] = sum;
 		}
+		return result;
+	}
+
+	constexpr
+	Vec4f mul_scalar( Mat44f const& aLeft, Vec4f const& aRight ) noexcept
+	{
+		return Vec4f{
+			aLeft[0,0] * aRight.x + aLeft[0,1] * aRight.y + aLeft[0,2] * aRight.z + aLeft[0,3] * aRight.w,
+			aLeft[1,0] * aRight.x + aLeft[1,1] * aRight.y + aLeft[1,2] * aRight.z + aLeft[1,3] * aRight.w,
+			aLeft[2,0] * aRight.x + aLeft[2,1] * aRight.y + aLeft[2,2] * aRight.z + aLeft[2,3] * aRight.w,
+			aLeft[3,0] * aRight.x + aLeft[3,1] * aRight.y + aLeft[3,2] * aRight.z + aLeft[3,3] * aRight.w
+		};
+	}
+
+	Mat44f invert_scalar( Mat44f const& aM ) noexcept;
+
+#	if VMLIB_CONF_SIMD
+	// Row r of the result is a linear combination of the rows of aRight,
+	// weighted by the elements of row r of aLeft.
+	inline
+	Mat44f mul_simd( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
+	{
+		Mat44f result;
+#		if VMLIB_CONF_SIMD >= 2
+		// AVX2: two rows of the result per iteration.
+		__m256 const r0 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v+0) );
+		__m256 const r1 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v+4) );
+		__m256 const r2 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v+8) );
+		__m256 const r3 = _mm256_broadcast_ps( reinterpret_cast<__m128 const*>(aRight.v+12) );
+
+		for( std::size_t i = 0; i < 16; i += 8 )
+		{
+			__m256 const l = _mm256_loadu_ps( aLeft.v+i );
+
+			__m256 acc = _mm256_mul_ps( _mm256_shuffle_ps( l, l, 0x00 ), r0 );
+			acc = madd( _mm256_shuffle_ps( l, l, 0x55 ), r1, acc );
+			acc = madd( _mm256_shuffle_ps( l, l, 0xaa ), r2, acc );
+			acc = madd( _mm256_shuffle_ps( l, l, 0xff ), r3, acc );
+
+			_mm256_storeu_ps( result.v+i, acc );
+		}
+#		else // SSE
+		__m128 const r0 = _mm_loadu_ps( aRight.v+0 );
+		__m128 const r1 = _mm_loadu_ps( aRight.v+4 );
+		__m128 const r2 = _mm_loadu_ps( aRight.v+8 );
+		__m128 const r3 = _mm_loadu_ps( aRight.v+12 );
+
+		for( std::size_t i = 0; i < 16; i += 4 )
+		{
+			__m128 const l = _mm_loadu_ps( aLeft.v+i );
+
+			__m128 acc = _mm_mul_ps( _mm_shuffle_ps( l, l, 0x00 ), r0 );
+			acc = madd( _mm_shuffle_ps( l, l, 0x55 ), r1, acc );
+			acc = madd( _mm_shuffle_ps( l, l, 0xaa ), r2, acc );
+			acc = madd( _mm_shuffle_ps( l, l, 0xff ), r3, acc );
+
+			_mm_storeu_ps( result.v+i, acc );
+		}
+#		endif // ~ SIMD >= 2
+		return result;
+	}
+
+	// Four row-vector dot products. The products are transposed so that the
+	// final horizontal sums become three vertical adds (SSE2 only, no hadd).
+	inline
+	Vec4f mul_simd( Mat44f const& aLeft, Vec4f const& aRight ) noexcept
+	{
+		__m128 const v = _mm_loadu_ps( &aRight.x );
+
+		__m128 p0 = _mm_mul_ps( _mm_loadu_ps( aLeft.v+0 ), v );
+		__m128 p1 = _mm_mul_ps( _mm_loadu_ps( aLeft.v+4 ), v );
+		__m128 p2 = _mm_mul_ps( _mm_loadu_ps( aLeft.v+8 ), v );
+		__m128 p3 = _mm_mul_ps( _mm_loadu_ps( aLeft.v+12 ), v );
+
+		_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+
+		Vec4f result;
+		_mm_storeu_ps( &result.x, _mm_add_ps( _mm_add_ps( p0, p1 ), _mm_add_ps( p2, p3 ) ) );
+		return result;
 	}
-	return result;
+
+	Mat44f invert_simd( Mat44f const& aM ) noexcept;
+#	endif // ~ SIMD
+}
+
+// Common operators for Mat44f.
+
+constexpr
+Mat44f operator*( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
+{
+#	if VMLIB_CONF_SIMD
+	if !consteval
+	{
+		return detail::mul_simd( aLeft, aRight );
+	}
+#	endif // ~ SIMD
+	return detail::mul_scalar( aLeft, aRight );
 }
 
 constexpr
 Vec4f operator*( Mat44f const& aLeft, Vec4f const& aRight ) noexcept
 {
-	return Vec4f{
-		aLeft[0,0] * aRight.x + aLeft[0,1] * aRight.y + aLeft[0,2] * aRight.z + aLeft[0,3] * aRight.w,
-		aLeft[1,0] * aRight.x + aLeft[1,1] * aRight.y + aLeft[1,2] * aRight.z + aLeft[1,3] * aRight.w,
-		aLeft[2,0] * aRight.x + aLeft[2,1] * aRight.y + aLeft[2,2] * aRight.z + aLeft[2,3] * aRight.w,
-		aLeft[3,0] * aRight.x + aLeft[3,1] * aRight.y + aLeft[3,2] * aRight.z + aLeft[3,3] * aRight.w
-	};
+#	if VMLIB_CONF_SIMD
+	if !consteval
+	{
+		return detail::mul_simd( aLeft, aRight );
+	}
+#	endif // ~ SIMD
+	return detail::mul_scalar( aLeft, aRight );
 }
 
 // Functions:
 
 Mat44f invert( Mat44f const& aM ) noexcept;
 
+// Batched versions of the above. These process a whole array in one call,
+// which keeps the kernel and (for the shared-left version) the left operand
+// in registers. aOut must be at least as large as the inputs; it may alias
+// them.
+void mul_batch( std::span<Mat44f const> aLeft, std::span<Mat44f const> aRight, std::span<Mat44f> aOut ) noexcept;
+void mul_batch( Mat44f const& aLeft, std::span<Mat44f const> aRight, std::span<Mat44f> aOut ) noexcept;
+
+// aOut may alias aIn.
+void invert_batch( std::span<Mat44f const> aIn, std::span<Mat44f> aOut ) noexcept;
+
+// Inverse of an affine transform, i.e., a matrix whose last row is (0,0,0,1).
+// This is the case for any combination of make_translation(), make_rotation_*()
+// and make_scaling(). Only the upper 3x3 block needs to be inverted:
+//
+//   ⎛ A  t ⎞-1   ⎛ A⁻¹  -A⁻¹t ⎞
+//   ⎝ 0  1 ⎠   = ⎝ 0     1    ⎠
+//
+inline
+Mat44f invert_affine( Mat44f const& aM ) noexcept
+{
+	assert( (aM[3,0] == 0.f && aM[3,1] == 0.f && aM[3,2] == 0.f && aM[3,3] == 1.f) );
+
+	// Cofactors of the upper 3x3 block
+	float const c00 = aM[1,1]*aM[2,2] - aM[1,2]*aM[2,1];
+	float const c01 = aM[1,2]*aM[2,0] - aM[1,0]*aM[2,2];
+	float const c02 = aM[1,0]*aM[2,1] - aM[1,1]*aM[2,0];
+	float const c10 = aM[0,2]*aM[2,1] - aM[0,1]*aM[2,2];
+	float const c11 = aM[0,0]*aM[2,2] - aM[0,2]*aM[2,0];
+	float const c12 = aM[0,1]*aM[2,0] - aM[0,0]*aM[2,1];
+	float const c20 = aM[0,1]*aM[1,2] - aM[0,2]*aM[1,1];
+	float const c21 = aM[0,2]*aM[1,0] - aM[0,0]*aM[1,2];
+	float const c22 = aM[0,0]*aM[1,1] - aM[0,1]*aM[1,0];
+
+	float const rd = 1.f / (aM[0,0]*c00 + aM[0,1]*c01 + aM[0,2]*c02);
+
+	// A⁻¹ is the transposed cofactor matrix divided by the determinant
+	Mat44f ret = kIdentity44f;
+	ret[0,0] = c00*rd; ret[0,1] = c10*rd; ret[0,2] = c20*rd;
+	ret[1,0] = c01*rd; ret[1,1] = c11*rd; ret[1,2] = c21*rd;
+	ret[2,0] = c02*rd; ret[2,1] = c12*rd; ret[2,2] = c22*rd;
+
+	for( std::size_t i = 0; i < 3; ++i )
+		ret[i,3] = -(ret[i,0]*aM[0,3] + ret[i,1]*aM[1,3] + ret[i,2]*aM[2,3]);
+
+	return ret;
+}
+
+// Inverse of a rigid-body transform (rotation and translation only). The
+// rotation is orthonormal, so its inverse is its transpose. The result is
+// wrong if aM contains scaling or shearing; use invert_affine() then.
+inline
+Mat44f invert_rigid( Mat44f const& aM ) noexcept
+{
+	Mat44f ret = kIdentity44f;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			ret[i,j] = aM[j,i];
+	}
+
+	for( std::size_t i = 0; i < 3; ++i )
+		ret[i,3] = -(ret[i,0]*aM[0,3] + ret[i,1]*aM[1,3] + ret[i,2]*aM[2,3]);
+
+	return ret;
+}
+
 inline
 Mat44f transpose( Mat44f const& aM ) noexcept
 {
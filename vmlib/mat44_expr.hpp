@@ -0,0 +1,236 @@
+#ifndef MAT44_EXPR_HPP_C81F5A2E_3D94_4B07_A6E1_5F2B09C7D386
+#define MAT44_EXPR_HPP_C81F5A2E_3D94_4B07_A6E1_5F2B09C7D386
+
+#include <type_traits>
+
+#include "simd.hpp"
+#include "mat44.hpp"
+
+/* Lazy Mat44f products
+ *
+ * The plain operator* on Mat44f evaluates eagerly, so
+ *
+ *    Mat44f mvp = projection * view * model;
+ *
+ * performs two full 4x4 products (64 multiply-adds each) and creates a
+ * temporary. The expression layer below instead records the chain and
+ * evaluates it when converted to Mat44f. Operands can be tagged as affine
+ * (last row is 0,0,0,1), which is the case for view matrices from
+ * construct_camera_view() and all model matrices built from the make_*()
+ * functions:
+ *
+ *    Mat44f mvp = projection * as_affine( view ) * as_affine( model );
+ *
+ * The chain is evaluated right to left, so runs of affine matrices are
+ * multiplied first with a kernel that skips their known last row. P*V*M
+ * then costs one affine*affine and one general*affine product.
+ *
+ * The two products are deliberately kept separate. Fusing them does not
+ * save any arithmetic: streaming rows of P through V and M takes the same
+ * multiply-adds, and a single triple sum takes more. The intermediate V*M
+ * is three rows that stay in L1 between the two loops.
+ *
+ * Each individual product is bit-identical to operator*; only the
+ * association order differs, i.e., P*(V*M) rather than (P*V)*M.
+ *
+ * Expressions store copies of their operands, but they are still meant to be
+ * converted to Mat44f right away, not stored in "auto" variables.
+ */
+
+template< bool tAffine >
+struct Mat44Leaf
+{
+	Mat44f m;
+};
+
+template< typename tLeft, typename tRight >
+struct Mat44Product;
+
+namespace detail
+{
+	template< typename > struct IsMat44Expr_ : std::false_type {};
+	template< bool tA > struct IsMat44Expr_<Mat44Leaf<tA>> : std::true_type {};
+	template< typename tL, typename tR > struct IsMat44Expr_<Mat44Product<tL,tR>> : std::true_type {};
+}
+
+template< typename tExpr >
+concept Mat44Expr = detail::IsMat44Expr_<tExpr>::value;
+
+namespace detail
+{
+	template< typename > struct IsAffine_;
+	template< bool tA > struct IsAffine_<Mat44Leaf<tA>> : std::bool_constant<tA> {};
+	template< typename tL, typename tR > struct IsAffine_<Mat44Product<tL,tR>>
+		: std::bool_constant<IsAffine_<tL>::value && IsAffine_<tR>::value> {};
+
+	// Product with known structure. If aLeft is affine, its last row is
+	// (0,0,0,1), so the last row of the result is that of aRight. If aRight
+	// is affine, the k=3 term contributes only to the last column.
+	template< bool tLeftAffine, bool tRightAffine > constexpr
+	Mat44f mul_structured( Mat44f const& aLeft, Mat44f const& aRight ) noexcept
+	{
+		constexpr std::size_t rows = tLeftAffine ? 3 : 4;
+
+#		if VMLIB_CONF_SIMD
+		if !consteval
+		{
+			// Same operation order as mul_simd() (SSE variant).
+			__m128 const r0 = _mm_loadu_ps( aRight.v+0 );
+			__m128 const r1 = _mm_loadu_ps( aRight.v+4 );
+			__m128 const r2 = _mm_loadu_ps( aRight.v+8 );
+			__m128 const r3 = tRightAffine ? _mm_setr_ps( 0.f, 0.f, 0.f, 1.f ) : _mm_loadu_ps( aRight.v+12 );
+
+			Mat44f result;
+			for( std::size_t i = 0; i < 4*rows; i += 4 )
+			{
+				__m128 const l = _mm_loadu_ps( aLeft.v+i );
+
+				__m128 acc = _mm_mul_ps( _mm_shuffle_ps( l, l, 0x00 ), r0 );
+				acc = madd( _mm_shuffle_ps( l, l, 0x55 ), r1, acc );
+				acc = madd( _mm_shuffle_ps( l, l, 0xaa ), r2, acc );
+				acc = madd( _mm_shuffle_ps( l, l, 0xff ), r3, acc );
+
+				_mm_storeu_ps( result.v+i, acc );
+			}
+
+			if constexpr( tLeftAffine )
+				_mm_storeu_ps( result.v+12, r3 );
+
+			return result;
+		}
+#		endif // ~ SIMD
+
+		Mat44f result = { 0.f };
+		for( std::size_t r = 0; r < rows; ++r )
+		{
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				float sum = 0.f;
+				for( std::size_t k = 0; k < 3; ++k )
+					sum += aLeft[r, k] * aRight[k, c];
+
+				if( !tRightAffine )
+					sum += aLeft[r, 3] * aRight[3, c];
+				else if( 3 == c )
+					sum += aLeft[r, 3];
+
+				result[r, c] = sum;
+			}
+		}
+
+		if constexpr( tLeftAffine )
+		{
+			for( std::size_t c = 0; c < 4; ++c )
+				result[3, c] = aRight[3, c];
+		}
+
+		return result;
+	}
+
+	// Right-to-left fold over the chain. aAcc is the product of everything to
+	// the right of aExpr.
+	template< bool tAccAffine >
+	struct Mat44Acc_
+	{
+		Mat44f m;
+	};
+
+	template< bool tA, bool tAccAffine > constexpr
+	auto fold_( Mat44Leaf<tA> const& aLeaf, Mat44Acc_<tAccAffine> const& aAcc ) noexcept
+	{
+		return Mat44Acc_<tA && tAccAffine>{ mul_structured<tA, tAccAffine>( aLeaf.m, aAcc.m ) };
+	}
+	template< typename tL, typename tR, bool tAccAffine > constexpr
+	auto fold_( Mat44Product<tL,tR> const& aProd, Mat44Acc_<tAccAffine> const& aAcc ) noexcept
+	{
+		return fold_( aProd.left, fold_( aProd.right, aAcc ) );
+	}
+
+	template< bool tA > constexpr
+	auto eval_( Mat44Leaf<tA> const& aLeaf ) noexcept
+	{
+		return Mat44Acc_<tA>{ aLeaf.m };
+	}
+	template< typename tL, typename tR > constexpr
+	auto eval_( Mat44Product<tL,tR> const& aProd ) noexcept
+	{
+		return fold_( aProd.left, eval_( aProd.right ) );
+	}
+}
+
+template< typename tLeft, typename tRight >
+struct Mat44Product
+{
+	tLeft left;
+	tRight right;
+
+	static constexpr bool kAffine = detail::IsAffine_<Mat44Product>::value;
+
+	constexpr
+	Mat44f eval() const noexcept
+	{
+		return detail::eval_( *this ).m;
+	}
+
+	constexpr
+	operator Mat44f() const noexcept
+	{
+		return eval();
+	}
+};
+
+// Tagging functions:
+
+// Marks aM as affine. Checked with assert() in debug builds.
+constexpr
+Mat44Leaf<true> as_affine( Mat44f const& aM ) noexcept
+{
+	assert( (aM[3,0] == 0.f && aM[3,1] == 0.f && aM[3,2] == 0.f && aM[3,3] == 1.f) );
+	return Mat44Leaf<true>{ aM };
+}
+
+// Starts a lazy chain from an arbitrary matrix.
+constexpr
+Mat44Leaf<false> as_expr( Mat44f const& aM ) noexcept
+{
+	return Mat44Leaf<false>{ aM };
+}
+
+// Operators:
+
+template< Mat44Expr tLeft, Mat44Expr tRight > constexpr
+Mat44Product<tLeft, tRight> operator*( tLeft const& aLeft, tRight const& aRight ) noexcept
+{
+	return { aLeft, aRight };
+}
+
+template< Mat44Expr tRight > constexpr
+Mat44Product<Mat44Leaf<false>, tRight> operator*( Mat44f const& aLeft, tRight const& aRight ) noexcept
+{
+	return { Mat44Leaf<false>{ aLeft }, aRight };
+}
+template< Mat44Expr tLeft > constexpr
+Mat44Product<tLeft, Mat44Leaf<false>> operator*( tLeft const& aLeft, Mat44f const& aRight ) noexcept
+{
+	return { aLeft, Mat44Leaf<false>{ aRight } };
+}
+
+template< Mat44Expr tExpr > constexpr
+Vec4f operator*( tExpr const& aLeft, Vec4f const& aRight ) noexcept
+{
+	return Mat44f( aLeft ) * aRight;
+}
+
+// Explicit evaluation, e.g. for use with "auto".
+template< bool tA > constexpr
+Mat44f eval( Mat44Leaf<tA> const& aLeaf ) noexcept
+{
+	return aLeaf.m;
+}
+template< typename tL, typename tR > constexpr
+Mat44f eval( Mat44Product<tL,tR> const& aProd ) noexcept
+{
+	return aProd.eval();
+}
+
+#endif // MAT44_EXPR_HPP_C81F5A2E_3D94_4B07_A6E1_5F2B09C7D386
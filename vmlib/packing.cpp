@@ -0,0 +1,336 @@
+#include "packing.hpp"
+
+#include <cassert>
+
+#include "simd.hpp"
+
+namespace
+{
+	static_assert( sizeof(OctNormal16) == 2*sizeof(std::int16_t) );
+
+#	if VMLIB_CONF_SIMD
+	// Rounds to nearest even (the default MXCSR mode, same as nearbyint())
+	// and clamps to [aLo, aHi] before.
+	inline
+	__m128i round_clamped_( __m128 aV, __m128 aLo, __m128 aHi, __m128 aScale ) noexcept
+	{
+		return _mm_cvtps_epi32( _mm_mul_ps( _mm_min_ps( _mm_max_ps( aV, aLo ), aHi ), aScale ) );
+	}
+
+	// Sign extends four int16s in the lower or upper half of aV.
+	inline __m128 cvt_lo_i16_( __m128i aV ) noexcept { return _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpacklo_epi16( aV, aV ), 16 ) ); }
+	inline __m128 cvt_hi_i16_( __m128i aV ) noexcept { return _mm_cvtepi32_ps( _mm_srai_epi32( _mm_unpackhi_epi16( aV, aV ), 16 ) ); }
+
+	inline __m128 abs_( __m128 aV ) noexcept { return _mm_andnot_ps( _mm_set1_ps( -0.f ), aV ); }
+	inline __m128 sign_bit_( __m128 aV ) noexcept { return _mm_and_ps( _mm_set1_ps( -0.f ), aV ); }
+
+	// Four oct_encode()s.
+	inline
+	void oct_encode4_( __m128 aX, __m128 aY, __m128 aZ, __m128& aEX, __m128& aEY ) noexcept
+	{
+		__m128 const one = _mm_set1_ps( 1.f );
+
+		__m128 const rl1 = _mm_div_ps( one, _mm_add_ps( _mm_add_ps( abs_( aX ), abs_( aY ) ), abs_( aZ ) ) );
+		__m128 const px = _mm_mul_ps( aX, rl1 );
+		__m128 const py = _mm_mul_ps( aY, rl1 );
+
+		// Lower hemisphere: (1 - |py|) * sign(px), (1 - |px|) * sign(py)
+		__m128 const fx = _mm_or_ps( _mm_sub_ps( one, abs_( py ) ), sign_bit_( px ) );
+		__m128 const fy = _mm_or_ps( _mm_sub_ps( one, abs_( px ) ), sign_bit_( py ) );
+
+		__m128 const upper = _mm_cmpge_ps( aZ, _mm_setzero_ps() );
+		aEX = _mm_or_ps( _mm_and_ps( upper, px ), _mm_andnot_ps( upper, fx ) );
+		aEY = _mm_or_ps( _mm_and_ps( upper, py ), _mm_andnot_ps( upper, fy ) );
+	}
+
+	// Four oct_decode()s.
+	inline
+	void oct_decode4_( __m128 aEX, __m128 aEY, __m128& aX, __m128& aY, __m128& aZ ) noexcept
+	{
+		using detail::madd;
+
+		__m128 const z = _mm_sub_ps( _mm_sub_ps( _mm_set1_ps( 1.f ), abs_( aEX ) ), abs_( aEY ) );
+		__m128 const t = _mm_max_ps( _mm_sub_ps( _mm_setzero_ps(), z ), _mm_setzero_ps() );
+
+		__m128 const x = _mm_sub_ps( aEX, _mm_or_ps( t, sign_bit_( aEX ) ) );
+		__m128 const y = _mm_sub_ps( aEY, _mm_or_ps( t, sign_bit_( aEY ) ) );
+
+		__m128 const len = _mm_sqrt_ps( madd( x, x, madd( y, y, _mm_mul_ps( z, z ) ) ) );
+		aX = _mm_div_ps( x, len );
+		aY = _mm_div_ps( y, len );
+		aZ = _mm_div_ps( z, len );
+	}
+#	endif // ~ SIMD
+}
+
+void pack_half( std::span<float const> aIn, std::span<std::uint16_t> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD && defined(__F16C__)
+#	if VMLIB_CONF_SIMD >= 2
+	for( ; i + 8 <= count; i += 8 )
+	{
+		__m128i const h = _mm256_cvtps_ph( _mm256_loadu_ps( aIn.data()+i ), _MM_FROUND_TO_NEAREST_INT );
+		_mm_storeu_si128( reinterpret_cast<__m128i*>(aOut.data()+i), h );
+	}
+#	endif // ~ SIMD >= 2
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128i const h = _mm_cvtps_ph( _mm_loadu_ps( aIn.data()+i ), _MM_FROUND_TO_NEAREST_INT );
+		_mm_storel_epi64( reinterpret_cast<__m128i*>(aOut.data()+i), h );
+	}
+#	endif // ~ SIMD && F16C
+
+	for( ; i < count; ++i )
+		aOut[i] = pack_half( aIn[i] );
+}
+
+void unpack_half( std::span<std::uint16_t const> aIn, std::span<float> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD && defined(__F16C__)
+#	if VMLIB_CONF_SIMD >= 2
+	for( ; i + 8 <= count; i += 8 )
+	{
+		__m128i const h = _mm_loadu_si128( reinterpret_cast<__m128i const*>(aIn.data()+i) );
+		_mm256_storeu_ps( aOut.data()+i, _mm256_cvtph_ps( h ) );
+	}
+#	endif // ~ SIMD >= 2
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128i const h = _mm_loadl_epi64( reinterpret_cast<__m128i const*>(aIn.data()+i) );
+		_mm_storeu_ps( aOut.data()+i, _mm_cvtph_ps( h ) );
+	}
+#	endif // ~ SIMD && F16C
+
+	for( ; i < count; ++i )
+		aOut[i] = unpack_half( aIn[i] );
+}
+
+void pack_snorm16( std::span<float const> aIn, std::span<std::int16_t> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		__m128 const lo = _mm_set1_ps( -1.f ), hi = _mm_set1_ps( 1.f ), scale = _mm_set1_ps( 32767.f );
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m128i const a = round_clamped_( _mm_loadu_ps( aIn.data()+i+0 ), lo, hi, scale );
+			__m128i const b = round_clamped_( _mm_loadu_ps( aIn.data()+i+4 ), lo, hi, scale );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(aOut.data()+i), _mm_packs_epi32( a, b ) );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = pack_snorm16( aIn[i] );
+}
+
+void unpack_snorm16( std::span<std::int16_t const> aIn, std::span<float> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		__m128 const scale = _mm_set1_ps( 1.f / 32767.f ), lo = _mm_set1_ps( -1.f );
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m128i const v = _mm_loadu_si128( reinterpret_cast<__m128i const*>(aIn.data()+i) );
+			_mm_storeu_ps( aOut.data()+i+0, _mm_max_ps( _mm_mul_ps( cvt_lo_i16_( v ), scale ), lo ) );
+			_mm_storeu_ps( aOut.data()+i+4, _mm_max_ps( _mm_mul_ps( cvt_hi_i16_( v ), scale ), lo ) );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = unpack_snorm16( aIn[i] );
+}
+
+void pack_snorm8( std::span<float const> aIn, std::span<std::int8_t> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		__m128 const lo = _mm_set1_ps( -1.f ), hi = _mm_set1_ps( 1.f ), scale = _mm_set1_ps( 127.f );
+		for( ; i + 16 <= count; i += 16 )
+		{
+			__m128i const a = round_clamped_( _mm_loadu_ps( aIn.data()+i+0 ), lo, hi, scale );
+			__m128i const b = round_clamped_( _mm_loadu_ps( aIn.data()+i+4 ), lo, hi, scale );
+			__m128i const c = round_clamped_( _mm_loadu_ps( aIn.data()+i+8 ), lo, hi, scale );
+			__m128i const d = round_clamped_( _mm_loadu_ps( aIn.data()+i+12 ), lo, hi, scale );
+
+			__m128i const packed = _mm_packs_epi16( _mm_packs_epi32( a, b ), _mm_packs_epi32( c, d ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(aOut.data()+i), packed );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = pack_snorm8( aIn[i] );
+}
+
+void unpack_snorm8( std::span<std::int8_t const> aIn, std::span<float> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		__m128 const scale = _mm_set1_ps( 1.f / 127.f ), lo = _mm_set1_ps( -1.f );
+		for( ; i + 16 <= count; i += 16 )
+		{
+			__m128i const v = _mm_loadu_si128( reinterpret_cast<__m128i const*>(aIn.data()+i) );
+
+			// Sign extend to int16 first (duplicate bytes, then shift)
+			__m128i const lo16 = _mm_srai_epi16( _mm_unpacklo_epi8( v, v ), 8 );
+			__m128i const hi16 = _mm_srai_epi16( _mm_unpackhi_epi8( v, v ), 8 );
+
+			_mm_storeu_ps( aOut.data()+i+0, _mm_max_ps( _mm_mul_ps( cvt_lo_i16_( lo16 ), scale ), lo ) );
+			_mm_storeu_ps( aOut.data()+i+4, _mm_max_ps( _mm_mul_ps( cvt_hi_i16_( lo16 ), scale ), lo ) );
+			_mm_storeu_ps( aOut.data()+i+8, _mm_max_ps( _mm_mul_ps( cvt_lo_i16_( hi16 ), scale ), lo ) );
+			_mm_storeu_ps( aOut.data()+i+12, _mm_max_ps( _mm_mul_ps( cvt_hi_i16_( hi16 ), scale ), lo ) );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = unpack_snorm8( aIn[i] );
+}
+
+void pack_unorm16( std::span<float const> aIn, std::span<std::uint16_t> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		// SSE2 only has a signed saturating pack; bias into the int16 range
+		// and flip the top bit back afterwards.
+		__m128 const lo = _mm_setzero_ps(), hi = _mm_set1_ps( 1.f ), scale = _mm_set1_ps( 65535.f );
+		__m128i const bias32 = _mm_set1_epi32( 32768 );
+		__m128i const bias16 = _mm_set1_epi16( std::int16_t(0x8000) );
+
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m128i const a = _mm_sub_epi32( round_clamped_( _mm_loadu_ps( aIn.data()+i+0 ), lo, hi, scale ), bias32 );
+			__m128i const b = _mm_sub_epi32( round_clamped_( _mm_loadu_ps( aIn.data()+i+4 ), lo, hi, scale ), bias32 );
+			__m128i const packed = _mm_xor_si128( _mm_packs_epi32( a, b ), bias16 );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(aOut.data()+i), packed );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = pack_unorm16( aIn[i] );
+}
+
+void unpack_unorm16( std::span<std::uint16_t const> aIn, std::span<float> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		__m128 const scale = _mm_set1_ps( 1.f / 65535.f );
+		__m128i const zero = _mm_setzero_si128();
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m128i const v = _mm_loadu_si128( reinterpret_cast<__m128i const*>(aIn.data()+i) );
+			_mm_storeu_ps( aOut.data()+i+0, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( v, zero ) ), scale ) );
+			_mm_storeu_ps( aOut.data()+i+4, _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( v, zero ) ), scale ) );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = unpack_unorm16( aIn[i] );
+}
+
+void pack_oct16( std::span<Vec3f const> aIn, std::span<OctNormal16> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		auto const* src = reinterpret_cast<float const*>( aIn.data() );
+		__m128 const lo = _mm_set1_ps( -1.f ), hi = _mm_set1_ps( 1.f ), scale = _mm_set1_ps( 32767.f );
+
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128 x, y, z, ex, ey;
+			detail::load_vec3x4( src + 3*i, x, y, z );
+			oct_encode4_( x, y, z, ex, ey );
+
+			__m128i const ix = round_clamped_( ex, lo, hi, scale );
+			__m128i const iy = round_clamped_( ey, lo, hi, scale );
+
+			// Interleave to x0 y0 x1 y1 ...
+			__m128i const packed = _mm_packs_epi32( _mm_unpacklo_epi32( ix, iy ), _mm_unpackhi_epi32( ix, iy ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(aOut.data()+i), packed );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = pack_oct16( aIn[i] );
+}
+
+void unpack_oct16( std::span<OctNormal16 const> aIn, std::span<Vec3f> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	{
+		auto* dst = reinterpret_cast<float*>( aOut.data() );
+		__m128 const scale = _mm_set1_ps( 1.f / 32767.f ), lo = _mm_set1_ps( -1.f );
+
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128i const v = _mm_loadu_si128( reinterpret_cast<__m128i const*>(aIn.data()+i) );
+			__m128 const a = _mm_max_ps( _mm_mul_ps( cvt_lo_i16_( v ), scale ), lo ); // x0 y0 x1 y1
+			__m128 const b = _mm_max_ps( _mm_mul_ps( cvt_hi_i16_( v ), scale ), lo ); // x2 y2 x3 y3
+
+			__m128 const ex = _mm_shuffle_ps( a, b, _MM_SHUFFLE(2,0,2,0) );
+			__m128 const ey = _mm_shuffle_ps( a, b, _MM_SHUFFLE(3,1,3,1) );
+
+			__m128 x, y, z;
+			oct_decode4_( ex, ey, x, y, z );
+			detail::store_vec3x4( dst + 3*i, x, y, z );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = unpack_oct16( aIn[i] );
+}
@@ -0,0 +1,203 @@
+#ifndef PACKING_HPP_53CEA65F_78FC_4279_ACE6_46AE5246DD88
+#define PACKING_HPP_53CEA65F_78FC_4279_ACE6_46AE5246DD88
+
+#include <span>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "vec2.hpp"
+#include "vec3.hpp"
+
+/* Packed vertex encodings
+ *
+ * Compact storage formats for vertex attributes, matching the ones that
+ * OpenGL can consume directly:
+ *
+ *   half      -- IEEE 754 binary16, GL_HALF_FLOAT. 11 bit significand, i.e.,
+ *                relative error <= 2^-11 in the normal range [2^-14, 65504].
+ *   snorm8/16 -- signed normalized integers, GL_BYTE/GL_SHORT with
+ *                normalized = GL_TRUE. v = max( i / (2^(n-1)-1), -1 ).
+ *   unorm16   -- unsigned normalized, GL_UNSIGNED_SHORT, v = i / 65535.
+ *   oct16     -- unit vectors, octahedral mapping stored as two snorm16.
+ *
+ * Encoding rounds to nearest (ties to even) and clamps to the representable
+ * range, so the absolute error of the normalized formats is at most half a
+ * step, e.g., 1/(2*32767) for snorm16.
+ *
+ * The batched versions take spans; the output must hold at least as many
+ * elements as the input. They use SIMD (see simd.hpp) where available: SSE
+ * for the normalized formats and octahedral normals, and F16C for halfs.
+ * Results are identical to the scalar functions (except for NaN payloads),
+ * apart from the decoded octahedral normals, which may differ by rounding.
+ */
+
+// Octahedral unit vector, as two snorm16. Use with 2 x GL_SHORT, normalized.
+struct OctNormal16
+{
+	std::int16_t x, y;
+};
+
+// Two halfs, see pack_half(). Use with 2 x GL_HALF_FLOAT.
+struct Half2
+{
+	std::uint16_t x, y;
+};
+
+// Scalar functions:
+
+constexpr
+std::uint16_t pack_half( float aV ) noexcept
+{
+	// After F. Giesen's float_to_half_fast3_rtne (public domain)
+	constexpr std::uint32_t f32infty = 255u << 23;
+	constexpr std::uint32_t f16max = (127u + 16u) << 23;
+	constexpr std::uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+	std::uint32_t f = std::bit_cast<std::uint32_t>( aV );
+	std::uint32_t const sign = f & 0x80000000u;
+	f ^= sign;
+
+	std::uint32_t o;
+	if( f >= f16max ) // Inf, NaN and values that round to Inf
+	{
+		o = f > f32infty ? 0x7e00u : 0x7c00u;
+	}
+	else if( f < (113u << 23) ) // Zero and subnormals
+	{
+		// Let the FPU do the rounding
+		float const r = std::bit_cast<float>( f ) + std::bit_cast<float>( denormMagic );
+		o = std::bit_cast<std::uint32_t>( r ) - denormMagic;
+	}
+	else
+	{
+		std::uint32_t const mantOdd = (f >> 13) & 1u;
+		f += (std::uint32_t(15 - 127) << 23) + 0xfffu; // rebias exponent, round
+		f += mantOdd;
+		o = f >> 13;
+	}
+
+	return std::uint16_t(o | (sign >> 16));
+}
+
+constexpr
+float unpack_half( std::uint16_t aH ) noexcept
+{
+	constexpr std::uint32_t shiftedExp = 0x7c00u << 13;
+	constexpr float magic = std::bit_cast<float>( 113u << 23 );
+
+	std::uint32_t o = (std::uint32_t(aH) & 0x7fffu) << 13;
+	std::uint32_t const exp = shiftedExp & o;
+	o += (127u - 15u) << 23;
+
+	if( exp == shiftedExp ) // Inf or NaN
+	{
+		o += (128u - 16u) << 23;
+	}
+	else if( 0 == exp ) // Zero or subnormal
+	{
+		o += 1u << 23;
+		o = std::bit_cast<std::uint32_t>( std::bit_cast<float>( o ) - magic );
+	}
+
+	return std::bit_cast<float>( o | ((std::uint32_t(aH) & 0x8000u) << 16) );
+}
+
+inline
+std::int16_t pack_snorm16( float aV ) noexcept
+{
+	return std::int16_t(std::nearbyint( std::clamp( aV, -1.f, 1.f ) * 32767.f ));
+}
+constexpr
+float unpack_snorm16( std::int16_t aV ) noexcept
+{
+	return std::max( float(aV) * (1.f / 32767.f), -1.f );
+}
+
+inline
+std::int8_t pack_snorm8( float aV ) noexcept
+{
+	return std::int8_t(std::nearbyint( std::clamp( aV, -1.f, 1.f ) * 127.f ));
+}
+constexpr
+float unpack_snorm8( std::int8_t aV ) noexcept
+{
+	return std::max( float(aV) * (1.f / 127.f), -1.f );
+}
+
+inline
+std::uint16_t pack_unorm16( float aV ) noexcept
+{
+	return std::uint16_t(std::nearbyint( std::clamp( aV, 0.f, 1.f ) * 65535.f ));
+}
+constexpr
+float unpack_unorm16( std::uint16_t aV ) noexcept
+{
+	return float(aV) * (1.f / 65535.f);
+}
+
+// Octahedral mapping of a unit vector to [-1,1]^2 (Meyer et al. 2010, "On
+// floating-point normal vectors"). The upper hemisphere maps to the inner
+// diamond |x|+|y| <= 1, the lower one is folded over the edges.
+inline
+Vec2f oct_encode( Vec3f const& aN ) noexcept
+{
+	float const rl1 = 1.f / (std::abs( aN.x ) + std::abs( aN.y ) + std::abs( aN.z ));
+	float const px = aN.x * rl1;
+	float const py = aN.y * rl1;
+
+	if( aN.z >= 0.f )
+		return Vec2f{ px, py };
+
+	return Vec2f{
+		(1.f - std::abs( py )) * std::copysign( 1.f, px ),
+		(1.f - std::abs( px )) * std::copysign( 1.f, py )
+	};
+}
+
+// Inverse of oct_encode(). The result is normalized.
+inline
+Vec3f oct_decode( Vec2f const& aE ) noexcept
+{
+	float const z = 1.f - std::abs( aE.x ) - std::abs( aE.y );
+	float const t = std::max( -z, 0.f );
+
+	Vec3f const n{
+		aE.x - std::copysign( t, aE.x ),
+		aE.y - std::copysign( t, aE.y ),
+		z
+	};
+	return normalize( n );
+}
+
+inline
+OctNormal16 pack_oct16( Vec3f const& aN ) noexcept
+{
+	Vec2f const e = oct_encode( aN );
+	return OctNormal16{ pack_snorm16( e.x ), pack_snorm16( e.y ) };
+}
+inline
+Vec3f unpack_oct16( OctNormal16 const& aP ) noexcept
+{
+	return oct_decode( Vec2f{ unpack_snorm16( aP.x ), unpack_snorm16( aP.y ) } );
+}
+
+// Batched functions:
+
+void pack_half( std::span<float const> aIn, std::span<std::uint16_t> aOut ) noexcept;
+void unpack_half( std::span<std::uint16_t const> aIn, std::span<float> aOut ) noexcept;
+
+void pack_snorm16( std::span<float const> aIn, std::span<std::int16_t> aOut ) noexcept;
+void unpack_snorm16( std::span<std::int16_t const> aIn, std::span<float> aOut ) noexcept;
+
+void pack_snorm8( std::span<float const> aIn, std::span<std::int8_t> aOut ) noexcept;
+void unpack_snorm8( std::span<std::int8_t const> aIn, std::span<float> aOut ) noexcept;
+
+void pack_unorm16( std::span<float const> aIn, std::span<std::uint16_t> aOut ) noexcept;
+void unpack_unorm16( std::span<std::uint16_t const> aIn, std::span<float> aOut ) noexcept;
+
+void pack_oct16( std::span<Vec3f const> aIn, std::span<OctNormal16> aOut ) noexcept;
+void unpack_oct16( std::span<OctNormal16 const> aIn, std::span<Vec3f> aOut ) noexcept;
+
+#endif // PACKING_HPP_53CEA65F_78FC_4279_ACE6_46AE5246DD88
@@ -0,0 +1,239 @@
+#ifndef QUAT_HPP_6A41C2D8_7F0B_4E8A_B3C5_90E2D41F7A16
+#define QUAT_HPP_6A41C2D8_7F0B_4E8A_B3C5_90E2D41F7A16
+
+#include <cmath>
+#include <cassert>
+#include <cstdlib>
+
+#include "vec3.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/** Quatf: quaternion with floats
+ *
+ * Used to represent rotations (orientations) compactly: four floats instead
+ * of the nine of a Mat33f, and cheap to interpolate. All functions below
+ * except normalize() assume unit quaternions where it matters.
+ *
+ * The quaternion is (x, y, z, w), where (x, y, z) is the vector part and w
+ * the scalar part. A rotation by angle a around the unit axis n is
+ *   { n * sin(a/2), cos(a/2) }
+ *
+ * Conversions to matrices follow the conventions of Mat33f/Mat44f (rotation
+ * of column vectors, row-major storage).
+ */
+struct Quatf
+{
+	float x, y, z, w;
+};
+
+// Identity rotation
+constexpr Quatf kIdentityQuatf = { 0.f, 0.f, 0.f, 1.f };
+
+// Common operators for Quatf.
+
+// Hamilton product. (aLeft * aRight) rotates by aRight first, then aLeft,
+// matching the order of matrix products.
+constexpr
+Quatf operator*( Quatf const& aLeft, Quatf const& aRight ) noexcept
+{
+	return Quatf{
+		aLeft.w*aRight.x + aLeft.x*aRight.w + aLeft.y*aRight.z - aLeft.z*aRight.y,
+		aLeft.w*aRight.y - aLeft.x*aRight.z + aLeft.y*aRight.w + aLeft.z*aRight.x,
+		aLeft.w*aRight.z + aLeft.x*aRight.y - aLeft.y*aRight.x + aLeft.z*aRight.w,
+		aLeft.w*aRight.w - aLeft.x*aRight.x - aLeft.y*aRight.y - aLeft.z*aRight.z
+	};
+}
+
+// Functions:
+
+constexpr
+float dot( Quatf const& aLeft, Quatf const& aRight ) noexcept
+{
+	return aLeft.x*aRight.x + aLeft.y*aRight.y + aLeft.z*aRight.z + aLeft.w*aRight.w;
+}
+
+// For unit quaternions, the conjugate is the inverse rotation.
+constexpr
+Quatf conjugate( Quatf const& aQ ) noexcept
+{
+	return Quatf{ -aQ.x, -aQ.y, -aQ.z, aQ.w };
+}
+
+inline
+Quatf normalize( Quatf const& aQ ) noexcept
+{
+	float const rl = 1.f / std::sqrt( dot( aQ, aQ ) );
+	return Quatf{ aQ.x*rl, aQ.y*rl, aQ.z*rl, aQ.w*rl };
+}
+
+inline
+Quatf make_quat_axis_angle( Vec3f const& aAxis, float aAngle ) noexcept
+{
+	Vec3f const n = normalize( aAxis );
+	float const s = std::sin( aAngle * 0.5f );
+	return Quatf{ n.x*s, n.y*s, n.z*s, std::cos( aAngle * 0.5f ) };
+}
+
+// Rotates aVec by aQ. Cheaper than building the matrix for a single vector:
+//   v' = v + 2w (q × v) + 2 q × (q × v)
+inline
+Vec3f rotate( Quatf const& aQ, Vec3f const& aVec ) noexcept
+{
+	Vec3f const q{ aQ.x, aQ.y, aQ.z };
+	Vec3f const t = 2.f * cross( q, aVec );
+	return aVec + aQ.w * t + cross( q, t );
+}
+
+// Normalized linear interpolation. Not constant angular velocity, but cheap
+// and accurate enough for small steps. Takes the shortest path.
+inline
+Quatf nlerp( Quatf const& aA, Quatf const& aB, float aT ) noexcept
+{
+	float const sign = dot( aA, aB ) < 0.f ? -1.f : 1.f;
+	float const ta = 1.f - aT;
+	float const tb = aT * sign;
+
+	return normalize( Quatf{
+		ta*aA.x + tb*aB.x,
+		ta*aA.y + tb*aB.y,
+		ta*aA.z + tb*aB.z,
+		ta*aA.w + tb*aB.w
+	} );
+}
+
+// Spherical linear interpolation (constant angular velocity). Takes the
+// shortest path. Falls back to nlerp() for nearly identical rotations, where
+// sin(theta) would become too small to divide by.
+inline
+Quatf slerp( Quatf const& aA, Quatf const& aB, float aT ) noexcept
+{
+	float d = dot( aA, aB );
+	Quatf b = aB;
+	if( d < 0.f )
+	{
+		d = -d;
+		b = Quatf{ -aB.x, -aB.y, -aB.z, -aB.w };
+	}
+
+	if( d > 0.9995f )
+		return nlerp( aA, b, aT );
+
+	float const theta = std::acos( d );
+	float const rs = 1.f / std::sin( theta );
+	float const ta = std::sin( (1.f - aT) * theta ) * rs;
+	float const tb = std::sin( aT * theta ) * rs;
+
+	return Quatf{
+		ta*aA.x + tb*b.x,
+		ta*aA.y + tb*b.y,
+		ta*aA.z + tb*b.z,
+		ta*aA.w + tb*b.w
+	};
+}
+
+inline
+Mat33f quat_to_mat33( Quatf const& aQ ) noexcept
+{
+	float const xx = aQ.x*aQ.x, yy = aQ.y*aQ.y, zz = aQ.z*aQ.z;
+	float const xy = aQ.x*aQ.y, xz = aQ.x*aQ.z, yz = aQ.y*aQ.z;
+	float const wx = aQ.w*aQ.x, wy = aQ.w*aQ.y, wz = aQ.w*aQ.z;
+
+	return Mat33f{ {
+		1.f - 2.f*(yy + zz), 2.f*(xy - wz),       2.f*(xz + wy),
+		2.f*(xy + wz),       1.f - 2.f*(xx + zz), 2.f*(yz - wx),
+		2.f*(xz - wy),       2.f*(yz + wx),       1.f - 2.f*(xx + yy)
+	} };
+}
+
+inline
+Mat44f quat_to_mat44( Quatf const& aQ ) noexcept
+{
+	Mat33f const r = quat_to_mat33( aQ );
+
+	Mat44f ret = kIdentity44f;
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		for( std::size_t j = 0; j < 3; ++j )
+			ret[i,j] = r[i,j];
+	}
+	return ret;
+}
+
+// Converts a rotation matrix (orthonormal, determinant +1) to a quaternion.
+// Picks the largest of w, x, y, z to divide by, to stay numerically stable.
+inline
+Quatf mat33_to_quat( Mat33f const& aM ) noexcept
+{
+	float const trace = aM[0,0] + aM[1,1] + aM[2,2];
+
+	Quatf q;
+	if( trace > 0.f )
+	{
+		float const s = 2.f * std::sqrt( 1.f + trace );
+		q = Quatf{ (aM[2,1] - aM[1,2]) / s, (aM[0,2] - aM[2,0]) / s, (aM[1,0] - aM[0,1]) / s, 0.25f * s };
+	}
+	else if( aM[0,0] > aM[1,1] && aM[0,0] > aM[2,2] )
+	{
+		float const s = 2.f * std::sqrt( 1.f + aM[0,0] - aM[1,1] - aM[2,2] );
+		q = Quatf{ 0.25f * s, (aM[0,1] + aM[1,0]) / s, (aM[0,2] + aM[2,0]) / s, (aM[2,1] - aM[1,2]) / s };
+	}
+	else if( aM[1,1] > aM[2,2] )
+	{
+		float const s = 2.f * std::sqrt( 1.f + aM[1,1] - aM[0,0] - aM[2,2] );
+		q = Quatf{ (aM[0,1] + aM[1,0]) / s, 0.25f * s, (aM[1,2] + aM[2,1]) / s, (aM[0,2] - aM[2,0]) / s };
+	}
+	else
+	{
+		float const s = 2.f * std::sqrt( 1.f + aM[2,2] - aM[0,0] - aM[1,1] );
+		q = Quatf{ (aM[0,2] + aM[2,0]) / s, (aM[1,2] + aM[2,1]) / s, 0.25f * s, (aM[1,0] - aM[0,1]) / s };
+	}
+
+	return normalize( q );
+}
+
+// Uses the upper 3x3 block, which must be a pure rotation.
+inline
+Quatf mat44_to_quat( Mat44f const& aM ) noexcept
+{
+	return mat33_to_quat( mat44_to_mat33( aM ) );
+}
+
+// Rotation that maps the +Y axis onto the unit vector aDir. The remaining
+// roll is fixed by keeping +Z horizontal (perpendicular to world +Y), or,
+// if aDir is close to vertical, perpendicular to world +X.
+inline
+Quatf make_quat_align_y( Vec3f const& aDir ) noexcept
+{
+	Vec3f const up = std::abs( aDir.y ) > 0.99f ? Vec3f{ 1.f, 0.f, 0.f } : Vec3f{ 0.f, 1.f, 0.f };
+
+	// Right-handed basis (x = y × z), so that the matrix is a rotation
+	Vec3f const yAxis = aDir;
+	Vec3f const zAxis = normalize( cross( yAxis, up ) );
+	Vec3f const xAxis = normalize( cross( yAxis, zAxis ) );
+
+	return mat33_to_quat( Mat33f{ {
+		xAxis.x, yAxis.x, zAxis.x,
+		xAxis.y, yAxis.y, zAxis.y,
+		xAxis.z, yAxis.z, zAxis.z
+	} } );
+}
+
+// Composes translation * rotation * scaling into one matrix directly, i.e.,
+// the same as
+//   make_translation( aT ) * quat_to_mat44( aR ) * make_scaling( aS.x, aS.y, aS.z )
+// without the two matrix products.
+inline
+Mat44f make_trs( Vec3f const& aT, Quatf const& aR, Vec3f const& aS ) noexcept
+{
+	Mat33f const r = quat_to_mat33( aR );
+
+	return Mat44f{ {
+		r[0,0]*aS.x, r[0,1]*aS.y, r[0,2]*aS.z, aT.x,
+		r[1,0]*aS.x, r[1,1]*aS.y, r[1,2]*aS.z, aT.y,
+		r[2,0]*aS.x, r[2,1]*aS.y, r[2,2]*aS.z, aT.z,
+		0.f,         0.f,         0.f,         1.f
+	} };
+}
+
+#endif // QUAT_HPP_6A41C2D8_7F0B_4E8A_B3C5_90E2D41F7A16
@@ -0,0 +1,91 @@
+#ifndef SIMD_HPP_3C0E6B0A_52F1_4E36_9E0B_8D3A6C1B7F42
+#define SIMD_HPP_3C0E6B0A_52F1_4E36_9E0B_8D3A6C1B7F42
+
+/* Compile time config: SIMD backend used by vmlib
+ *
+ *   VMLIB_CONF_SIMD = 0  -- portable scalar code only
+ *   VMLIB_CONF_SIMD = 1  -- SSE (SSE2 baseline, uses FMA if available)
+ *   VMLIB_CONF_SIMD = 2  -- AVX2 (+FMA)
+ *
+ * By default the widest backend that the compiler targets is selected. With
+ * GCC/clang this follows -march=native, which the premake build passes. The
+ * backend can be forced by defining VMLIB_CONF_SIMD, e.g. via
+ *
+ *   premake5 gmake --vmlib-simd=scalar
+ *
+ * The scalar kernels are always compiled, regardless of the selected backend,
+ * and are used in constant evaluation (constexpr).
+ */
+#if !defined(VMLIB_CONF_SIMD)
+#	if defined(__AVX2__) && defined(__FMA__)
+#		define VMLIB_CONF_SIMD 2
+#	elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#		define VMLIB_CONF_SIMD 1
+#	else /* no SIMD */
+#		define VMLIB_CONF_SIMD 0
+#	endif
+#endif // ~ VMLIB_CONF_SIMD
+
+#if VMLIB_CONF_SIMD
+#	include <immintrin.h>
+#endif
+
+#if VMLIB_CONF_SIMD
+namespace detail
+{
+	// a*b + c. Uses a fused multiply-add when the target has one.
+	inline
+	__m128 madd( __m128 aA, __m128 aB, __m128 aC ) noexcept
+	{
+#		if defined(__FMA__)
+		return _mm_fmadd_ps( aA, aB, aC );
+#		else
+		return _mm_add_ps( _mm_mul_ps( aA, aB ), aC );
+#		endif
+	}
+
+	// Loads four Vec3fs (12 floats) and transposes them into one register
+	// per component.
+	//   a0 = x0 y0 z0 x1,  a1 = y1 z1 x2 y2,  a2 = z2 x3 y3 z3
+	inline
+	void load_vec3x4( float const* aSrc, __m128& aX, __m128& aY, __m128& aZ ) noexcept
+	{
+		__m128 const a0 = _mm_loadu_ps( aSrc+0 );
+		__m128 const a1 = _mm_loadu_ps( aSrc+4 );
+		__m128 const a2 = _mm_loadu_ps( aSrc+8 );
+
+		__m128 const xy23 = _mm_shuffle_ps( a1, a2, _MM_SHUFFLE(2,1,3,2) ); // x2 y2 x3 y3
+		__m128 const yz01 = _mm_shuffle_ps( a0, a1, _MM_SHUFFLE(1,0,2,1) ); // y0 z0 y1 z1
+
+		aX = _mm_shuffle_ps( a0, xy23, _MM_SHUFFLE(2,0,3,0) );
+		aY = _mm_shuffle_ps( yz01, xy23, _MM_SHUFFLE(3,1,2,0) );
+		aZ = _mm_shuffle_ps( yz01, a2, _MM_SHUFFLE(3,0,3,1) );
+	}
+	// Inverse of load_vec3x4()
+	inline
+	void store_vec3x4( float* aDst, __m128 aX, __m128 aY, __m128 aZ ) noexcept
+	{
+		__m128 const xy01 = _mm_unpacklo_ps( aX, aY ); // x0 y0 x1 y1
+		__m128 const xy23 = _mm_unpackhi_ps( aX, aY ); // x2 y2 x3 y3
+
+		__m128 const zx01 = _mm_shuffle_ps( aZ, aX, _MM_SHUFFLE(1,1,0,0) );   // z0 z0 x1 x1
+		__m128 const yz11 = _mm_shuffle_ps( xy01, aZ, _MM_SHUFFLE(1,1,3,3) ); // y1 y1 z1 z1
+		__m128 const zx23 = _mm_shuffle_ps( aZ, xy23, _MM_SHUFFLE(2,2,2,2) ); // z2 z2 x3 x3
+		__m128 const yz33 = _mm_shuffle_ps( xy23, aZ, _MM_SHUFFLE(3,3,3,3) ); // y3 y3 z3 z3
+
+		_mm_storeu_ps( aDst+0, _mm_shuffle_ps( xy01, zx01, _MM_SHUFFLE(2,0,1,0) ) );
+		_mm_storeu_ps( aDst+4, _mm_shuffle_ps( yz11, xy23, _MM_SHUFFLE(1,0,2,0) ) );
+		_mm_storeu_ps( aDst+8, _mm_shuffle_ps( zx23, yz33, _MM_SHUFFLE(2,0,2,0) ) );
+	}
+
+#	if VMLIB_CONF_SIMD >= 2
+	inline
+	__m256 madd( __m256 aA, __m256 aB, __m256 aC ) noexcept
+	{
+		return _mm256_fmadd_ps( aA, aB, aC );
+	}
+#	endif // ~ SIMD >= 2
+}
+#endif // ~ SIMD
+
+#endif // SIMD_HPP_3C0E6B0A_52F1_4E36_9E0B_8D3A6C1B7F42
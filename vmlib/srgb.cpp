@@ -0,0 +1,152 @@
+#include "srgb.hpp"
+
+#include <array>
+#include <cmath>
+#include <cassert>
+
+#include "simd.hpp"
+
+namespace
+{
+	struct Tables_
+	{
+		std::array<std::uint16_t, 256> toLinear;
+		std::array<std::uint8_t, kLinear15Max+1> toSrgb;
+	};
+
+	Tables_ make_tables_() noexcept
+	{
+		Tables_ ret;
+
+		for( std::size_t i = 0; i < ret.toLinear.size(); ++i )
+		{
+			double const s = double(i) / 255.0;
+			double const l = s <= 0.04045 ? s / 12.92 : std::pow( (s + 0.055) / 1.055, 2.4 );
+			ret.toLinear[i] = std::uint16_t(std::lround( l * kLinear15Max ));
+		}
+
+		for( std::size_t i = 0; i < ret.toSrgb.size(); ++i )
+		{
+			double const l = double(i) / kLinear15Max;
+			double const s = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow( l, 1.0 / 2.4 ) - 0.055;
+			ret.toSrgb[i] = std::uint8_t(std::lround( s * 255.0 ));
+		}
+
+		return ret;
+	}
+
+	Tables_ const& tables_() noexcept
+	{
+		static Tables_ const tables = make_tables_();
+		return tables;
+	}
+
+	// Alpha is linear; rescale with rounding
+	inline std::uint16_t alpha8_to_15_( std::uint8_t aA ) noexcept
+	{
+		return std::uint16_t((std::uint32_t(aA) * kLinear15Max + 127) / 255);
+	}
+	inline std::uint8_t alpha15_to_8_( std::uint16_t aA ) noexcept
+	{
+		return std::uint8_t((std::uint32_t(aA) * 255 + kLinear15Max/2) / kLinear15Max);
+	}
+}
+
+std::uint16_t srgb8_to_linear15( std::uint8_t aV ) noexcept
+{
+	return tables_().toLinear[aV];
+}
+std::uint8_t linear15_to_srgb8( std::uint16_t aV ) noexcept
+{
+	assert( aV <= kLinear15Max );
+	return tables_().toSrgb[aV];
+}
+
+void srgba8_to_linear15( std::span<std::uint8_t const> aIn, std::span<std::uint16_t> aOut ) noexcept
+{
+	assert( aIn.size() % 4 == 0 );
+	assert( aOut.size() >= aIn.size() );
+
+	auto const& toLinear = tables_().toLinear;
+	for( std::size_t i = 0; i < aIn.size(); i += 4 )
+	{
+		aOut[i+0] = toLinear[aIn[i+0]];
+		aOut[i+1] = toLinear[aIn[i+1]];
+		aOut[i+2] = toLinear[aIn[i+2]];
+		aOut[i+3] = alpha8_to_15_( aIn[i+3] );
+	}
+}
+void linear15_to_srgba8( std::span<std::uint16_t const> aIn, std::span<std::uint8_t> aOut ) noexcept
+{
+	assert( aIn.size() % 4 == 0 );
+	assert( aOut.size() >= aIn.size() );
+
+	auto const& toSrgb = tables_().toSrgb;
+	for( std::size_t i = 0; i < aIn.size(); i += 4 )
+	{
+		assert( aIn[i+0] <= kLinear15Max && aIn[i+1] <= kLinear15Max && aIn[i+2] <= kLinear15Max );
+		aOut[i+0] = toSrgb[aIn[i+0]];
+		aOut[i+1] = toSrgb[aIn[i+1]];
+		aOut[i+2] = toSrgb[aIn[i+2]];
+		aOut[i+3] = alpha15_to_8_( aIn[i+3] );
+	}
+}
+
+void downsample_linear15( std::span<std::uint16_t const> aIn, std::size_t aWidth, std::size_t aHeight, std::span<std::uint16_t> aOut, std::size_t aRowBegin, std::size_t aRowEnd ) noexcept
+{
+	std::size_t const outWidth = mip_size( aWidth );
+	std::size_t const outHeight = mip_size( aHeight );
+
+	assert( aIn.size() >= aWidth * aHeight * 4 );
+	assert( aOut.size() >= outWidth * outHeight * 4 );
+	assert( aRowBegin <= aRowEnd && aRowEnd <= outHeight );
+	(void)outHeight;
+
+	for( std::size_t y = aRowBegin; y < aRowEnd; ++y )
+	{
+		std::uint16_t const* r0 = aIn.data() + std::min( 2*y, aHeight-1 ) * aWidth * 4;
+		std::uint16_t const* r1 = aIn.data() + std::min( 2*y+1, aHeight-1 ) * aWidth * 4;
+		std::uint16_t* out = aOut.data() + y * outWidth * 4;
+
+		std::size_t x = 0;
+
+#		if VMLIB_CONF_SIMD
+		// Each 128 bit load holds the two input pixels of one output pixel.
+		// Sums of two linear15 values fit into 16 bits; sums of four are
+		// formed in 32 bit lanes.
+		__m128i const zero = _mm_setzero_si128();
+		__m128i const half = _mm_set1_epi32( 2 );
+
+		// Output pixels whose two input columns are both inside the image
+		std::size_t const pairs = aWidth / 2;
+
+		auto const filter = [&] (std::size_t aX) {
+			__m128i const a = _mm_loadu_si128( reinterpret_cast<__m128i const*>(r0 + aX*8) );
+			__m128i const b = _mm_loadu_si128( reinterpret_cast<__m128i const*>(r1 + aX*8) );
+			__m128i const s = _mm_add_epi16( a, b );
+
+			__m128i const left = _mm_unpacklo_epi16( s, zero );
+			__m128i const right = _mm_unpackhi_epi16( s, zero );
+			return _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( left, right ), half ), 2 );
+		};
+
+		for( ; x + 2 <= pairs; x += 2 )
+		{
+			__m128i const d = _mm_packs_epi32( filter( x ), filter( x+1 ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>(out + x*4), d );
+		}
+#		endif // ~ SIMD
+
+		for( ; x < outWidth; ++x )
+		{
+			std::size_t const c0 = std::min( 2*x, aWidth-1 ) * 4;
+			std::size_t const c1 = std::min( 2*x+1, aWidth-1 ) * 4;
+
+			for( std::size_t c = 0; c < 4; ++c )
+			{
+				std::uint32_t const sum = std::uint32_t(r0[c0+c]) + r0[c1+c] + r1[c0+c] + r1[c1+c];
+				out[x*4+c] = std::uint16_t((sum + 2) >> 2);
+			}
+		}
+	}
+}
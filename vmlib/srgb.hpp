@@ -0,0 +1,65 @@
+#ifndef SRGB_HPP_8A41C6D2_0E57_4B9B_9F3C_61D2B7E4A05F
+#define SRGB_HPP_8A41C6D2_0E57_4B9B_9F3C_61D2B7E4A05F
+
+#include <span>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+/* sRGB images
+ *
+ * Kernels for building the mip chain of an sRGB texture on the CPU.
+ * Averaging sRGB encoded values directly darkens the smaller levels, so the
+ * image is decoded to linear intensities first, downsampled, and each level
+ * is encoded to sRGB again.
+ *
+ * Linear values are stored as 15 bit unsigned integers (linear15, 0 to
+ * kLinear15Max). This keeps every sRGB8 value distinct (the darkest steps
+ * are about 10 linear15 units apart, so sRGB8 -> linear15 -> sRGB8 is
+ * exact) and lets the filter run on 16 bit integer lanes. Filtering is
+ * exact integer arithmetic, so the SIMD and scalar paths give identical
+ * results.
+ *
+ * Images are RGBA with 4 channels per pixel and tightly packed rows. Alpha
+ * is linear already; it is rescaled, but not sRGB encoded. Colors are not
+ * weighted by alpha.
+ */
+
+inline constexpr std::uint16_t kLinear15Max = 32767;
+
+// Scalar functions (table lookups):
+
+std::uint16_t srgb8_to_linear15( std::uint8_t aV ) noexcept;
+std::uint8_t linear15_to_srgb8( std::uint16_t aV ) noexcept;
+
+// Size of the next mip level along one axis
+constexpr
+std::size_t mip_size( std::size_t aSize ) noexcept
+{
+	return std::max<std::size_t>( aSize / 2, 1 );
+}
+
+// Batched functions. Spans hold whole pixels (4 values each); the output
+// must hold at least as many values as the input.
+
+void srgba8_to_linear15( std::span<std::uint8_t const> aIn, std::span<std::uint16_t> aOut ) noexcept;
+void linear15_to_srgba8( std::span<std::uint16_t const> aIn, std::span<std::uint8_t> aOut ) noexcept;
+
+// 2x2 box filter. aIn is a linear15 RGBA image of aWidth x aHeight pixels,
+// aOut is the next level, mip_size(aWidth) x mip_size(aHeight) pixels. Only
+// rows [aRowBegin, aRowEnd) of aOut are written, so that rows can be split
+// across threads.
+//
+// Output pixel (x,y) averages input pixels (2x,2y) to (2x+1,2y+1), rounded
+// to nearest. Coordinates are clamped to the input, i.e., for an odd size
+// the last input row or column is dropped, and a size of 1 stays 1.
+void downsample_linear15(
+	std::span<std::uint16_t const> aIn,
+	std::size_t aWidth,
+	std::size_t aHeight,
+	std::span<std::uint16_t> aOut,
+	std::size_t aRowBegin,
+	std::size_t aRowEnd
+) noexcept;
+
+#endif // SRGB_HPP_8A41C6D2_0E57_4B9B_9F3C_61D2B7E4A05F
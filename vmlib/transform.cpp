@@ -0,0 +1,175 @@
+#include "transform.hpp"
+
+#include "simd.hpp"
+
+namespace
+{
+	// The SIMD paths treat arrays of Vec3f as flat arrays of floats.
+	static_assert( sizeof(Vec3f) == 3*sizeof(float) );
+
+#	if VMLIB_CONF_SIMD
+	template< typename tReg > tReg splat_( float ) noexcept;
+
+	template<> inline
+	__m128 splat_<__m128>( float aV ) noexcept { return _mm_set1_ps( aV ); }
+
+	inline __m128 mul_( __m128 aA, __m128 aB ) noexcept { return _mm_mul_ps( aA, aB ); }
+	inline __m128 div_( __m128 aA, __m128 aB ) noexcept { return _mm_div_ps( aA, aB ); }
+	inline __m128 sqrt_( __m128 aA ) noexcept { return _mm_sqrt_ps( aA ); }
+
+#	if VMLIB_CONF_SIMD >= 2
+	template<> inline
+	__m256 splat_<__m256>( float aV ) noexcept { return _mm256_set1_ps( aV ); }
+
+	inline __m256 mul_( __m256 aA, __m256 aB ) noexcept { return _mm256_mul_ps( aA, aB ); }
+	inline __m256 div_( __m256 aA, __m256 aB ) noexcept { return _mm256_div_ps( aA, aB ); }
+	inline __m256 sqrt_( __m256 aA ) noexcept { return _mm256_sqrt_ps( aA ); }
+
+	// Eight Vec3fs, as two groups of four.
+	inline
+	void load8_soa_( float const* aSrc, __m256& aX, __m256& aY, __m256& aZ ) noexcept
+	{
+		__m128 x0, y0, z0, x1, y1, z1;
+		detail::load_vec3x4( aSrc+0, x0, y0, z0 );
+		detail::load_vec3x4( aSrc+12, x1, y1, z1 );
+
+		aX = _mm256_set_m128( x1, x0 );
+		aY = _mm256_set_m128( y1, y0 );
+		aZ = _mm256_set_m128( z1, z0 );
+	}
+	inline
+	void store8_aos_( float* aDst, __m256 aX, __m256 aY, __m256 aZ ) noexcept
+	{
+		detail::store_vec3x4( aDst+0, _mm256_castps256_ps128( aX ), _mm256_castps256_ps128( aY ), _mm256_castps256_ps128( aZ ) );
+		detail::store_vec3x4( aDst+12, _mm256_extractf128_ps( aX, 1 ), _mm256_extractf128_ps( aY, 1 ), _mm256_extractf128_ps( aZ, 1 ) );
+	}
+#	endif // ~ SIMD >= 2
+
+	// aM holds the top three rows of the 4x4 matrix, one element per register.
+	template< typename tReg > inline
+	void affine_( tReg const (&aM)[12], tReg& aX, tReg& aY, tReg& aZ ) noexcept
+	{
+		using detail::madd;
+
+		tReg const x = aX, y = aY, z = aZ;
+		aX = madd( aM[0], x, madd( aM[1], y, madd( aM[2], z, aM[3] ) ) );
+		aY = madd( aM[4], x, madd( aM[5], y, madd( aM[6], z, aM[7] ) ) );
+		aZ = madd( aM[8], x, madd( aM[9], y, madd( aM[10], z, aM[11] ) ) );
+	}
+
+	template< typename tReg > inline
+	void linear_normalized_( tReg const (&aM)[9], tReg& aX, tReg& aY, tReg& aZ ) noexcept
+	{
+		using detail::madd;
+
+		tReg const x = aX, y = aY, z = aZ;
+		tReg const nx = madd( aM[0], x, madd( aM[1], y, mul_( aM[2], z ) ) );
+		tReg const ny = madd( aM[3], x, madd( aM[4], y, mul_( aM[5], z ) ) );
+		tReg const nz = madd( aM[6], x, madd( aM[7], y, mul_( aM[8], z ) ) );
+
+		tReg const len = sqrt_( madd( nx, nx, madd( ny, ny, mul_( nz, nz ) ) ) );
+		aX = div_( nx, len );
+		aY = div_( ny, len );
+		aZ = div_( nz, len );
+	}
+
+	template< typename tReg, std::size_t tN > inline
+	void splat_all_( tReg (&aOut)[tN], float const* aIn ) noexcept
+	{
+		for( std::size_t i = 0; i < tN; ++i )
+			aOut[i] = splat_<tReg>( aIn[i] );
+	}
+#	endif // ~ SIMD
+}
+
+void transform_points( Mat44f const& aTransform, std::span<Vec3f const> aIn, std::span<Vec3f> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	auto const* src = reinterpret_cast<float const*>( aIn.data() );
+	auto* dst = reinterpret_cast<float*>( aOut.data() );
+
+#	if VMLIB_CONF_SIMD >= 2
+	{
+		__m256 m[12];
+		splat_all_( m, aTransform.v );
+
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m256 x, y, z;
+			load8_soa_( src + 3*i, x, y, z );
+			affine_( m, x, y, z );
+			store8_aos_( dst + 3*i, x, y, z );
+		}
+	}
+#	endif // ~ SIMD >= 2
+
+	{
+		__m128 m[12];
+		splat_all_( m, aTransform.v );
+
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128 x, y, z;
+			detail::load_vec3x4( src + 3*i, x, y, z );
+			affine_( m, x, y, z );
+			detail::store_vec3x4( dst + 3*i, x, y, z );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+	{
+		Vec3f const p = aIn[i];
+		Vec4f const t = aTransform * Vec4f{ p.x, p.y, p.z, 1.f };
+		aOut[i] = Vec3f{ t.x, t.y, t.z };
+	}
+}
+
+void transform_normals( Mat33f const& aNormalMatrix, std::span<Vec3f const> aIn, std::span<Vec3f> aOut ) noexcept
+{
+	assert( aOut.size() >= aIn.size() );
+
+	std::size_t const count = aIn.size();
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	auto const* src = reinterpret_cast<float const*>( aIn.data() );
+	auto* dst = reinterpret_cast<float*>( aOut.data() );
+
+#	if VMLIB_CONF_SIMD >= 2
+	{
+		__m256 m[9];
+		splat_all_( m, aNormalMatrix.v );
+
+		for( ; i + 8 <= count; i += 8 )
+		{
+			__m256 x, y, z;
+			load8_soa_( src + 3*i, x, y, z );
+			linear_normalized_( m, x, y, z );
+			store8_aos_( dst + 3*i, x, y, z );
+		}
+	}
+#	endif // ~ SIMD >= 2
+
+	{
+		__m128 m[9];
+		splat_all_( m, aNormalMatrix.v );
+
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128 x, y, z;
+			detail::load_vec3x4( src + 3*i, x, y, z );
+			linear_normalized_( m, x, y, z );
+			detail::store_vec3x4( dst + 3*i, x, y, z );
+		}
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		aOut[i] = normalize( aNormalMatrix * aIn[i] );
+}
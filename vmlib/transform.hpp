@@ -0,0 +1,31 @@
+#ifndef TRANSFORM_HPP_9B2D4E71_0C6A_4F3B_8E55_1D7A3F90C2E4
+#define TRANSFORM_HPP_9B2D4E71_0C6A_4F3B_8E55_1D7A3F90C2E4
+
+#include <span>
+
+#include "vec3.hpp"
+#include "mat33.hpp"
+#include "mat44.hpp"
+
+/* Batched vertex transforms
+ *
+ * These transform a contiguous array of Vec3fs by a single matrix. They are
+ * intended for baking meshes on the CPU (e.g., append_transformed_mesh()),
+ * where doing one full Mat44f*Vec4f per vertex is wasteful.
+ *
+ * With a SIMD backend (see simd.hpp), 4 (SSE) or 8 (AVX2) vertices are
+ * processed per iteration; any remainder is handled with scalar code.
+ *
+ * The output must be preallocated and hold at least as many elements as the
+ * input. In-place operation (aOut == aIn) is allowed.
+ */
+
+// Transforms positions as points (w = 1). The w component of the result is
+// ignored, i.e., aTransform is assumed to be affine.
+void transform_points( Mat44f const& aTransform, std::span<Vec3f const> aIn, std::span<Vec3f> aOut ) noexcept;
+
+// Transforms normals by aNormalMatrix (typically the inverse transpose of the
+// model matrix) and renormalizes the results.
+void transform_normals( Mat33f const& aNormalMatrix, std::span<Vec3f const> aIn, std::span<Vec3f> aOut ) noexcept;
+
+#endif // TRANSFORM_HPP_9B2D4E71_0C6A_4F3B_8E55_1D7A3F90C2E4
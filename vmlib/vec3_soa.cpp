@@ -0,0 +1,346 @@
+#include "vec3_soa.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+#include "simd.hpp"
+
+namespace
+{
+	// Widest register of the selected backend. The storage of Vec3fSoA is
+	// aligned and padded for all of them.
+#	if VMLIB_CONF_SIMD >= 2
+	using Reg_ = __m256;
+	constexpr std::size_t kWidth_ = 8;
+
+	inline Reg_ load_( float const* aP ) noexcept { return _mm256_load_ps( aP ); }
+	inline void store_( float* aP, Reg_ aV ) noexcept { _mm256_store_ps( aP, aV ); }
+	inline Reg_ splat_( float aV ) noexcept { return _mm256_set1_ps( aV ); }
+	inline Reg_ add_( Reg_ aA, Reg_ aB ) noexcept { return _mm256_add_ps( aA, aB ); }
+	inline Reg_ sub_( Reg_ aA, Reg_ aB ) noexcept { return _mm256_sub_ps( aA, aB ); }
+	inline Reg_ mul_( Reg_ aA, Reg_ aB ) noexcept { return _mm256_mul_ps( aA, aB ); }
+	inline Reg_ div_( Reg_ aA, Reg_ aB ) noexcept { return _mm256_div_ps( aA, aB ); }
+	inline Reg_ sqrt_( Reg_ aA ) noexcept { return _mm256_sqrt_ps( aA ); }
+	inline void storeu_( float* aP, Reg_ aV ) noexcept { _mm256_storeu_ps( aP, aV ); }
+#	elif VMLIB_CONF_SIMD
+	using Reg_ = __m128;
+	constexpr std::size_t kWidth_ = 4;
+
+	inline Reg_ load_( float const* aP ) noexcept { return _mm_load_ps( aP ); }
+	inline void store_( float* aP, Reg_ aV ) noexcept { _mm_store_ps( aP, aV ); }
+	inline Reg_ splat_( float aV ) noexcept { return _mm_set1_ps( aV ); }
+	inline Reg_ add_( Reg_ aA, Reg_ aB ) noexcept { return _mm_add_ps( aA, aB ); }
+	inline Reg_ sub_( Reg_ aA, Reg_ aB ) noexcept { return _mm_sub_ps( aA, aB ); }
+	inline Reg_ mul_( Reg_ aA, Reg_ aB ) noexcept { return _mm_mul_ps( aA, aB ); }
+	inline Reg_ div_( Reg_ aA, Reg_ aB ) noexcept { return _mm_div_ps( aA, aB ); }
+	inline Reg_ sqrt_( Reg_ aA ) noexcept { return _mm_sqrt_ps( aA ); }
+	inline void storeu_( float* aP, Reg_ aV ) noexcept { _mm_storeu_ps( aP, aV ); }
+#	else // scalar
+	using Reg_ = float;
+	constexpr std::size_t kWidth_ = 1;
+
+	inline Reg_ load_( float const* aP ) noexcept { return *aP; }
+	inline void store_( float* aP, Reg_ aV ) noexcept { *aP = aV; }
+	inline Reg_ splat_( float aV ) noexcept { return aV; }
+	inline Reg_ add_( Reg_ aA, Reg_ aB ) noexcept { return aA + aB; }
+	inline Reg_ sub_( Reg_ aA, Reg_ aB ) noexcept { return aA - aB; }
+	inline Reg_ mul_( Reg_ aA, Reg_ aB ) noexcept { return aA * aB; }
+	inline Reg_ div_( Reg_ aA, Reg_ aB ) noexcept { return aA / aB; }
+	inline Reg_ sqrt_( Reg_ aA ) noexcept { return std::sqrt( aA ); }
+	inline void storeu_( float* aP, Reg_ aV ) noexcept { *aP = aV; }
+#	endif // ~ SIMD
+
+	static_assert( Vec3fSoA::kLanes % kWidth_ == 0 );
+	static_assert( Vec3fSoA::kAlign >= kWidth_ * sizeof(float) );
+
+	inline
+	Reg_ madd_( Reg_ aA, Reg_ aB, Reg_ aC ) noexcept
+	{
+#		if VMLIB_CONF_SIMD
+		return detail::madd( aA, aB, aC );
+#		else
+		return aA*aB + aC;
+#		endif
+	}
+
+	inline
+	Reg_ dot_( Reg_ aAX, Reg_ aAY, Reg_ aAZ, Reg_ aBX, Reg_ aBY, Reg_ aBZ ) noexcept
+	{
+		return madd_( aAX, aBX, madd_( aAY, aBY, mul_( aAZ, aBZ ) ) );
+	}
+
+	std::size_t padded_( std::size_t aCount ) noexcept
+	{
+		return (aCount + Vec3fSoA::kLanes - 1) / Vec3fSoA::kLanes * Vec3fSoA::kLanes;
+	}
+
+	// Runs aOp over all registers of the padded storage. aOp receives the
+	// offset of the current register.
+	template< typename tOp > inline
+	void for_each_reg_( std::size_t aPadded, tOp&& aOp )
+	{
+		for( std::size_t i = 0; i < aPadded; i += kWidth_ )
+			aOp( i );
+	}
+}
+
+// Vec3fSoA
+
+Vec3fSoA::Vec3fSoA( std::size_t aCount )
+{
+	resize( aCount );
+}
+
+Vec3fSoA::Vec3fSoA( std::span<Vec3f const> aValues )
+{
+	assign( aValues );
+}
+
+void Vec3fSoA::resize( std::size_t aCount )
+{
+	std::size_t const padded = padded_( aCount );
+	mX.resize( padded );
+	mY.resize( padded );
+	mZ.resize( padded );
+
+	// The padding may hold stale values from earlier operations.
+	if( aCount > mSize )
+	{
+		std::fill( mX.begin()+mSize, mX.begin()+aCount, 0.f );
+		std::fill( mY.begin()+mSize, mY.begin()+aCount, 0.f );
+		std::fill( mZ.begin()+mSize, mZ.begin()+aCount, 0.f );
+	}
+
+	mSize = aCount;
+}
+
+void Vec3fSoA::reserve( std::size_t aCount )
+{
+	std::size_t const padded = padded_( aCount );
+	mX.reserve( padded );
+	mY.reserve( padded );
+	mZ.reserve( padded );
+}
+
+void Vec3fSoA::clear() noexcept
+{
+	mX.clear();
+	mY.clear();
+	mZ.clear();
+	mSize = 0;
+}
+
+void Vec3fSoA::push_back( Vec3f const& aV )
+{
+	resize( mSize+1 );
+	set( mSize-1, aV );
+}
+
+void Vec3fSoA::pop_back() noexcept
+{
+	assert( mSize > 0 );
+	--mSize;
+}
+
+void Vec3fSoA::swap_remove( std::size_t aI ) noexcept
+{
+	assert( aI < mSize );
+	set( aI, (*this)[mSize-1] );
+	pop_back();
+}
+
+void Vec3fSoA::assign( std::span<Vec3f const> aValues )
+{
+	std::size_t const count = aValues.size();
+	resize( count );
+
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	auto const* src = reinterpret_cast<float const*>( aValues.data() );
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x, y, z;
+		detail::load_vec3x4( src + 3*i, x, y, z );
+		_mm_store_ps( mX.data()+i, x );
+		_mm_store_ps( mY.data()+i, y );
+		_mm_store_ps( mZ.data()+i, z );
+	}
+#	endif // ~ SIMD
+
+	for( ; i < count; ++i )
+		set( i, aValues[i] );
+}
+
+void Vec3fSoA::copy_to( std::span<Vec3f> aOut ) const noexcept
+{
+	assert( aOut.size() >= mSize );
+
+	std::size_t i = 0;
+
+#	if VMLIB_CONF_SIMD
+	auto* dst = reinterpret_cast<float*>( aOut.data() );
+	for( ; i + 4 <= mSize; i += 4 )
+		detail::store_vec3x4( dst + 3*i, _mm_load_ps( mX.data()+i ), _mm_load_ps( mY.data()+i ), _mm_load_ps( mZ.data()+i ) );
+#	endif // ~ SIMD
+
+	for( ; i < mSize; ++i )
+		aOut[i] = (*this)[i];
+}
+
+// Functions
+
+void add( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut )
+{
+	assert( aA.size() == aB.size() );
+	aOut.resize( aA.size() );
+
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, add_( load_( aA.x()+aI ), load_( aB.x()+aI ) ) );
+		store_( aOut.y()+aI, add_( load_( aA.y()+aI ), load_( aB.y()+aI ) ) );
+		store_( aOut.z()+aI, add_( load_( aA.z()+aI ), load_( aB.z()+aI ) ) );
+	} );
+}
+
+void add( Vec3fSoA const& aA, Vec3f const& aB, Vec3fSoA& aOut )
+{
+	aOut.resize( aA.size() );
+
+	Reg_ const bx = splat_( aB.x ), by = splat_( aB.y ), bz = splat_( aB.z );
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, add_( load_( aA.x()+aI ), bx ) );
+		store_( aOut.y()+aI, add_( load_( aA.y()+aI ), by ) );
+		store_( aOut.z()+aI, add_( load_( aA.z()+aI ), bz ) );
+	} );
+}
+
+void sub( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut )
+{
+	assert( aA.size() == aB.size() );
+	aOut.resize( aA.size() );
+
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, sub_( load_( aA.x()+aI ), load_( aB.x()+aI ) ) );
+		store_( aOut.y()+aI, sub_( load_( aA.y()+aI ), load_( aB.y()+aI ) ) );
+		store_( aOut.z()+aI, sub_( load_( aA.z()+aI ), load_( aB.z()+aI ) ) );
+	} );
+}
+
+void mul( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut )
+{
+	assert( aA.size() == aB.size() );
+	aOut.resize( aA.size() );
+
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, mul_( load_( aA.x()+aI ), load_( aB.x()+aI ) ) );
+		store_( aOut.y()+aI, mul_( load_( aA.y()+aI ), load_( aB.y()+aI ) ) );
+		store_( aOut.z()+aI, mul_( load_( aA.z()+aI ), load_( aB.z()+aI ) ) );
+	} );
+}
+
+void mul( float aS, Vec3fSoA const& aA, Vec3fSoA& aOut )
+{
+	aOut.resize( aA.size() );
+
+	Reg_ const s = splat_( aS );
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, mul_( s, load_( aA.x()+aI ) ) );
+		store_( aOut.y()+aI, mul_( s, load_( aA.y()+aI ) ) );
+		store_( aOut.z()+aI, mul_( s, load_( aA.z()+aI ) ) );
+	} );
+}
+
+void madd( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA const& aC, Vec3fSoA& aOut )
+{
+	assert( aA.size() == aB.size() && aA.size() == aC.size() );
+	aOut.resize( aA.size() );
+
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, madd_( load_( aA.x()+aI ), load_( aB.x()+aI ), load_( aC.x()+aI ) ) );
+		store_( aOut.y()+aI, madd_( load_( aA.y()+aI ), load_( aB.y()+aI ), load_( aC.y()+aI ) ) );
+		store_( aOut.z()+aI, madd_( load_( aA.z()+aI ), load_( aB.z()+aI ), load_( aC.z()+aI ) ) );
+	} );
+}
+
+void madd( float aS, Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut )
+{
+	assert( aA.size() == aB.size() );
+	aOut.resize( aA.size() );
+
+	Reg_ const s = splat_( aS );
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		store_( aOut.x()+aI, madd_( s, load_( aA.x()+aI ), load_( aB.x()+aI ) ) );
+		store_( aOut.y()+aI, madd_( s, load_( aA.y()+aI ), load_( aB.y()+aI ) ) );
+		store_( aOut.z()+aI, madd_( s, load_( aA.z()+aI ), load_( aB.z()+aI ) ) );
+	} );
+}
+
+void cross( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut )
+{
+	assert( aA.size() == aB.size() );
+	aOut.resize( aA.size() );
+
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		Reg_ const ax = load_( aA.x()+aI ), ay = load_( aA.y()+aI ), az = load_( aA.z()+aI );
+		Reg_ const bx = load_( aB.x()+aI ), by = load_( aB.y()+aI ), bz = load_( aB.z()+aI );
+
+		store_( aOut.x()+aI, sub_( mul_( ay, bz ), mul_( az, by ) ) );
+		store_( aOut.y()+aI, sub_( mul_( az, bx ), mul_( ax, bz ) ) );
+		store_( aOut.z()+aI, sub_( mul_( ax, by ), mul_( ay, bx ) ) );
+	} );
+}
+
+void normalize( Vec3fSoA const& aA, Vec3fSoA& aOut )
+{
+	aOut.resize( aA.size() );
+
+	// Note: zero-length vectors (including the padding) become NaN, as with
+	// normalize( Vec3f ).
+	for_each_reg_( aOut.padded_size(), [&] (std::size_t aI) {
+		Reg_ const x = load_( aA.x()+aI ), y = load_( aA.y()+aI ), z = load_( aA.z()+aI );
+		Reg_ const len = sqrt_( dot_( x, y, z, x, y, z ) );
+
+		store_( aOut.x()+aI, div_( x, len ) );
+		store_( aOut.y()+aI, div_( y, len ) );
+		store_( aOut.z()+aI, div_( z, len ) );
+	} );
+}
+
+void dot( Vec3fSoA const& aA, Vec3fSoA const& aB, std::span<float> aOut ) noexcept
+{
+	assert( aA.size() == aB.size() );
+	assert( aOut.size() >= aA.size() );
+
+	std::size_t const count = aA.size();
+	std::size_t i = 0;
+
+	// aOut is not padded, so the last partial register is done element-wise.
+	for( ; i + kWidth_ <= count; i += kWidth_ )
+	{
+		Reg_ const d = dot_(
+			load_( aA.x()+i ), load_( aA.y()+i ), load_( aA.z()+i ),
+			load_( aB.x()+i ), load_( aB.y()+i ), load_( aB.z()+i )
+		);
+		storeu_( aOut.data()+i, d );
+	}
+
+	for( ; i < count; ++i )
+		aOut[i] = dot( aA[i], aB[i] );
+}
+
+void length( Vec3fSoA const& aA, std::span<float> aOut ) noexcept
+{
+	assert( aOut.size() >= aA.size() );
+
+	std::size_t const count = aA.size();
+	std::size_t i = 0;
+
+	for( ; i + kWidth_ <= count; i += kWidth_ )
+	{
+		Reg_ const x = load_( aA.x()+i ), y = load_( aA.y()+i ), z = load_( aA.z()+i );
+		storeu_( aOut.data()+i, sqrt_( dot_( x, y, z, x, y, z ) ) );
+	}
+
+	for( ; i < count; ++i )
+		aOut[i] = length( aA[i] );
+}
@@ -0,0 +1,148 @@
+#ifndef VEC3_SOA_HPP_471D5D99_CBD2_45D5_997B_FF17A53DCD6C
+#define VEC3_SOA_HPP_471D5D99_CBD2_45D5_997B_FF17A53DCD6C
+
+#include <span>
+#include <new>
+#include <vector>
+#include <cassert>
+#include <cstdlib>
+
+#include "vec3.hpp"
+
+/* Vec3fSoA: array of Vec3fs, stored as a structure of arrays
+ *
+ * A std::vector<Vec3f> interleaves the components (x0 y0 z0 x1 y1 z1 ...),
+ * so a SIMD register never holds the same component of several vectors
+ * without shuffling. Vec3fSoA keeps three separate arrays instead:
+ *
+ *   x: x0 x1 x2 ...
+ *   y: y0 y1 y2 ...
+ *   z: z0 z1 z2 ...
+ *
+ * Each array is aligned to kAlign bytes and padded to a multiple of kLanes
+ * elements, so that the functions below can process full registers (8 with
+ * AVX2, 4 with SSE; see simd.hpp) without a scalar tail. The padding is part
+ * of the storage only; size() is the number of actual elements.
+ *
+ * Conversion from and to spans of Vec3f (assign(), copy_to()) uses the SIMD
+ * AoS/SoA shuffles.
+ *
+ * Example (particle update):
+ *
+ *    add( velocities, dt * gravity, velocities );
+ *    madd( dt, velocities, positions, positions );  // p += dt * v
+ */
+namespace detail
+{
+	template< typename tType, std::size_t tAlign >
+	struct AlignedAllocator
+	{
+		using value_type = tType;
+
+		template< typename tOther >
+		struct rebind { using other = AlignedAllocator<tOther, tAlign>; };
+
+		AlignedAllocator() noexcept = default;
+		template< typename tOther >
+		AlignedAllocator( AlignedAllocator<tOther, tAlign> const& ) noexcept {}
+
+		tType* allocate( std::size_t aCount )
+		{
+			return static_cast<tType*>(::operator new( aCount * sizeof(tType), std::align_val_t( tAlign ) ));
+		}
+		void deallocate( tType* aPtr, std::size_t ) noexcept
+		{
+			::operator delete( aPtr, std::align_val_t( tAlign ) );
+		}
+
+		template< typename tOther >
+		bool operator==( AlignedAllocator<tOther, tAlign> const& ) const noexcept { return true; }
+	};
+}
+
+class Vec3fSoA final
+{
+	public:
+		static constexpr std::size_t kLanes = 8;
+		static constexpr std::size_t kAlign = 32;
+
+	public:
+		Vec3fSoA() = default;
+		explicit Vec3fSoA( std::size_t aCount );
+		explicit Vec3fSoA( std::span<Vec3f const> );
+
+	public:
+		std::size_t size() const noexcept { return mSize; }
+		bool empty() const noexcept { return 0 == mSize; }
+
+		// Storage size, i.e., size() rounded up to a multiple of kLanes.
+		std::size_t padded_size() const noexcept { return mX.size(); }
+
+		// New elements are zero.
+		void resize( std::size_t );
+		void reserve( std::size_t );
+		void clear() noexcept;
+
+		void push_back( Vec3f const& );
+		void pop_back() noexcept;
+
+		// Removes element aI by moving the last element into its place.
+		void swap_remove( std::size_t aI ) noexcept;
+
+		Vec3f operator[] (std::size_t aI) const noexcept
+		{
+			assert( aI < mSize );
+			return Vec3f{ mX[aI], mY[aI], mZ[aI] };
+		}
+		void set( std::size_t aI, Vec3f const& aV ) noexcept
+		{
+			assert( aI < mSize );
+			mX[aI] = aV.x;
+			mY[aI] = aV.y;
+			mZ[aI] = aV.z;
+		}
+
+		float* x() noexcept { return mX.data(); }
+		float* y() noexcept { return mY.data(); }
+		float* z() noexcept { return mZ.data(); }
+		float const* x() const noexcept { return mX.data(); }
+		float const* y() const noexcept { return mY.data(); }
+		float const* z() const noexcept { return mZ.data(); }
+
+		// AoS -> SoA. Resizes to aValues.size().
+		void assign( std::span<Vec3f const> aValues );
+		// SoA -> AoS. aOut must hold at least size() elements.
+		void copy_to( std::span<Vec3f> aOut ) const noexcept;
+
+	private:
+		using Storage_ = std::vector<float, detail::AlignedAllocator<float, kAlign>>;
+
+		Storage_ mX, mY, mZ;
+		std::size_t mSize = 0;
+};
+
+// Functions:
+//
+// Lane-wise operations. All operands must have the same size, aOut is
+// resized to match. aOut may alias any of the inputs.
+
+void add( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut );
+void add( Vec3fSoA const& aA, Vec3f const& aB, Vec3fSoA& aOut );
+void sub( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut );
+
+void mul( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut ); // component-wise
+void mul( float aS, Vec3fSoA const& aA, Vec3fSoA& aOut );
+
+// aA*aB + aC, component-wise. Uses FMA if available.
+void madd( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA const& aC, Vec3fSoA& aOut );
+// aS*aA + aB
+void madd( float aS, Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut );
+
+void cross( Vec3fSoA const& aA, Vec3fSoA const& aB, Vec3fSoA& aOut );
+void normalize( Vec3fSoA const& aA, Vec3fSoA& aOut );
+
+// Per-element scalar results. aOut must hold at least aA.size() elements.
+void dot( Vec3fSoA const& aA, Vec3fSoA const& aB, std::span<float> aOut ) noexcept;
+void length( Vec3fSoA const& aA, std::span<float> aOut ) noexcept;
+
+#endif // VEC3_SOA_HPP_471D5D99_CBD2_45D5_997B_FF17A53DCD6C